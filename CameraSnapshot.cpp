@@ -0,0 +1,140 @@
+/**
+ * @file CameraSnapshot.cpp
+ * @brief Implementation of the camera snapshot.
+ */
+
+#include "CameraSnapshot.hpp"
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        using FovGetter = bool (*)(float *);
+        using FovSetter = void (*)(float);
+
+        struct FovAccessor
+        {
+            FovGetter SPF_Camera_API::*get;
+            FovSetter SPF_Camera_API::*set;
+        };
+
+        // Indexed by CameraFov.
+        constexpr FovAccessor FOV_ACCESSORS[(size_t)CameraFov::Count] = {
+            {&SPF_Camera_API::Cam_GetBehindFov, &SPF_Camera_API::Cam_SetBehindFov},
+            {&SPF_Camera_API::Cam_GetInteriorFov, &SPF_Camera_API::Cam_SetInteriorFov},
+            {&SPF_Camera_API::Cam_GetTopFov, &SPF_Camera_API::Cam_SetTopFov},
+            {&SPF_Camera_API::Cam_GetWindowFov, &SPF_Camera_API::Cam_SetWindowFov},
+            {&SPF_Camera_API::Cam_GetBumperFov, &SPF_Camera_API::Cam_SetBumperFov},
+            {&SPF_Camera_API::Cam_GetWheelFov, &SPF_Camera_API::Cam_SetWheelFov},
+            {&SPF_Camera_API::Cam_GetCabinFov, &SPF_Camera_API::Cam_SetCabinFov},
+            {&SPF_Camera_API::Cam_GetTVFov, &SPF_Camera_API::Cam_SetTVFov},
+            {&SPF_Camera_API::Cam_GetFreeFov, &SPF_Camera_API::Cam_SetFreeFov},
+        };
+    } // namespace
+
+    bool CameraSnapshot::Capture(const SPF_Camera_API *api)
+    {
+        captured = 0;
+        if (!api || !api->Cam_GetCurrentCamera || !api->Cam_GetCurrentCamera(&type))
+        {
+            return false;
+        }
+        captured |= Type;
+
+        if (api->Cam_GetBehindLiveState && api->Cam_GetBehindLiveState(&behind_pitch, &behind_yaw, &behind_zoom))
+        {
+            captured |= BehindLive;
+        }
+        if (api->Cam_GetInteriorSeatPos && api->Cam_GetInteriorSeatPos(&seat[0], &seat[1], &seat[2]))
+        {
+            captured |= InteriorSeat;
+        }
+        if (api->Cam_GetInteriorHeadRot && api->Cam_GetInteriorHeadRot(&head_yaw, &head_pitch))
+        {
+            captured |= InteriorHead;
+        }
+        if (api->Cam_GetWindowHeadOffset && api->Cam_GetWindowHeadOffset(&window_head[0], &window_head[1], &window_head[2]))
+        {
+            captured |= WindowHead;
+        }
+        if (api->Cam_GetWindowLiveRotation && api->Cam_GetWindowLiveRotation(&window_yaw, &window_pitch))
+        {
+            captured |= WindowRotation;
+        }
+        if (api->Cam_GetFreePosition && api->Cam_GetFreePosition(&free_position[0], &free_position[1], &free_position[2]))
+        {
+            captured |= FreePosition;
+        }
+        if (api->Cam_GetFreeOrientation && api->Cam_GetFreeOrientation(&free_mouse_x, &free_mouse_y, &free_roll))
+        {
+            captured |= FreeOrientation;
+        }
+
+        for (size_t i = 0; i < (size_t)CameraFov::Count; ++i)
+        {
+            const FovGetter get = api->*FOV_ACCESSORS[i].get;
+            if (get && get(&fov[i]))
+            {
+                captured |= FovBase << (uint32_t)i;
+            }
+        }
+        return true;
+    }
+
+    void CameraSnapshot::Restore(const SPF_Camera_API *api) const
+    {
+        if (!api || !Has(Type))
+        {
+            return;
+        }
+
+        // The free camera is what the rig moved. It is put back before the switch, so a player who
+        // was flying it never sees the rig pose again.
+        if (Has(FreePosition) && api->Cam_SetFreePosition)
+        {
+            api->Cam_SetFreePosition(free_position[0], free_position[1], free_position[2]);
+        }
+        if (Has(FreeOrientation) && api->Cam_SetFreeOrientation)
+        {
+            api->Cam_SetFreeOrientation(free_mouse_x, free_mouse_y, free_roll);
+        }
+
+        if (api->Cam_SwitchTo)
+        {
+            api->Cam_SwitchTo(type);
+        }
+
+        // Switching re-initialises the target camera, so its live state is applied afterwards.
+        if (Has(BehindLive) && api->Cam_SetBehindLiveState)
+        {
+            api->Cam_SetBehindLiveState(behind_pitch, behind_yaw, behind_zoom);
+        }
+        if (Has(InteriorSeat) && api->Cam_SetInteriorSeatPos)
+        {
+            api->Cam_SetInteriorSeatPos(seat[0], seat[1], seat[2]);
+        }
+        if (Has(InteriorHead) && api->Cam_SetInteriorHeadRot)
+        {
+            api->Cam_SetInteriorHeadRot(head_yaw, head_pitch);
+        }
+        if (Has(WindowHead) && api->Cam_SetWindowHeadOffset)
+        {
+            api->Cam_SetWindowHeadOffset(window_head[0], window_head[1], window_head[2]);
+        }
+        if (Has(WindowRotation) && api->Cam_SetWindowLiveRotation)
+        {
+            api->Cam_SetWindowLiveRotation(window_yaw, window_pitch);
+        }
+
+        for (size_t i = 0; i < (size_t)CameraFov::Count; ++i)
+        {
+            const FovSetter set = api->*FOV_ACCESSORS[i].set;
+            if (HasFov((CameraFov)i) && set)
+            {
+                set(fov[i]);
+            }
+        }
+    }
+
+} // namespace SPF_RedLightCamera
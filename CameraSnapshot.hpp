@@ -0,0 +1,81 @@
+/**
+ * @file CameraSnapshot.hpp
+ * @brief Full snapshot of the player's camera setup, captured and restored in a single call.
+ * @details A capture moves the free camera and switches away from whatever the player was using.
+ * The snapshot records the active camera type together with the live state of every camera
+ * type the Camera API exposes (behind orbit and zoom, interior seat and head, window head and
+ * rotation, per-type FOVs, free camera pose), so `Restore` can put all of it back in the same
+ * frame as the switch. Fields whose getter is missing or fails are flagged and left untouched on
+ * restore.
+ */
+#pragma once
+
+#include <SPF_Camera_API.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Camera types with their own FOV, indexing `CameraSnapshot::fov`. */
+  enum class CameraFov : uint8_t
+  {
+    Behind,
+    Interior,
+    Top,
+    Window,
+    Bumper,
+    Wheel,
+    Cabin,
+    TV,
+    Free,
+    Count
+  };
+
+  struct CameraSnapshot
+  {
+    /** @brief Bits of `captured`, one per group of fields. */
+    enum Field : uint32_t
+    {
+      Type = 1u << 0,
+      BehindLive = 1u << 1,
+      InteriorSeat = 1u << 2,
+      InteriorHead = 1u << 3,
+      WindowHead = 1u << 4,
+      WindowRotation = 1u << 5,
+      FreePosition = 1u << 6,
+      FreeOrientation = 1u << 7,
+      FovBase = 1u << 8, ///< Bit of FOV i is FovBase << i.
+    };
+
+    uint32_t captured = 0;
+
+    SPF_CameraType type = SPF_CAMERA_INTERIOR;
+    float behind_pitch = 0.0f, behind_yaw = 0.0f, behind_zoom = 0.0f;
+    float seat[3] = {0.0f, 0.0f, 0.0f};
+    float head_yaw = 0.0f, head_pitch = 0.0f;
+    float window_head[3] = {0.0f, 0.0f, 0.0f};
+    float window_yaw = 0.0f, window_pitch = 0.0f;
+    float free_position[3] = {0.0f, 0.0f, 0.0f};
+    float free_mouse_x = 0.0f, free_mouse_y = 0.0f, free_roll = 0.0f;
+    float fov[(size_t)CameraFov::Count] = {};
+
+    bool Has(uint32_t field) const { return (captured & field) != 0; }
+    bool HasFov(CameraFov which) const { return Has(FovBase << (uint32_t)which); }
+
+    /**
+     * @brief Reads the current camera setup.
+     * @return false if not even the active camera type could be read.
+     */
+    bool Capture(const SPF_Camera_API *api);
+
+    /**
+     * @brief Switches back to the captured camera type and re-applies every captured field.
+     * @details The free camera is restored first, before the switch, so it does not flash into
+     *          view; everything else is applied right after the switch.
+     */
+    void Restore(const SPF_Camera_API *api) const;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,167 @@
+/**
+ * @file RigPresetConfig.cpp
+ * @brief Implementation of the rig preset loader.
+ */
+
+#include "RigPresetConfig.hpp"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        bool IsNumber(SPF_JsonType type)
+        {
+            return type == SPF_JSON_TYPE_NUMBER_INTEGER || type == SPF_JSON_TYPE_NUMBER_UNSIGNED || type == SPF_JSON_TYPE_NUMBER_FLOAT;
+        }
+
+        /** @brief Reads a numeric member into `out`; leaves it untouched if absent or not a number. */
+        bool ReadFloat(const SPF_JsonReader_API *json, const SPF_JsonValue_Handle *object, const char *name, float &out)
+        {
+            const SPF_JsonValue_Handle *member = json->Json_GetMember(object, name);
+            if (!member || !IsNumber(json->Json_GetType(member)))
+            {
+                return false;
+            }
+            out = (float)json->Json_GetFloat(member, out);
+            return true;
+        }
+
+        bool ParsePreset(const SPF_JsonReader_API *json, const SPF_JsonValue_Handle *item, RigPreset &out)
+        {
+            out = RigPreset{};
+            if (!item || json->Json_GetType(item) != SPF_JSON_TYPE_OBJECT)
+            {
+                return false;
+            }
+
+            if (const SPF_JsonValue_Handle *name = json->Json_GetMember(item, "name"))
+            {
+                json->Json_GetString(name, out.name, (int)sizeof(out.name));
+            }
+            ReadFloat(json, item, "distance", out.distance);
+            ReadFloat(json, item, "height", out.height);
+            ReadFloat(json, item, "lateral", out.lateral);
+            ReadFloat(json, item, "yaw_offset", out.yaw_offset);
+            out.has_pitch = ReadFloat(json, item, "pitch", out.pitch);
+            ReadFloat(json, item, "fov", out.fov);
+            ReadFloat(json, item, "roll", out.roll);
+            out.valid = true;
+            return true;
+        }
+
+        const SPF_JsonValue_Handle *GetArray(const RigPresetSource &source, const char *key)
+        {
+            const SPF_JsonValue_Handle *array = source.config->Cfg_GetJsonValueHandle(source.handle, key);
+            return (array && source.json->Json_GetType(array) == SPF_JSON_TYPE_ARRAY) ? array : nullptr;
+        }
+    } // namespace
+
+    size_t LoadRigPresets(const RigPresetSource &source, RigPresetTable &table)
+    {
+        const SPF_JsonValue_Handle *array = source.IsValid() ? GetArray(source, RIG_PRESETS_KEY) : nullptr;
+        if (!array)
+        {
+            table.Resize(0);
+            return 0;
+        }
+
+        const int size = source.json->Json_GetArraySize(array);
+        table.Resize(size > 0 ? (size_t)size : 0);
+        size_t valid = 0;
+        for (size_t i = 0; i < table.GetCount(); ++i)
+        {
+            valid += ParsePreset(source.json, source.json->Json_GetArrayItem(array, (int)i), *table.Slot(i)) ? 1 : 0;
+        }
+        return valid;
+    }
+
+    bool ReloadRigPreset(const RigPresetSource &source, size_t index, RigPresetTable &table)
+    {
+        const SPF_JsonValue_Handle *array = source.IsValid() ? GetArray(source, RIG_PRESETS_KEY) : nullptr;
+        RigPreset *slot = table.Slot(index);
+        if (!array || !slot)
+        {
+            return false;
+        }
+
+        // An element past the current end means the array grew; take the new size.
+        const int size = source.json->Json_GetArraySize(array);
+        if (index >= table.GetCount() && (int)index < size)
+        {
+            table.Resize((size_t)size);
+        }
+        return ParsePreset(source.json, source.json->Json_GetArrayItem(array, (int)index), *slot);
+    }
+
+    size_t LoadOffencePresets(const RigPresetSource &source, RigPresetTable &table)
+    {
+        table.ClearProfiles();
+        const SPF_JsonValue_Handle *array = source.IsValid() ? GetArray(source, OFFENCE_PRESETS_KEY) : nullptr;
+        if (!array)
+        {
+            return 0;
+        }
+
+        size_t count = 0;
+        const int size = source.json->Json_GetArraySize(array);
+        for (int i = 0; i < size; ++i)
+        {
+            const SPF_JsonValue_Handle *item = source.json->Json_GetArrayItem(array, i);
+            const SPF_JsonValue_Handle *offence = item ? source.json->Json_GetMember(item, "offence") : nullptr;
+            const SPF_JsonValue_Handle *preset = item ? source.json->Json_GetMember(item, "preset") : nullptr;
+            if (!offence || !preset || source.json->Json_GetType(offence) != SPF_JSON_TYPE_STRING)
+            {
+                continue;
+            }
+
+            char key[RIG_PROFILE_KEY_SIZE];
+            if (source.json->Json_GetString(offence, key, (int)sizeof(key)) <= 0)
+            {
+                continue;
+            }
+            count += table.SetProfile(key, source.json->Json_GetInt32(preset, -1)) ? 1 : 0;
+        }
+        return count;
+    }
+
+    bool IsRigPresetKey(const char *key_path, size_t &index)
+    {
+        const size_t prefix = std::strlen(RIG_PRESETS_KEY);
+        if (!key_path || std::strncmp(key_path, RIG_PRESETS_KEY, prefix) != 0)
+        {
+            return false;
+        }
+
+        // "settings.rig_presets" is the whole array; ".<n>" or "[<n>]" (optionally followed by a
+        // member) is one element. Anything else sharing the prefix is a different setting.
+        const char *rest = key_path + prefix;
+        index = SIZE_MAX;
+        if (*rest == '\0')
+        {
+            return true;
+        }
+        if (*rest != '.' && *rest != '[')
+        {
+            return false;
+        }
+        char *end = nullptr;
+        const unsigned long value = std::strtoul(rest + 1, &end, 10);
+        if (end != rest + 1)
+        {
+            index = (size_t)value;
+        }
+        return true;
+    }
+
+    bool IsOffencePresetKey(const char *key_path)
+    {
+        const size_t prefix = std::strlen(OFFENCE_PRESETS_KEY);
+        return key_path && std::strncmp(key_path, OFFENCE_PRESETS_KEY, prefix) == 0 && (key_path[prefix] == '\0' || key_path[prefix] == '.' || key_path[prefix] == '[');
+    }
+
+} // namespace SPF_RedLightCamera
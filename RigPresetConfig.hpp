@@ -0,0 +1,62 @@
+/**
+ * @file RigPresetConfig.hpp
+ * @brief Reads the rig presets and offence profiles from the plugin config.
+ * @details Both are structured settings, so they are read through `Cfg_GetJsonValueHandle` and the
+ * JSON Reader API instead of the scalar getters:
+ *
+ *     "rig_presets": [ { "name": "Side", "distance": 6, "lateral": 14, "height": 2.5,
+ *                        "yaw_offset": 0, "pitch": -10, "fov": 60, "roll": 0 }, ... ]
+ *     "offence_presets": [ { "offence": "red_signal", "preset": 1 }, { "offence": "manual", "preset": 2 } ]
+ *
+ * The profiles are an array rather than an object keyed by offence because the JSON Reader API
+ * cannot enumerate object members. Missing preset members take the `RigPreset` defaults; `pitch`
+ * is only an override when present.
+ * Parsing happens when the plugin is activated and when these settings change; a change reported
+ * for a single array element (`settings.rig_presets.<n>` or `settings.rig_presets[<n>]`) re-parses
+ * only that preset.
+ */
+#pragma once
+
+#include <SPF_Config_API.h>
+#include <SPF_JsonReader_API.h>
+
+#include "RigPresets.hpp"
+
+#include <cstddef>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr const char *RIG_PRESETS_KEY = "settings.rig_presets";
+  constexpr const char *OFFENCE_PRESETS_KEY = "settings.offence_presets";
+
+  /** @brief The config and JSON APIs the loader reads through. Invalid if any part is missing. */
+  struct RigPresetSource
+  {
+    const SPF_Config_API *config = nullptr;
+    SPF_Config_Handle *handle = nullptr;
+    const SPF_JsonReader_API *json = nullptr;
+
+    bool IsValid() const { return config && config->Cfg_GetJsonValueHandle && handle && json; }
+  };
+
+  /** @brief Parses every preset. Returns the number of valid presets. */
+  size_t LoadRigPresets(const RigPresetSource &source, RigPresetTable &table);
+
+  /** @brief Re-parses preset `index` only. Returns false if it is missing or not an object. */
+  bool ReloadRigPreset(const RigPresetSource &source, size_t index, RigPresetTable &table);
+
+  /** @brief Replaces the offence profiles. Returns the number of profiles read. */
+  size_t LoadOffencePresets(const RigPresetSource &source, RigPresetTable &table);
+
+  /**
+   * @brief Classifies a changed setting path.
+   * @param index Out: the array element for a single-preset change, or SIZE_MAX for the whole array.
+   * @return true if the path belongs to the rig presets.
+   */
+  bool IsRigPresetKey(const char *key_path, size_t &index);
+
+  /** @brief true if the path belongs to the offence profiles. */
+  bool IsOffencePresetKey(const char *key_path);
+
+} // namespace SPF_RedLightCamera
@@ -10,7 +10,7 @@
 #define _USE_MATH_DEFINES
 #include <cmath>
 #include <cstring>                // For C-style string manipulation functions like strncpy_s.
-#include <string>                 // For std::string and std::to_string
+#include <ctime>                  // For std::time (recording file names)
 
 namespace SPF_RedLightCamera
 {
@@ -32,6 +32,206 @@ namespace SPF_RedLightCamera
      */
     PluginContext g_ctx;
 
+    /** @brief Maximum number of nearby vehicles the rig tries to keep in shot. */
+    constexpr size_t MAX_FRAMED_VEHICLES = 4;
+    /** @brief Extra room around framed vehicles, as a multiple of their angular extent. */
+    constexpr double TRAFFIC_FRAMING_MARGIN = 1.15;
+    /** @brief Upper limit when widening the FOV for traffic or auto-framing (degrees). */
+    constexpr double MAX_FRAMING_FOV = 110.0;
+
+    /** @brief The rig's placement in the truck's frame (X right, Y up, Z back): the preset's, or the sliders'. */
+    static SPF_FVector RigOffset(const RigPreset *preset)
+    {
+        return preset ? SPF_FVector{preset->lateral, preset->height, -preset->distance}
+                      : SPF_FVector{0.0f, g_ctx.setting_height_above, -g_ctx.setting_distance_forward};
+    }
+
+    /** @brief A fly-by that has not reached every shot after this many frames is cut short. */
+    constexpr int CINEMATIC_TIMEOUT_FRAMES = 1800;
+
+    /** @brief How often (in frames) a flush of the telemetry recording is requested. */
+    constexpr uint64_t RECORDING_FLUSH_INTERVAL_FRAMES = 300;
+
+    /** @brief Vignette flash: depth of each edge gradient, as a fraction of the screen size. */
+    constexpr float FLASH_VIGNETTE_BAND = 0.3f;
+
+    /** @brief Height of the frame cost sparkline in the statistics HUD, in pixels. */
+    constexpr float STATS_SPARKLINE_HEIGHT = 48.0f;
+
+    /** @brief A site alerted for is forgotten once nothing is within this many alert radii. */
+    constexpr double PROXIMITY_CLEAR_FACTOR = 1.5;
+
+    /** @brief Finished background jobs handed back per frame; the rest wait for the next frame. */
+    constexpr size_t WORKER_COMPLETIONS_PER_FRAME = 32;
+
+    /** @brief Keybind group and full action name of the manual capture (group + "." + action). */
+    const char *MANUAL_CAPTURE_GROUP = "SPF_RedLightCamera.Capture";
+    const char *MANUAL_CAPTURE_ACTION = "SPF_RedLightCamera.Capture.manual";
+    const char *VIOLATION_EXPORT_ACTION = "SPF_RedLightCamera.Capture.export";
+
+    /** @brief A screenshot the game log has not mentioned after this long counts as unconfirmed. */
+    constexpr uint64_t SCREENSHOT_CONFIRM_TIMEOUT_US = 10 * 1000 * 1000;
+
+    /** @brief Microseconds on the steady clock, comparable across threads. */
+    static uint64_t NowMicros()
+    {
+        return (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(FrameBudgetGovernor::Clock::now().time_since_epoch()).count();
+    }
+
+    /** @brief Copies at most size - 1 bytes into a journal record field and always terminates it. */
+    static void CopyJournalString(char *out, size_t size, const char *text)
+    {
+        const size_t length = ::strnlen(text, size - 1);
+        std::memcpy(out, text, length);
+        out[length] = '\0';
+    }
+
+    // =================================================================================================
+    // 1.1. Settings Schema
+    // =================================================================================================
+    // Expanded from RLC_SETTINGS (SettingsSchema.hpp). Adding a setting there adds its field,
+    // default, metadata and change dispatch; only its localization strings live elsewhere.
+
+    // Live Preview: re-apply the rig on the next frame with headroom. Dragging a slider fires
+    // many changes per frame; the governor coalesces them into a single re-pose.
+    static void OnRigSettingChanged() { g_ctx.governor.Defer(DeferredTask::PreviewRepose); }
+
+    static void OnRecordTelemetryChanged()
+    {
+        if (g_ctx.setting_record_telemetry)
+        {
+            StartTelemetryRecording();
+        }
+        else
+        {
+            StopTelemetryRecording();
+        }
+    }
+
+    static void OnPublishMetricsChanged()
+    {
+        if (g_ctx.setting_publish_metrics)
+        {
+            StartMetricsPublishing();
+        }
+        else
+        {
+            StopMetricsPublishing();
+        }
+    }
+
+    static void OnTrafficWatchChanged() { g_ctx.traffic_watch.Reset(); }
+
+    static void OnFrameCrossingTrafficChanged()
+    {
+        g_ctx.traffic_index.Reset();
+        OnRigSettingChanged();
+    }
+
+    // The flash curve is sampled here, never in the draw callback.
+    static void OnFlashSettingChanged()
+    {
+        g_ctx.flash_curve.Build((FlashStyle)g_ctx.setting_flash_style, (uint32_t)g_ctx.setting_flash_duration_ms * 1000u);
+    }
+
+    static void OnDedupSettingChanged()
+    {
+        g_ctx.dedup.Configure(g_ctx.setting_dedup_cell_size, (uint64_t)((double)g_ctx.setting_dedup_window_s * 1000000.0));
+    }
+
+    static void OnHeatmapChanged()
+    {
+        if (g_ctx.setting_heatmap)
+        {
+            OpenViolationHeatmap();
+        }
+        else
+        {
+            CloseViolationHeatmap();
+        }
+    }
+
+    static void OnProximityAlertsChanged()
+    {
+        if (g_ctx.setting_proximity_alerts)
+        {
+            LoadViolationSites();
+        }
+        else
+        {
+            g_ctx.violation_sites.Clear();
+        }
+        g_ctx.proximity_site = ~0u;
+    }
+
+    static void OnCaptureHistoryChanged()
+    {
+        if (g_ctx.setting_capture_history)
+        {
+            OpenCaptureHistory();
+        }
+        else
+        {
+            CloseCaptureHistory();
+        }
+    }
+
+    static void OnCaptureJournalChanged()
+    {
+        if (g_ctx.setting_capture_journal)
+        {
+            OpenCaptureJournal();
+        }
+        else
+        {
+            CloseCaptureJournal();
+        }
+    }
+
+    // Turning the check off and on again retries a screenshot folder that was not found.
+    static void OnQualityCheckChanged() { g_ctx.quality_unavailable = false; }
+
+    static void OnFrameBudgetChanged()
+    {
+        g_ctx.governor.SetBudgetMicros(g_ctx.setting_frame_budget_us > 0 ? (uint32_t)g_ctx.setting_frame_budget_us : 0);
+    }
+
+    constexpr SettingDescriptor SETTINGS[] = {RLC_SETTINGS(RLC_SETTING_DESCRIPTOR)};
+    constexpr auto SETTINGS_DEFAULTS_JSON = FinishJsonObject("{" RLC_STRUCTURED_SETTINGS_JSON RLC_SETTINGS(RLC_SETTING_JSON) "}");
+    constexpr auto SETTINGS_LOOKUP = BuildSettingLookup<128>(SETTINGS);
+
+    /** @brief Finds the descriptor for a "settings.<key>" path, or nullptr. */
+    static const SettingDescriptor *FindSetting(const char *key_path)
+    {
+        constexpr size_t mask = SETTINGS_LOOKUP.size() - 1;
+        for (size_t slot = HashSettingKey(key_path) & mask; SETTINGS_LOOKUP[slot] >= 0; slot = (slot + 1) & mask)
+        {
+            const SettingDescriptor &setting = SETTINGS[SETTINGS_LOOKUP[slot]];
+            if (strcmp(setting.key_path, key_path) == 0)
+            {
+                return &setting;
+            }
+        }
+        return nullptr;
+    }
+
+    /** @brief Reads one setting from the config into its PluginContext field. */
+    static void ReadSetting(const SPF_Config_API *config, SPF_Config_Handle *handle, const SettingDescriptor &setting)
+    {
+        switch (setting.type)
+        {
+        case SettingType::Float:
+            g_ctx.*setting.as_float = config->Cfg_GetFloat(handle, setting.key_path, (float)setting.default_value);
+            break;
+        case SettingType::Int:
+            g_ctx.*setting.as_int = config->Cfg_GetInt32(handle, setting.key_path, (int32_t)setting.default_value);
+            break;
+        case SettingType::Bool:
+            g_ctx.*setting.as_bool = config->Cfg_GetBool(handle, setting.key_path, setting.default_value != 0.0);
+            break;
+        }
+    }
+
     // =================================================================================================
     // 2. Manifest Implementation
     // =================================================================================================
@@ -63,13 +263,7 @@ namespace SPF_RedLightCamera
         }
 
         // --- 2.3. Custom Settings Defaults ---
-        api->Settings_SetJson(h, R"json(
-        {
-            "distance_forward": 25.0,
-            "height_above": 4.0,
-            "field_of_view": 70.0
-        }
-    )json");
+        api->Settings_SetJson(h, SETTINGS_DEFAULTS_JSON.data());
 
         // --- 2.4. Default Settings for Framework Systems ---
 
@@ -82,6 +276,14 @@ namespace SPF_RedLightCamera
         // UI
         {
             api->Defaults_AddWindow(h, "FlashWindow", false, false, 0, 0, 0, 0, false, false);
+            api->Defaults_AddWindow(h, "StatsWindow", false, true, 40, 40, 320, 300, false, false);
+            api->Defaults_AddWindow(h, "HeatmapWindow", false, true, 380, 40, 360, 400, false, false);
+        }
+
+        // Keybinds
+        {
+            api->Defaults_AddKeybind(h, MANUAL_CAPTURE_GROUP, "manual", "keyboard", "KEY_F9", "always");
+            api->Defaults_AddKeybind(h, MANUAL_CAPTURE_GROUP, "export", "keyboard", "KEY_F10", "always");
         }
 
         // =============================================================================================
@@ -89,24 +291,24 @@ namespace SPF_RedLightCamera
         // =============================================================================================
 
         // --- Custom Settings Metadata ---
-        
-        auto AddSliderMeta = [&](const char *key, const char *title, const char *desc, float min, float max, const char *format)
+        // Titles, descriptions and slider parameters all come from the settings schema. Traffic
+        // framing needs vehicle positions the Vehicle API does not provide, so its settings stay
+        // hidden until something installs a position source (see TrafficIndex.hpp).
+        for (const SettingDescriptor &setting : SETTINGS)
         {
-            std::string params = "{ \"min\": " + std::to_string(min) + 
-                                 ", \"max\": " + std::to_string(max) + 
-                                 ", \"format\": \"" + format + "\" }";
-            api->Meta_AddCustomSetting(h, key, title, desc, "slider", params.c_str(), false);
-        };
-
-        { //--- Metadata for "distance_forward" ---
-            AddSliderMeta("distance_forward", "Setting.DistanceForward.Title", "Setting.DistanceForward.Description", -100.0f, 100.0f, "%0.1f");
-        }
-        { //--- Metadata for "height_above" ---
-            AddSliderMeta("height_above", "Setting.HeightAbove.Title", "Setting.HeightAbove.Description", -100.0f, 100.0f, "%0.1f");
-        }
-        { //--- Metadata for "field_of_view" ---
-            AddSliderMeta("field_of_view", "Setting.FieldOfView.Title", "Setting.FieldOfView.Description", 0.0f, 120.0f, "%0.1f");
+            const bool traffic_framing = setting.as_bool == &PluginContext::setting_frame_crossing_traffic ||
+                                         setting.as_float == &PluginContext::setting_crossing_traffic_radius;
+            const bool hidden = traffic_framing && !g_ctx.traffic_index.HasPositionSource();
+            api->Meta_AddCustomSetting(h, setting.Key(), setting.title, setting.description, setting.widget, setting.widget_params, hidden);
         }
+
+        // --- Windows Metadata ---
+        api->Meta_AddWindow(h, "StatsWindow", "Window.Stats.Title", "Window.Stats.Description");
+        api->Meta_AddWindow(h, "HeatmapWindow", "Window.Heatmap.Title", "Window.Heatmap.Description");
+
+        // --- Keybinds Metadata ---
+        api->Meta_AddKeybind(h, MANUAL_CAPTURE_GROUP, "manual", "Keybind.ManualCapture.Title", "Keybind.ManualCapture.Description");
+        api->Meta_AddKeybind(h, MANUAL_CAPTURE_GROUP, "export", "Keybind.ExportViolations.Title", "Keybind.ExportViolations.Description");
     }
 
     // =================================================================================================
@@ -133,13 +335,25 @@ namespace SPF_RedLightCamera
                 g_ctx.configHandle = g_ctx.loadAPI->config->Cfg_GetContext(PLUGIN_NAME);
                 if (g_ctx.configHandle)
                 {
-                    const auto config = g_ctx.loadAPI->config;
-                    g_ctx.setting_distance_forward = config->Cfg_GetFloat(g_ctx.configHandle, "settings.distance_forward", 25.0f);
-                    g_ctx.setting_height_above = config->Cfg_GetFloat(g_ctx.configHandle, "settings.height_above", 4.0f);
-                    g_ctx.setting_field_of_view = config->Cfg_GetFloat(g_ctx.configHandle, "settings.field_of_view", 70.0f);
+                    for (const SettingDescriptor &setting : SETTINGS)
+                    {
+                        ReadSetting(g_ctx.loadAPI->config, g_ctx.configHandle, setting);
+                    }
                 }
             }
 
+            OnFlashSettingChanged();
+            OnDedupSettingChanged();
+
+            // --- Frame Budget Governor ---
+            g_ctx.governor.SetBudgetMicros(g_ctx.setting_frame_budget_us > 0 ? (uint32_t)g_ctx.setting_frame_budget_us : 0);
+            g_ctx.governor.SetTask(DeferredTask::FlushRecording, []() { g_ctx.recorder.Flush(); });
+            g_ctx.governor.SetTask(DeferredTask::PreviewRepose, PositionAndOrientRedLightCamera);
+            g_ctx.governor.SetTask(DeferredTask::PublishMetrics, []() { g_ctx.metrics.Publish(); });
+            g_ctx.governor.SetTask(DeferredTask::CheckpointJournal, RequestJournalCheckpoint);
+
+            ApplyTrafficWatchRules();
+
             if (g_ctx.loggerHandle && g_ctx.formattingAPI)
             {
                 char log_buffer[256];
@@ -174,6 +388,10 @@ namespace SPF_RedLightCamera
             g_ctx.gameConsoleAPI = g_ctx.coreAPI->console;
             g_ctx.uiAPI = g_ctx.coreAPI->ui;
 
+                    if (g_ctx.coreAPI->environment)
+                    {
+                        g_ctx.environmentHandle = g_ctx.coreAPI->environment->Env_GetContext(PLUGIN_NAME);
+                    }
                     if (g_ctx.coreAPI->telemetry)
                     {
                         g_ctx.telemetryHandle = g_ctx.coreAPI->telemetry->Tel_GetContext(PLUGIN_NAME);
@@ -183,6 +401,20 @@ namespace SPF_RedLightCamera
                 if (g_ctx.telemetryHandle && g_ctx.coreAPI && g_ctx.coreAPI->telemetry)
                 {
                     g_ctx.gameplayEventsSubscription = g_ctx.coreAPI->telemetry->Tel_RegisterForGameplayEvents(g_ctx.telemetryHandle, OnGameplayEvents, &g_ctx);
+                    // Keep the manual capture armed (see OnTruckData). Without these the key falls back to the regular pose.
+                    if (g_ctx.coreAPI->telemetry->Tel_RegisterForTruckData && g_ctx.coreAPI->telemetry->Tel_RegisterForTimestamps)
+                    {
+                        g_ctx.truckDataSubscription = g_ctx.coreAPI->telemetry->Tel_RegisterForTruckData(g_ctx.telemetryHandle, OnTruckData, &g_ctx);
+                        g_ctx.timestampsSubscription = g_ctx.coreAPI->telemetry->Tel_RegisterForTimestamps(g_ctx.telemetryHandle, OnTimestamps, &g_ctx);
+                    }
+                    // Auto-framing invalidation. Without these the box is built once and kept.
+                    const auto tel = g_ctx.coreAPI->telemetry;
+                    if (tel->Tel_RegisterForTruckConstants && tel->Tel_RegisterForTrailerConstants && tel->Tel_RegisterForTrailers)
+                    {
+                        g_ctx.truckConstantsSubscription = tel->Tel_RegisterForTruckConstants(g_ctx.telemetryHandle, OnTruckConstants, &g_ctx);
+                        g_ctx.trailerConstantsSubscription = tel->Tel_RegisterForTrailerConstants(g_ctx.telemetryHandle, OnTrailerConstants, &g_ctx);
+                        g_ctx.trailersSubscription = tel->Tel_RegisterForTrailers(g_ctx.telemetryHandle, OnTrailers, &g_ctx);
+                    }
                 }
         if (g_ctx.loggerHandle && g_ctx.formattingAPI)
         {
@@ -193,19 +425,65 @@ namespace SPF_RedLightCamera
             g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
         }
 
+        if (g_ctx.setting_record_telemetry)
+        {
+            StartTelemetryRecording();
+        }
+
+        if (g_ctx.setting_publish_metrics)
+        {
+            StartMetricsPublishing();
+        }
+
+        if (g_ctx.setting_heatmap)
+        {
+            OpenViolationHeatmap();
+        }
+
+        if (g_ctx.setting_capture_journal)
+        {
+            OpenCaptureJournal();
+        }
+
+        StartWorkerPool();
+        LoadRigPresetConfig();
+
+        // After the heatmap, which may have compacted the file, and the pool, which builds the index.
+        if (g_ctx.setting_proximity_alerts)
+        {
+            LoadViolationSites();
+        }
+
+        // After the pool, which seals the earlier segments.
+        if (g_ctx.setting_capture_history)
+        {
+            OpenCaptureHistory();
+        }
+
         // --- Optional API Initialization & Callback Registration (Uncomment if needed) ---
         // Remember to also uncomment the relevant #include directives in SPF_RedLightCamera.hpp
         // and add corresponding members to the PluginContext struct.
 
-        /*
-        // Keybinds API
-        // Requires: SPF_KeyBinds_API.h
-        */
+        // Keybinds API: manual capture and violation export (see OnManualCaptureKey, OnViolationExportKey).
+        if (g_ctx.coreAPI && g_ctx.coreAPI->keybinds)
+        {
+            g_ctx.keybindsHandle = g_ctx.coreAPI->keybinds->Kbind_GetContext(PLUGIN_NAME);
+            if (g_ctx.keybindsHandle)
+            {
+                g_ctx.coreAPI->keybinds->Kbind_Register(g_ctx.keybindsHandle, MANUAL_CAPTURE_ACTION, OnManualCaptureKey);
+                g_ctx.coreAPI->keybinds->Kbind_Register(g_ctx.keybindsHandle, VIOLATION_EXPORT_ACTION, OnViolationExportKey);
+            }
+        }
 
-        /*
-        // Game Log API
-        // Requires: SPF_GameLog_API.h
-        */
+        // Game Log API: confirms that screenshots were written (see ProcessScreenshotLog).
+        if (g_ctx.coreAPI && g_ctx.coreAPI->gamelog)
+        {
+            g_ctx.gameLogHandle = g_ctx.coreAPI->gamelog->GLog_GetContext(PLUGIN_NAME);
+            if (g_ctx.gameLogHandle)
+            {
+                g_ctx.gameLogCallbackHandle = g_ctx.coreAPI->gamelog->GLog_RegisterCallback(g_ctx.gameLogHandle, OnGameLogMessage, &g_ctx);
+            }
+        }
 
         /*
         // Telemetry API
@@ -263,152 +541,70 @@ namespace SPF_RedLightCamera
 
     void OnUpdate()
     {
-        if (!g_ctx.sequence_active)
+        // Close the previous frame's accounting (OnUpdate + draw callbacks) before measuring this one.
+        const bool overrun = g_ctx.governor.BeginFrame();
+        if (g_ctx.governor.GetFrameCount() > 1)
         {
-            return;
+            g_ctx.metrics.RecordFrameCost(g_ctx.governor.GetLastFrameMicros(), overrun, g_ctx.governor.GetBudgetMicros());
+            g_ctx.stats.RecordFrameCost(g_ctx.governor.GetLastFrameMicros());
         }
-
-        g_ctx.sequence_frame_counter++;
-
-        switch (g_ctx.sequence_frame_counter)
+        if (overrun && g_ctx.loggerHandle && g_ctx.formattingAPI)
         {
-        case 1:
-            // --- Frame 1: Save original camera state and position new camera ---
-            // 1. Save the current camera type
-            if (g_ctx.cameraAPI && g_ctx.cameraAPI->Cam_GetCurrentCamera)
-            {
-                g_ctx.cameraAPI->Cam_GetCurrentCamera(&g_ctx.originalCameraType);
-            }
-            else
-            {
-                // Log an error if Camera API is not available or GetCurrentCamera is NULL.
-                if (g_ctx.loggerHandle)
-                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "OnUpdate (Frame 1): Camera API or GetCurrentCamera function is not available.");
-                g_ctx.sequence_active = false; // Abort sequence if we can't get current camera.
-                return;
-            }
+            char log_buffer[160];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Frame budget exceeded: %u us (budget %u us, %llu overruns).",
+                                            g_ctx.governor.GetLastFrameMicros(), g_ctx.governor.GetBudgetMicros(), (unsigned long long)g_ctx.governor.GetOverrunCount());
+            g_ctx.loadAPI->logger->LogThrottled(g_ctx.loggerHandle, SPF_LOG_WARN, "redlightcamera.frame_budget", 5000, log_buffer);
+        }
 
-            // 2. Save Yaw and Pitch ONLY for SPF_CAMERA_INTERIOR.
-            if (g_ctx.originalCameraType == SPF_CAMERA_INTERIOR)
-            {
-                if (g_ctx.cameraAPI->Cam_GetInteriorHeadRot)
-                {
-                    g_ctx.cameraAPI->Cam_GetInteriorHeadRot(&g_ctx.originalYaw, &g_ctx.originalPitch);
-                    if (g_ctx.loggerHandle)
-                        g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, "OnUpdate (Frame 1): Saved Interior camera Yaw/Pitch.");
-                }
-                else
-                {
-                    if (g_ctx.loggerHandle)
-                        g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "OnUpdate (Frame 1): GetInteriorHeadRot is NULL, cannot save Interior camera orientation.");
-                }
-            }
-            else
-            {
-                // For other camera types, we are not saving orientation.
-                if (g_ctx.loggerHandle)
-                {
-                    char log_buffer[128];
-                    g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "OnUpdate (Frame 1): Original came type %d, orientation not saved for restoration.", g_ctx.originalCameraType);
-                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
-                }
-            }
-            g_ctx.flash_alpha = 1.0f;
-            // 3. Position and orient the red light camera. This function will switch to SPF_CAMERA_DEVELOPER_FREE internally.
-            PositionAndOrientRedLightCamera();
+        {
+            FrameBudgetGovernor::Scope frame_scope(g_ctx.governor);
 
-            break;
-        case 2:
-            // --- Frame 2: Take a uniquely named screenshot ---
-            if (g_ctx.gameConsoleAPI && g_ctx.coreAPI && g_ctx.coreAPI->telemetry && g_ctx.telemetryHandle && g_ctx.formattingAPI)
+            // Append this frame's telemetry to the recording before any capture logic runs,
+            // so a replay sees exactly the data the sequence below was driven by.
+            if (g_ctx.recorder.IsOpen() && g_ctx.coreAPI && g_ctx.coreAPI->telemetry && g_ctx.telemetryHandle)
             {
-                // 1. Get current truck and time data for the filename.
                 SPF_TruckData truck_data;
                 g_ctx.coreAPI->telemetry->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
 
                 SPF_Timestamps timestamps;
                 g_ctx.coreAPI->telemetry->Tel_GetTimestamps(g_ctx.telemetryHandle, &timestamps, sizeof(SPF_Timestamps));
 
-                const auto &world_pos = truck_data.world_placement.position;
-                const uint64_t sim_time = timestamps.simulation;
-
-                // 2. Format the command string to create a unique filename.
-                // Format: "screenshot red_light_X<coord>_Y<coord>_Z<coord>_T<time>"
-                char command_buffer[256];
-                g_ctx.formattingAPI->Fmt_Format(
-                    command_buffer,
-                    sizeof(command_buffer),
-                    "screenshot red_light_X%d_Y%d_Z%d_T%llu",
-                    (int)world_pos.x,
-                    (int)world_pos.y,
-                    (int)world_pos.z,
-                    sim_time);
-
-                // 3. Execute the command via the game console.
-                g_ctx.gameConsoleAPI->GCon_ExecuteCommand(command_buffer);
-
-                // 4. Log the action for debugging.
-                if (g_ctx.loggerHandle)
+                g_ctx.recorder.WriteFrame(truck_data, timestamps);
+                if (g_ctx.governor.GetFrameCount() % RECORDING_FLUSH_INTERVAL_FRAMES == 0)
                 {
-                    char log_buffer[512];
-                    g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "OnUpdate (Frame 2): Executed nd: %s", command_buffer);
-                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+                    g_ctx.governor.Defer(DeferredTask::FlushRecording);
                 }
             }
-            break;
-        case 3:
-            // --- Frame 3: Restore the original camera and end the sequence ---
-            if (g_ctx.cameraAPI)
+
+            // Hand results of finished background jobs back to the plugin state (see WorkerPool.hpp).
+            g_ctx.workers.DrainCompletions(WORKER_COMPLETIONS_PER_FRAME);
+
+            g_ctx.is_screenshot_frame = false;
+            AdvanceCaptureSequence();
+            UpdateFlash();
+            if (g_ctx.capture.HasPending() && !g_ctx.capture.IsActive())
             {
-                // 1. Switch back to the camera type that was active before the sequence started.
-                g_ctx.cameraAPI->Cam_SwitchTo(g_ctx.originalCameraType);
-                break;
-            case 4:
-                g_ctx.flash_alpha = 0.7f;
-                break;
-            case 5:
-                // 2. If the original camera was an interior camera, restore its saved Yaw and Pitch.
-                if (g_ctx.originalCameraType == SPF_CAMERA_INTERIOR)
-                {
-                    if (g_ctx.cameraAPI->Cam_SetInteriorHeadRot)
-                    {
-                        g_ctx.cameraAPI->Cam_SetInteriorHeadRot(g_ctx.originalYaw, g_ctx.originalPitch);
-                    }
-                }
+                StartCaptureSequence(nullptr);
             }
-            else
+            ProcessScreenshotLog();
+            UpdateTrafficWatch();
+            UpdateProximityAlert();
+            SampleCaptureHistory();
+            if (IsTrafficFramingActive() && g_ctx.coreAPI && g_ctx.coreAPI->vehicle)
             {
-                if (g_ctx.loggerHandle)
-                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "OnUpdate  (Frame 3): Camera API not available, cannot restore camera.");
+                const TrafficWatchRules &rules = g_ctx.traffic_watch.GetRules();
+                g_ctx.traffic_index.Update(g_ctx.coreAPI->vehicle, rules.vehicles_per_frame, rules.budget_us);
             }
-            g_ctx.flash_alpha = 0.5f;
-            break;
-        case 6:
-            g_ctx.flash_alpha = 0.3f;
-            break;
-        default:
-        {
-            // --- Frame 4 / Default: Clean up and end sequence ---
 
-            // Hide the flash window.
-            if (g_ctx.uiAPI && g_ctx.flash_window_handle)
+            if (g_ctx.metrics.IsShared())
             {
-                g_ctx.uiAPI->UI_SetVisibility(g_ctx.flash_window_handle, false);
+                g_ctx.governor.Defer(DeferredTask::PublishMetrics);
             }
+        }
 
-            // Reset all state flags and counters.
-            g_ctx.is_flash_active = false;
-            g_ctx.flash_alpha = 0.0f;
-            g_ctx.sequence_active = false;
-            g_ctx.sequence_frame_counter = 0;
+        // Optional work runs outside the measured scope, and only while this frame has headroom.
+        g_ctx.governor.RunDeferred();
 
-            if (g_ctx.loggerHandle)
-            {
-                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, "Sequence finished.");
-            }
-            break;
-        }
-        }
         // This function is called every frame while the plugin is active.
         // Avoid performing heavy or blocking operations here, as it will directly impact game performance.
 
@@ -427,49 +623,371 @@ namespace SPF_RedLightCamera
         */
     }
 
-    void OnUnload()
+    void AdvanceCaptureSequence()
     {
-        // Perform cleanup. Nullify cached API pointers to prevent use-after-free
-        // and ensure a clean shutdown. This is the last chance for cleanup.
+        // The core sequence decides what this frame does; this function carries it out.
+        const CaptureStep step = g_ctx.capture.Advance();
 
-        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI)
+        switch (step)
         {
-            char log_buffer[256];
-            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "%s is being unloaded.", PLUGIN_NAME);
-            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        case CaptureStep::Idle:
+            return;
+        case CaptureStep::CinematicSetup:
+        case CaptureStep::CinematicPlayback:
+            AdvanceCinematicSequence();
+            return;
+        case CaptureStep::SnapshotAndPose:
+            // --- Frame 1: Save original camera state and position new camera ---
+            // 1. Snapshot the player's whole camera setup, so frame 3 can restore it in one go.
+            if (!g_ctx.original_camera.Capture(g_ctx.cameraAPI))
+            {
+                // Log an error if Camera API is not available or GetCurrentCamera is NULL.
+                if (g_ctx.loggerHandle)
+                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "OnUpdate (Frame 1): Camera API or GetCurrentCamera function is not available.");
+                g_ctx.capture.Finish(); // Abort sequence if we can't get current camera.
+                g_ctx.capture_attempt = 0;
+                g_ctx.is_manual_capture = false;
+                g_ctx.capture_preset = -1;
+                g_ctx.metrics.RecordCaptureDropped();
+                g_ctx.metrics.SetQueueDepth(0);
+                return;
+            }
+            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+            {
+                char log_buffer[128];
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "OnUpdate (Frame 1): Saved camera type %d (fields 0x%x).",
+                                                (int)g_ctx.original_camera.type, g_ctx.original_camera.captured);
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+            }
+            // 2. Position and orient the red light camera. This function will switch to SPF_CAMERA_DEVELOPER_FREE internally.
+            //    A manual capture uses the pose armed by the last truck data update instead.
+            if (g_ctx.is_manual_capture && g_ctx.is_pose_armed)
+            {
+                ApplyRigPose(g_ctx.armed_pose);
+            }
+            else
+            {
+                PositionAndOrientRedLightCamera();
+            }
+            RecordCapturePhase(CapturePhase::Posed);
+            break;
+        case CaptureStep::Screenshot:
+            // --- Frame 2: Take a uniquely named screenshot ---
+            ExecuteCaptureScreenshot(-1);
+            break;
+        case CaptureStep::Restore:
+            // --- Frame 3: Restore the original camera, all of it in this frame ---
+            if (g_ctx.cameraAPI)
+            {
+                g_ctx.original_camera.Restore(g_ctx.cameraAPI);
+                RecordCapturePhase(CapturePhase::Restored);
+            }
+            else
+            {
+                if (g_ctx.loggerHandle)
+                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "OnUpdate  (Frame 3): Camera API not available, cannot restore camera.");
+            }
+            break;
+        case CaptureStep::Fade:
+            break;
+        case CaptureStep::Finish:
+            // --- Frame 7: Clean up and end sequence ---
+            FinishCaptureSequence();
+            return;
         }
+    }
 
-        // --- Optional API Cleanup (Uncomment if needed) ---
-        // Example: Unregistering keybinds (often handled by framework, but good practice if explicitly registered).
-        // Requires: SPF_KeyBinds_API.h
+    void AdvanceCinematicSequence()
+    {
+        const auto camera = g_ctx.cameraAPI;
 
-        // Nullify all cached API pointers and handles.
-        g_ctx.coreAPI = nullptr;
-        g_ctx.loadAPI = nullptr;
-        g_ctx.loggerHandle = nullptr;
-        g_ctx.formattingAPI = nullptr;
+        if (g_ctx.capture.GetFrame() == 1)
+        {
+            // --- Frame 1: Build the fly-by and start playback ---
+            if (!camera || !camera->Cam_GetCurrentCamera || !camera->Cam_ClearAllStatesInMemory || !camera->Cam_AddStateInMemory ||
+                !camera->Cam_Anim_Play || !g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle)
+            {
+                if (g_ctx.loggerHandle)
+                    g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "AdvanceCinematicSequence: Camera animation API not available, falling back to a single still.");
+                g_ctx.capture.DowngradeToStandard();
+                AdvanceCaptureSequence();
+                return;
+            }
 
-        // --- Optional Handles (Nullify if used) ---
-        // g_ctx.configHandle = nullptr;
-        g_ctx.localizationHandle = nullptr;
-        // g_ctx.keybindsHandle = nullptr;
-        g_ctx.uiAPI = nullptr;
+            g_ctx.original_camera.Capture(camera);
+            if (g_ctx.original_camera.type != SPF_CAMERA_DEVELOPER_FREE)
+            {
+                camera->Cam_SwitchTo(SPF_CAMERA_DEVELOPER_FREE);
+            }
+
+            SPF_TruckData truck_data;
+            g_ctx.coreAPI->telemetry->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
+
+            double origin_x = 0.0, origin_z = 0.0;
+            GetLocalGridOrigin(origin_x, origin_z);
+
+            CinematicParams params;
+            params.distance = g_ctx.setting_distance_forward;
+            params.height = g_ctx.setting_height_above;
+            params.sweep_deg = g_ctx.setting_cinematic_sweep;
+            params.fov = g_ctx.setting_field_of_view;
+            params.keyframes = g_ctx.setting_cinematic_keyframes > 0 ? (size_t)g_ctx.setting_cinematic_keyframes : 2;
+            // Keep whatever the engine stores in internal_value for the user's own states.
+            if (camera->Cam_GetStateCount && camera->Cam_GetState && camera->Cam_GetStateCount() > 0)
+            {
+                SPF_CameraState_t existing;
+                if (camera->Cam_GetState(0, &existing))
+                {
+                    params.internal_value = existing.internal_value;
+                }
+            }
+
+            g_ctx.cinematic_keyframe_count = GenerateFlyByKeyframes(truck_data.world_placement.position, truck_data.world_placement.orientation.heading,
+                                                                    origin_x, origin_z, params, g_ctx.cinematic_keyframes);
+            g_ctx.cinematic_shot_count = g_ctx.setting_cinematic_shots > 0 ? g_ctx.setting_cinematic_shots : 1;
+            g_ctx.cinematic_shots_taken = 0;
+
+            camera->Cam_ClearAllStatesInMemory();
+            for (size_t i = 0; i < g_ctx.cinematic_keyframe_count; ++i)
+            {
+                camera->Cam_AddStateInMemory(&g_ctx.cinematic_keyframes[i]);
+            }
+            camera->Cam_Anim_Play(0);
+
+            // No flash during the fly-by: it would be drawn into the shots.
+            HideFlash();
+            RecordCapturePhase(CapturePhase::Posed);
+
+            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+            {
+                char log_buffer[256];
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Cinematic fly-by: %u keyframes over %.0f deg, %d shots.",
+                                                (unsigned)g_ctx.cinematic_keyframe_count, g_ctx.setting_cinematic_sweep, g_ctx.cinematic_shot_count);
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+            }
+            return;
+        }
+
+        // --- Playback: screenshot each time the path parameter passes the next shot ---
+        const bool playing = camera->Cam_Anim_GetPlaybackState && camera->Cam_Anim_GetPlaybackState() == SPF_ANIM_PLAYING;
+        float path_position = 1.0f;
+        if (playing && camera->Cam_Anim_GetCurrentFrame && camera->Cam_Anim_GetCurrentFrameProgress)
+        {
+            const float segments = (float)(g_ctx.cinematic_keyframe_count - 1);
+            path_position = ((float)camera->Cam_Anim_GetCurrentFrame() + camera->Cam_Anim_GetCurrentFrameProgress()) / segments;
+        }
+
+        const bool timed_out = g_ctx.capture.GetFrame() > CINEMATIC_TIMEOUT_FRAMES;
+        if (g_ctx.cinematic_shots_taken < g_ctx.cinematic_shot_count && !timed_out)
+        {
+            const int32_t shot = g_ctx.cinematic_shots_taken;
+            const float target = CinematicShotPosition(shot, g_ctx.cinematic_shot_count);
+
+            // One screenshot per frame at most. Once playback has ended the remaining shots are
+            // taken at the final pose rather than dropped.
+            if (path_position >= target)
+            {
+                ExecuteCaptureScreenshot(shot);
+                g_ctx.cinematic_shots_taken++;
+            }
+            return;
+        }
+
+        // --- All shots taken: restore the user's camera states and camera ---
+        if (camera->Cam_Anim_Stop)
+        {
+            camera->Cam_Anim_Stop();
+        }
+        if (camera->Cam_ReloadStatesFromFile)
+        {
+            camera->Cam_ReloadStatesFromFile();
+        }
+        g_ctx.original_camera.Restore(camera);
+        RecordCapturePhase(CapturePhase::Restored);
+
+        if (timed_out && g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "Cinematic fly-by: playback did not reach every shot in time, sequence cut short.");
+        }
+        FinishCaptureSequence();
+    }
+
+    bool ExecuteCaptureScreenshot(int32_t shot)
+    {
+        if (!g_ctx.gameConsoleAPI || !g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle)
+        {
+            return false;
+        }
+
+        // 1. Get current truck and time data for the filename. A manual capture names the shot
+        //    after the armed snapshot, which is at most one telemetry update old.
+        SPF_DVector world_pos = g_ctx.armed_truck_position;
+        uint64_t sim_time = g_ctx.armed_simulation_time;
+        const bool manual = g_ctx.is_manual_capture && g_ctx.is_pose_armed;
+        if (!manual)
+        {
+            SPF_TruckData truck_data;
+            g_ctx.coreAPI->telemetry->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
+
+            SPF_Timestamps timestamps;
+            g_ctx.coreAPI->telemetry->Tel_GetTimestamps(g_ctx.telemetryHandle, &timestamps, sizeof(SPF_Timestamps));
+
+            world_pos = truck_data.world_placement.position;
+            sim_time = timestamps.simulation;
+        }
+
+        // 2. Format the command string to create a unique filename (see CaptureNaming.hpp).
+        char command_buffer[256];
+        if (FormatScreenshotCommand(command_buffer, sizeof(command_buffer), g_ctx.capture.GetLabel(), world_pos, sim_time, shot) == 0)
+        {
+            return false;
+        }
+
+        // 3. Execute the command via the game console. Only the first shot counts towards latency.
+        //    The game log later reports whether the file was written (see ProcessScreenshotLog).
+        g_ctx.gameConsoleAPI->GCon_ExecuteCommand(command_buffer);
+        g_ctx.is_screenshot_frame = true;
+        g_ctx.screenshots.Track(ScreenshotNameOf(command_buffer), g_ctx.capture.GetLabel(), g_ctx.capture_attempt, NowMicros(), world_pos);
+        if (g_ctx.capture_dedup_id != 0)
+        {
+            g_ctx.dedup.SetName(g_ctx.capture_dedup_id, ScreenshotNameOf(command_buffer));
+        }
+        if (g_ctx.journal.IsOpen())
+        {
+            JournalScreenshot record{};
+            record.simulation_time = sim_time;
+            record.x = world_pos.x;
+            record.y = world_pos.y;
+            record.z = world_pos.z;
+            record.shot = shot;
+            record.attempt = g_ctx.capture_attempt;
+            CopyJournalString(record.label, sizeof(record.label), g_ctx.capture.GetLabel());
+            CopyJournalString(record.name, sizeof(record.name), ScreenshotNameOf(command_buffer));
+            AppendCaptureJournal(JournalRecordType::Screenshot, &record, sizeof(record));
+
+            // Names the screenshot of the fine that started or queued this capture (see ViolationExport.hpp).
+            if (g_ctx.capture_dedup_id != 0 && shot <= 0)
+            {
+                JournalCaptureNamed named{};
+                named.capture_id = g_ctx.capture_dedup_id;
+                CopyJournalString(named.name, sizeof(named.name), ScreenshotNameOf(command_buffer));
+                AppendCaptureJournal(JournalRecordType::CaptureNamed, &named, sizeof(named));
+            }
+        }
+        if (shot <= 0)
+        {
+            RecordCapturePhase(CapturePhase::Screenshot);
+        }
+        if (g_ctx.is_manual_capture && shot <= 0)
+        {
+            // Microseconds go to the metrics; the log counts frames so replays stay deterministic.
+            const uint64_t latency_us = NowMicros() - g_ctx.manual_key_at_us;
+            g_ctx.metrics.RecordManualCapture(latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)latency_us);
+            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+            {
+                char log_buffer[160];
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Manual capture: screenshot issued on update %llu after the key press%s.",
+                                                (unsigned long long)(g_ctx.governor.GetFrameCount() - g_ctx.manual_key_frame), manual ? "" : " (pose not armed, fetched telemetry)");
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+            }
+        }
+
+        // 4. Log the action for debugging.
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[512];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Capture: Executed command: %s", command_buffer);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+        return true;
+    }
+
+    void FinishCaptureSequence()
+    {
+        // Reset all state flags and counters. The flash is left to UpdateFlash.
+        g_ctx.capture.Finish();
+        g_ctx.capture_attempt = 0;
+        g_ctx.capture_dedup_id = 0;
+        g_ctx.is_manual_capture = false;
+        g_ctx.capture_preset = -1;
+
+        RecordCapturePhase(CapturePhase::Finished);
+        g_ctx.metrics.RecordCaptureCompleted();
+        g_ctx.metrics.SetQueueDepth(0);
+
+        if (g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, "Sequence finished.");
+        }
+    }
+
+    void OnUnload()
+    {
+        // Perform cleanup. Nullify cached API pointers to prevent use-after-free
+        // and ensure a clean shutdown. This is the last chance for cleanup.
+
+        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[256];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "%s is being unloaded.", PLUGIN_NAME);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+
+        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[256];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Frame budget: %llu overruns in %llu frames (budget %u us).",
+                                            (unsigned long long)g_ctx.governor.GetOverrunCount(), (unsigned long long)g_ctx.governor.GetFrameCount(),
+                                            g_ctx.governor.GetBudgetMicros());
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+
+        // Join the pool first: its last completions may still write recordings or metrics, and a
+        // maintenance run may be in flight. The closed history's last segment is sealed here after.
+        CloseCaptureHistory();
+        StopWorkerPool();
+        FinishHistoryMaintenance();
+        StopTelemetryRecording();
+        StopMetricsPublishing();
+        CloseViolationHeatmap();
+        CloseCaptureJournal();
+
+        // --- Optional API Cleanup (Uncomment if needed) ---
+        // Unregister the manual capture keybind (the framework would also clean it up).
+        if (g_ctx.coreAPI && g_ctx.coreAPI->keybinds && g_ctx.keybindsHandle)
+        {
+            g_ctx.coreAPI->keybinds->Kbind_UnregisterAll(g_ctx.keybindsHandle);
+        }
+
+        // Nullify all cached API pointers and handles.
+        g_ctx.coreAPI = nullptr;
+        g_ctx.loadAPI = nullptr;
+        g_ctx.loggerHandle = nullptr;
+        g_ctx.formattingAPI = nullptr;
+
+        // --- Optional Handles (Nullify if used) ---
+        // g_ctx.configHandle = nullptr;
+        g_ctx.localizationHandle = nullptr;
+        g_ctx.keybindsHandle = nullptr;
+        g_ctx.uiAPI = nullptr;
         // g_ctx.mainWindowHandle = nullptr;
         // g_ctx.telemetryHandle = nullptr;
         // g_ctx.hooksAPI = nullptr;
         // g_ctx.gameConsoleAPI = nullptr;
         // g_ctx.virtualDeviceHandle = nullptr;
         // g_ctx.cameraAPI = nullptr;
-        // g_ctx.gameLogCallbackHandle = nullptr;
+        g_ctx.gameLogCallbackHandle = nullptr;
+        g_ctx.gameLogHandle = nullptr;
+        g_ctx.environmentHandle = nullptr;
         //
         // // Telemetry Subscriptions (Nullify if used)
         // g_ctx.gameStateSubscription = nullptr;
-        // g_ctx.timestampsSubscription = nullptr;
+        g_ctx.timestampsSubscription = nullptr;
         // g_ctx.commonDataSubscription = nullptr;
-        // g_ctx.truckConstantsSubscription = nullptr;
-        // g_ctx.trailerConstantsSubscription = nullptr;
-        // g_ctx.truckDataSubscription = nullptr;
-        // g_ctx.trailersSubscription = nullptr;
+        g_ctx.truckConstantsSubscription = nullptr;
+        g_ctx.trailerConstantsSubscription = nullptr;
+        g_ctx.truckDataSubscription = nullptr;
+        g_ctx.trailersSubscription = nullptr;
         // g_ctx.jobConstantsSubscription = nullptr;
         // g_ctx.jobDataSubscription = nullptr;
         // g_ctx.navigationDataSubscription = nullptr;
@@ -487,24 +1005,38 @@ namespace SPF_RedLightCamera
     // in OnActivated or OnRegisterUI as appropriate.
 
     void OnSettingChanged(SPF_Config_Handle* config_handle, const char* keyPath) {
-        // A setting has changed. Check the keyPath and use the config_handle
-        // with the Config API to get the new value.
+        // A setting has changed. Look it up in the settings schema, store the new value in its
+        // PluginContext field and run the setting's change handler.
         if (!g_ctx.loadAPI || !g_ctx.loadAPI->config) {
             if (g_ctx.loggerHandle) g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "OnSettingChanged: LoadAPI or Config API not available.");
             return;
         }
-        const auto config = g_ctx.loadAPI->config; 
-    
-        if (strcmp(keyPath, "settings.distance_forward") == 0) {
-            g_ctx.setting_distance_forward = config->Cfg_GetFloat(config_handle, keyPath, 25.0f);
-        } else if (strcmp(keyPath, "settings.height_above") == 0) {
-            g_ctx.setting_height_above = config->Cfg_GetFloat(config_handle, keyPath, 4.0f);
-        } else if (strcmp(keyPath, "settings.field_of_view") == 0) {
-            g_ctx.setting_field_of_view = config->Cfg_GetFloat(config_handle, keyPath, 70.0f);
+
+        // Structured settings: re-parse only what changed, never on the capture path.
+        size_t preset_index = 0;
+        if (IsRigPresetKey(keyPath, preset_index)) {
+            if (preset_index == SIZE_MAX) {
+                LoadRigPresetConfig();
+            } else {
+                const RigPresetSource source{g_ctx.loadAPI->config, config_handle, g_ctx.coreAPI ? g_ctx.coreAPI->json_reader : nullptr};
+                ReloadRigPreset(source, preset_index, g_ctx.rig_presets);
+            }
+            OnRigSettingChanged();
+            return;
+        }
+        if (IsOffencePresetKey(keyPath)) {
+            LoadRigPresetConfig();
+            return;
+        }
+
+        const SettingDescriptor *setting = FindSetting(keyPath);
+        if (!setting) {
+            return; // Not one of ours (e.g. a framework system setting).
+        }
+        ReadSetting(g_ctx.loadAPI->config, config_handle, *setting);
+        if (setting->on_change) {
+            setting->on_change();
         }
-    
-        // Live Preview: Call PositionAndOrientRedLightCamera to immediately apply changes
-        PositionAndOrientRedLightCamera();
     }
 
     /*
@@ -517,6 +1049,8 @@ namespace SPF_RedLightCamera
         {
             // 1. Register the drawing function, passing nullptr because g_ctx is global.
             ui_api->UI_RegisterDrawCallback(PLUGIN_NAME, "FlashWindow", RenderFlashWindow, nullptr);
+            ui_api->UI_RegisterDrawCallback(PLUGIN_NAME, "StatsWindow", RenderStatsWindow, nullptr);
+            ui_api->UI_RegisterDrawCallback(PLUGIN_NAME, "HeatmapWindow", RenderHeatmapWindow, nullptr);
 
             // 2. Get and store the window handle so we can control it later.
             g_ctx.flash_window_handle = ui_api->UI_GetWindowHandle(PLUGIN_NAME, "FlashWindow");
@@ -529,17 +1063,51 @@ namespace SPF_RedLightCamera
     // This function name should match what you passed to RegisterDrawCallback.
     */
 
-    /*
-    // --- OnKeybindAction Callback ---
-    // Requires: SPF_KeyBinds_API.h
-    // This function name should match what you passed to SPF_KeyBinds_API.Register.
-    */
+    // --- OnManualCaptureKey Callback ---
+    // Registered for MANUAL_CAPTURE_ACTION in OnActivated.
+    void OnManualCaptureKey()
+    {
+        const uint64_t pressed_at = NowMicros();
+        if (!g_ctx.capture.Start(CaptureSequence::MANUAL_LABEL, false))
+        {
+            g_ctx.metrics.RecordManualCaptureIgnored();
+            if (g_ctx.loggerHandle)
+            {
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "Manual capture ignored: a capture is already in progress.");
+            }
+            return;
+        }
 
-    /*
-    // --- OnGameLogMessage Callback ---
-    // Requires: SPF_GameLog_API.h
-    // This function name should match what you passed to SPF_GameLog_API.RegisterCallback.
-    */
+        g_ctx.is_manual_capture = true;
+        g_ctx.manual_key_at_us = pressed_at;
+        g_ctx.manual_key_frame = g_ctx.governor.GetFrameCount();
+        BeginCaptureSequence();
+        if (g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, "Manual capture key pressed. Starting sequence.");
+        }
+    }
+
+    void OnViolationExportKey()
+    {
+        RequestViolationExport();
+        RequestTrackExport();
+    }
+
+    void OnGameLogMessage(const char *log_line, void *user_data)
+    {
+        (void)user_data;
+        // Every line the game logs passes through here: one table walk, no allocation, no locks.
+        const uint8_t flags = log_line ? g_ctx.screenshot_log_matcher.Classify(log_line) : 0;
+        if (flags == 0)
+        {
+            return;
+        }
+
+        ScreenshotLogLine line;
+        line.Assign(log_line, flags, NowMicros());
+        g_ctx.screenshot_log_lines.Push(line); // If full, the screenshot times out instead.
+    }
 
     /*
     // --- OnGameWorldReady Callback ---
@@ -585,14 +1153,15 @@ namespace SPF_RedLightCamera
     }
     */
 
-    /*
-    void OnTimestamps(const SPF_Timestamps* data, void* user_data) {
-        // if (!data || !user_data) return;
-        // SPF_RedLightCamera::PluginContext* ctx = reinterpret_cast<SPF_RedLightCamera::PluginContext*>(user_data);
-        // // Example: Cache the latest timestamp data
-        // // ctx->telemetryDataCache.timestamps = *data;
+    void OnTimestamps(const SPF_Timestamps *data, void *user_data)
+    {
+        if (!data || !user_data)
+        {
+            return;
+        }
+        g_ctx.armed_simulation_time = data->simulation;
+        g_ctx.render_time_us = data->render;
     }
-    */
 
     /*
     void OnCommonData(const SPF_CommonData* data, void* user_data) {
@@ -603,46 +1172,58 @@ namespace SPF_RedLightCamera
     }
     */
 
-    /*
-    void OnTruckConstants(const SPF_TruckConstants* data, void* user_data) {
-        // if (!data || !user_data) return;
-        // SPF_RedLightCamera::PluginContext* ctx = reinterpret_cast<SPF_RedLightCamera::PluginContext*>(user_data);
-        // // Example: Cache the latest truck constants
-        // // ctx->telemetryDataCache.truckConstants = *data;
+    // The constants only arrive when they change; the framing box is rebuilt lazily on next use.
+    void OnTruckConstants(const SPF_TruckConstants *data, void *user_data)
+    {
+        if (!data || !user_data)
+        {
+            return;
+        }
+        g_ctx.auto_framer.Invalidate();
     }
-    */
 
-    /*
-    void OnTrailerConstants(const SPF_TrailerConstants* data, void* user_data) {
-        // if (!data || !user_data) return;
-        // SPF_RedLightCamera::PluginContext* ctx = reinterpret_cast<SPF_RedLightCamera::PluginContext*>(user_data);
-        // // Example: Cache the latest trailer constants
-        // // ctx->telemetryDataCache.trailerConstants = *data;
+    void OnTrailerConstants(const SPF_TrailerConstants *data, void *user_data)
+    {
+        if (!data || !user_data)
+        {
+            return;
+        }
+        g_ctx.auto_framer.Invalidate();
     }
-    */
 
-    /*
-    void OnTruckData(const SPF_TruckData* data, void* user_data) {
-        // if (!data || !user_data) return;
-        // SPF_RedLightCamera::PluginContext* ctx = reinterpret_cast<SPF_RedLightCamera::PluginContext*>(user_data);
-        // // Example: Cache the latest truck data
-        // // ctx->telemetryDataCache.truckData = *data;
+    void OnTruckData(const SPF_TruckData *data, void *user_data)
+    {
+        if (!data || !user_data)
+        {
+            return;
+        }
+
+        // Re-arm the manual capture: all the maths happens here, once per update, so the key press
+        // only has to move the camera. The pose follows the current rig settings and traffic.
+        g_ctx.armed_truck_position = data->world_placement.position;
+        const RigPreset *preset = g_ctx.rig_presets.Get(g_ctx.manual_preset);
+        g_ctx.armed_pose = preset ? ComputePresetPose(data->world_placement.position, data->world_placement.orientation.heading, *preset)
+                                  : ComputeRigPose(data->world_placement.position, data->world_placement.orientation.heading,
+                                                   g_ctx.setting_distance_forward, g_ctx.setting_height_above, g_ctx.setting_field_of_view);
+        FitRigToCombination(g_ctx.armed_pose, data->world_placement.position, data->world_placement.orientation.heading, RigOffset(preset));
+        if (IsTrafficFramingActive())
+        {
+            WidenRigForTraffic(g_ctx.armed_pose);
+        }
+        g_ctx.is_pose_armed = true;
     }
-    */
 
-    /*
-    void OnTrailers(const SPF_Trailer* trailers, uint32_t count, void* user_data) {
-        // if (!user_data) return;
-        // SPF_RedLightCamera::PluginContext* ctx = reinterpret_cast<SPF_RedLightCamera::PluginContext*>(user_data);
-        // // Example: Cache the latest trailers data
-        // // ctx->telemetryDataCache.trailers.clear();
-        // // if (trailers && count > 0) {
-        // //     for (uint32_t i = 0; i < count; ++i) {
-        // //         ctx->telemetryDataCache.trailers.push_back(trailers[i]);
-        // //     }
-        // // }
+    // Delivered every update; only a coupled or dropped trailer matters to the framing box.
+    void OnTrailers(const SPF_Trailer *trailers, uint32_t count, void *user_data)
+    {
+        (void)trailers;
+        if (!user_data || count == g_ctx.framed_trailer_count)
+        {
+            return;
+        }
+        g_ctx.framed_trailer_count = count;
+        g_ctx.auto_framer.Invalidate();
     }
-    */
 
     /*
     void OnJobConstants(const SPF_JobConstants* data, void* user_data) {
@@ -696,28 +1277,73 @@ namespace SPF_RedLightCamera
             return;
         }
 
+        if (g_ctx.recorder.IsOpen())
+        {
+            g_ctx.recorder.WriteEvent(event_id, data);
+        }
+
         if (strcmp(event_id, "player.fined") == 0)
         {
-            if (strcmp(data->player_fined.fine_offence, "red_signal") == 0)
+            const char *offence = data->player_fined.fine_offence;
+            g_ctx.metrics.RecordFine(offence);
+
+            // Where and when the fine happened (kept current by the telemetry subscriptions), for
+            // folding repeats at one junction into the capture that already covers them.
+            const SPF_DVector position = g_ctx.armed_truck_position;
+            const uint64_t simulation_time = g_ctx.armed_simulation_time;
+            const bool red_light = strcmp(offence, CaptureSequence::RED_LIGHT_OFFENCE) == 0;
+            if (red_light && g_ctx.heatmap.IsOpen())
+            {
+                g_ctx.heatmap.Add(position.x, position.z);
+            }
+            if (g_ctx.history.IsOpen())
+            {
+                AppendCaptureHistory(red_light ? HistoryKind::RedLightFine : HistoryKind::OtherFine);
+            }
+            if (red_light && g_ctx.dedup.IsEnabled())
             {
-                if (g_ctx.sequence_active)
+                DedupHit hit;
+                if (g_ctx.dedup.Attach(position.x, position.z, simulation_time, hit))
                 {
+                    g_ctx.metrics.RecordCaptureDeduplicated();
+                    if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+                    {
+                        char log_buffer[256];
+                        g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Repeated red signal fine attached to capture #%u (%s), %u attached, %llu suppressed in total.",
+                                                        hit.capture_id, hit.name[0] ? hit.name : "screenshot pending", hit.attached,
+                                                        (unsigned long long)g_ctx.dedup.GetSuppressed());
+                        g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+                    }
+                    AppendFineJournal(data->player_fined, position, simulation_time, JournalFineCapture::Attached, hit.capture_id);
                     return;
                 }
+            }
 
+            switch (g_ctx.capture.OnFine(offence, g_ctx.setting_cinematic_capture))
+            {
+            case FineOutcome::Started:
                 if (g_ctx.loggerHandle && g_ctx.formattingAPI)
                 {
                     g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, "Red signal event caught! Starting sequence.");
                 }
-                g_ctx.sequence_active = true;
-                g_ctx.sequence_frame_counter = 0;
-
-                if (g_ctx.uiAPI && g_ctx.flash_window_handle)
-                {
-                    g_ctx.is_flash_active = true;
-                    g_ctx.uiAPI->UI_SetVisibility(g_ctx.flash_window_handle, true);
-                    g_ctx.flash_alpha = 0.0f;
-                }
+                g_ctx.capture_dedup_id = g_ctx.dedup_next_id++;
+                g_ctx.dedup.Record(position.x, position.z, simulation_time, g_ctx.capture_dedup_id);
+                AppendFineJournal(data->player_fined, position, simulation_time, JournalFineCapture::Started, g_ctx.capture_dedup_id);
+                BeginCaptureSequence();
+                break;
+            case FineOutcome::Queued:
+                g_ctx.pending_dedup_id = g_ctx.dedup_next_id++;
+                g_ctx.dedup.Record(position.x, position.z, simulation_time, g_ctx.pending_dedup_id);
+                g_ctx.metrics.SetQueueDepth(2);
+                AppendFineJournal(data->player_fined, position, simulation_time, JournalFineCapture::Queued, g_ctx.pending_dedup_id);
+                break;
+            case FineOutcome::Dropped:
+                g_ctx.metrics.RecordCaptureDropped();
+                AppendFineJournal(data->player_fined, position, simulation_time, JournalFineCapture::Dropped, 0);
+                break;
+            case FineOutcome::Ignored:
+                AppendFineJournal(data->player_fined, position, simulation_time, JournalFineCapture::None, 0);
+                break;
             }
         }
     }
@@ -735,130 +1361,295 @@ namespace SPF_RedLightCamera
     // This function is called by the UI framework to draw the content of the "FlashWindow".
     void RenderFlashWindow(SPF_UI_API *ui, void *user_data)
     {
-        // We only draw if the flash is active, has some transparency, and the UI API is valid.
-        if (!g_ctx.is_flash_active || g_ctx.flash_alpha <= 0.0f || !ui)
+        (void)user_data;
+        FrameBudgetGovernor::Scope draw_scope(g_ctx.governor);
+
+        // We only draw if the flash is active and the UI API is valid. On the update that issued a
+        // screenshot the flash can stay out of the frame, so it never ends up in the evidence.
+        if (!g_ctx.is_flash_active || !ui || (g_ctx.is_screenshot_frame && g_ctx.setting_flash_skip_screenshot_frame))
+        {
+            return;
+        }
+
+        // Table lookup only; the curve was sampled when the settings were read.
+        const float alpha = g_ctx.flash_curve.Sample(g_ctx.render_time_us - g_ctx.flash_started_us);
+        if (alpha <= 0.0f)
         {
             return;
         }
 
         float width, height;
-        // Get the current viewport size to draw the rectangle across the entire screen.
+        // Get the current viewport size to draw across the entire screen.
         ui->UI_GetViewportSize(&width, &height);
 
-        // Draw a white rectangle that covers the whole screen with the current flash_alpha transparency.
-        // The RGBA components (1.0f, 1.0f, 1.0f, g_ctx.flash_alpha) define a white color with variable opacity.
-        ui->UI_AddRectFilled(0, 0, width, height, 1.0f, 1.0f, 1.0f, g_ctx.flash_alpha);
+        // Vignette: four gradients from the screen edges inwards, batched into the window's draw list.
+        if (g_ctx.flash_curve.GetStyle() == FlashStyle::Vignette && ui->UI_GetWindowDrawList && ui->UI_ColorConvertFloat4ToU32 &&
+            ui->UI_DrawList_AddRectFilledMultiColor)
+        {
+            const SPF_DrawList_Handle draw_list = ui->UI_GetWindowDrawList();
+            const uint32_t edge = ui->UI_ColorConvertFloat4ToU32(1.0f, 1.0f, 1.0f, alpha);
+            const uint32_t clear = ui->UI_ColorConvertFloat4ToU32(1.0f, 1.0f, 1.0f, 0.0f);
+            const float band_x = width * FLASH_VIGNETTE_BAND;
+            const float band_y = height * FLASH_VIGNETTE_BAND;
+            // Corner colours: upper left, upper right, bottom right, bottom left.
+            ui->UI_DrawList_AddRectFilledMultiColor(draw_list, 0, 0, width, band_y, edge, edge, clear, clear);
+            ui->UI_DrawList_AddRectFilledMultiColor(draw_list, 0, height - band_y, width, height, clear, clear, edge, edge);
+            ui->UI_DrawList_AddRectFilledMultiColor(draw_list, 0, 0, band_x, height, edge, clear, clear, edge);
+            ui->UI_DrawList_AddRectFilledMultiColor(draw_list, width - band_x, 0, width, height, clear, edge, edge, clear);
+            return;
+        }
+
+        // Draw a white rectangle that covers the whole screen with the curve's opacity.
+        ui->UI_AddRectFilled(0, 0, width, height, 1.0f, 1.0f, 1.0f, alpha);
     }
 
-    // This function contains the full logic for positioning and orienting the camera.
-    void PositionAndOrientRedLightCamera()
+    // --- RenderStatsWindow Function ---
+    // Draws the statistics HUD. Only called while the window is open; all aggregation happens as
+    // events arrive, so this is a cached text block and one polyline.
+    void RenderStatsWindow(SPF_UI_API *ui, void *user_data)
     {
-        // --- 0. Safety Check ---
-        // Ensure all required API pointers and handles are available before proceeding.
-        if (!g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle || !g_ctx.coreAPI->camera || !g_ctx.loggerHandle || !g_ctx.formattingAPI)
+        (void)user_data;
+        FrameBudgetGovernor::Scope draw_scope(g_ctx.governor);
+
+        if (!ui || !ui->UI_Text)
         {
-            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
-            {
-                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "PositionAndOrientRedLightCamera: Required APIs or handles are not available.");
-            }
-            return; // Exit if something is missing to prevent a crash.
+            return;
         }
 
-        // --- 1. Get Truck Data from Telemetry ---
-        // Fetch the latest data about the truck's state.
-        SPF_TruckData truck_data;
-        g_ctx.coreAPI->telemetry->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
-
-        // Extract the truck's high-precision world position and heading (rotation).
-        const SPF_DVector &truck_world_pos_d = truck_data.world_placement.position; // (double)
-        const double heading_rad = truck_data.world_placement.orientation.heading;  // (double)
+        // Every value shown only ever grows, so their sum changes whenever one of them does.
+        const MetricsBlock &metrics = g_ctx.metrics.GetLocal();
+        uint64_t key = metrics.captures_completed + metrics.captures_dropped + metrics.captures_deduplicated + g_ctx.stats.GetLatencyCount() + g_ctx.stats.GetFrameGeneration();
+        for (uint32_t i = 0; i < metrics.offence_count && i < METRICS_MAX_OFFENCES; ++i)
+        {
+            key += metrics.fines_by_offence[i];
+        }
+        if (key != g_ctx.stats_text_key)
+        {
+            g_ctx.stats_text_key = key;
+            FormatStatsText();
+        }
+        ui->UI_Text(g_ctx.stats_text);
 
-        // --- 2. Calculate the Camera's Target World Position ---
-        // Use the settings loaded from the config file.
-        const float distance_forward = g_ctx.setting_distance_forward;
-        const float height_above = g_ctx.setting_height_above;
-
-        // Convert the truck's heading from the SCS telemetry system to a standard mathematical angle.
-        // SCS telemetry `heading_rad` is a normalized value (0.0 to 1.0) representing a full circle (360 degrees).
-        // In SCS, 0.0 `heading` points North (along the +Z axis in SCS world coordinates), and the angle increases clockwise.
-        // Standard mathematical functions (cos/sin) expect angles in radians, starting from the +X axis, increasing counter-clockwise.
-        // The formula `(1.5 * M_PI) - (2.0 * M_PI * heading_rad)` performs this conversion:
-        // 1. `(2.0 * M_PI * heading_rad)`: Converts the normalized SCS heading (0-1) into full radians (0-2*PI).
-        // 2. `(1.5 * M_PI) - ...`: Adjusts for the coordinate system difference (SCS Z-forward vs. Math X-right, and clockwise vs. counter-clockwise).
-        const double phi = (1.5 * M_PI) - (2.0 * M_PI * heading_rad);
-
-        // Calculate the components of a normalized direction vector based on the angle.
-        const double dir_x = cos(phi);
-        const double dir_z = sin(phi);
-
-        // Calculate the offset vector from the truck in world coordinates.
-        // This vector points from the truck to where the camera should be.
-        const SPF_DVector world_offset_from_truck = {
-            dir_x * distance_forward,
-            (double)height_above,
-            dir_z * distance_forward};
-
-        // Calculate the final target world position for the camera by adding the offset to the truck's position.
-        const SPF_DVector cam_target_world_pos = {
-            truck_world_pos_d.x + world_offset_from_truck.x,
-            truck_world_pos_d.y + world_offset_from_truck.y,
-            truck_world_pos_d.z + world_offset_from_truck.z};
+        if (!ui->UI_GetCursorScreenPos || !ui->UI_GetContentRegionAvail || !ui->UI_GetWindowDrawList || !ui->UI_DrawList_AddPolyline ||
+            !ui->UI_ColorConvertFloat4ToU32 || !ui->UI_Dummy)
+        {
+            return;
+        }
+        float x, y, width, available_height;
+        ui->UI_GetCursorScreenPos(&x, &y);
+        ui->UI_GetContentRegionAvail(&width, &available_height);
+        g_ctx.frame_sparkline.Update(g_ctx.stats, x, y, width, STATS_SPARKLINE_HEIGHT);
+        if (g_ctx.frame_sparkline.GetCount() >= 2)
+        {
+            ui->UI_DrawList_AddPolyline(ui->UI_GetWindowDrawList(), g_ctx.frame_sparkline.GetX(), g_ctx.frame_sparkline.GetY(), g_ctx.frame_sparkline.GetCount(),
+                                        ui->UI_ColorConvertFloat4ToU32(0.4f, 0.9f, 0.4f, 1.0f), false, 1.5f);
+        }
+        ui->UI_Dummy(width, STATS_SPARKLINE_HEIGHT);
+    }
 
-        // --- 3. Switch to Free Camera (if needed) ---
-        // Check if the developer camera is already active. If not, switch to it.
-        // This prevents constant re-activation when dragging a slider.
-        SPF_CameraType current_camera;
-        if (g_ctx.cameraAPI->Cam_GetCurrentCamera(&current_camera) && current_camera != SPF_CAMERA_DEVELOPER_FREE)
+    void FormatStatsText()
+    {
+        if (!g_ctx.formattingAPI)
         {
-            g_ctx.cameraAPI->Cam_SwitchTo(SPF_CAMERA_DEVELOPER_FREE);
+            return;
         }
-        // --- 4. Find the Game's Local Grid Origin ---
-        // Get the camera's current position in both world and local coordinates.
-        float cam_current_world_x, cam_current_world_y, cam_current_world_z;
-        g_ctx.cameraAPI->Cam_GetCameraWorldCoordinates(&cam_current_world_x, &cam_current_world_y, &cam_current_world_z);
+        const MetricsBlock &metrics = g_ctx.metrics.GetLocal();
+        char *out = g_ctx.stats_text;
+        size_t left = sizeof(g_ctx.stats_text);
+        const auto append = [&](int written) {
+            const size_t used = written < 0 ? 0 : ((size_t)written < left ? (size_t)written : left - 1);
+            out += used;
+            left -= used;
+        };
 
-        float cam_current_local_x, cam_current_local_y, cam_current_local_z;
-        g_ctx.cameraAPI->Cam_GetFreePosition(&cam_current_local_x, &cam_current_local_y, &cam_current_local_z);
+        append(g_ctx.formattingAPI->Fmt_Format(out, left, "Fines this session:\n"));
+        bool any_fine = false;
+        for (uint32_t i = 0; i < metrics.offence_count && i < METRICS_MAX_OFFENCES; ++i)
+        {
+            if (metrics.fines_by_offence[i] != 0)
+            {
+                append(g_ctx.formattingAPI->Fmt_Format(out, left, "  %-18.*s %llu\n", (int)METRICS_OFFENCE_NAME_SIZE, metrics.offence_names[i],
+                                                       (unsigned long long)metrics.fines_by_offence[i]));
+                any_fine = true;
+            }
+        }
+        if (!any_fine)
+        {
+            append(g_ctx.formattingAPI->Fmt_Format(out, left, "  none\n"));
+        }
+        append(g_ctx.formattingAPI->Fmt_Format(out, left, "Captures: %llu completed, %llu dropped, %llu repeats attached\n",
+                                               (unsigned long long)metrics.captures_completed, (unsigned long long)metrics.captures_dropped,
+                                               (unsigned long long)metrics.captures_deduplicated));
+        if (g_ctx.stats.GetLatencyCount() > 0)
+        {
+            append(g_ctx.formattingAPI->Fmt_Format(out, left, "Fine to screenshot: last %.1f ms, p95 %.1f ms\n", g_ctx.stats.GetLastLatency() / 1000.0,
+                                                   g_ctx.stats.GetP95Latency() / 1000.0));
+        }
+        else
+        {
+            append(g_ctx.formattingAPI->Fmt_Format(out, left, "Fine to screenshot: no captures yet\n"));
+        }
+        append(g_ctx.formattingAPI->Fmt_Format(out, left, "Plugin frame cost (worst per %u frames, peak %u us):", STATS_FRAMES_PER_BUCKET,
+                                               g_ctx.stats.GetFramePeak()));
+    }
 
-        // The difference between the world and local positions gives us the origin of the game's moving local grid.
-        const double game_current_origin_x = cam_current_world_x - cam_current_local_x;
-        const double game_current_origin_z = cam_current_world_z - cam_current_local_z;
+    // --- RenderHeatmapWindow Function ---
+    // Draws the violation heatmap around the truck. The rectangles come from the cached view, which
+    // is rebuilt only when a fine arrives or the truck enters another cell.
+    void RenderHeatmapWindow(SPF_UI_API *ui, void *user_data)
+    {
+        (void)user_data;
+        FrameBudgetGovernor::Scope draw_scope(g_ctx.governor);
+
+        if (!ui || !ui->UI_Text || !g_ctx.formattingAPI)
+        {
+            return;
+        }
+
+        const HeatmapGrid &grid = g_ctx.heatmap;
+        const uint64_t key = grid.GetGeneration() * 2 + (grid.IsOpen() ? 1 : 0);
+        if (key != g_ctx.heatmap_text_key)
+        {
+            g_ctx.heatmap_text_key = key;
+            if (grid.GetCellCount() == 0)
+            {
+                g_ctx.formattingAPI->Fmt_Format(g_ctx.heatmap_text, sizeof(g_ctx.heatmap_text), grid.IsOpen() ? "No red light fines recorded yet." : "Enable Violation Heatmap to record red light fines.");
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(g_ctx.heatmap_text, sizeof(g_ctx.heatmap_text), "Red light fines: %llu at %u places, busiest %u.%s",
+                                                (unsigned long long)grid.GetTotal(), (unsigned)grid.GetCellCount(), grid.GetMaxCount(),
+                                                grid.IsOpen() ? "" : " (not recording)");
+            }
+        }
+        ui->UI_Text(g_ctx.heatmap_text);
+
+        if (!ui->UI_GetCursorScreenPos || !ui->UI_GetContentRegionAvail || !ui->UI_GetWindowDrawList || !ui->UI_DrawList_AddRectFilled ||
+            !ui->UI_DrawList_AddCircleFilled || !ui->UI_ColorConvertFloat4ToU32 || !ui->UI_Dummy)
+        {
+            return;
+        }
+        if (!g_ctx.heatmap_palette_ready)
+        {
+            // Yellow and translucent for a single fine, to opaque red for the busiest place.
+            for (size_t i = 0; i < HEATMAP_LEVELS; ++i)
+            {
+                const float t = (float)i / (float)(HEATMAP_LEVELS - 1);
+                g_ctx.heatmap_palette[i] = ui->UI_ColorConvertFloat4ToU32(1.0f, 0.9f - 0.8f * t, 0.2f - 0.15f * t, 0.45f + 0.5f * t);
+            }
+            g_ctx.heatmap_palette_ready = true;
+        }
+
+        float x, y, width, height;
+        ui->UI_GetCursorScreenPos(&x, &y);
+        ui->UI_GetContentRegionAvail(&width, &height);
+        if (width < 1.0f || height < 1.0f)
+        {
+            return;
+        }
+        const SPF_DVector &truck = g_ctx.armed_truck_position;
+        g_ctx.heatmap_view.Update(grid, truck.x, truck.z, g_ctx.setting_heatmap_range, x, y, width, height);
+
+        const SPF_DrawList_Handle draw_list = ui->UI_GetWindowDrawList();
+        ui->UI_DrawList_AddRectFilled(draw_list, x, y, x + width, y + height, ui->UI_ColorConvertFloat4ToU32(0.08f, 0.08f, 0.1f, 0.85f), 0.0f);
+        const HeatmapQuad *quads = g_ctx.heatmap_view.GetQuads();
+        for (size_t i = 0; i < g_ctx.heatmap_view.GetCount(); ++i)
+        {
+            ui->UI_DrawList_AddRectFilled(draw_list, quads[i].x0, quads[i].y0, quads[i].x1, quads[i].y1, g_ctx.heatmap_palette[quads[i].level], 0.0f);
+        }
+        float truck_x, truck_y;
+        g_ctx.heatmap_view.ToScreen(truck.x, truck.z, truck_x, truck_y);
+        ui->UI_DrawList_AddCircleFilled(draw_list, truck_x, truck_y, 4.0f, ui->UI_ColorConvertFloat4ToU32(0.3f, 0.7f, 1.0f, 1.0f), 12);
+        ui->UI_Dummy(width, height);
+    }
+
+    // This function contains the full logic for positioning and orienting the camera.
+    void PositionAndOrientRedLightCamera()
+    {
+        // --- 0. Safety Check ---
+        // Ensure all required API pointers and handles are available before proceeding.
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle || !g_ctx.coreAPI->camera || !g_ctx.loggerHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+            {
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "PositionAndOrientRedLightCamera: Required APIs or handles are not available.");
+            }
+            return; // Exit if something is missing to prevent a crash.
+        }
+
+        // --- 1. Get Truck Data from Telemetry ---
+        // Fetch the latest data about the truck's state.
+        SPF_TruckData truck_data;
+        g_ctx.coreAPI->telemetry->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
+
+        // Extract the truck's high-precision world position and heading (rotation).
+        const SPF_DVector &truck_world_pos_d = truck_data.world_placement.position; // (double)
+        const double heading_rad = truck_data.world_placement.orientation.heading;  // (double)
+
+        // --- 2. Calculate the Camera's Target World Position ---
+        // Use the capture's rig preset, or the settings loaded from the config file when it has none.
+        // The pose maths lives in the core (see RigPose.hpp, RigPresets.hpp).
+        const RigPreset *preset = g_ctx.rig_presets.Get(g_ctx.capture_preset);
+        RigPose pose = preset ? ComputePresetPose(truck_world_pos_d, heading_rad, *preset)
+                              : ComputeRigPose(truck_world_pos_d, heading_rad, g_ctx.setting_distance_forward, g_ctx.setting_height_above, g_ctx.setting_field_of_view);
+
+        // --- 2.1. Fit the Whole Combination (Optional) ---
+        // With auto-framing on, the rig keeps its direction from the truck but is aimed at the
+        // truck and trailers together, at the distance or FOV that fits all of them.
+        FitRigToCombination(pose, truck_world_pos_d, heading_rad, RigOffset(preset));
+
+        // --- 2.2. Include Crossing Traffic (Optional) ---
+        // By default the camera looks straight at the truck. With traffic framing enabled, nearby
+        // vehicles shift the look-at point towards them and widen the FOV so they stay in shot.
+        if (IsTrafficFramingActive())
+        {
+            WidenRigForTraffic(pose);
+        }
+
+        ApplyRigPose(pose);
+    }
+
+    void ApplyRigPose(const RigPose &pose)
+    {
+        if (!g_ctx.cameraAPI)
+        {
+            return;
+        }
+
+        // --- 3. Switch to Free Camera (if needed) ---
+        // Check if the developer camera is already active. If not, switch to it.
+        // This prevents constant re-activation when dragging a slider.
+        SPF_CameraType current_camera;
+        if (g_ctx.cameraAPI->Cam_GetCurrentCamera(&current_camera) && current_camera != SPF_CAMERA_DEVELOPER_FREE)
+        {
+            g_ctx.cameraAPI->Cam_SwitchTo(SPF_CAMERA_DEVELOPER_FREE);
+        }
+        // --- 4. Find the Game's Local Grid Origin ---
+        double game_current_origin_x = 0.0, game_current_origin_z = 0.0;
+        GetLocalGridOrigin(game_current_origin_x, game_current_origin_z);
 
         // --- 5. Set the Camera's Position ---
         // Calculate the final local position for the camera by making our target world position relative to the loca grid origin.
         const SPF_FVector final_local_pos_to_set = {
-            (float)(cam_target_world_pos.x - game_current_origin_x), // X-coordinate relative to the local grid.
-            (float)cam_target_world_pos.y,                           // Y-coordinate (height) is absolute.
-            (float)(cam_target_world_pos.z - game_current_origin_z)  // Z-coordinate relative to the local grid.
+            (float)(pose.camera.x - game_current_origin_x), // X-coordinate relative to the local grid.
+            (float)pose.camera.y,                           // Y-coordinate (height) is absolute.
+            (float)(pose.camera.z - game_current_origin_z)  // Z-coordinate relative to the local grid.
         };
 
         // Set the free camera's position using the calculated local coordinates.
         g_ctx.cameraAPI->Cam_SetFreePosition(final_local_pos_to_set.x, final_local_pos_to_set.y, final_local_pos_to_set.z);
 
         // --- 6. Set the Camera's Orientation ---
-        // To make the camera look at the truck, we need to calculate the yaw and pitch angles.
-        // This is based on the direction vector pointing from the camera back to the truck.
-        float yaw = 0.0f;
-        float pitch = 0.0f;
-        if (distance_forward != 0.0f || height_above != 0.0f)
+        // The rig has no look direction when it sits on the truck; keep the current orientation then.
+        // Roll is 0 unless a preset sets it.
+        if (pose.oriented)
         {
-            // The look-at vector is the inverse of the offset vector.
-            const SPF_FVector look_at_vec = {(float)(-world_offset_from_truck.x), (float)(-world_offset_from_truck.y), (float)(-world_offset_from_truck.z)};
-
-            // Calculate the horizontal distance for the pitch calculation.
-            const float horizontal_dist = sqrt(look_at_vec.x * look_at_vec.x + look_at_vec.z * look_at_vec.z);
-
-            // Calculate yaw (horizontal angle) and pitch (vertical angle) using atan2 for correct quadrant handling.
-            yaw = atan2(-look_at_vec.x, -look_at_vec.z);
-            pitch = atan2(look_at_vec.y, horizontal_dist);
-
-            // Set the free camera's orientation. Roll is set to 0.
-            g_ctx.cameraAPI->Cam_SetFreeOrientation(yaw, pitch, 0.0f);
+            g_ctx.cameraAPI->Cam_SetFreeOrientation(pose.yaw, pose.pitch, pose.roll);
         }
 
         // --- 7. Set the Camera's Field of View (FOV) ---
-        // Apply the FOV from our settings.
-        g_ctx.cameraAPI->Cam_SetFreeFov(g_ctx.setting_field_of_view);
+        // Apply the FOV from our settings (possibly widened for traffic).
+        g_ctx.cameraAPI->Cam_SetFreeFov(pose.fov);
 
         // --- 8. Final Debug Logging ---
         if (g_ctx.loggerHandle && g_ctx.formattingAPI)
@@ -869,11 +1660,1292 @@ namespace SPF_RedLightCamera
                                         " Set Local Pos: (%.2f, %.2f, %.2f),"
                                         " Set Orientation: (Yaw: %.2f, Pitch: %.2f),"
                                         " Set FOV: %.1f",
-                                        final_local_pos_to_set.x, final_local_pos_to_set.y, final_local_pos_to_set.z, yaw, pitch, g_ctx.setting_field_of_view);
+                                        final_local_pos_to_set.x, final_local_pos_to_set.y, final_local_pos_to_set.z, pose.yaw, pose.pitch, pose.fov);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    bool GetLocalGridOrigin(double &origin_x, double &origin_z)
+    {
+        if (!g_ctx.cameraAPI || !g_ctx.cameraAPI->Cam_GetCameraWorldCoordinates || !g_ctx.cameraAPI->Cam_GetFreePosition)
+        {
+            return false;
+        }
+
+        // Get the camera's current position in both world and local coordinates.
+        float cam_current_world_x, cam_current_world_y, cam_current_world_z;
+        g_ctx.cameraAPI->Cam_GetCameraWorldCoordinates(&cam_current_world_x, &cam_current_world_y, &cam_current_world_z);
+
+        float cam_current_local_x, cam_current_local_y, cam_current_local_z;
+        g_ctx.cameraAPI->Cam_GetFreePosition(&cam_current_local_x, &cam_current_local_y, &cam_current_local_z);
+
+        // The difference between the world and local positions gives us the origin of the game's moving local grid.
+        origin_x = cam_current_world_x - cam_current_local_x;
+        origin_z = cam_current_world_z - cam_current_local_z;
+        return true;
+    }
+
+    bool IsTrafficFramingActive()
+    {
+        return g_ctx.setting_frame_crossing_traffic && g_ctx.traffic_index.HasPositionSource();
+    }
+
+    bool WidenRigForTraffic(RigPose &pose)
+    {
+        TrafficHit hits[MAX_FRAMED_VEHICLES];
+        const size_t count = g_ctx.traffic_index.QueryRadius(pose.look_target.x, pose.look_target.z, g_ctx.setting_crossing_traffic_radius, hits, MAX_FRAMED_VEHICLES);
+        if (count == 0)
+        {
+            return false;
+        }
+
+        SPF_DVector others[MAX_FRAMED_VEHICLES];
+        for (size_t i = 0; i < count; ++i)
+        {
+            others[i] = {hits[i].entry.x, hits[i].entry.y, hits[i].entry.z};
+        }
+
+        FramingLimits limits;
+        limits.margin = TRAFFIC_FRAMING_MARGIN;
+        limits.max_fov = MAX_FRAMING_FOV;
+        FrameRigTargets(pose, others, count, GetViewportAspect(), limits);
+        return true;
+    }
+
+    double GetViewportAspect()
+    {
+        float width = 16.0f, height = 9.0f;
+        if (g_ctx.uiAPI && g_ctx.uiAPI->UI_GetViewportSize)
+        {
+            g_ctx.uiAPI->UI_GetViewportSize(&width, &height);
+        }
+
+        // The 3D view may cover only part of the screen (normalised rectangle).
+        float x1 = 0.0f, x2 = 1.0f, y1 = 0.0f, y2 = 1.0f;
+        if (g_ctx.cameraAPI && g_ctx.cameraAPI->Cam_GetViewport && g_ctx.cameraAPI->Cam_GetViewport(&x1, &x2, &y1, &y2) && x2 > x1 && y2 > y1)
+        {
+            width *= x2 - x1;
+            height *= y2 - y1;
+        }
+        return (width > 0.0f && height > 0.0f) ? (double)width / (double)height : 16.0 / 9.0;
+    }
+
+    bool FitRigToCombination(RigPose &pose, const SPF_DVector &truck, double heading, const SPF_FVector &rig_offset)
+    {
+        if (g_ctx.setting_auto_framing <= 0 || g_ctx.setting_auto_framing >= (int32_t)AutoFramingMode::Count)
+        {
+            return false;
+        }
+
+        if (!g_ctx.auto_framer.HasBox())
+        {
+            if (!g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle || !g_ctx.coreAPI->telemetry->Tel_GetTruckConstants ||
+                !g_ctx.coreAPI->telemetry->Tel_GetTrailers)
+            {
+                return false;
+            }
+            // Large and only needed here; static so a rebuild does not put ~40 KB on the game's stack.
+            static SPF_TruckConstants truck_constants;
+            static SPF_Trailer trailers[SPF_TELEMETRY_TRAILER_MAX_COUNT];
+            uint32_t trailer_count = SPF_TELEMETRY_TRAILER_MAX_COUNT;
+            g_ctx.coreAPI->telemetry->Tel_GetTruckConstants(g_ctx.telemetryHandle, &truck_constants, sizeof(SPF_TruckConstants));
+            g_ctx.coreAPI->telemetry->Tel_GetTrailers(g_ctx.telemetryHandle, trailers, sizeof(SPF_Trailer), &trailer_count);
+            g_ctx.framed_trailer_count = trailer_count;
+            g_ctx.auto_framer.SetBox(BuildCombinationBox(truck_constants, trailers, trailer_count));
+
+            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+            {
+                const FramingBox &box = g_ctx.auto_framer.GetBox();
+                char log_buffer[256];
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Auto-framing: combination %.1f x %.1f x %.1f m with %u trailers%s.",
+                                                box.max.z - box.min.z, box.max.x - box.min.x, box.max.y - box.min.y, box.trailer_count,
+                                                box.valid ? "" : " (no truck constants yet)");
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+            }
+        }
+
+        FramingRequest request;
+        request.rig_offset = rig_offset;
+        request.fov = pose.fov;
+        request.max_fov = (float)MAX_FRAMING_FOV;
+        request.aspect = (float)GetViewportAspect();
+        request.margin = g_ctx.setting_auto_framing_margin;
+        request.mode = (AutoFramingMode)g_ctx.setting_auto_framing;
+        const FramingSolution &solution = g_ctx.auto_framer.Solve(request);
+        if (!solution.valid)
+        {
+            return false;
+        }
+        pose = PlaceFramedRig(truck, heading, solution, pose.roll);
+        return true;
+    }
+
+    void StartTelemetryRecording()
+    {
+        if (g_ctx.recorder.IsOpen())
+        {
+            return;
+        }
+
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "StartTelemetryRecording: Environment API not available, recording disabled.");
+            return;
+        }
+
+        // Recordings live in the plugin's data directory, one file per session.
+        const auto env = g_ctx.coreAPI->environment;
+        char data_dir[512];
+        if (env->Env_GetPluginDataDir(g_ctx.environmentHandle, data_dir, sizeof(data_dir)) <= 0)
+        {
+            return;
+        }
+        env->Env_CreatePath(g_ctx.environmentHandle, data_dir);
+
+        char path[640];
+        g_ctx.formattingAPI->Fmt_Format(path, sizeof(path), "%s/telemetry_%lld.rlcrec", data_dir, (long long)std::time(nullptr));
+
+        const bool opened = g_ctx.recorder.Open(path);
+        if (g_ctx.loggerHandle)
+        {
+            char log_buffer[768];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), opened ? "Telemetry recording started: %s" : "Failed to open telemetry recording: %s", path);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, opened ? SPF_LOG_INFO : SPF_LOG_ERROR, log_buffer);
+        }
+    }
+
+    void StopTelemetryRecording()
+    {
+        if (!g_ctx.recorder.IsOpen())
+        {
+            return;
+        }
+
+        const uint64_t record_count = g_ctx.recorder.GetRecordCount();
+        g_ctx.recorder.Close();
+
+        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[128];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Telemetry recording closed (%llu records).", (unsigned long long)record_count);
             g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
         }
     }
 
+    // One heatmap per profile, kept across sessions next to the recordings.
+    static bool GetHeatmapPath(char *out_path, size_t size)
+    {
+        const auto env = g_ctx.coreAPI->environment;
+        char data_dir[512];
+        if (env->Env_GetPluginDataDir(g_ctx.environmentHandle, data_dir, sizeof(data_dir)) <= 0)
+        {
+            return false;
+        }
+        env->Env_CreatePath(g_ctx.environmentHandle, data_dir);
+        g_ctx.formattingAPI->Fmt_Format(out_path, size, "%s/violation_heatmap.rlch", data_dir);
+        return true;
+    }
+
+    void OpenViolationHeatmap()
+    {
+        if (g_ctx.heatmap.IsOpen())
+        {
+            return;
+        }
+
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "OpenViolationHeatmap: Environment API not available, heatmap disabled.");
+            return;
+        }
+
+        char path[640];
+        if (!GetHeatmapPath(path, sizeof(path)))
+        {
+            return;
+        }
+
+        const bool opened = g_ctx.heatmap.Open(path);
+        if (g_ctx.loggerHandle)
+        {
+            char log_buffer[768];
+            if (opened)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Violation heatmap: %llu fines at %u places loaded from %s%s.",
+                                                (unsigned long long)g_ctx.heatmap.GetTotal(), (unsigned)g_ctx.heatmap.GetCellCount(), path,
+                                                g_ctx.heatmap.WasCompacted() ? " (compacted)" : "");
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Failed to open violation heatmap: %s", path);
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, opened ? SPF_LOG_INFO : SPF_LOG_ERROR, log_buffer);
+        }
+    }
+
+    void CloseViolationHeatmap()
+    {
+        if (!g_ctx.heatmap.IsOpen())
+        {
+            return;
+        }
+
+        g_ctx.heatmap.Close();
+        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI && g_ctx.heatmap.GetDropped() != 0)
+        {
+            char log_buffer[128];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Violation heatmap full: %llu fines at new places were not recorded.",
+                                            (unsigned long long)g_ctx.heatmap.GetDropped());
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, log_buffer);
+        }
+    }
+
+    void OpenCaptureJournal()
+    {
+        if (g_ctx.journal.IsOpen())
+        {
+            return;
+        }
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "OpenCaptureJournal: Environment API not available, capture journal disabled.");
+            return;
+        }
+        // A checkpoint of the previous open may still be writing the file through the job's path.
+        if (g_ctx.checkpoint_job.busy)
+        {
+            g_ctx.checkpoint_job.reopen = true;
+            return;
+        }
+
+        const auto env = g_ctx.coreAPI->environment;
+        char data_dir[512];
+        if (env->Env_GetPluginDataDir(g_ctx.environmentHandle, data_dir, sizeof(data_dir)) <= 0)
+        {
+            return;
+        }
+        env->Env_CreatePath(g_ctx.environmentHandle, data_dir);
+        char path[640];
+        g_ctx.formattingAPI->Fmt_Format(path, sizeof(path), "%s/capture_journal.rlcj", data_dir);
+        g_ctx.formattingAPI->Fmt_Format(g_ctx.checkpoint_job.path, sizeof(g_ctx.checkpoint_job.path), "%s", path);
+
+        // Recovery validates only what was written after the last checkpoint.
+        const auto started = FrameBudgetGovernor::Clock::now();
+        JournalRecovery recovery;
+        const bool opened = g_ctx.journal.Open(path, recovery);
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(FrameBudgetGovernor::Clock::now() - started).count();
+
+        if (g_ctx.loggerHandle)
+        {
+            char log_buffer[768];
+            if (!opened)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Failed to open capture journal: %s", path);
+            }
+            else if (recovery.created)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Capture journal created: %s", path);
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer),
+                                                "Capture journal: %llu records, %llu recovered after the last checkpoint (%llu bytes scanned, %llu torn bytes dropped) in %.2f ms.",
+                                                (unsigned long long)recovery.records, (unsigned long long)recovery.tail_records,
+                                                (unsigned long long)recovery.scanned_bytes, (unsigned long long)recovery.dropped_bytes, elapsed_ms);
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, !opened ? SPF_LOG_ERROR : (recovery.dropped_bytes ? SPF_LOG_WARN : SPF_LOG_INFO), log_buffer);
+        }
+    }
+
+    void CloseCaptureJournal()
+    {
+        g_ctx.checkpoint_job.reopen = false;
+        if (!g_ctx.journal.IsOpen())
+        {
+            return;
+        }
+        // Close checkpoints under a newer sequence number, so a write still in flight cannot undo it.
+        g_ctx.checkpoint_job.stale = g_ctx.checkpoint_job.busy;
+        const uint64_t record_count = g_ctx.journal.GetRecordCount();
+        g_ctx.journal.Close();
+
+        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[128];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Capture journal closed (%llu records).", (unsigned long long)record_count);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    void AppendCaptureJournal(JournalRecordType type, const void *payload, size_t size)
+    {
+        if (!g_ctx.journal.Append(type, payload, size))
+        {
+            if (g_ctx.loggerHandle)
+            {
+                g_ctx.loadAPI->logger->LogThrottled(g_ctx.loggerHandle, SPF_LOG_ERROR, "redlightcamera.journal", 5000, "Capture journal write failed; no more records this session.");
+            }
+            return;
+        }
+        if (g_ctx.journal.GetUnsyncedBytes() >= JOURNAL_CHECKPOINT_BYTES)
+        {
+            g_ctx.governor.Defer(DeferredTask::CheckpointJournal);
+        }
+    }
+
+    static void RunJournalCheckpoint(WorkerJob *job)
+    {
+        JournalCheckpointJob &self = *static_cast<JournalCheckpointJob *>(job);
+        self.written = CaptureJournal::WriteCheckpoint(self.path, self.checkpoint);
+    }
+
+    static void CompleteJournalCheckpoint(WorkerJob *job)
+    {
+        JournalCheckpointJob &self = *static_cast<JournalCheckpointJob *>(job);
+        self.busy = false;
+        if (self.stale)
+        {
+            self.stale = false;
+            if (self.reopen)
+            {
+                self.reopen = false;
+                OpenCaptureJournal();
+            }
+            return;
+        }
+        g_ctx.journal.FinishCheckpoint(self.checkpoint, self.written);
+        if (!self.written && g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "Capture journal checkpoint failed; no more records this session.");
+        }
+        else if (g_ctx.journal.GetUnsyncedBytes() >= JOURNAL_CHECKPOINT_BYTES)
+        {
+            // Records kept coming while it ran.
+            g_ctx.governor.Defer(DeferredTask::CheckpointJournal);
+        }
+    }
+
+    void RequestJournalCheckpoint()
+    {
+        JournalCheckpointJob &job = g_ctx.checkpoint_job;
+        if (job.busy || !g_ctx.journal.PrepareCheckpoint(job.checkpoint))
+        {
+            return;
+        }
+
+        job.run = RunJournalCheckpoint;
+        job.complete = CompleteJournalCheckpoint;
+        job.busy = g_ctx.workers.Submit(&job);
+        if (!job.busy)
+        {
+            // No pool: checkpoint in place rather than not at all.
+            job.written = CaptureJournal::WriteCheckpoint(job.path, job.checkpoint);
+            g_ctx.journal.FinishCheckpoint(job.checkpoint, job.written);
+        }
+    }
+
+    void AppendFineJournal(const SPF_GameplayEvent_PlayerFined &fine, const SPF_DVector &position, uint64_t simulation_time, JournalFineCapture capture,
+                           uint32_t capture_id)
+    {
+        if (!g_ctx.journal.IsOpen() || !g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle)
+        {
+            return;
+        }
+        // Fines are rare; the constants are fetched for each rather than tracked.
+        const auto tel = g_ctx.coreAPI->telemetry;
+        SPF_TruckData truck_data;
+        tel->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
+        static SPF_TruckConstants truck_constants;
+        memset(&truck_constants, 0, sizeof(truck_constants));
+        if (tel->Tel_GetTruckConstants)
+        {
+            tel->Tel_GetTruckConstants(g_ctx.telemetryHandle, &truck_constants, sizeof(SPF_TruckConstants));
+        }
+
+        JournalFine record{};
+        record.simulation_time = simulation_time;
+        record.x = position.x;
+        record.y = position.y;
+        record.z = position.z;
+        record.heading = truck_data.world_placement.orientation.heading;
+        record.speed = truck_data.speed;
+        record.fine_amount = fine.fine_amount;
+        record.capture_id = capture_id;
+        record.capture = (uint8_t)capture;
+        CopyJournalString(record.offence, sizeof(record.offence), fine.fine_offence);
+        CopyJournalString(record.truck_id, sizeof(record.truck_id), truck_constants.id);
+        CopyJournalString(record.plate, sizeof(record.plate), truck_constants.license_plate);
+        AppendCaptureJournal(JournalRecordType::Fine, &record, sizeof(record));
+    }
+
+    static void RunViolationExport(WorkerJob *job)
+    {
+        ViolationExportJob &self = *static_cast<ViolationExportJob *>(job);
+        const auto started = FrameBudgetGovernor::Clock::now();
+        self.result = ExportViolations(self.journal_path, self.out_path, self.screenshot_dir);
+        self.elapsed_ms = std::chrono::duration<double, std::milli>(FrameBudgetGovernor::Clock::now() - started).count();
+    }
+
+    static void CompleteViolationExport(WorkerJob *job)
+    {
+        ViolationExportJob &self = *static_cast<ViolationExportJob *>(job);
+        self.busy = false;
+        const ViolationExportResult &result = self.result;
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[896];
+            if (result.ok)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Violation export: %llu fines in %llu batches (%llu bytes) written to %s in %.0f ms.",
+                                                (unsigned long long)result.rows, (unsigned long long)result.batches, (unsigned long long)result.bytes, self.out_path,
+                                                self.elapsed_ms);
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Violation export failed: could not read %s or write %s.", self.journal_path, self.out_path);
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, result.ok ? SPF_LOG_INFO : SPF_LOG_ERROR, log_buffer);
+        }
+    }
+
+    void RequestViolationExport()
+    {
+        ViolationExportJob &job = g_ctx.export_job;
+        if (job.busy || !g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, job.busy ? "Violation export already running." : "Violation export: Environment API not available.");
+            return;
+        }
+
+        const auto env = g_ctx.coreAPI->environment;
+        char data_dir[512];
+        if (env->Env_GetPluginDataDir(g_ctx.environmentHandle, data_dir, sizeof(data_dir)) <= 0)
+        {
+            return;
+        }
+        g_ctx.formattingAPI->Fmt_Format(job.journal_path, sizeof(job.journal_path), "%s/capture_journal.rlcj", data_dir);
+        g_ctx.formattingAPI->Fmt_Format(job.out_path, sizeof(job.out_path), "%s/violations.arrows", data_dir);
+        job.screenshot_dir[0] = '\0';
+        if (env->Env_GetSCSScreenshotsDir)
+        {
+            env->Env_GetSCSScreenshotsDir(g_ctx.environmentHandle, job.screenshot_dir, sizeof(job.screenshot_dir));
+        }
+
+        // Appended records are already with the OS, so the worker reads everything up to now.
+        job.run = RunViolationExport;
+        job.complete = CompleteViolationExport;
+        job.busy = g_ctx.workers.Submit(&job);
+        if (g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, job.busy ? SPF_LOG_INFO : SPF_LOG_WARN, job.busy ? "Violation export started." : "Violation export: worker pool not running.");
+        }
+    }
+
+    static void RunViolationSites(WorkerJob *job)
+    {
+        // Mapped for the build only; the index keeps its own copy.
+        ViolationSitesJob &self = *static_cast<ViolationSitesJob *>(job);
+        const auto started = FrameBudgetGovernor::Clock::now();
+        MappedFile file;
+        self.built = file.Open(self.path) && self.index.BuildFromHeatmapFile(file.GetData(), file.GetSize());
+        file.Close();
+        self.elapsed_ms = std::chrono::duration<double, std::milli>(FrameBudgetGovernor::Clock::now() - started).count();
+    }
+
+    static void CompleteViolationSites(WorkerJob *job)
+    {
+        ViolationSitesJob &self = *static_cast<ViolationSitesJob *>(job);
+        self.busy = false;
+        const bool again = self.again;
+        self.again = false;
+        if (!g_ctx.setting_proximity_alerts || again)
+        {
+            // Turned off, or requested again while building (the file may have changed): drop this build.
+            self.index.Clear();
+            if (again && g_ctx.setting_proximity_alerts)
+            {
+                LoadViolationSites();
+            }
+            return;
+        }
+
+        // Site indices change with the build, so the last alert no longer identifies a site.
+        g_ctx.violation_sites = std::move(self.index);
+        self.index.Clear();
+        g_ctx.proximity_site = ~0u;
+
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[768];
+            if (self.built)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Proximity alerts: %u violation sites in %u buckets loaded in %.2f ms.",
+                                                (unsigned)g_ctx.violation_sites.GetSiteCount(), (unsigned)g_ctx.violation_sites.GetBucketCount(), self.elapsed_ms);
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Proximity alerts: no violation heatmap at %s yet.", self.path);
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    void LoadViolationSites()
+    {
+        ViolationSitesJob &job = g_ctx.sites_job;
+        if (job.busy)
+        {
+            job.again = true;
+            return;
+        }
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            return;
+        }
+        if (!GetHeatmapPath(job.path, sizeof(job.path)))
+        {
+            return;
+        }
+
+        job.run = RunViolationSites;
+        job.complete = CompleteViolationSites;
+        job.busy = g_ctx.workers.Submit(&job);
+        if (!job.busy && g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "Proximity alerts: worker pool not running, violation sites not loaded.");
+        }
+    }
+
+    void UpdateProximityAlert()
+    {
+        if (g_ctx.violation_sites.GetSiteCount() == 0 || g_ctx.governor.GetFrameCount() % (uint64_t)g_ctx.setting_proximity_check_frames != 0)
+        {
+            return;
+        }
+
+        // The alerted site is kept until nothing is left within the clearing radius, so driving
+        // along the edge of the alert radius does not alert again.
+        const double radius = g_ctx.setting_proximity_radius;
+        const SPF_DVector &truck = g_ctx.armed_truck_position;
+        SiteHit hit;
+        if (!g_ctx.violation_sites.FindNearest(truck.x, truck.z, radius * PROXIMITY_CLEAR_FACTOR, hit))
+        {
+            g_ctx.proximity_site = ~0u;
+            return;
+        }
+        if (hit.index == g_ctx.proximity_site || hit.distance > radius)
+        {
+            return;
+        }
+        g_ctx.proximity_site = hit.index;
+
+        if (!g_ctx.formattingAPI)
+        {
+            return;
+        }
+        char message[160];
+        g_ctx.formattingAPI->Fmt_Format(message, sizeof(message), "Red light ahead: **%u** earlier fine%s %.0f m from here.", hit.count, hit.count == 1 ? "" : "s",
+                                        hit.distance);
+        if (g_ctx.uiAPI && g_ctx.uiAPI->UI_ShowNotification)
+        {
+            g_ctx.uiAPI->UI_ShowNotification(SPF_NOTIFICATION_WARNING, message, SPF_NOTIF_MODE_TOP);
+        }
+        if (g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, message);
+        }
+    }
+
+    // One directory per profile, next to the heatmap.
+    static bool GetHistoryDirectory(char *out_path, size_t size)
+    {
+        const auto env = g_ctx.coreAPI->environment;
+        char data_dir[512];
+        if (env->Env_GetPluginDataDir(g_ctx.environmentHandle, data_dir, sizeof(data_dir)) <= 0)
+        {
+            return false;
+        }
+        g_ctx.formattingAPI->Fmt_Format(out_path, size, "%s/history", data_dir);
+        env->Env_CreatePath(g_ctx.environmentHandle, out_path);
+        return true;
+    }
+
+    static void RunHistoryMaintenance(WorkerJob *job)
+    {
+        HistoryMaintenanceJob &self = *static_cast<HistoryMaintenanceJob *>(job);
+        self.result = MaintainHistory(self.directory, self.active_sequence);
+    }
+
+    static void CompleteHistoryMaintenance(WorkerJob *job)
+    {
+        HistoryMaintenanceJob &self = *static_cast<HistoryMaintenanceJob *>(job);
+        self.busy = false;
+        if (g_ctx.track_job.queued)
+        {
+            g_ctx.track_job.queued = false;
+            RequestTrackExport();
+        }
+        const HistoryMaintenanceResult &result = self.result;
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI && (result.sealed || result.merged || result.leftovers || result.failures))
+        {
+            char log_buffer[256];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Capture history: %u segments sealed, %u merged, %u leftovers removed (%llu -> %llu bytes)%s.",
+                                            result.sealed, result.merged, result.leftovers, (unsigned long long)result.bytes_before,
+                                            (unsigned long long)result.bytes_after, result.failures ? ", some segments could not be rewritten" : "");
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, result.failures ? SPF_LOG_WARN : SPF_LOG_INFO, log_buffer);
+        }
+        if (self.reopen)
+        {
+            // Opening requests a run of its own.
+            self.reopen = false;
+            self.again = false;
+            OpenCaptureHistory();
+        }
+        if (self.again)
+        {
+            self.again = false;
+            RequestHistoryMaintenance();
+        }
+    }
+
+    void RequestHistoryMaintenance()
+    {
+        HistoryMaintenanceJob &job = g_ctx.history_job;
+        if (job.busy || g_ctx.track_job.busy)
+        {
+            job.again = true;
+            return;
+        }
+        if (!job.directory[0])
+        {
+            return;
+        }
+        // The segment being written (or the last one, once closed) and any the writer rolls over
+        // to meanwhile are left alone; the directory stays that of the last open.
+        job.active_sequence = g_ctx.history.GetActiveSequence();
+        job.run = RunHistoryMaintenance;
+        job.complete = CompleteHistoryMaintenance;
+        job.busy = g_ctx.workers.Submit(&job);
+    }
+
+    void FinishHistoryMaintenance()
+    {
+        HistoryMaintenanceJob &job = g_ctx.history_job;
+        if (g_ctx.workers.IsRunning() || g_ctx.history.IsOpen() || !job.directory[0])
+        {
+            return;
+        }
+        // Nothing else touches the segments any more, so the last one is sealed as well.
+        job.active_sequence = 0;
+        job.again = false;
+        job.reopen = false;
+        job.busy = true;
+        RunHistoryMaintenance(&job);
+        CompleteHistoryMaintenance(&job);
+    }
+
+    static void RunTrackExport(WorkerJob *job)
+    {
+        TrackExportJob &self = *static_cast<TrackExportJob *>(job);
+        const auto started = FrameBudgetGovernor::Clock::now();
+        self.result = ExportTracks(self.directory, self.out_path, self.options);
+        self.elapsed_ms = std::chrono::duration<double, std::milli>(FrameBudgetGovernor::Clock::now() - started).count();
+    }
+
+    static void CompleteTrackExport(WorkerJob *job)
+    {
+        TrackExportJob &self = *static_cast<TrackExportJob *>(job);
+        self.busy = false;
+        const TrackExportResult &result = self.result;
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[896];
+            if (result.ok)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Track export: %llu fines, %llu of %llu path points kept (%llu bytes) written to %s in %.0f ms.",
+                                                (unsigned long long)result.tracks, (unsigned long long)result.points_out, (unsigned long long)result.points_in,
+                                                (unsigned long long)result.bytes, self.out_path, self.elapsed_ms);
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Track export failed: could not write %s.", self.out_path);
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, result.ok ? SPF_LOG_INFO : SPF_LOG_ERROR, log_buffer);
+        }
+
+        // Maintenance requested while the export read the segments.
+        if (g_ctx.history_job.again)
+        {
+            g_ctx.history_job.again = false;
+            RequestHistoryMaintenance();
+        }
+    }
+
+    void RequestTrackExport()
+    {
+        TrackExportJob &job = g_ctx.track_job;
+        if (job.busy || job.queued || !g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, job.busy || job.queued ? "Track export already running." : "Track export: Environment API not available.");
+            return;
+        }
+
+        const auto env = g_ctx.coreAPI->environment;
+        char data_dir[512];
+        if (env->Env_GetPluginDataDir(g_ctx.environmentHandle, data_dir, sizeof(data_dir)) <= 0 || !GetHistoryDirectory(job.directory, sizeof(job.directory)))
+        {
+            return;
+        }
+        job.options.format = g_ctx.setting_track_export_format == 1 ? TrackFormat::Gpx : TrackFormat::GeoJson;
+        job.options.tolerance_m = g_ctx.setting_track_tolerance;
+        job.options.window_s = g_ctx.setting_track_window_s;
+        g_ctx.formattingAPI->Fmt_Format(job.out_path, sizeof(job.out_path), "%s/violation_tracks.%s", data_dir,
+                                        job.options.format == TrackFormat::Gpx ? "gpx" : "geojson");
+
+        // The buffered records go to the active segment first, so the latest fines are exported.
+        if (g_ctx.history.IsOpen())
+        {
+            g_ctx.history.Flush();
+        }
+        if (g_ctx.history_job.busy)
+        {
+            job.queued = true;
+            return;
+        }
+        job.run = RunTrackExport;
+        job.complete = CompleteTrackExport;
+        job.busy = g_ctx.workers.Submit(&job);
+        if (g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, job.busy ? SPF_LOG_INFO : SPF_LOG_WARN, job.busy ? "Track export started." : "Track export: worker pool not running.");
+        }
+    }
+
+    void OpenCaptureHistory()
+    {
+        if (g_ctx.history.IsOpen())
+        {
+            return;
+        }
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "OpenCaptureHistory: Environment API not available, capture history disabled.");
+            return;
+        }
+
+        // A maintenance run in flight may be rewriting the segments the writer numbers itself
+        // after, and reads the directory; the open waits for it.
+        if (g_ctx.history_job.busy)
+        {
+            g_ctx.history_job.reopen = true;
+            return;
+        }
+        char directory[HISTORY_PATH_SIZE];
+        if (!GetHistoryDirectory(directory, sizeof(directory)))
+        {
+            return;
+        }
+        strcpy(g_ctx.history_job.directory, directory);
+
+        const bool opened = g_ctx.history.Open(directory);
+        g_ctx.history_last_sample_time = ~0ull;
+        if (g_ctx.loggerHandle)
+        {
+            char log_buffer[768];
+            if (opened)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Capture history: writing segment %u in %s.", g_ctx.history.GetActiveSequence(), directory);
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Failed to open capture history in %s.", directory);
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, opened ? SPF_LOG_INFO : SPF_LOG_ERROR, log_buffer);
+        }
+        if (opened)
+        {
+            RequestHistoryMaintenance();
+        }
+    }
+
+    void CloseCaptureHistory()
+    {
+        g_ctx.history_job.reopen = false;
+        if (!g_ctx.history.IsOpen())
+        {
+            return;
+        }
+
+        const uint64_t record_count = g_ctx.history.GetRecordCount();
+        g_ctx.history.Close();
+        RequestHistoryMaintenance();
+
+        if (g_ctx.loadAPI && g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[128];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Capture history closed (%llu records, %llu bytes).", (unsigned long long)record_count,
+                                            (unsigned long long)g_ctx.history.GetBytesWritten());
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    void AppendCaptureHistory(HistoryKind kind)
+    {
+        if (!g_ctx.coreAPI || !g_ctx.coreAPI->telemetry || !g_ctx.telemetryHandle)
+        {
+            return;
+        }
+        SPF_TruckData truck_data;
+        g_ctx.coreAPI->telemetry->Tel_GetTruckData(g_ctx.telemetryHandle, &truck_data, sizeof(SPF_TruckData));
+
+        HistoryRecord record;
+        record.time_us = g_ctx.armed_simulation_time;
+        record.position = truck_data.world_placement.position;
+        record.heading = truck_data.world_placement.orientation.heading;
+        record.speed = truck_data.speed;
+        record.kind = kind;
+        g_ctx.history.Append(record);
+        g_ctx.history_last_sample_time = record.time_us;
+        if (!g_ctx.history.IsOpen() && g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_ERROR, "Capture history: a segment could not be written, history closed.");
+        }
+
+        if (g_ctx.history.ConsumeRollover())
+        {
+            RequestHistoryMaintenance();
+        }
+    }
+
+    void SampleCaptureHistory()
+    {
+        // No samples while the simulation is paused.
+        if (!g_ctx.history.IsOpen() || g_ctx.governor.GetFrameCount() % (uint64_t)g_ctx.setting_history_sample_frames != 0 ||
+            g_ctx.armed_simulation_time == g_ctx.history_last_sample_time)
+        {
+            return;
+        }
+        AppendCaptureHistory(HistoryKind::Sample);
+    }
+
+    void StartCaptureSequence(const char *label)
+    {
+        // A null label starts the queued red light capture.
+        const bool started = label ? g_ctx.capture.Start(label, g_ctx.setting_cinematic_capture) : g_ctx.capture.StartPending();
+        if (started)
+        {
+            g_ctx.capture_dedup_id = label ? 0 : g_ctx.pending_dedup_id;
+            g_ctx.pending_dedup_id = label ? g_ctx.pending_dedup_id : 0;
+            BeginCaptureSequence();
+        }
+    }
+
+    void BeginCaptureSequence()
+    {
+        g_ctx.capture_started_at = FrameBudgetGovernor::Clock::now();
+        g_ctx.metrics.SetQueueDepth(1);
+        g_ctx.capture_preset = g_ctx.rig_presets.FindProfile(CaptureProfileKey(g_ctx.capture.GetLabel()));
+
+        if (g_ctx.uiAPI && g_ctx.flash_window_handle)
+        {
+            g_ctx.is_flash_active = true;
+            g_ctx.flash_started_us = g_ctx.render_time_us;
+            g_ctx.uiAPI->UI_SetVisibility(g_ctx.flash_window_handle, true);
+        }
+    }
+
+    void UpdateFlash()
+    {
+        if (!g_ctx.is_flash_active)
+        {
+            return;
+        }
+        // A render clock that has not moved (no timestamps) would hold the flash forever; end it
+        // with the capture then.
+        const uint64_t elapsed = g_ctx.render_time_us - g_ctx.flash_started_us;
+        if (g_ctx.flash_curve.IsOver(elapsed) || (elapsed == 0 && !g_ctx.capture.IsActive()))
+        {
+            HideFlash();
+        }
+    }
+
+    void HideFlash()
+    {
+        if (g_ctx.uiAPI && g_ctx.flash_window_handle)
+        {
+            g_ctx.uiAPI->UI_SetVisibility(g_ctx.flash_window_handle, false);
+        }
+        g_ctx.is_flash_active = false;
+    }
+
+    void LoadRigPresetConfig()
+    {
+        const RigPresetSource source{g_ctx.loadAPI ? g_ctx.loadAPI->config : nullptr, g_ctx.configHandle, g_ctx.coreAPI ? g_ctx.coreAPI->json_reader : nullptr};
+        if (!source.IsValid())
+        {
+            return;
+        }
+
+        const size_t presets = LoadRigPresets(source, g_ctx.rig_presets);
+        const size_t profiles = LoadOffencePresets(source, g_ctx.rig_presets);
+        g_ctx.manual_preset = g_ctx.rig_presets.FindProfile(CaptureSequence::MANUAL_LABEL);
+
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[128];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Rig presets loaded: %u presets, %u offence profiles.", (unsigned)presets, (unsigned)profiles);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    const char *CaptureProfileKey(const char *label)
+    {
+        if (std::strcmp(label, CaptureSequence::RED_LIGHT_LABEL) == 0)
+        {
+            return CaptureSequence::RED_LIGHT_OFFENCE;
+        }
+        if (std::strncmp(label, "traffic_", 8) == 0)
+        {
+            return "traffic";
+        }
+        return label;
+    }
+
+    void UpdateTrafficWatch()
+    {
+        if (!g_ctx.setting_traffic_watch || g_ctx.capture.IsActive() || !g_ctx.coreAPI || !g_ctx.coreAPI->vehicle)
+        {
+            return;
+        }
+
+        TrafficCandidate candidate;
+        if (!g_ctx.traffic_watch.Tick(g_ctx.coreAPI->vehicle, g_ctx.governor.GetFrameCount(), candidate))
+        {
+            return;
+        }
+
+        // The rig is still placed relative to the player's truck: the Vehicle API exposes no
+        // traffic positions. The vehicle id and reason go into the file name instead.
+        char label[64];
+        g_ctx.formattingAPI->Fmt_Format(label, sizeof(label), "traffic_%d_%s", candidate.id, TrafficReasonName(candidate.reason));
+
+        if (g_ctx.loggerHandle)
+        {
+            char log_buffer[256];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Traffic watch: vehicle %d (%s, speed %.1f m/s, limit %.1f m/s, accel %.1f m/s2). Starting sequence.",
+                                            candidate.id, TrafficReasonName(candidate.reason), candidate.speed, candidate.speed_limit, candidate.acceleration);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+        StartCaptureSequence(label);
+    }
+
+    void ApplyTrafficWatchRules()
+    {
+        TrafficWatchRules rules = g_ctx.traffic_watch.GetRules();
+        rules.speed_ratio = g_ctx.setting_traffic_speed_ratio;
+        rules.hard_accel = g_ctx.setting_traffic_hard_accel;
+        rules.vehicles_per_frame = g_ctx.setting_traffic_vehicles_per_frame > 0 ? (uint32_t)g_ctx.setting_traffic_vehicles_per_frame : 1;
+        rules.budget_us = g_ctx.setting_traffic_scan_budget_us > 0 ? (uint32_t)g_ctx.setting_traffic_scan_budget_us : 0;
+        g_ctx.traffic_watch.SetRules(rules);
+    }
+
+    void StartMetricsPublishing()
+    {
+        const bool opened = g_ctx.metrics.Open();
+        if (g_ctx.loadAPI && g_ctx.loggerHandle)
+        {
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, opened ? SPF_LOG_INFO : SPF_LOG_ERROR,
+                                       opened ? "Metrics publishing started." : "Failed to create the shared-memory metrics segment.");
+        }
+    }
+
+    void StopMetricsPublishing()
+    {
+        if (!g_ctx.metrics.IsShared())
+        {
+            return;
+        }
+
+        // Leave the final values visible to readers before unmapping.
+        g_ctx.metrics.Publish();
+        g_ctx.metrics.Close();
+    }
+
+    void StartWorkerPool()
+    {
+        WorkerPoolConfig config;
+        config.threads = (uint32_t)g_ctx.setting_worker_threads;
+        config.priority = g_ctx.setting_worker_priority;
+        config.affinity_mask = (uint64_t)(uint32_t)g_ctx.setting_worker_affinity_mask;
+        config.run_inline = g_ctx.workers_inline;
+        if (!g_ctx.workers.Start(config))
+        {
+            return;
+        }
+
+        if (config.run_inline)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, "Worker pool started inline: jobs run on the game thread.");
+        }
+        else if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[160];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Worker pool started: %u threads, priority %d, affinity mask 0x%x.",
+                                            g_ctx.workers.GetThreadCount(), config.priority, (unsigned)config.affinity_mask);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    void StopWorkerPool()
+    {
+        if (!g_ctx.workers.IsRunning())
+        {
+            return;
+        }
+
+        g_ctx.workers.Stop();
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            const WorkerPoolStats stats = g_ctx.workers.GetStats();
+            char log_buffer[160];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Worker pool stopped: %llu jobs run (%llu stolen), %llu rejected.",
+                                            (unsigned long long)stats.executed, (unsigned long long)stats.stolen, (unsigned long long)stats.rejected);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+        }
+    }
+
+    void ProcessScreenshotLog()
+    {
+        ScreenshotResult result;
+        ScreenshotLogLine line;
+        while (g_ctx.screenshot_log_lines.Pop(line))
+        {
+            if (g_ctx.screenshots.Resolve(line.flags, line.text, line.at_us, (uint32_t)g_ctx.setting_screenshot_retries, result))
+            {
+                ReportScreenshotResult(result);
+            }
+        }
+
+        const uint64_t now = NowMicros();
+        while (g_ctx.screenshots.Expire(now, SCREENSHOT_CONFIRM_TIMEOUT_US, result))
+        {
+            ReportScreenshotResult(result);
+        }
+
+        // Retake a failed screenshot once the camera is free; a red light capture waiting for it goes first.
+        // The retry is a single still from the truck's current position, under the original label.
+        if (!g_ctx.screenshots.HasRetry() || g_ctx.capture.IsActive() || g_ctx.capture.HasPending())
+        {
+            return;
+        }
+        char label[SCREENSHOT_LABEL_SIZE];
+        uint32_t attempt = 0;
+        if (g_ctx.screenshots.TakeRetry(label, attempt) && g_ctx.capture.Start(label, false))
+        {
+            g_ctx.capture_attempt = attempt;
+            g_ctx.metrics.RecordScreenshotRetry();
+            BeginCaptureSequence();
+            if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+            {
+                char log_buffer[160];
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Retrying capture '%s' (attempt %u).", label, attempt + 1);
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_INFO, log_buffer);
+            }
+        }
+    }
+
+    void ReportScreenshotResult(const ScreenshotResult &result)
+    {
+        const uint32_t latency_us = result.latency_us > UINT32_MAX ? UINT32_MAX : (uint32_t)result.latency_us;
+        const char *format = nullptr;
+        SPF_LogLevel level = SPF_LOG_INFO;
+        switch (result.outcome)
+        {
+        case ScreenshotOutcome::Saved:
+            g_ctx.metrics.RecordScreenshotSaved(latency_us);
+            format = "Screenshot saved: %s";
+            break;
+        case ScreenshotOutcome::Failed:
+            g_ctx.metrics.RecordScreenshotFailed();
+            format = result.retry_queued ? "Screenshot failed: %s (retry queued)" : "Screenshot failed: %s";
+            level = SPF_LOG_WARN;
+            break;
+        case ScreenshotOutcome::TimedOut:
+            g_ctx.metrics.RecordScreenshotUnconfirmed();
+            format = "Screenshot not confirmed by the game log: %s";
+            break;
+        }
+
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char log_buffer[256];
+            g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), format, result.name);
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, level, log_buffer);
+        }
+
+        if (g_ctx.journal.IsOpen())
+        {
+            JournalScreenshotResult record{};
+            record.latency_us = result.latency_us;
+            record.attempt = result.attempt;
+            record.outcome = (uint8_t)result.outcome;
+            record.retry_queued = result.retry_queued ? 1 : 0;
+            memcpy(record.name, result.name, sizeof(record.name));
+            AppendCaptureJournal(JournalRecordType::ScreenshotResult, &record, sizeof(record));
+        }
+
+        if (result.outcome == ScreenshotOutcome::Saved && g_ctx.setting_quality_check && strcmp(result.label, CaptureSequence::RED_LIGHT_LABEL) == 0)
+        {
+            RequestScreenshotQuality(result);
+        }
+    }
+
+    static void RunScreenshotQuality(WorkerJob *job)
+    {
+        ScreenshotQualityJob &self = *static_cast<ScreenshotQualityJob *>(job);
+        const auto started = FrameBudgetGovernor::Clock::now();
+        self.checker.Check(self.request.path, self.thresholds, self.metrics);
+        self.elapsed_ms = std::chrono::duration<double, std::milli>(FrameBudgetGovernor::Clock::now() - started).count();
+    }
+
+    static void SubmitScreenshotQuality()
+    {
+        ScreenshotQualityJob &job = g_ctx.quality_job;
+        job.thresholds.black_luma = g_ctx.setting_quality_black_luma;
+        job.thresholds.blur_variance = g_ctx.setting_quality_blur_threshold;
+        job.busy = g_ctx.workers.Submit(&job);
+    }
+
+    static void CompleteScreenshotQuality(WorkerJob *job)
+    {
+        ScreenshotQualityJob &self = *static_cast<ScreenshotQualityJob *>(job);
+        self.busy = false;
+        const ScreenshotQualityRequest &request = self.request;
+        const QualityMetrics &metrics = self.metrics;
+
+        // Retake a bad capture while the truck is still near where the screenshot was taken; an
+        // unreadable file is not a bad capture. The retake is a retry: it counts against the same limit.
+        bool retake = false;
+        if ((metrics.flags & (QUALITY_BLACK | QUALITY_BLURRED | QUALITY_STALE)) && !(metrics.flags & QUALITY_UNREADABLE) &&
+            request.attempt < (uint32_t)g_ctx.setting_screenshot_retries)
+        {
+            const double dx = g_ctx.armed_truck_position.x - request.position.x;
+            const double dz = g_ctx.armed_truck_position.z - request.position.z;
+            const double radius = g_ctx.setting_quality_retake_radius;
+            retake = dx * dx + dz * dz <= radius * radius && radius > 0.0 && g_ctx.screenshots.QueueRetry(request.label, request.attempt + 1);
+        }
+
+        if (g_ctx.loggerHandle && g_ctx.formattingAPI)
+        {
+            char flags[48];
+            FormatQualityFlags(flags, sizeof(flags), metrics.flags);
+            char log_buffer[384];
+            if (metrics.flags & QUALITY_MISSING)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer),
+                                                "Screenshot quality: %s not found; the game may save screenshots in another format or folder. "
+                                                "Quality check disabled until it is turned off and on again.",
+                                                request.path);
+            }
+            else if (metrics.flags & QUALITY_UNREADABLE)
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Screenshot quality: could not read %s (only 8-bit PNG is checked).", request.path);
+            }
+            else
+            {
+                g_ctx.formattingAPI->Fmt_Format(log_buffer, sizeof(log_buffer), "Screenshot quality: %s is %s (luma %.1f, laplacian %.1f, difference %.2f) in %.1f ms%s.",
+                                                request.name, flags, metrics.mean_luma, metrics.laplacian_variance, metrics.difference, self.elapsed_ms,
+                                                retake ? ", retake queued" : "");
+            }
+            g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, metrics.flags ? SPF_LOG_WARN : SPF_LOG_INFO, log_buffer);
+        }
+
+        if (g_ctx.journal.IsOpen())
+        {
+            JournalScreenshotQuality record{};
+            record.mean_luma = metrics.mean_luma;
+            record.laplacian_variance = metrics.laplacian_variance;
+            record.difference = metrics.difference;
+            record.width = metrics.width;
+            record.height = metrics.height;
+            record.attempt = request.attempt;
+            record.flags = metrics.flags;
+            record.retake = retake ? 1 : 0;
+            memcpy(record.name, request.name, sizeof(record.name));
+            AppendCaptureJournal(JournalRecordType::ScreenshotQuality, &record, sizeof(record));
+        }
+        g_ctx.metrics.RecordScreenshotQuality(metrics.flags, retake);
+
+        // Every later screenshot would be missing too; checks stay off until the setting is toggled.
+        if (metrics.flags & QUALITY_MISSING)
+        {
+            g_ctx.quality_unavailable = true;
+            self.queued_count = 0;
+            return;
+        }
+
+        // The next screenshot saved meanwhile. Nothing is submitted while the pool stops.
+        if (self.queued_count != 0)
+        {
+            self.request = self.queued[0];
+            self.queued_count--;
+            memmove(self.queued, self.queued + 1, self.queued_count * sizeof(self.queued[0]));
+            SubmitScreenshotQuality();
+        }
+    }
+
+    void RequestScreenshotQuality(const ScreenshotResult &result)
+    {
+        ScreenshotQualityJob &job = g_ctx.quality_job;
+        if (g_ctx.quality_unavailable || !g_ctx.coreAPI || !g_ctx.coreAPI->environment || !g_ctx.coreAPI->environment->Env_GetSCSScreenshotsDir ||
+            !g_ctx.environmentHandle || !g_ctx.formattingAPI)
+        {
+            return;
+        }
+        if (job.busy && job.queued_count == ScreenshotQualityJob::MAX_QUEUED)
+        {
+            if (g_ctx.loggerHandle)
+                g_ctx.loadAPI->logger->Log(g_ctx.loggerHandle, SPF_LOG_WARN, "Screenshot quality: check queue full, screenshot not checked.");
+            return;
+        }
+
+        char directory[QUALITY_PATH_SIZE];
+        if (g_ctx.coreAPI->environment->Env_GetSCSScreenshotsDir(g_ctx.environmentHandle, directory, sizeof(directory)) <= 0)
+        {
+            return;
+        }
+        ScreenshotQualityRequest &request = job.busy ? job.queued[job.queued_count++] : job.request;
+        g_ctx.formattingAPI->Fmt_Format(request.path, sizeof(request.path), "%s/%s.png", directory, result.name);
+        memcpy(request.name, result.name, sizeof(request.name));
+        memcpy(request.label, result.label, sizeof(request.label));
+        request.attempt = result.attempt;
+        request.position = result.position;
+        if (!job.busy)
+        {
+            job.run = RunScreenshotQuality;
+            job.complete = CompleteScreenshotQuality;
+            SubmitScreenshotQuality();
+        }
+    }
+
+    void RecordCapturePhase(CapturePhase phase)
+    {
+        const auto elapsed = FrameBudgetGovernor::Clock::now() - g_ctx.capture_started_at;
+        const uint32_t micros = (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count();
+        g_ctx.metrics.RecordPhaseLatency(phase, micros);
+        if (phase == CapturePhase::Screenshot)
+        {
+            g_ctx.stats.RecordLatency(micros);
+        }
+    }
+
     // =================================================================================================
     // 6. Plugin Exports
     // =================================================================================================
@@ -15,6 +15,9 @@
 
 // SPF_Plugin.h: Defines the core plugin export structures (SPF_Plugin_Exports, SPF_Core_API)
 //               and lifecycle functions. This is mandatory for any plugin.
+//               SPF_Hooks_API.h, which it includes, uses size_t without including <stddef.h>,
+//               so <cstddef> has to come first outside MSVC.
+#include <cstddef>
 #include <SPF_Plugin.h>
 // SPF_Manifest_API.h: Required for defining the plugin's metadata (name, version, etc.)
 //                     via the GetManifestData function, which the framework calls first.
@@ -35,21 +38,55 @@
 
 #include <SPF_Config_API.h>       // For SPF_Config_Handle
 #include <SPF_Localization_API.h> // For SPF_Localization_Handle
-// #include <SPF_KeyBinds_API.h>       // For SPF_KeyBinds_Handle
+#include <SPF_KeyBinds_API.h>       // For SPF_KeyBinds_Handle
 #include <SPF_UI_API.h>        // For SPF_UI_API, SPF_Window_Handle
 #include <SPF_Telemetry_API.h> // For SPF_Telemetry_Handle
 // #include <SPF_Hooks_API.h>          // For SPF_Hooks_API, SPF_Hook_Handle
 #include <SPF_GameConsole_API.h> // For SPF_GameConsole_API
 // #include <SPF_VirtInput_API.h>      // For SPF_VirtualDevice_Handle
 #include <SPF_Camera_API.h> // For SPF_Camera_API
-// #include <SPF_GameLog_API.h>        // For SPF_GameLog_Callback_Handle
-// #include <SPF_JsonReader_API.h>     // For SPF_JsonValue_Handle, SPF_JsonReader_API (often with OnSettingChanged). Functions: Json_GetType, Json_GetString, etc.
+#include <SPF_Environment_API.h> // For SPF_Environment_Handle
+#include <SPF_Vehicle_API.h>     // For SPF_Vehicle_API (traffic watch)
+#include <SPF_GameLog_API.h>       // For SPF_GameLog_Callback_Handle
+#include <SPF_JsonReader_API.h>     // For SPF_JsonValue_Handle, SPF_JsonReader_API (rig presets)
 
 // =================================================================================================
 // 2. Standard Library Includes
 // =================================================================================================
 #include <cstdint> // For fixed-width integer types like int32_t, useful for consistent data sizes.
 
+// =================================================================================================
+// 2.1. Plugin Module Includes
+// =================================================================================================
+#include "TelemetryRecorder.hpp" // For TelemetryRecorder
+#include "FrameBudget.hpp"       // For FrameBudgetGovernor
+#include "SharedMetrics.hpp"     // For SharedMetricsWriter
+#include "TrafficWatch.hpp"      // For TrafficWatch
+#include "TrafficIndex.hpp"      // For TrafficIndex
+#include "CinematicPath.hpp"     // For GenerateFlyByKeyframes
+#include "CaptureSequence.hpp"   // For CaptureSequence
+#include "RigPose.hpp"           // For RigPose
+#include "RigPresets.hpp"        // For RigPresetTable
+#include "AutoFraming.hpp"       // For AutoFramer
+#include "CaptureDedup.hpp"      // For CaptureDedup
+#include "ViolationHeatmap.hpp"  // For HeatmapGrid, HeatmapView
+#include "ViolationSites.hpp"    // For ViolationSiteIndex
+#include "MappedFile.hpp"        // For MappedFile
+#include "HistoryStore.hpp"      // For HistoryWriter, MaintainHistory
+#include "TrackExport.hpp"       // For ExportTracks
+#include "CaptureJournal.hpp"    // For CaptureJournal
+#include "ViolationExport.hpp"   // For ExportViolations
+#include "FlashCurve.hpp"        // For FlashCurve
+#include "CaptureStats.hpp"      // For CaptureStats, Sparkline
+#include "RigPresetConfig.hpp"   // For LoadRigPresets
+#include "CaptureNaming.hpp"     // For FormatScreenshotCommand
+#include "WorkerPool.hpp"        // For WorkerPool
+#include "LogMatcher.hpp"        // For ScreenshotLogMatcher
+#include "ScreenshotTracker.hpp" // For ScreenshotTracker
+#include "ScreenshotQuality.hpp" // For ScreenshotQualityChecker
+#include "CameraSnapshot.hpp"    // For CameraSnapshot
+#include "SettingsSchema.hpp"    // For RLC_SETTINGS
+
 // It's a strong best practice to wrap all your plugin's code in a unique namespace.
 // This prevents naming conflicts with the framework or other plugins that might be loaded.
 namespace SPF_RedLightCamera
@@ -59,6 +96,111 @@ namespace SPF_RedLightCamera
   // 3. Core Plugin Architecture
   // =================================================================================================
 
+  // --- Background Jobs ---
+
+  /**
+   * @brief Seals and merges the capture history segments on the worker pool (see MaintainHistory).
+   * @details Only the game thread submits it and reads `result`, in the completion.
+   */
+  struct HistoryMaintenanceJob : WorkerJob
+  {
+    char directory[HISTORY_PATH_SIZE] = "";
+    uint32_t active_sequence = 0;
+    HistoryMaintenanceResult result;
+    bool busy = false;  ///< Submitted and not yet completed.
+    bool again = false; ///< Requested while busy (or while a track export reads the segments); resubmitted on completion.
+    bool reopen = false; ///< The history was enabled while busy; opened on completion.
+  };
+
+  /**
+   * @brief Exports the path before every red light fine in the capture history on the worker pool
+   *        (see ExportTracks). Never runs alongside a maintenance run, which may delete segments.
+   */
+  struct TrackExportJob : WorkerJob
+  {
+    char directory[HISTORY_PATH_SIZE] = "";
+    char out_path[HISTORY_PATH_SIZE] = "";
+    TrackExportOptions options;
+    TrackExportResult result;
+    double elapsed_ms = 0.0;
+    bool busy = false;
+    bool queued = false; ///< Requested during maintenance; submitted when it completes.
+  };
+
+  /**
+   * @brief Exports the fines in the capture journal to an Arrow IPC stream on the worker pool (see
+   *        ExportViolations). Only the game thread submits it and reads `result`.
+   */
+  struct ViolationExportJob : WorkerJob
+  {
+    char journal_path[VIOLATION_PATH_SIZE] = "";
+    char out_path[VIOLATION_PATH_SIZE] = "";
+    char screenshot_dir[VIOLATION_PATH_SIZE] = "";
+    ViolationExportResult result;
+    double elapsed_ms = 0.0;
+    bool busy = false;
+  };
+
+  /**
+   * @brief Makes a capture journal checkpoint durable on the worker pool (see
+   *        CaptureJournal::WriteCheckpoint), so its two syncs never stall a frame.
+   * @details Only the game thread prepares and submits it and reads `written`, in the completion.
+   */
+  struct JournalCheckpointJob : WorkerJob
+  {
+    char path[VIOLATION_PATH_SIZE] = "";
+    JournalCheckpoint checkpoint = {};
+    bool written = false;
+    bool busy = false;
+    bool stale = false;  ///< The journal was closed while it ran; the outcome is ignored.
+    bool reopen = false; ///< The journal was enabled again while it ran; opened on completion.
+  };
+
+  /**
+   * @brief Builds the proximity alert index from the violation heatmap file on the worker pool (see
+   *        ViolationSites.hpp). The completion swaps it into `violation_sites`.
+   * @details Only the game thread submits it and reads `index`, in the completion.
+   */
+  struct ViolationSitesJob : WorkerJob
+  {
+    char path[VIOLATION_PATH_SIZE] = "";
+    ViolationSiteIndex index;
+    bool built = false;
+    double elapsed_ms = 0.0;
+    bool busy = false;
+    bool again = false; ///< Requested while busy; resubmitted on completion.
+  };
+
+  /** @brief A saved red light screenshot waiting for its quality check. */
+  struct ScreenshotQualityRequest
+  {
+    char path[QUALITY_PATH_SIZE];
+    char name[SCREENSHOT_NAME_SIZE];
+    char label[SCREENSHOT_LABEL_SIZE];
+    uint32_t attempt;
+    SPF_DVector position; ///< Of the truck when the screenshot command was issued.
+  };
+
+  /**
+   * @brief Checks saved red light screenshots for black, blurred or stale frames on the worker pool
+   *        (see ScreenshotQuality.hpp), one at a time and in order, each against the one before.
+   * @details Only the game thread queues requests and reads `metrics`, in the completion.
+   */
+  struct ScreenshotQualityJob : WorkerJob
+  {
+    static constexpr size_t MAX_QUEUED = 8;
+
+    ScreenshotQualityRequest request; ///< The one being checked.
+    QualityThresholds thresholds;
+    QualityMetrics metrics;
+    ScreenshotQualityChecker checker; ///< About 1 MB; g_ctx is in static storage.
+    double elapsed_ms = 0.0;
+    bool busy = false;
+
+    ScreenshotQualityRequest queued[MAX_QUEUED]; ///< Saved while busy, in order.
+    size_t queued_count = 0;
+  };
+
   // --- Plugin Context ---
 
   /**
@@ -88,7 +230,7 @@ namespace SPF_RedLightCamera
 
     SPF_Config_Handle *configHandle = nullptr;             // Requires: SPF_Config_API.h
     SPF_Localization_Handle *localizationHandle = nullptr; // Requires: SPF_Localization_API.h
-                                                           // SPF_KeyBinds_Handle* keybindsHandle = nullptr;     // Requires: SPF_KeyBinds_API.h
+    SPF_KeyBinds_Handle *keybindsHandle = nullptr;         // Requires: SPF_KeyBinds_API.h
     SPF_UI_API *uiAPI = nullptr; // Requires: SPF_UI_API.h
                                  // SPF_Window_Handle* mainWindowHandle = nullptr;     // Requires: SPF_UI_API.h (Example for a main UI window)
     SPF_Telemetry_Handle *telemetryHandle = nullptr; // Requires: SPF_Telemetry_API.h
@@ -96,19 +238,21 @@ namespace SPF_RedLightCamera
     SPF_GameConsole_API *gameConsoleAPI = nullptr; // Requires: SPF_GameConsole_API.h
                                                    // SPF_VirtualDevice_Handle* virtualDeviceHandle = nullptr; // Requires: SPF_VirtInput_API.h
     SPF_Camera_API *cameraAPI = nullptr; // Requires: SPF_Camera_API.h
-                                         // SPF_GameLog_Callback_Handle gameLogCallbackHandle = nullptr; // Requires: SPF_GameLog_API.h
+    SPF_GameLog_Handle *gameLogHandle = nullptr;                     // Requires: SPF_GameLog_API.h
+    SPF_GameLog_Callback_Handle *gameLogCallbackHandle = nullptr;    // Requires: SPF_GameLog_API.h
+    SPF_Environment_Handle *environmentHandle = nullptr; // Requires: SPF_Environment_API.h
 
     // --- Telemetry Callback Handles (Optional - Uncomment if needed) ---
     // These handles manage the lifetime of telemetry subscriptions. Storing them explicitly
     // is good practice, though their lifetime is automatically tied to 'telemetryHandle'.
     // Requires: SPF_Telemetry_API.h
     // SPF_Telemetry_Callback_Handle* gameStateSubscription = nullptr;
-    // SPF_Telemetry_Callback_Handle* timestampsSubscription = nullptr;
+    SPF_Telemetry_Callback_Handle *timestampsSubscription = nullptr;
     // SPF_Telemetry_Callback_Handle* commonDataSubscription = nullptr;
-    // SPF_Telemetry_Callback_Handle* truckConstantsSubscription = nullptr;
-    // SPF_Telemetry_Callback_Handle* trailerConstantsSubscription = nullptr;
-    // SPF_Telemetry_Callback_Handle* truckDataSubscription = nullptr;
-    // SPF_Telemetry_Callback_Handle* trailersSubscription = nullptr;
+    SPF_Telemetry_Callback_Handle *truckConstantsSubscription = nullptr;
+    SPF_Telemetry_Callback_Handle *trailerConstantsSubscription = nullptr;
+    SPF_Telemetry_Callback_Handle *truckDataSubscription = nullptr;
+    SPF_Telemetry_Callback_Handle *trailersSubscription = nullptr;
     // SPF_Telemetry_Callback_Handle* jobConstantsSubscription = nullptr;
     // SPF_Telemetry_Callback_Handle* jobDataSubscription = nullptr;
     // SPF_Telemetry_Callback_Handle* navigationDataSubscription = nullptr;
@@ -119,21 +263,118 @@ namespace SPF_RedLightCamera
 
     // --- Plugin State Variables (Optional - Uncomment/Add if needed) ---
     // Add any plugin-specific state variables here.
-    bool sequence_active = false;
-    int sequence_frame_counter = 0;
-    SPF_CameraType originalCameraType = SPF_CAMERA_INTERIOR;
-    float originalYaw;
-    float originalPitch;
+    CaptureSequence capture;        // Capture state machine, label and queued red light capture (see CaptureSequence.hpp).
+    CameraSnapshot original_camera; // The player's camera setup before the sequence (see CameraSnapshot.hpp).
 
-    // Cache settings variables
-    float setting_distance_forward = 0.0f;
-    float setting_height_above = 0.0f;
-    float setting_field_of_view = 0.0f;
+    // Cache settings variables: one `setting_<key>` per entry in SettingsSchema.hpp.
+    RLC_SETTINGS(RLC_SETTING_FIELD)
 
+    // Flash overlay (see FlashCurve.hpp). Timed against the game's render timestamps.
     bool is_flash_active = false;
-    float flash_alpha = 0.0f;
+    bool is_screenshot_frame = false; // A screenshot was issued this update; the flash may skip drawing.
+    FlashCurve flash_curve;           // Sampled from flash_style and flash_duration_ms.
+    uint64_t flash_started_us = 0;
+    uint64_t render_time_us = 0;      // Latest render timestamp from OnTimestamps.
     SPF_Window_Handle *flash_window_handle = nullptr;
 
+    // Telemetry recording (see TelemetryRecorder.hpp)
+    TelemetryRecorder recorder;
+
+    // Per-frame cost accounting and deferred optional work (see FrameBudget.hpp)
+    FrameBudgetGovernor governor;
+
+    // Live metrics for external monitoring (see SharedMetrics.hpp)
+    SharedMetricsWriter metrics;
+    FrameBudgetGovernor::Clock::time_point capture_started_at;
+
+    // Statistics HUD (see CaptureStats.hpp). The text is re-formatted only when a value changes.
+    CaptureStats stats;
+    Sparkline frame_sparkline;
+    char stats_text[768] = "";
+    uint64_t stats_text_key = ~0ull;
+
+    // Violation heatmap (see ViolationHeatmap.hpp). The palette is converted on the first draw.
+    HeatmapGrid heatmap;
+    HeatmapView heatmap_view;
+    uint32_t heatmap_palette[HEATMAP_LEVELS] = {};
+    bool heatmap_palette_ready = false;
+    char heatmap_text[192] = "";
+    uint64_t heatmap_text_key = ~0ull;
+
+    // Proximity alerts (see ViolationSites.hpp). `proximity_site` is the site last alerted for,
+    // kept until the truck is well clear of it so one junction alerts once per approach.
+    ViolationSiteIndex violation_sites;
+    ViolationSitesJob sites_job;
+    uint32_t proximity_site = ~0u;
+
+    // Capture history (see HistoryStore.hpp). One maintenance run is in flight at a time; a
+    // request while it runs is remembered and served when it completes. The track export
+    // (see TrackExport.hpp) takes turns with maintenance the same way.
+    HistoryWriter history;
+    HistoryMaintenanceJob history_job;
+    TrackExportJob track_job;
+    uint64_t history_last_sample_time = ~0ull;
+
+    // Crash-safe journal of fines, screenshots and their outcome (see CaptureJournal.hpp), and its
+    // export for analytics (see ViolationExport.hpp).
+    CaptureJournal journal;
+    JournalCheckpointJob checkpoint_job;
+    ViolationExportJob export_job;
+
+    // AI traffic scanner (see TrafficWatch.hpp)
+    TrafficWatch traffic_watch;
+
+    // Spatial index of nearby traffic for framing (see TrafficIndex.hpp). Needs a position source.
+    TrafficIndex traffic_index;
+
+    // Cinematic fly-by of the capture in progress (see CinematicPath.hpp).
+    SPF_CameraState_t cinematic_keyframes[CINEMATIC_MAX_KEYFRAMES];
+    size_t cinematic_keyframe_count = 0;
+    int32_t cinematic_shot_count = 0;
+    int32_t cinematic_shots_taken = 0;
+
+    // Background threads for file and image work; completions are drained in OnUpdate (see WorkerPool.hpp).
+    // `workers_inline` runs the jobs on the game thread instead; rlc_replay sets it before OnActivated.
+    WorkerPool workers;
+    bool workers_inline = false;
+
+    // Screenshot confirmation from the game log (see LogMatcher.hpp, ScreenshotTracker.hpp).
+    // Matching lines are queued by OnGameLogMessage, which may run on any thread, and resolved in OnUpdate.
+    ScreenshotLogMatcher screenshot_log_matcher;
+    BoundedMpmcQueue<ScreenshotLogLine, 32> screenshot_log_lines;
+    ScreenshotTracker screenshots;
+    uint32_t capture_attempt = 0; // 0 for a first capture, n for the n-th retry of a failed screenshot.
+    ScreenshotQualityJob quality_job; // Checks saved red light screenshots; may queue retakes (see RequestScreenshotQuality).
+    bool quality_unavailable = false; // A screenshot was not where the check looks for it; set until the check is re-enabled.
+
+    // Repeated fines at one junction (see CaptureDedup.hpp). Red light captures get an id when they
+    // start or are queued, so the table can name them once the screenshot is taken; 0 is none.
+    CaptureDedup dedup;
+    uint32_t dedup_next_id = 1;
+    uint32_t capture_dedup_id = 0;
+    uint32_t pending_dedup_id = 0;
+
+    // Named rig presets and offence profiles, parsed from JSON settings (see RigPresetConfig.hpp).
+    // A capture resolves its preset index once when it starts; -1 uses the camera sliders.
+    RigPresetTable rig_presets;
+    int32_t capture_preset = -1;
+    int32_t manual_preset = -1; // Preset of the "manual" profile, for the armed pose.
+
+    // Auto-framing of the truck and trailer combination (see AutoFraming.hpp). The box is rebuilt
+    // only after the constants change or a trailer is coupled or dropped.
+    AutoFramer auto_framer;
+    uint32_t framed_trailer_count = 0;
+
+    // Manual capture keybind (see OnManualCaptureKey). The rig pose is re-armed on every truck data
+    // update, so a key press goes straight to the camera and the screenshot: no telemetry fetch, no trig.
+    RigPose armed_pose;
+    SPF_DVector armed_truck_position = {};
+    uint64_t armed_simulation_time = 0;
+    bool is_pose_armed = false;
+    bool is_manual_capture = false; // The capture in flight was started by the keybind.
+    uint64_t manual_key_at_us = 0;
+    uint64_t manual_key_frame = 0;
+
     // int32_t someNumberSetting = 0;   // Example for a configurable setting
   };
 
@@ -230,22 +471,41 @@ namespace SPF_RedLightCamera
   void RenderFlashWindow(SPF_UI_API *ui, void *user_data);
 
   /**
-   * @brief Callback executed when a keybind action is triggered by the user.
-   * @details Uncomment this if your plugin defines keybinds in its manifest and needs to react
-   *          to user input. You would typically register this callback in `OnActivated`.
-   *          Requires: SPF_KeyBinds_API.h (for registration, but callback itself is void(void))
+   * @brief Renders the statistics HUD: fines per offence, capture totals, latency and a frame cost
+   *        sparkline. Opened and closed from the framework's window list.
+   */
+  void RenderStatsWindow(SPF_UI_API *ui, void *user_data);
+
+  /** @brief Re-formats the HUD text from the metrics and the rolling stats. */
+  void FormatStatsText();
+
+  /**
+   * @brief Renders the violation heatmap around the truck as coloured cells, from the cached view.
+   *        Opened and closed from the framework's window list.
+   */
+  void RenderHeatmapWindow(SPF_UI_API *ui, void *user_data);
+
+  /**
+   * @brief Callback for the manual capture keybind.
+   * @details Starts a single-still capture labelled "manual" from the pre-armed pose. Ignored while
+   *          another capture is in flight.
+   */
+  void OnManualCaptureKey();
+
+  /**
+   * @brief Callback for the violation export keybind.
+   * @details Starts `RequestViolationExport` and `RequestTrackExport`; each is ignored while it is running.
    */
-  // void OnKeybindAction();
+  void OnViolationExportKey();
 
   /**
    * @brief Callback for game log messages.
-   * @details Uncomment this if your plugin needs to monitor the game's internal log output.
-   *          You would typically register this callback in `OnActivated`.
-   *          Requires: SPF_GameLog_API.h (for registration, but callback itself is const char*, void*)
+   * @details Runs for every line the game logs, possibly off the game thread. Lines are classified
+   *          with `ScreenshotLogMatcher`; the rare screenshot lines are queued for `OnUpdate`.
    * @param log_line The content of the log line.
    * @param user_data A pointer to user-defined data passed during registration.
    */
-  // void OnGameLogMessage(const char* log_line, void* user_data);
+  void OnGameLogMessage(const char *log_line, void *user_data);
 
   // =================================================================================================
   // 4.2. Function Prototypes - Optional Helper Functions (Commented Out)
@@ -258,6 +518,274 @@ namespace SPF_RedLightCamera
   // void InstallGameHook();         // Example for SPF_Hooks_API
   void PositionAndOrientRedLightCamera();
 
+  /**
+   * @brief Switches to the free camera and moves it to `pose`.
+   * @details Only Camera API calls: the pose is already in world coordinates and only needs the
+   *          local grid offset.
+   */
+  void ApplyRigPose(const RigPose &pose);
+
+  /**
+   * @brief Advances the red light capture sequence by one frame.
+   * @details Called from `OnUpdate` inside the frame budget scope. Does nothing while no
+   *          sequence is active.
+   */
+  void AdvanceCaptureSequence();
+
+  /**
+   * @brief Advances a cinematic fly-by capture by one frame.
+   * @details Frame 1 loads the keyframes into the camera animation system and starts playback.
+   *          Later frames take a screenshot whenever playback passes the next shot parameter,
+   *          then stop playback, reload the user's saved camera states and restore the camera.
+   */
+  void AdvanceCinematicSequence();
+
+  /**
+   * @brief Issues the `screenshot` console command for the capture in progress.
+   * @param shot Shot index appended to the file name, or -1 for a single still.
+   * @return true if the command was executed.
+   */
+  bool ExecuteCaptureScreenshot(int32_t shot);
+
+  /**
+   * @brief Clears the sequence state and records the completed capture. The flash fades out on
+   *        its own clock (see UpdateFlash).
+   */
+  void FinishCaptureSequence();
+
+  /**
+   * @brief Hides the flash once its curve has run out. If the render clock has not moved since
+   *        the flash started, the flash ends with the capture instead.
+   */
+  void UpdateFlash();
+
+  /** @brief Hides the flash window. */
+  void HideFlash();
+
+  /**
+   * @brief Finds the world position of the game's moving local grid origin.
+   * @details Compares the free camera's world and local positions, so the free camera must be active.
+   * @return false if the Camera API is unavailable.
+   */
+  bool GetLocalGridOrigin(double &origin_x, double &origin_z);
+
+  /**
+   * @brief Starts the capture sequence on the next frame, unless one is already running.
+   * @param label Screenshot file name prefix for this capture (e.g. "red_light"), or nullptr to
+   *              start the red light capture queued by `CaptureSequence::OnFine`.
+   */
+  void StartCaptureSequence(const char *label);
+
+  /**
+   * @brief Shows the flash, starts the latency clock and resolves the rig preset for a capture the
+   *        sequence just accepted.
+   */
+  void BeginCaptureSequence();
+
+  /**
+   * @brief Parses all rig presets and offence profiles from the config.
+   * @details Needs the JSON Reader API, so it runs from `OnActivated`, and again when the whole
+   *          array changes.
+   */
+  void LoadRigPresetConfig();
+
+  /**
+   * @brief Maps a capture label to its offence profile key ("red_signal", "traffic", "manual", ...).
+   */
+  const char *CaptureProfileKey(const char *label);
+
+  /**
+   * @brief Advances the traffic scan by one budgeted slice and starts a capture on a match.
+   */
+  void UpdateTrafficWatch();
+
+  /**
+   * @brief Copies the cached traffic settings into the scanner's rules.
+   */
+  void ApplyTrafficWatchRules();
+
+  /**
+   * @brief True when traffic framing is enabled and the traffic index has a position source.
+   * @details Without a source the index stays empty, so neither its per-frame update nor the
+   *          framing query is worth running.
+   */
+  bool IsTrafficFramingActive();
+
+  /**
+   * @brief Shifts the look-at point and widens the FOV so traffic near the truck stays in shot.
+   * @details Queries the traffic index around `pose.look_target` (the truck) and hands the hits
+   *          to `FrameRigTargets` with the current viewport aspect.
+   * @return true if any vehicle was framed.
+   */
+  bool WidenRigForTraffic(RigPose &pose);
+
+  /**
+   * @brief Viewport width / height: the game's view rectangle (`Cam_GetViewport`) scaled by the
+   *        UI viewport size. 16:9 if neither is available.
+   */
+  double GetViewportAspect();
+
+  /**
+   * @brief Replaces `pose` with the auto-framed rig when `auto_framing` is on.
+   * @details Rebuilds the combination box from the truck and trailer constants if it was
+   *          invalidated, then takes the cached solution (solved again only when the request
+   *          changed) and places it at the truck.
+   * @param rig_offset The rig's placement in the truck's frame (see AutoFraming.hpp).
+   * @return true if the pose was replaced.
+   */
+  bool FitRigToCombination(RigPose &pose, const SPF_DVector &truck, double heading, const SPF_FVector &rig_offset);
+
+  /**
+   * @brief Records the time elapsed since the current capture's fine in the given phase histogram.
+   */
+  void RecordCapturePhase(CapturePhase phase);
+
+  /**
+   * @brief Opens a new telemetry recording in the plugin's data directory.
+   * @details The file is named `telemetry_<unix time>.rlcrec`. Does nothing if a recording
+   *          is already open or the Environment/Telemetry APIs are unavailable.
+   */
+  void StartTelemetryRecording();
+
+  /**
+   * @brief Flushes and closes the current telemetry recording, if any.
+   */
+  void StopTelemetryRecording();
+
+  /**
+   * @brief Loads the violation heatmap from the plugin's data directory and starts adding red
+   *        light fines to it.
+   */
+  void OpenViolationHeatmap();
+
+  /**
+   * @brief Closes the violation heatmap file; the window keeps showing what was loaded.
+   */
+  void CloseViolationHeatmap();
+
+  /**
+   * @brief Rebuilds the proximity alert index from the violation heatmap file on the worker pool.
+   * @details The current index keeps answering queries until the new one is swapped in.
+   */
+  void LoadViolationSites();
+
+  /**
+   * @brief Every `proximity_check_frames` frames, looks up the nearest earlier violation site and
+   *        shows a notification when the truck comes within the alert radius of a new one.
+   */
+  void UpdateProximityAlert();
+
+  /**
+   * @brief Starts a new capture history segment in the plugin's data directory and seals or
+   *        merges the earlier ones in the background. Deferred while a maintenance run is in flight.
+   */
+  void OpenCaptureHistory();
+
+  /**
+   * @brief Writes the buffered history records and closes the segment. It is sealed once the
+   *        history is reopened, or by `FinishHistoryMaintenance` on unload.
+   */
+  void CloseCaptureHistory();
+
+  /**
+   * @brief Appends the truck's current position, heading and speed to the capture history.
+   */
+  void AppendCaptureHistory(HistoryKind kind);
+
+  /**
+   * @brief Every `history_sample_frames` frames, appends the truck's position to the capture history.
+   */
+  void SampleCaptureHistory();
+
+  /**
+   * @brief Queues a history maintenance run on the worker pool, or marks one to follow the run in flight.
+   */
+  void RequestHistoryMaintenance();
+
+  /**
+   * @brief Runs a last maintenance pass on the calling thread, sealing the last segment too.
+   *        Only after the worker pool has stopped and the history is closed.
+   */
+  void FinishHistoryMaintenance();
+
+  /**
+   * @brief Opens the capture journal in the plugin's data directory, recovering a torn tail.
+   *        Deferred while a checkpoint of the previous open is still being written.
+   */
+  void OpenCaptureJournal();
+
+  /**
+   * @brief Checkpoints and closes the capture journal.
+   */
+  void CloseCaptureJournal();
+
+  /**
+   * @brief Appends a record to the capture journal and schedules a checkpoint when one is due.
+   */
+  void AppendCaptureJournal(JournalRecordType type, const void *payload, size_t size);
+
+  /**
+   * @brief Hands a capture journal checkpoint to the worker pool, unless one is already in flight.
+   */
+  void RequestJournalCheckpoint();
+
+  /**
+   * @brief Journals a fine with the truck's heading, speed, id and plate, and what became of its capture.
+   */
+  void AppendFineJournal(const SPF_GameplayEvent_PlayerFined &fine, const SPF_DVector &position, uint64_t simulation_time, JournalFineCapture capture,
+                         uint32_t capture_id);
+
+  /**
+   * @brief Exports the fines in the capture journal to `violations.arrows` in the plugin's data
+   *        directory, on the worker pool.
+   */
+  void RequestViolationExport();
+
+  /**
+   * @brief Exports the path before every red light fine in the capture history to
+   *        `violation_tracks.geojson` or `.gpx` in the plugin's data directory, on the worker pool.
+   */
+  void RequestTrackExport();
+
+  /**
+   * @brief Creates the shared-memory metrics segment and starts publishing to it every frame.
+   */
+  void StartMetricsPublishing();
+
+  /**
+   * @brief Publishes the final values and unmaps the metrics segment, if mapped.
+   */
+  void StopMetricsPublishing();
+
+  /**
+   * @brief Starts the background worker pool with the configured size, priority and affinity.
+   * @details Called from `OnActivated`; the settings take effect on the next activation.
+   */
+  void StartWorkerPool();
+
+  /**
+   * @brief Finishes the pool's queued jobs, joins its threads and runs the remaining completions.
+   */
+  void StopWorkerPool();
+
+  /**
+   * @brief Resolves queued screenshot log lines and timeouts, and starts a queued retry when idle.
+   */
+  void ProcessScreenshotLog();
+
+  /**
+   * @brief Logs a resolved screenshot and records it in the metrics. A saved red light screenshot
+   *        goes to the quality check.
+   */
+  void ReportScreenshotResult(const ScreenshotResult &result);
+
+  /**
+   * @brief Queues a saved screenshot for the quality check on the worker pool. A bad capture is
+   *        recorded in the capture journal and, while the truck is within the retake radius and
+   *        retries are left, queued for a retake.
+   */
+  void RequestScreenshotQuality(const ScreenshotResult &result);
+
   // =================================================================================================
   // 4.3. Function Prototypes - Telemetry Callbacks (Optional - Commented Out)
   // =================================================================================================
@@ -265,12 +793,12 @@ namespace SPF_RedLightCamera
   // Requires: SPF_Telemetry_API.h
 
   // void OnGameState(const SPF_GameState* data, void* user_data);
-  // void OnTimestamps(const SPF_Timestamps* data, void* user_data);
+  void OnTimestamps(const SPF_Timestamps *data, void *user_data);
   // void OnCommonData(const SPF_CommonData* data, void* user_data);
-  // void OnTruckConstants(const SPF_TruckConstants* data, void* user_data);
-  // void OnTrailerConstants(const SPF_TrailerConstants* data, void* user_data);
-  // void OnTruckData(const SPF_TruckData* data, void* user_data);
-  // void OnTrailers(const SPF_Trailer* trailers, uint32_t count, void* user_data);
+  void OnTruckConstants(const SPF_TruckConstants *data, void *user_data);
+  void OnTrailerConstants(const SPF_TrailerConstants *data, void *user_data);
+  void OnTruckData(const SPF_TruckData *data, void *user_data);
+  void OnTrailers(const SPF_Trailer *trailers, uint32_t count, void *user_data);
   // void OnJobConstants(const SPF_JobConstants* data, void* user_data);
   // void OnJobData(const SPF_JobData* data, void* user_data);
   // void OnNavigationData(const SPF_NavigationData* data, void* user_data);
@@ -0,0 +1,222 @@
+/**
+ * @file SettingsSchema.hpp
+ * @brief The plugin's settings, declared once and expanded at compile time.
+ * @details `RLC_SETTINGS` lists every setting as one line:
+ *
+ *     X(key, type, default, min, max, format, localization name, change handler)
+ *
+ * From that list the build produces the typed `PluginContext::setting_<key>` fields, the defaults
+ * JSON passed to `Settings_SetJson`, the slider parameter strings for `Meta_AddCustomSetting`,
+ * and the descriptor table that `OnLoad` and `OnSettingChanged` walk. All strings are literals
+ * (defaults are stringized tokens), so building the manifest does not allocate.
+ *
+ * `type` is `Float`, `Int` or `Bool`. Bools are shown as checkboxes and ignore min/max/format.
+ * The localization name `X` maps to the keys `Setting.X.Title` and `Setting.X.Description`.
+ * The change handler is a `void()` called after the new value is stored, or `nullptr`.
+ *
+ * Structured settings (arrays and objects) cannot be expressed as sliders and are not part of the
+ * list. Their defaults are `RLC_STRUCTURED_SETTINGS_JSON`, placed before the scalar members, and
+ * they are read through the JSON Reader API (see `RigPresetConfig.hpp`).
+ */
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+// clang-format off
+#define RLC_SETTINGS(X) \
+    X(distance_forward,           Float, 25.0,  -100.0, 100.0,  "%0.1f",      DistanceForward,          OnRigSettingChanged) \
+    X(height_above,               Float, 4.0,   -100.0, 100.0,  "%0.1f",      HeightAbove,              OnRigSettingChanged) \
+    X(field_of_view,              Float, 70.0,  0.0,    120.0,  "%0.1f",      FieldOfView,              OnRigSettingChanged) \
+    X(record_telemetry,           Bool,  false, 0,      0,      "",           RecordTelemetry,          OnRecordTelemetryChanged) \
+    X(frame_budget_us,            Int,   500,   0,      5000,   "%d us",      FrameBudget,              OnFrameBudgetChanged) \
+    X(publish_metrics,            Bool,  false, 0,      0,      "",           PublishMetrics,           OnPublishMetricsChanged) \
+    X(traffic_watch,              Bool,  false, 0,      0,      "",           TrafficWatch,             OnTrafficWatchChanged) \
+    X(traffic_speed_ratio,        Float, 1.25,  1.0,    2.0,    "x%0.2f",     TrafficSpeedRatio,        ApplyTrafficWatchRules) \
+    X(traffic_hard_accel,         Float, 4.0,   0.0,    15.0,   "%0.1f m/s2", TrafficHardAccel,         ApplyTrafficWatchRules) \
+    X(traffic_vehicles_per_frame, Int,   16,    1,      128,    "%d",         TrafficVehiclesPerFrame,  ApplyTrafficWatchRules) \
+    X(traffic_scan_budget_us,     Int,   100,   0,      1000,   "%d us",      TrafficScanBudget,        ApplyTrafficWatchRules) \
+    X(frame_crossing_traffic,     Bool,  false, 0,      0,      "",           FrameCrossingTraffic,     OnFrameCrossingTrafficChanged) \
+    X(crossing_traffic_radius,    Float, 40.0,  5.0,    150.0,  "%0.0f m",    CrossingTrafficRadius,    OnRigSettingChanged) \
+    X(auto_framing,               Int,   0,     0,      2,      "%d",         AutoFraming,              OnRigSettingChanged) \
+    X(auto_framing_margin,        Float, 1.1,   1.0,    2.0,    "x%0.2f",     AutoFramingMargin,        OnRigSettingChanged) \
+    X(cinematic_capture,          Bool,  false, 0,      0,      "",           CinematicCapture,         nullptr) \
+    X(cinematic_sweep,            Float, 90.0,  10.0,   360.0,  "%0.0f deg",  CinematicSweep,           nullptr) \
+    X(cinematic_keyframes,        Int,   8,     2,      32,     "%d",         CinematicKeyframes,       nullptr) \
+    X(cinematic_shots,            Int,   3,     1,      8,      "%d",         CinematicShots,           nullptr) \
+    X(worker_threads,             Int,   2,     1,      8,      "%d",         WorkerThreads,            nullptr) \
+    X(worker_priority,            Int,   -1,    -2,     2,      "%d",         WorkerPriority,           nullptr) \
+    X(worker_affinity_mask,       Int,   0,     0,      65535,  "%d",         WorkerAffinityMask,       nullptr) \
+    X(screenshot_retries,         Int,   1,     0,      3,      "%d",         ScreenshotRetries,        nullptr) \
+    X(quality_check,              Bool,  false, 0,      0,      "",           QualityCheck,             OnQualityCheckChanged) \
+    X(quality_black_luma,         Float, 10.0,  0.0,    64.0,   "%0.0f",      QualityBlackLuma,         nullptr) \
+    X(quality_blur_threshold,     Float, 25.0,  0.0,    500.0,  "%0.0f",      QualityBlurThreshold,     nullptr) \
+    X(quality_retake_radius,      Float, 50.0,  0.0,    500.0,  "%0.0f m",    QualityRetakeRadius,      nullptr) \
+    X(dedup_window_s,             Float, 15.0,  0.0,    120.0,  "%0.0f s",    DedupWindow,              OnDedupSettingChanged) \
+    X(dedup_cell_size,            Float, 25.0,  5.0,    200.0,  "%0.0f m",    DedupCellSize,            OnDedupSettingChanged) \
+    X(heatmap,                    Bool,  false, 0,      0,      "",           Heatmap,                  OnHeatmapChanged) \
+    X(heatmap_range,              Float, 2000.0, 250.0, 20000.0, "%0.0f m",   HeatmapRange,             nullptr) \
+    X(proximity_alerts,           Bool,  false, 0,      0,      "",           ProximityAlerts,          OnProximityAlertsChanged) \
+    X(proximity_radius,           Float, 250.0, 50.0,   1000.0, "%0.0f m",    ProximityRadius,          nullptr) \
+    X(proximity_check_frames,     Int,   30,    1,      240,    "%d",         ProximityCheckFrames,     nullptr) \
+    X(capture_history,            Bool,  false, 0,      0,      "",           CaptureHistory,           OnCaptureHistoryChanged) \
+    X(history_sample_frames,      Int,   60,    1,      600,    "%d",         HistorySampleFrames,      nullptr) \
+    X(track_export_format,        Int,   0,     0,      1,      "%d",         TrackExportFormat,        nullptr) \
+    X(track_tolerance,            Float, 2.0,   0.0,    25.0,   "%0.1f m",    TrackTolerance,           nullptr) \
+    X(track_window_s,             Float, 30.0,  5.0,    120.0,  "%0.0f s",    TrackWindow,              nullptr) \
+    X(capture_journal,            Bool,  false, 0,      0,      "",           CaptureJournal,           OnCaptureJournalChanged) \
+    X(flash_style,                Int,   0,     0,      3,      "%d",         FlashStyle,               OnFlashSettingChanged) \
+    X(flash_duration_ms,          Int,   300,   50,     2000,   "%d ms",      FlashDuration,            OnFlashSettingChanged) \
+    X(flash_skip_screenshot_frame, Bool, true,  0,      0,      "",           FlashSkipScreenshotFrame, nullptr)
+
+// Rig presets and the offence profiles that select them. Index -1 means "use the camera sliders".
+#define RLC_STRUCTURED_SETTINGS_JSON \
+    "\"rig_presets\": [" \
+        "{ \"name\": \"Front\", \"distance\": 25.0, \"height\": 4.0, \"fov\": 70.0 }," \
+        "{ \"name\": \"Wide\", \"distance\": 35.0, \"height\": 9.0, \"fov\": 90.0 }," \
+        "{ \"name\": \"Side\", \"distance\": 4.0, \"lateral\": 14.0, \"height\": 2.5, \"fov\": 60.0 }," \
+        "{ \"name\": \"Overhead\", \"distance\": 1.0, \"height\": 30.0, \"pitch\": -80.0, \"fov\": 75.0 }" \
+    "]," \
+    "\"offence_presets\": [" \
+        "{ \"offence\": \"red_signal\", \"preset\": -1 }," \
+        "{ \"offence\": \"traffic\", \"preset\": -1 }," \
+        "{ \"offence\": \"manual\", \"preset\": -1 }" \
+    "],"
+// clang-format on
+
+// --- Per-type expansion helpers ---
+#define RLC_SETTING_CTYPE_Float float
+#define RLC_SETTING_CTYPE_Int int32_t
+#define RLC_SETTING_CTYPE_Bool bool
+
+#define RLC_SETTING_WIDGET_Float "slider"
+#define RLC_SETTING_WIDGET_Int "slider"
+#define RLC_SETTING_WIDGET_Bool nullptr
+
+#define RLC_SETTING_PARAMS_Float(min, max, format) "{ \"min\": " #min ", \"max\": " #max ", \"format\": \"" format "\" }"
+#define RLC_SETTING_PARAMS_Int(min, max, format) RLC_SETTING_PARAMS_Float(min, max, format)
+#define RLC_SETTING_PARAMS_Bool(min, max, format) nullptr
+
+#define RLC_SETTING_MEMBER_Float(key) .as_float = &PluginContext::setting_##key
+#define RLC_SETTING_MEMBER_Int(key) .as_int = &PluginContext::setting_##key
+#define RLC_SETTING_MEMBER_Bool(key) .as_bool = &PluginContext::setting_##key
+
+// --- Expansions of RLC_SETTINGS ---
+
+/** @brief Declares `setting_<key>` with its default. Used inside `PluginContext`. */
+#define RLC_SETTING_FIELD(key, type, def, min, max, format, loc, handler) RLC_SETTING_CTYPE_##type setting_##key = def;
+
+/** @brief One `"key": default,` JSON member. */
+#define RLC_SETTING_JSON(key, type, def, min, max, format, loc, handler) "\"" #key "\": " #def ","
+
+/** @brief One `SettingDescriptor` initializer. */
+#define RLC_SETTING_DESCRIPTOR(key, kind, def, min, max, format, loc, handler)                                       \
+    SettingDescriptor{.key_path = "settings." #key,                                                                 \
+                      .type = SettingType::kind,                                                                    \
+                      RLC_SETTING_MEMBER_##kind(key),                                                               \
+                      .default_value = (double)(def),                                                               \
+                      .title = "Setting." #loc ".Title",                                                            \
+                      .description = "Setting." #loc ".Description",                                                \
+                      .widget = RLC_SETTING_WIDGET_##kind,                                                          \
+                      .widget_params = RLC_SETTING_PARAMS_##kind(min, max, format),                                 \
+                      .on_change = handler},
+
+namespace SPF_RedLightCamera
+{
+
+  struct PluginContext;
+
+  enum class SettingType : uint8_t
+  {
+    Float,
+    Int,
+    Bool
+  };
+
+  /** @brief Everything the plugin needs to know about one setting at run time. */
+  struct SettingDescriptor
+  {
+    const char *key_path; ///< "settings.<key>", as passed to OnSettingChanged.
+    SettingType type;
+    float PluginContext::*as_float = nullptr;
+    int32_t PluginContext::*as_int = nullptr;
+    bool PluginContext::*as_bool = nullptr;
+    double default_value;
+    const char *title;
+    const char *description;
+    const char *widget;        ///< nullptr for the framework's default widget (checkbox for bools).
+    const char *widget_params; ///< JSON, or nullptr.
+    void (*on_change)();
+
+    /** @brief The key without the "settings." prefix, as used by the manifest. */
+    constexpr const char *Key() const { return key_path + 9; }
+  };
+
+  // =================================================================================================
+  // Compile-time helpers
+  // =================================================================================================
+
+  /**
+   * @brief Turns `{ "a": 1, "b": 2, }` into valid JSON by blanking the last comma.
+   * @details The X-macro expansion emits a comma after every member; fixing the last one here keeps
+   *          the result a compile-time array of the same size.
+   */
+  template <size_t N>
+  constexpr std::array<char, N> FinishJsonObject(const char (&text)[N])
+  {
+    std::array<char, N> out{};
+    size_t last_comma = N;
+    for (size_t i = 0; i < N; ++i)
+    {
+      out[i] = text[i];
+      if (text[i] == ',')
+      {
+        last_comma = i;
+      }
+    }
+    if (last_comma != N)
+    {
+      out[last_comma] = ' ';
+    }
+    return out;
+  }
+
+  /** @brief FNV-1a over a NUL-terminated string. */
+  constexpr uint32_t HashSettingKey(const char *key)
+  {
+    uint32_t hash = 2166136261u;
+    for (; *key; ++key)
+    {
+      hash = (hash ^ (uint8_t)*key) * 16777619u;
+    }
+    return hash;
+  }
+
+  /**
+   * @brief Open-addressing index from key-path hash to descriptor, built at compile time.
+   * @details `Size` is a power of two at least twice the setting count, so probes stay short.
+   *          Slots hold the descriptor index, or -1 when empty.
+   */
+  template <size_t Size, size_t Count>
+  constexpr std::array<int16_t, Size> BuildSettingLookup(const SettingDescriptor (&settings)[Count])
+  {
+    static_assert((Size & (Size - 1)) == 0 && Size >= Count * 2, "lookup size must be a power of two, at least twice the setting count");
+    std::array<int16_t, Size> slots{};
+    for (int16_t &slot : slots)
+    {
+      slot = -1;
+    }
+    for (size_t i = 0; i < Count; ++i)
+    {
+      size_t slot = HashSettingKey(settings[i].key_path) & (Size - 1);
+      while (slots[slot] >= 0)
+      {
+        slot = (slot + 1) & (Size - 1);
+      }
+      slots[slot] = (int16_t)i;
+    }
+    return slots;
+  }
+
+} // namespace SPF_RedLightCamera
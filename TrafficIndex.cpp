@@ -0,0 +1,274 @@
+/**
+ * @file TrafficIndex.cpp
+ * @brief Implementation of the traffic spatial hash.
+ */
+
+#include "TrafficIndex.hpp"
+
+#include <chrono>
+#include <cmath>
+
+namespace SPF_RedLightCamera
+{
+
+    static constexpr uint32_t CLOCK_CHECK_INTERVAL = 4;
+
+    // =================================================================================================
+    // 1. Grid
+    // =================================================================================================
+
+    void TrafficIndex::Grid::Clear()
+    {
+        count = 0;
+        for (int16_t &head : buckets)
+        {
+            head = -1;
+        }
+    }
+
+    void TrafficIndex::Grid::Insert(const TrafficEntry &entry)
+    {
+        if (count >= MAX_VEHICLES)
+        {
+            return;
+        }
+
+        const size_t slot = count++;
+        entries[slot] = entry;
+        cellX[slot] = CellOf(entry.x, cellSize);
+        cellZ[slot] = CellOf(entry.z, cellSize);
+
+        const size_t bucket = BucketOf(cellX[slot], cellZ[slot]);
+        next[slot] = buckets[bucket];
+        buckets[bucket] = (int16_t)slot;
+    }
+
+    size_t TrafficIndex::BucketOf(int32_t cx, int32_t cz)
+    {
+        // Two large primes spread neighbouring cells across buckets.
+        const uint32_t h = (uint32_t)cx * 73856093u ^ (uint32_t)cz * 19349663u;
+        return h & (BUCKET_COUNT - 1);
+    }
+
+    int32_t TrafficIndex::CellOf(double coordinate, double cell_size)
+    {
+        return (int32_t)std::floor(coordinate / cell_size);
+    }
+
+    template <typename Visitor>
+    void TrafficIndex::VisitCell(const Grid &grid, int32_t cx, int32_t cz, Visitor &&visit) const
+    {
+        for (int16_t slot = grid.buckets[BucketOf(cx, cz)]; slot >= 0; slot = grid.next[slot])
+        {
+            // Different cells can share a bucket.
+            if (grid.cellX[slot] == cx && grid.cellZ[slot] == cz)
+            {
+                visit(grid.entries[slot]);
+            }
+        }
+    }
+
+    // =================================================================================================
+    // 2. Incremental Rebuild
+    // =================================================================================================
+
+    void TrafficIndex::Reset()
+    {
+        m_grids[0].Clear();
+        m_grids[1].Clear();
+        m_snapshotCount = 0;
+        m_cursor = 0;
+        m_passActive = false;
+    }
+
+    void TrafficIndex::BeginPass(const SPF_Vehicle_API *vehicles)
+    {
+        m_snapshotCount = vehicles->Veh_GetAllHandles(m_snapshot, (uint32_t)MAX_VEHICLES);
+        if (m_snapshotCount > MAX_VEHICLES)
+        {
+            m_snapshotCount = (uint32_t)MAX_VEHICLES;
+        }
+        m_cursor = 0;
+
+        Grid &back = m_grids[1 - m_front];
+        back.cellSize = m_pendingCellSize;
+        back.Clear();
+        m_passActive = true;
+    }
+
+    bool TrafficIndex::Update(const SPF_Vehicle_API *vehicles, uint32_t max_vehicles, uint32_t budget_us)
+    {
+        if (!m_source || !vehicles || !vehicles->Veh_GetAllHandles || !vehicles->Veh_GetId)
+        {
+            return false;
+        }
+
+        if (!m_passActive)
+        {
+            BeginPass(vehicles);
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        Grid &back = m_grids[1 - m_front];
+
+        for (uint32_t processed = 0; processed < max_vehicles && m_cursor < m_snapshotCount; ++processed)
+        {
+            if (budget_us != 0 && processed % CLOCK_CHECK_INTERVAL == CLOCK_CHECK_INTERVAL - 1 &&
+                std::chrono::steady_clock::now() - start >= std::chrono::microseconds(budget_us))
+            {
+                break;
+            }
+
+            SPF_VehicleHandle handle = m_snapshot[m_cursor++];
+            if (!handle)
+            {
+                continue;
+            }
+            const int32_t id = vehicles->Veh_GetId(handle);
+            if (id < 0)
+            {
+                continue; // The player's truck.
+            }
+            // Same staleness guard as the traffic watch: skip vehicles that despawned mid-pass.
+            if (vehicles->Veh_GetVehicleById && vehicles->Veh_GetVehicleById(id) != handle)
+            {
+                continue;
+            }
+
+            SPF_DVector position;
+            if (m_source(handle, &position))
+            {
+                back.Insert(TrafficEntry{id, position.x, position.y, position.z});
+            }
+        }
+
+        if (m_cursor < m_snapshotCount)
+        {
+            return false;
+        }
+
+        m_front = 1 - m_front;
+        m_passActive = false;
+        m_passes++;
+        return true;
+    }
+
+    // =================================================================================================
+    // 3. Queries
+    // =================================================================================================
+
+    size_t TrafficIndex::QueryRadius(double x, double z, double radius, TrafficHit *out, size_t max_hits) const
+    {
+        const Grid &grid = m_grids[m_front];
+        if (grid.count == 0 || max_hits == 0 || radius <= 0.0)
+        {
+            return 0;
+        }
+
+        const double radius_sq = radius * radius;
+        const int32_t min_cx = CellOf(x - radius, grid.cellSize), max_cx = CellOf(x + radius, grid.cellSize);
+        const int32_t min_cz = CellOf(z - radius, grid.cellSize), max_cz = CellOf(z + radius, grid.cellSize);
+
+        size_t found = 0;
+        for (int32_t cx = min_cx; cx <= max_cx; ++cx)
+        {
+            for (int32_t cz = min_cz; cz <= max_cz; ++cz)
+            {
+                VisitCell(grid, cx, cz, [&](const TrafficEntry &entry) {
+                    const double dx = entry.x - x, dz = entry.z - z;
+                    const double d2 = dx * dx + dz * dz;
+                    if (d2 > radius_sq)
+                    {
+                        return;
+                    }
+                    // Insertion sort keeps the nearest `max_hits` in order.
+                    size_t i;
+                    if (found < max_hits)
+                    {
+                        i = found++;
+                    }
+                    else if (d2 < out[max_hits - 1].distance_sq)
+                    {
+                        i = max_hits - 1;
+                    }
+                    else
+                    {
+                        return;
+                    }
+                    while (i > 0 && out[i - 1].distance_sq > d2)
+                    {
+                        out[i] = out[i - 1];
+                        --i;
+                    }
+                    out[i] = TrafficHit{entry, d2};
+                });
+            }
+        }
+        return found;
+    }
+
+    size_t TrafficIndex::QueryNearest(double x, double z, size_t k, double max_radius, TrafficHit *out) const
+    {
+        const Grid &grid = m_grids[m_front];
+        if (k > MAX_K)
+        {
+            k = MAX_K;
+        }
+        if (grid.count == 0 || k == 0)
+        {
+            return 0;
+        }
+
+        const int32_t cx0 = CellOf(x, grid.cellSize), cz0 = CellOf(z, grid.cellSize);
+        const int32_t max_ring = (int32_t)std::ceil(max_radius / grid.cellSize) + 1;
+        const double max_radius_sq = max_radius * max_radius;
+
+        size_t found = 0;
+        auto consider = [&](const TrafficEntry &entry) {
+            const double dx = entry.x - x, dz = entry.z - z;
+            const double d2 = dx * dx + dz * dz;
+            if (d2 > max_radius_sq || (found == k && d2 >= out[k - 1].distance_sq))
+            {
+                return;
+            }
+            size_t i = found < k ? found++ : k - 1;
+            while (i > 0 && out[i - 1].distance_sq > d2)
+            {
+                out[i] = out[i - 1];
+                --i;
+            }
+            out[i] = TrafficHit{entry, d2};
+        };
+
+        // Visit square rings of cells outwards. Anything in ring r+1 is at least r * cellSize away,
+        // so once k hits are closer than that the search can stop.
+        for (int32_t ring = 0; ring <= max_ring; ++ring)
+        {
+            if (ring == 0)
+            {
+                VisitCell(grid, cx0, cz0, consider);
+            }
+            else
+            {
+                for (int32_t d = -ring; d <= ring; ++d)
+                {
+                    VisitCell(grid, cx0 + d, cz0 - ring, consider);
+                    VisitCell(grid, cx0 + d, cz0 + ring, consider);
+                }
+                for (int32_t d = -ring + 1; d <= ring - 1; ++d)
+                {
+                    VisitCell(grid, cx0 - ring, cz0 + d, consider);
+                    VisitCell(grid, cx0 + ring, cz0 + d, consider);
+                }
+            }
+
+            const double reach = (double)ring * grid.cellSize;
+            if (found == k && out[k - 1].distance_sq <= reach * reach)
+            {
+                break;
+            }
+        }
+        return found;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,114 @@
+/**
+ * @file TrafficIndex.hpp
+ * @brief Uniform-grid spatial hash of traffic vehicles for radius and k-nearest queries.
+ * @details Vehicles are bucketed by their (x, z) world cell. Two grids are kept: queries read the
+ * front grid while the back grid is filled a slice of vehicles per frame from a handle snapshot,
+ * under the same vehicle-count and microsecond budget as the traffic watch. When the back grid
+ * is complete the two are swapped, so queries always see a consistent set that is at most one
+ * pass old.
+ *
+ * Vehicle positions come from a `PositionSource` callback. `SPF_Vehicle_API` does not expose
+ * traffic positions yet, so the index stays empty until a source is installed.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+#include <SPF_Vehicle_API.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief One indexed vehicle. */
+  struct TrafficEntry
+  {
+    int32_t id;
+    double x, y, z;
+  };
+
+  /** @brief A query hit: the entry and its squared horizontal distance to the query point. */
+  struct TrafficHit
+  {
+    TrafficEntry entry;
+    double distance_sq;
+  };
+
+  class TrafficIndex
+  {
+  public:
+    /** @brief Resolves a vehicle's world position. Returns false if unknown. */
+    using PositionSource = bool (*)(SPF_VehicleHandle handle, SPF_DVector *out_position);
+
+    static constexpr size_t MAX_VEHICLES = 512;
+    static constexpr size_t BUCKET_COUNT = 1024; ///< Power of two; several times MAX_VEHICLES keeps chains short.
+    static constexpr size_t MAX_K = 16;
+
+    void SetPositionSource(PositionSource source) { m_source = source; }
+    bool HasPositionSource() const { return m_source != nullptr; }
+
+    /** @brief Cell edge length in metres. Takes effect from the next pass. */
+    void SetCellSize(double metres) { m_pendingCellSize = metres > 1.0 ? metres : 1.0; }
+
+    /** @brief Empties both grids. */
+    void Reset();
+
+    /**
+     * @brief Adds the next slice of vehicles to the back grid, swapping when it is complete.
+     * @return true if this call completed a pass (the front grid changed).
+     */
+    bool Update(const SPF_Vehicle_API *vehicles, uint32_t max_vehicles, uint32_t budget_us);
+
+    /**
+     * @brief All vehicles within `radius` metres (horizontally) of (x, z), nearest first.
+     * @return Number of hits written (at most `max_hits`).
+     */
+    size_t QueryRadius(double x, double z, double radius, TrafficHit *out, size_t max_hits) const;
+
+    /**
+     * @brief The `k` vehicles nearest to (x, z), nearest first. `k` is clamped to `MAX_K`.
+     * @param max_radius Search limit in metres, so sparse traffic does not scan the whole grid.
+     * @return Number of hits written.
+     */
+    size_t QueryNearest(double x, double z, size_t k, double max_radius, TrafficHit *out) const;
+
+    size_t GetCount() const { return m_grids[m_front].count; }
+    uint64_t GetPassCount() const { return m_passes; }
+
+  private:
+    struct Grid
+    {
+      double cellSize = 32.0;
+      TrafficEntry entries[MAX_VEHICLES];
+      int32_t cellX[MAX_VEHICLES];
+      int32_t cellZ[MAX_VEHICLES];
+      int16_t next[MAX_VEHICLES];     ///< Bucket chain, -1 terminated.
+      int16_t buckets[BUCKET_COUNT];  ///< Chain head per bucket, -1 if empty.
+      size_t count = 0;
+
+      void Clear();
+      void Insert(const TrafficEntry &entry);
+    };
+
+    static size_t BucketOf(int32_t cx, int32_t cz);
+    static int32_t CellOf(double coordinate, double cell_size);
+
+    template <typename Visitor>
+    void VisitCell(const Grid &grid, int32_t cx, int32_t cz, Visitor &&visit) const;
+
+    void BeginPass(const SPF_Vehicle_API *vehicles);
+
+    Grid m_grids[2];
+    int m_front = 0;
+    double m_pendingCellSize = 32.0;
+
+    PositionSource m_source = nullptr;
+    SPF_VehicleHandle m_snapshot[MAX_VEHICLES] = {};
+    uint32_t m_snapshotCount = 0;
+    uint32_t m_cursor = 0;
+    bool m_passActive = false;
+    uint64_t m_passes = 0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,172 @@
+/**
+ * @file TrafficWatch.cpp
+ * @brief Implementation of the amortised traffic scanner.
+ */
+
+#include "TrafficWatch.hpp"
+
+#include <chrono>
+#include <cmath>
+
+namespace SPF_RedLightCamera
+{
+
+    // Reading the clock costs about as much as evaluating a vehicle, so it is sampled periodically.
+    static constexpr uint32_t CLOCK_CHECK_INTERVAL = 4;
+
+    const char *TrafficReasonName(TrafficReason reason)
+    {
+        switch (reason)
+        {
+        case TrafficReason::Speeding:
+            return "speeding";
+        case TrafficReason::HardAcceleration:
+            return "hard_accel";
+        default:
+            return "none";
+        }
+    }
+
+    void TrafficWatch::Reset()
+    {
+        m_count = 0;
+        m_cursor = 0;
+        for (Cooldown &cooldown : m_cooldowns)
+        {
+            cooldown = Cooldown{};
+        }
+    }
+
+    bool TrafficWatch::Tick(const SPF_Vehicle_API *vehicles, uint64_t frame, TrafficCandidate &out)
+    {
+        if (!vehicles || !vehicles->Veh_GetAllHandles || !vehicles->Veh_GetId || !vehicles->Veh_GetVehicleById ||
+            !vehicles->Veh_GetCurrentSpeed || !vehicles->Veh_GetSpeedLimit || !vehicles->Veh_GetAcceleration)
+        {
+            return false;
+        }
+        if (vehicles->Veh_IsReady && !vehicles->Veh_IsReady())
+        {
+            return false;
+        }
+
+        const auto start = std::chrono::steady_clock::now();
+        const auto budget = std::chrono::microseconds(m_rules.budget_us);
+
+        for (uint32_t processed = 0; processed < m_rules.vehicles_per_frame; ++processed)
+        {
+            if (m_cursor >= m_count)
+            {
+                // Only start a new pass at the beginning of a frame's slice, so the snapshot cost
+                // is not stacked on top of a full slice.
+                if (processed > 0)
+                {
+                    break;
+                }
+                TakeSnapshot(vehicles);
+                if (m_count == 0)
+                {
+                    break;
+                }
+            }
+
+            if (m_rules.budget_us != 0 && processed % CLOCK_CHECK_INTERVAL == CLOCK_CHECK_INTERVAL - 1 &&
+                std::chrono::steady_clock::now() - start >= budget)
+            {
+                break;
+            }
+
+            const uint32_t index = m_cursor++;
+            const int32_t id = m_ids[index];
+            m_scanned++;
+
+            // The snapshot may be a few frames old; skip vehicles that despawned since.
+            if (vehicles->Veh_GetVehicleById(id) != m_handles[index] || IsCoolingDown(id, frame))
+            {
+                continue;
+            }
+
+            if (Evaluate(vehicles, m_handles[index], out) != TrafficReason::None)
+            {
+                out.id = id;
+                StartCooldown(id, frame);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TrafficWatch::TakeSnapshot(const SPF_Vehicle_API *vehicles)
+    {
+        const uint32_t written = vehicles->Veh_GetAllHandles(m_handles, (uint32_t)MAX_VEHICLES);
+        m_count = 0;
+        for (uint32_t i = 0; i < written && i < MAX_VEHICLES; ++i)
+        {
+            const int32_t id = m_handles[i] ? vehicles->Veh_GetId(m_handles[i]) : -1;
+            if (id < 0)
+            {
+                continue; // The player's truck, or an invalid entry.
+            }
+            m_handles[m_count] = m_handles[i];
+            m_ids[m_count] = id;
+            m_count++;
+        }
+        m_cursor = 0;
+        m_passes++;
+    }
+
+    TrafficReason TrafficWatch::Evaluate(const SPF_Vehicle_API *vehicles, SPF_VehicleHandle handle, TrafficCandidate &out) const
+    {
+        const float speed = vehicles->Veh_GetCurrentSpeed(handle);
+        const float limit = vehicles->Veh_GetSpeedLimit(handle);
+        const float accel = vehicles->Veh_GetAcceleration(handle);
+
+        out.reason = TrafficReason::None;
+        out.speed = speed;
+        out.speed_limit = limit;
+        out.acceleration = accel;
+
+        // A zero or negative limit means the game has none for this lane; skip the speeding rule.
+        if (limit > 0.0f && speed >= limit * m_rules.speed_ratio && speed - limit >= m_rules.min_speed_excess)
+        {
+            out.reason = TrafficReason::Speeding;
+        }
+        else if (m_rules.hard_accel > 0.0f && std::fabs(accel) >= m_rules.hard_accel)
+        {
+            out.reason = TrafficReason::HardAcceleration;
+        }
+        return out.reason;
+    }
+
+    bool TrafficWatch::IsCoolingDown(int32_t id, uint64_t frame) const
+    {
+        for (const Cooldown &cooldown : m_cooldowns)
+        {
+            if (cooldown.id == id && frame < cooldown.until)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void TrafficWatch::StartCooldown(int32_t id, uint64_t frame)
+    {
+        // Reuse an expired slot, otherwise evict the one that expires soonest.
+        Cooldown *slot = &m_cooldowns[0];
+        for (Cooldown &cooldown : m_cooldowns)
+        {
+            if (cooldown.until <= frame)
+            {
+                slot = &cooldown;
+                break;
+            }
+            if (cooldown.until < slot->until)
+            {
+                slot = &cooldown;
+            }
+        }
+        slot->id = id;
+        slot->until = frame + m_rules.cooldown_frames;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,105 @@
+/**
+ * @file TrafficWatch.hpp
+ * @brief Amortised scan of AI traffic for vehicles worth photographing.
+ * @details The scan walks a snapshot of `Veh_GetAllHandles` a few vehicles per frame. Each frame
+ * is bounded both by a vehicle count and by a microsecond budget, so dense traffic makes a full
+ * pass take more frames instead of making any single frame more expensive. A new snapshot is
+ * taken when the previous one has been fully walked.
+ *
+ * Only traffic the game is currently simulating is returned by the Vehicle API, which in practice
+ * is the traffic around the player.
+ */
+#pragma once
+
+#include <SPF_Vehicle_API.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Why a vehicle was selected. */
+  enum class TrafficReason : uint8_t
+  {
+    None = 0,
+    Speeding,        ///< Current speed is at least `speed_ratio` x its speed limit.
+    HardAcceleration ///< Absolute acceleration is at least `hard_accel`.
+  };
+
+  /** @brief Selection rules and scan budget. */
+  struct TrafficWatchRules
+  {
+    float speed_ratio = 1.25f;       ///< Speeding threshold as a multiple of the limit.
+    float min_speed_excess = 3.0f;   ///< Minimum excess over the limit (m/s), filters crawling traffic.
+    float hard_accel = 4.0f;         ///< Hard acceleration/braking threshold (m/s^2). 0 disables.
+    uint32_t vehicles_per_frame = 16;
+    uint32_t budget_us = 100;        ///< 0 = vehicle count only.
+    uint32_t cooldown_frames = 1800; ///< Frames before the same vehicle may be selected again.
+  };
+
+  /** @brief A vehicle that matched a rule. */
+  struct TrafficCandidate
+  {
+    int32_t id = -1;
+    TrafficReason reason = TrafficReason::None;
+    float speed = 0.0f;
+    float speed_limit = 0.0f;
+    float acceleration = 0.0f;
+  };
+
+  /** @brief Returns a short, filename-safe name for a reason ("speeding", "hard_accel"). */
+  const char *TrafficReasonName(TrafficReason reason);
+
+  /**
+   * @brief Incremental traffic scanner.
+   * @details Holds no framework state besides the handle snapshot; the Vehicle API table is passed
+   * to `Tick` so the caller decides when the API is valid.
+   */
+  class TrafficWatch
+  {
+  public:
+    static constexpr size_t MAX_VEHICLES = 512;
+    static constexpr size_t COOLDOWN_SLOTS = 32;
+
+    void SetRules(const TrafficWatchRules &rules) { m_rules = rules; }
+    const TrafficWatchRules &GetRules() const { return m_rules; }
+
+    /** @brief Drops the snapshot and cooldowns (e.g. when the watch is toggled). */
+    void Reset();
+
+    /**
+     * @brief Scans the next slice of the snapshot.
+     * @param vehicles The Vehicle API table.
+     * @param frame A monotonically increasing frame number, used for cooldowns.
+     * @param out Receives the first matching vehicle.
+     * @return true if a vehicle matched; the scan resumes after it on the next call.
+     */
+    bool Tick(const SPF_Vehicle_API *vehicles, uint64_t frame, TrafficCandidate &out);
+
+    uint64_t GetScannedCount() const { return m_scanned; }
+    uint64_t GetPassCount() const { return m_passes; }
+
+  private:
+    void TakeSnapshot(const SPF_Vehicle_API *vehicles);
+    TrafficReason Evaluate(const SPF_Vehicle_API *vehicles, SPF_VehicleHandle handle, TrafficCandidate &out) const;
+    bool IsCoolingDown(int32_t id, uint64_t frame) const;
+    void StartCooldown(int32_t id, uint64_t frame);
+
+    struct Cooldown
+    {
+      int32_t id = -1;
+      uint64_t until = 0;
+    };
+
+    TrafficWatchRules m_rules;
+    SPF_VehicleHandle m_handles[MAX_VEHICLES] = {};
+    int32_t m_ids[MAX_VEHICLES] = {};
+    uint32_t m_count = 0;
+    uint32_t m_cursor = 0;
+    Cooldown m_cooldowns[COOLDOWN_SLOTS];
+    uint64_t m_scanned = 0;
+    uint64_t m_passes = 0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,258 @@
+/**
+ * @file AutoFraming.cpp
+ * @brief Implementation of the combination bounding box and the framing solver.
+ */
+
+#define _USE_MATH_DEFINES
+#include "AutoFraming.hpp"
+
+#include <cmath>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        /** @brief A unit's extent in its own frame. */
+        struct UnitExtent
+        {
+            float front = 0.0f; // Smallest z.
+            float rear = 0.0f;  // Largest z.
+            float half_width = FRAMING_BODY_HALF_WIDTH;
+            float ground = 0.0f;
+        };
+
+        UnitExtent MeasureWheels(const SPF_WheelConstants *wheels, uint32_t count)
+        {
+            UnitExtent extent;
+            count = count < SPF_TELEMETRY_WHEEL_MAX_COUNT ? count : SPF_TELEMETRY_WHEEL_MAX_COUNT;
+            for (uint32_t i = 0; i < count; ++i)
+            {
+                const SPF_WheelConstants &wheel = wheels[i];
+                const float front = wheel.position.z - wheel.radius;
+                const float rear = wheel.position.z + wheel.radius;
+                const float ground = wheel.position.y - wheel.radius;
+                extent.front = (i == 0 || front < extent.front) ? front : extent.front;
+                extent.rear = (i == 0 || rear > extent.rear) ? rear : extent.rear;
+                extent.ground = (i == 0 || ground < extent.ground) ? ground : extent.ground;
+                extent.half_width = std::fmax(extent.half_width, std::fabs(wheel.position.x) + FRAMING_TYRE_HALF_WIDTH);
+            }
+            extent.rear += FRAMING_REAR_OVERHANG;
+            return extent;
+        }
+
+        void Include(FramingBox &box, const UnitExtent &extent, float y_offset, float z_offset)
+        {
+            const SPF_FVector min = {-extent.half_width, extent.ground + y_offset, extent.front + z_offset};
+            const SPF_FVector max = {extent.half_width, extent.ground + y_offset + FRAMING_BODY_HEIGHT, extent.rear + z_offset};
+            if (!box.valid)
+            {
+                box.min = min;
+                box.max = max;
+                box.valid = true;
+                return;
+            }
+            box.min = {std::fmin(box.min.x, min.x), std::fmin(box.min.y, min.y), std::fmin(box.min.z, min.z)};
+            box.max = {std::fmax(box.max.x, max.x), std::fmax(box.max.y, max.y), std::fmax(box.max.z, max.z)};
+        }
+
+        bool HasPlacement(const SPF_Trailer &trailer)
+        {
+            const SPF_DVector &p = trailer.data.world_placement.position;
+            return p.x != 0.0 || p.y != 0.0 || p.z != 0.0;
+        }
+
+        float Dot(const SPF_FVector &a, const SPF_FVector &b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+
+        SPF_FVector Cross(const SPF_FVector &a, const SPF_FVector &b)
+        {
+            return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x};
+        }
+
+        bool Normalize(SPF_FVector &v)
+        {
+            const float length = std::sqrt(Dot(v, v));
+            if (length < 1e-6f)
+            {
+                return false;
+            }
+            v = {v.x / length, v.y / length, v.z / length};
+            return true;
+        }
+
+        /** @brief Right and up vectors of a camera looking along `forward` with no roll. */
+        void CameraBasis(const SPF_FVector &forward, SPF_FVector &right, SPF_FVector &up)
+        {
+            right = Cross(forward, {0.0f, 1.0f, 0.0f});
+            if (!Normalize(right))
+            {
+                right = {1.0f, 0.0f, 0.0f}; // Straight up or down: any horizontal right will do.
+            }
+            up = Cross(right, forward);
+        }
+    } // namespace
+
+    FramingBox BuildCombinationBox(const SPF_TruckConstants &truck, const SPF_Trailer *trailers, uint32_t trailer_count)
+    {
+        FramingBox box;
+        if (truck.wheel_count == 0)
+        {
+            return box;
+        }
+
+        // The truck: wheels, plus the cabin and the driver's head, which can sit ahead of the front axle.
+        UnitExtent unit = MeasureWheels(truck.wheels, truck.wheel_count);
+        const float cabin_front = std::fmin(truck.cabin_position.z, truck.cabin_position.z + truck.head_position.z);
+        unit.front = std::fmin(unit.front - FRAMING_TRUCK_FRONT_OVERHANG, cabin_front);
+        unit.rear = std::fmax(unit.rear, truck.hook_position.z);
+        Include(box, unit, 0.0f, 0.0f);
+
+        // Trailers, straightened out behind the truck.
+        float y_offset = 0.0f, z_offset = 0.0f, rear = box.max.z;
+        trailer_count = !trailers ? 0 : (trailer_count < SPF_TELEMETRY_TRAILER_MAX_COUNT ? trailer_count : SPF_TELEMETRY_TRAILER_MAX_COUNT);
+        for (uint32_t i = 0; i < trailer_count; ++i)
+        {
+            const SPF_TrailerConstants &constants = trailers[i].constants;
+            unit = MeasureWheels(constants.wheels, constants.wheel_count);
+            if (constants.wheel_count == 0)
+            {
+                unit.front = unit.rear = constants.hook_position.z;
+            }
+            unit.front = std::fmin(unit.front, constants.hook_position.z - FRAMING_TRAILER_FRONT_OVERHANG);
+
+            if (i == 0)
+            {
+                // The kingpin sits on the truck's hook.
+                z_offset = truck.hook_position.z - constants.hook_position.z;
+                y_offset = truck.hook_position.y - constants.hook_position.y;
+            }
+            else if (HasPlacement(trailers[i]) && HasPlacement(trailers[i - 1]))
+            {
+                // No constant gives the previous trailer's rear hitch; its live distance does.
+                const SPF_DVector &a = trailers[i - 1].data.world_placement.position;
+                const SPF_DVector &b = trailers[i].data.world_placement.position;
+                z_offset += (float)std::sqrt((b.x - a.x) * (b.x - a.x) + (b.z - a.z) * (b.z - a.z));
+                y_offset += (float)(b.y - a.y);
+            }
+            else
+            {
+                z_offset = rear - unit.front; // Unknown: nose to tail with the unit ahead.
+            }
+
+            Include(box, unit, y_offset, z_offset);
+            rear = unit.rear + z_offset;
+        }
+        box.trailer_count = trailer_count;
+        return box;
+    }
+
+    bool FramingRequest::operator==(const FramingRequest &other) const
+    {
+        return rig_offset.x == other.rig_offset.x && rig_offset.y == other.rig_offset.y && rig_offset.z == other.rig_offset.z && fov == other.fov &&
+               max_fov == other.max_fov && aspect == other.aspect && margin == other.margin && mode == other.mode;
+    }
+
+    FramingSolution SolveFraming(const FramingBox &box, const FramingRequest &request)
+    {
+        FramingSolution solution;
+        solution.fov = request.fov;
+        if (!box.valid || request.mode == AutoFramingMode::Off)
+        {
+            return solution;
+        }
+
+        const SPF_FVector centre = {(box.min.x + box.max.x) * 0.5f, (box.min.y + box.max.y) * 0.5f, (box.min.z + box.max.z) * 0.5f};
+        const SPF_FVector half = {(box.max.x - box.min.x) * 0.5f, (box.max.y - box.min.y) * 0.5f, (box.max.z - box.min.z) * 0.5f};
+        const float aspect = request.aspect > 0.0f ? request.aspect : 16.0f / 9.0f;
+        const float margin = request.margin > 0.0f ? request.margin : 1.0f;
+        solution.target = centre;
+
+        // Corner q (relative to the centre) seen from a camera at centre - depth * forward is
+        // (q.right, q.up) / (q.forward + depth). It fits if both ratios, times the margin, stay
+        // within the half-FOV tangents; each corner gives one linear bound on depth or on the tangent.
+        if (request.mode == AutoFramingMode::Distance)
+        {
+            SPF_FVector away = request.rig_offset;
+            if (!Normalize(away))
+            {
+                return solution;
+            }
+            const SPF_FVector forward = {-away.x, -away.y, -away.z};
+            SPF_FVector right, up;
+            CameraBasis(forward, right, up);
+
+            const float fov = std::fmin(std::fmax(request.fov, 1.0f), 179.0f);
+            const float tan_v = (float)std::tan(fov * M_PI / 360.0);
+            const float tan_h = tan_v * aspect;
+            float depth = 0.0f;
+            for (int corner = 0; corner < 8; ++corner)
+            {
+                const SPF_FVector q = {(corner & 1) ? half.x : -half.x, (corner & 2) ? half.y : -half.y, (corner & 4) ? half.z : -half.z};
+                const float along = Dot(q, forward);
+                const float needed = std::fmax(margin * std::fabs(Dot(q, right)) / tan_h, margin * std::fabs(Dot(q, up)) / tan_v);
+                depth = std::fmax(depth, std::fmax(needed, FRAMING_NEAR_PLANE) - along);
+            }
+            depth = std::fmin(depth, FRAMING_MAX_DISTANCE);
+            solution.camera = {centre.x + away.x * depth, centre.y + away.y * depth, centre.z + away.z * depth};
+            solution.fov = fov;
+            solution.valid = true;
+            return solution;
+        }
+
+        SPF_FVector forward = {centre.x - request.rig_offset.x, centre.y - request.rig_offset.y, centre.z - request.rig_offset.z};
+        const float depth = std::sqrt(Dot(forward, forward));
+        if (!Normalize(forward))
+        {
+            return solution;
+        }
+        SPF_FVector right, up;
+        CameraBasis(forward, right, up);
+
+        float tangent = 0.0f;
+        bool inside = false;
+        for (int corner = 0; corner < 8 && !inside; ++corner)
+        {
+            const SPF_FVector q = {(corner & 1) ? half.x : -half.x, (corner & 2) ? half.y : -half.y, (corner & 4) ? half.z : -half.z};
+            const float corner_depth = Dot(q, forward) + depth;
+            inside = corner_depth < FRAMING_NEAR_PLANE;
+            tangent = std::fmax(tangent, margin * std::fmax(std::fabs(Dot(q, up)), std::fabs(Dot(q, right)) / aspect) / corner_depth);
+        }
+        // A corner behind the camera cannot be fitted; open up as far as allowed.
+        const float fov = inside ? request.max_fov : (float)(2.0 * std::atan(tangent) * 180.0 / M_PI);
+        solution.camera = request.rig_offset;
+        solution.fov = std::fmin(std::fmax(fov, FRAMING_MIN_FOV), request.max_fov);
+        solution.valid = true;
+        return solution;
+    }
+
+    RigPose PlaceFramedRig(const SPF_DVector &truck, double heading, const FramingSolution &solution, float roll)
+    {
+        // Truck frame to world: right is (-sin, cos) and back is -(cos, sin) of the ComputeRigPose angle.
+        const double phi = (1.5 * M_PI) - (2.0 * M_PI * heading);
+        const double c = std::cos(phi), s = std::sin(phi);
+        auto to_world = [&](const SPF_FVector &local) {
+            return SPF_DVector{truck.x - s * local.x - c * local.z, truck.y + local.y, truck.z + c * local.x - s * local.z};
+        };
+
+        RigPose pose;
+        pose.camera = to_world(solution.camera);
+        pose.look_target = to_world(solution.target);
+        pose.fov = solution.fov;
+        pose.roll = roll;
+        AimRig(pose);
+        return pose;
+    }
+
+    const FramingSolution &AutoFramer::Solve(const FramingRequest &request)
+    {
+        if (!m_solved || request != m_request)
+        {
+            m_solution = SolveFraming(m_box, request);
+            m_request = request;
+            m_solved = true;
+            ++m_solveCount;
+        }
+        return m_solution;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,132 @@
+/**
+ * @file AutoFraming.hpp
+ * @brief Fits the whole truck and trailer combination in the shot.
+ * @details The telemetry constants carry no body dimensions, so the combination's bounding box is
+ * estimated from what they do carry: wheel positions and radii, the cabin and head positions, and
+ * the hook positions that chain the units together. Each unit gets the legal body width and height
+ * and typical overhangs ahead of its first and behind its last axle. Trailers are laid out straight
+ * behind the truck: the first one hangs off the truck's hook, later ones sit at their live distance
+ * from the unit ahead (`SPF_Trailer` placements), so the box does not depend on articulation.
+ *
+ * The box is in the truck's frame (X right, Y up, Z back; the truck faces -Z). Given the rig's
+ * offset in the same frame, the solver aims at the box centre and either moves the camera along the
+ * same direction or widens/narrows the FOV until every corner is inside the viewport. Both are closed
+ * form over the eight corners: no iteration, well under a microsecond.
+ *
+ * `AutoFramer` caches the box and the solution. The adapter invalidates the box when the truck or
+ * trailer constants change or a trailer is coupled or dropped; the solution is recomputed only when
+ * the box or the request (rig offset, FOV, aspect, margin, mode) changes. Per frame only the cached
+ * solution is turned into a world pose.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+
+#include "RigPose.hpp"
+
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr float FRAMING_BODY_HEIGHT = 4.0f;            ///< Metres above the wheels' contact patch (EU limit).
+  constexpr float FRAMING_BODY_HALF_WIDTH = 1.3f;        ///< Half of 2.55 m plus mirrors.
+  constexpr float FRAMING_TYRE_HALF_WIDTH = 0.25f;       ///< Added outside the outermost wheel centres.
+  constexpr float FRAMING_TRUCK_FRONT_OVERHANG = 1.6f;   ///< Bumper ahead of the front axle.
+  constexpr float FRAMING_TRAILER_FRONT_OVERHANG = 1.6f; ///< Trailer front wall ahead of the kingpin.
+  constexpr float FRAMING_REAR_OVERHANG = 1.2f;          ///< Body behind the last axle.
+  constexpr float FRAMING_NEAR_PLANE = 0.5f;             ///< Closest a corner may be to the camera.
+  constexpr float FRAMING_MIN_FOV = 10.0f;               ///< Lower limit for the solved FOV (degrees).
+  constexpr float FRAMING_MAX_DISTANCE = 250.0f;         ///< Upper limit for the solved rig distance (metres).
+
+  /** @brief How the solver fits the combination. Values are the `auto_framing` setting. */
+  enum class AutoFramingMode : int32_t
+  {
+    Off = 0,
+    Distance = 1, ///< Keep the FOV, move the rig along its direction from the truck.
+    Fov = 2,      ///< Keep the rig where it is, change the FOV.
+    Count
+  };
+
+  /** @brief Axis-aligned box in the truck's frame. */
+  struct FramingBox
+  {
+    SPF_FVector min = {0.0f, 0.0f, 0.0f};
+    SPF_FVector max = {0.0f, 0.0f, 0.0f};
+    uint32_t trailer_count = 0;
+    bool valid = false; ///< false until the truck constants list at least one wheel.
+  };
+
+  /**
+   * @brief Estimates the combination's bounding box.
+   * @param trailers Active trailers in coupling order, as returned by `Tel_GetTrailers`.
+   */
+  FramingBox BuildCombinationBox(const SPF_TruckConstants &truck, const SPF_Trailer *trailers, uint32_t trailer_count);
+
+  /** @brief Everything besides the box that the solution depends on. */
+  struct FramingRequest
+  {
+    SPF_FVector rig_offset = {0.0f, 0.0f, 0.0f}; ///< Camera relative to the truck origin, truck frame.
+    float fov = 70.0f;                           ///< Vertical FOV to keep in Distance mode (degrees).
+    float max_fov = 110.0f;                      ///< Upper limit in Fov mode (degrees).
+    float aspect = 16.0f / 9.0f;                 ///< Viewport width / height.
+    float margin = 1.1f;                         ///< Extra room around the box, as a multiple of its projected size.
+    AutoFramingMode mode = AutoFramingMode::Off;
+
+    bool operator==(const FramingRequest &other) const;
+    bool operator!=(const FramingRequest &other) const { return !(*this == other); }
+  };
+
+  /** @brief The solved rig, in the truck's frame. */
+  struct FramingSolution
+  {
+    SPF_FVector camera = {0.0f, 0.0f, 0.0f}; ///< Camera relative to the truck origin.
+    SPF_FVector target = {0.0f, 0.0f, 0.0f}; ///< Box centre relative to the truck origin.
+    float fov = 70.0f;
+    bool valid = false; ///< false for an invalid box, mode Off, or a rig offset of zero.
+  };
+
+  /** @brief Solves `request` for `box` in closed form. */
+  FramingSolution SolveFraming(const FramingBox &box, const FramingRequest &request);
+
+  /**
+   * @brief Turns a solution into a world pose for the truck's current placement and aims it.
+   * @param heading Truck heading (telemetry convention, 0..1, clockwise from north).
+   * @param roll Carried over into the pose (radians); the fit ignores it.
+   */
+  RigPose PlaceFramedRig(const SPF_DVector &truck, double heading, const FramingSolution &solution, float roll);
+
+  class AutoFramer
+  {
+  public:
+    /** @brief Drops the box; call when the constants or the trailer count change. */
+    void Invalidate() { m_box.valid = false; m_hasBox = false; }
+
+    /** @brief false until `SetBox` after construction or `Invalidate`. */
+    bool HasBox() const { return m_hasBox; }
+
+    void SetBox(const FramingBox &box)
+    {
+      m_box = box;
+      m_hasBox = true;
+      m_solved = false;
+    }
+
+    const FramingBox &GetBox() const { return m_box; }
+
+    /** @brief The solution for `request`, solved again only if the box or the request changed. */
+    const FramingSolution &Solve(const FramingRequest &request);
+
+    /** @brief Number of actual solves, for diagnostics. */
+    uint32_t GetSolveCount() const { return m_solveCount; }
+
+  private:
+    FramingBox m_box;
+    FramingRequest m_request;
+    FramingSolution m_solution;
+    uint32_t m_solveCount = 0;
+    bool m_hasBox = false;
+    bool m_solved = false;
+  };
+
+} // namespace SPF_RedLightCamera
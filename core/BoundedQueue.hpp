@@ -0,0 +1,107 @@
+/**
+ * @file BoundedQueue.hpp
+ * @brief Fixed-capacity lock-free multi-producer multi-consumer queue (Vyukov).
+ * @details Every cell carries a sequence number that tells producers and consumers whether it is
+ * free or filled for their lap around the ring, so `Push` and `Pop` each cost one CAS on the shared
+ * index and never block. The element type must be trivially copyable; it is copied in and out.
+ */
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace SPF_RedLightCamera
+{
+
+  template <typename T, size_t Capacity>
+  class BoundedMpmcQueue
+  {
+    static_assert((Capacity & (Capacity - 1)) == 0 && Capacity >= 2, "Capacity must be a power of two.");
+    static_assert(std::is_trivially_copyable_v<T>, "Elements are copied with plain assignment.");
+
+  public:
+    BoundedMpmcQueue()
+    {
+      for (size_t i = 0; i < Capacity; ++i)
+      {
+        m_cells[i].sequence.store(i, std::memory_order_relaxed);
+      }
+    }
+    BoundedMpmcQueue(const BoundedMpmcQueue &) = delete;
+    BoundedMpmcQueue &operator=(const BoundedMpmcQueue &) = delete;
+
+    /** @brief Appends a copy of `value`. Returns false if the queue is full. */
+    bool Push(const T &value)
+    {
+      size_t position = m_enqueue.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        Cell &cell = m_cells[position & MASK];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)position;
+        if (diff == 0)
+        {
+          if (m_enqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          {
+            cell.value = value;
+            cell.sequence.store(position + 1, std::memory_order_release);
+            return true;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false; // Full.
+        }
+        else
+        {
+          position = m_enqueue.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+    /** @brief Removes the oldest element into `out`. Returns false if the queue is empty. */
+    bool Pop(T &out)
+    {
+      size_t position = m_dequeue.load(std::memory_order_relaxed);
+      for (;;)
+      {
+        Cell &cell = m_cells[position & MASK];
+        const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const intptr_t diff = (intptr_t)sequence - (intptr_t)(position + 1);
+        if (diff == 0)
+        {
+          if (m_dequeue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+          {
+            out = cell.value;
+            cell.sequence.store(position + Capacity, std::memory_order_release);
+            return true;
+          }
+        }
+        else if (diff < 0)
+        {
+          return false; // Empty.
+        }
+        else
+        {
+          position = m_dequeue.load(std::memory_order_relaxed);
+        }
+      }
+    }
+
+  private:
+    static constexpr size_t MASK = Capacity - 1;
+
+    struct Cell
+    {
+      std::atomic<size_t> sequence;
+      T value;
+    };
+
+    Cell m_cells[Capacity];
+    alignas(64) std::atomic<size_t> m_enqueue{0};
+    alignas(64) std::atomic<size_t> m_dequeue{0};
+  };
+
+} // namespace SPF_RedLightCamera
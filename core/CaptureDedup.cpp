@@ -0,0 +1,147 @@
+/**
+ * @file CaptureDedup.cpp
+ * @brief Implementation of the capture deduplication table.
+ */
+
+#include "CaptureDedup.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    size_t CaptureDedup::SlotOf(int32_t cx, int32_t cz)
+    {
+        // Same spreading primes as the traffic index.
+        const uint32_t h = (uint32_t)cx * 73856093u ^ (uint32_t)cz * 19349663u;
+        return h & (DEDUP_TABLE_SLOTS - 1);
+    }
+
+    int32_t CaptureDedup::CellOf(double coordinate) const { return (int32_t)std::floor(coordinate / m_cellSize); }
+
+    void CaptureDedup::Configure(double cell_size, uint64_t window_us)
+    {
+        cell_size = cell_size > 1.0 ? cell_size : 1.0;
+        if (cell_size != m_cellSize)
+        {
+            Clear();
+        }
+        m_cellSize = cell_size;
+        m_windowUs = window_us;
+    }
+
+    void CaptureDedup::Clear()
+    {
+        for (Slot &slot : m_slots)
+        {
+            slot = Slot{};
+        }
+    }
+
+    bool CaptureDedup::Attach(double x, double z, uint64_t now_us, DedupHit &hit)
+    {
+        if (m_windowUs == 0)
+        {
+            return false;
+        }
+
+        const int32_t cx = CellOf(x), cz = CellOf(z);
+        const double radius_sq = m_cellSize * m_cellSize;
+        Slot *best = nullptr;
+        double best_sq = radius_sq;
+        for (int32_t dz = -1; dz <= 1; ++dz)
+        {
+            for (int32_t dx = -1; dx <= 1; ++dx)
+            {
+                for (size_t probe = 0, i = SlotOf(cx + dx, cz + dz); probe < DEDUP_TABLE_SLOTS; ++probe, i = (i + 1) & (DEDUP_TABLE_SLOTS - 1))
+                {
+                    Slot &slot = m_slots[i];
+                    if (slot.expires_us == 0)
+                    {
+                        break;
+                    }
+                    if (slot.cell_x != cx + dx || slot.cell_z != cz + dz || slot.expires_us <= now_us)
+                    {
+                        continue;
+                    }
+                    const double distance_sq = (slot.x - x) * (slot.x - x) + (slot.z - z) * (slot.z - z);
+                    if (distance_sq <= best_sq)
+                    {
+                        best = &slot;
+                        best_sq = distance_sq;
+                    }
+                    break; // One capture per cell.
+                }
+            }
+        }
+        if (!best)
+        {
+            return false;
+        }
+
+        best->attached++;
+        m_suppressed++;
+        hit.capture_id = best->capture_id;
+        hit.attached = best->attached;
+        hit.name = best->name;
+        return true;
+    }
+
+    void CaptureDedup::Record(double x, double z, uint64_t now_us, uint32_t capture_id)
+    {
+        if (m_windowUs == 0)
+        {
+            return;
+        }
+
+        // The cell's own slot if it has one (a newer capture replaces it), else the first free one
+        // on its probe chain, else whichever slot expires first.
+        const int32_t cx = CellOf(x), cz = CellOf(z);
+        Slot *target = nullptr;
+        Slot *soonest = &m_slots[0];
+        for (size_t probe = 0, i = SlotOf(cx, cz); probe < DEDUP_TABLE_SLOTS; ++probe, i = (i + 1) & (DEDUP_TABLE_SLOTS - 1))
+        {
+            Slot &slot = m_slots[i];
+            const bool live = slot.expires_us > now_us;
+            if (live && slot.cell_x == cx && slot.cell_z == cz)
+            {
+                target = &slot;
+                break;
+            }
+            if (!live && !target)
+            {
+                target = &slot;
+            }
+            if (slot.expires_us == 0)
+            {
+                break;
+            }
+            soonest = slot.expires_us < soonest->expires_us ? &slot : soonest;
+        }
+        target = target ? target : soonest;
+
+        target->x = x;
+        target->z = z;
+        target->expires_us = now_us + m_windowUs;
+        target->cell_x = cx;
+        target->cell_z = cz;
+        target->capture_id = capture_id;
+        target->attached = 0;
+        target->name[0] = '\0';
+    }
+
+    void CaptureDedup::SetName(uint32_t capture_id, const char *name)
+    {
+        for (Slot &slot : m_slots)
+        {
+            if (slot.expires_us != 0 && slot.capture_id == capture_id && slot.name[0] == '\0')
+            {
+                std::strncpy(slot.name, name ? name : "", DEDUP_NAME_SIZE - 1);
+                slot.name[DEDUP_NAME_SIZE - 1] = '\0';
+                return;
+            }
+        }
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,83 @@
+/**
+ * @file CaptureDedup.hpp
+ * @brief Folds repeated fines at the same place into the capture that already covers them.
+ * @details Stop-and-go traffic at one junction can produce several fines seconds apart. Every
+ * capture that starts is recorded under the world cell (x, z quantised to the cell size) the truck
+ * was in, and stays live for the time window. A later fine within one cell size of a live capture,
+ * found by looking at its own cell and the eight around it, is attached to that capture instead of
+ * starting a new one. The window is not extended by attached fines, so a long queue still gets a
+ * fresh capture once per window.
+ *
+ * Captures live in a fixed open-addressing table (linear probing). Expired slots are reused in
+ * place, so nothing is ever moved or allocated; when every slot is live, the one expiring first is
+ * replaced. Times are the game's simulation clock, which stops while the game is paused.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t DEDUP_TABLE_SLOTS = 32; ///< Power of two.
+  constexpr size_t DEDUP_NAME_SIZE = 96;   ///< Same as SCREENSHOT_NAME_SIZE.
+
+  /** @brief The live capture a fine was attached to. */
+  struct DedupHit
+  {
+    uint32_t capture_id;
+    uint32_t attached; ///< Fines attached so far, including this one.
+    const char *name;  ///< Screenshot name, or "" if the capture has not taken it yet.
+  };
+
+  class CaptureDedup
+  {
+  public:
+    /**
+     * @brief Sets the cell size (metres) and window (microseconds). A window of 0 disables the
+     *        stage. Clears the table when the cell size changes.
+     */
+    void Configure(double cell_size, uint64_t window_us);
+
+    bool IsEnabled() const { return m_windowUs != 0; }
+
+    /**
+     * @brief Attaches a fine at (x, z) to a live capture within one cell size, if there is one.
+     * @return false if the fine should start a capture of its own.
+     */
+    bool Attach(double x, double z, uint64_t now_us, DedupHit &hit);
+
+    /** @brief Records a capture that started at (x, z), live until `now_us` + window. */
+    void Record(double x, double z, uint64_t now_us, uint32_t capture_id);
+
+    /** @brief Names a recorded capture once its screenshot command is known. */
+    void SetName(uint32_t capture_id, const char *name);
+
+    /** @brief Forgets every capture. The suppression count is kept. */
+    void Clear();
+
+    /** @brief Fines attached instead of captured, since construction. */
+    uint64_t GetSuppressed() const { return m_suppressed; }
+
+  private:
+    struct Slot
+    {
+      double x, z;
+      uint64_t expires_us; ///< 0 for a slot that was never used; probing stops there.
+      int32_t cell_x, cell_z;
+      uint32_t capture_id;
+      uint32_t attached;
+      char name[DEDUP_NAME_SIZE];
+    };
+
+    static size_t SlotOf(int32_t cx, int32_t cz);
+    int32_t CellOf(double coordinate) const;
+
+    Slot m_slots[DEDUP_TABLE_SLOTS] = {};
+    double m_cellSize = 25.0;
+    uint64_t m_windowUs = 0;
+    uint64_t m_suppressed = 0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,360 @@
+/**
+ * @file CaptureJournal.cpp
+ * @brief Implementation of the capture journal and its recovery.
+ */
+
+#include "CaptureJournal.hpp"
+#include "Crc32c.hpp"
+
+#include <cstddef>
+#include <cstring>
+
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr size_t MAX_RECORD_SIZE = sizeof(JournalRecordHeader) + JOURNAL_MAX_PAYLOAD;
+
+        uint32_t CheckpointCrc(const JournalCheckpoint &checkpoint) { return Crc32c(&checkpoint, offsetof(JournalCheckpoint, crc)); }
+
+        uint32_t RecordCrc(const JournalRecordHeader &header, const void *payload)
+        {
+            const uint32_t crc = Crc32c(reinterpret_cast<const char *>(&header) + sizeof(header.crc), sizeof(header) - sizeof(header.crc));
+            return Crc32c(payload, header.size, crc);
+        }
+
+        uint64_t FileSize(FILE *file)
+        {
+            std::fseek(file, 0, SEEK_END);
+            const long size = std::ftell(file);
+            return size > 0 ? (uint64_t)size : 0;
+        }
+
+        /**
+         * @brief Reads the record at the current position, at most `remaining` bytes long.
+         * @return Its size including the header, or 0 if it is torn or corrupt.
+         */
+        size_t ReadRecord(FILE *file, uint64_t remaining, JournalRecordType &type, void *payload)
+        {
+            JournalRecordHeader header;
+            if (remaining < sizeof(header) || std::fread(&header, sizeof(header), 1, file) != 1 || header.size > JOURNAL_MAX_PAYLOAD ||
+                remaining - sizeof(header) < header.size || std::fread(payload, 1, header.size, file) != header.size || RecordCrc(header, payload) != header.crc)
+            {
+                return 0;
+            }
+            type = (JournalRecordType)header.type;
+            return sizeof(header) + header.size;
+        }
+
+        bool IsJournalHeader(const JournalFileHeader &header)
+        {
+            return std::memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) == 0 && header.version == JOURNAL_VERSION;
+        }
+
+        // The slots alternate, so a torn write only ever damages the older one.
+        uint64_t SlotOffset(const JournalCheckpoint &checkpoint)
+        {
+            return offsetof(JournalFileHeader, checkpoints) + (checkpoint.sequence & 1) * sizeof(JournalCheckpoint);
+        }
+
+        bool SyncFile(FILE *file)
+        {
+#ifdef _WIN32
+            return _commit(_fileno(file)) == 0;
+#else
+            return fsync(fileno(file)) == 0;
+#endif
+        }
+    } // namespace
+
+    // =================================================================================================
+    // 1. Writer
+    // =================================================================================================
+
+    bool CaptureJournal::Open(const char *path, JournalRecovery &recovery)
+    {
+        Close();
+        recovery = JournalRecovery();
+        m_failed = false;
+        if (!path)
+        {
+            return false;
+        }
+
+        m_file = std::fopen(path, "r+b");
+        const uint64_t size = m_file ? FileSize(m_file) : 0;
+        JournalFileHeader header;
+        const bool valid = m_file && size >= sizeof(header) && std::fseek(m_file, 0, SEEK_SET) == 0 && std::fread(&header, sizeof(header), 1, m_file) == 1 &&
+                           IsJournalHeader(header);
+        if (!valid)
+        {
+            // Missing, or a creation that was cut short. Anything longer is someone else's file.
+            if (m_file && size > sizeof(header))
+            {
+                std::fclose(m_file);
+                m_file = nullptr;
+                return false;
+            }
+            if (m_file)
+            {
+                std::fclose(m_file);
+            }
+            m_file = std::fopen(path, "w+b");
+            recovery.created = true;
+            if (!m_file || !Create())
+            {
+                Close();
+                return false;
+            }
+            return true;
+        }
+
+        // The newest checkpoint whose slot is intact and which the file still covers.
+        JournalCheckpoint start = {0, sizeof(header), 0, 0, 0};
+        bool found = false;
+        for (const JournalCheckpoint &checkpoint : header.checkpoints)
+        {
+            if (CheckpointCrc(checkpoint) == checkpoint.crc && checkpoint.length >= sizeof(header) && checkpoint.length <= size &&
+                (!found || checkpoint.sequence > start.sequence))
+            {
+                start = checkpoint;
+                found = true;
+            }
+        }
+
+        // Validate the tail and cut it at the first bad record.
+        uint64_t position = start.length;
+        uint64_t tail_records = 0;
+        std::fseek(m_file, (long)position, SEEK_SET);
+        uint8_t payload[JOURNAL_MAX_PAYLOAD];
+        JournalRecordType type;
+        while (const size_t record_size = ReadRecord(m_file, size - position, type, payload))
+        {
+            position += record_size;
+            ++tail_records;
+        }
+        if (position < size)
+        {
+            std::fflush(m_file);
+#ifdef _WIN32
+            const bool truncated = _chsize_s(_fileno(m_file), (__int64)position) == 0;
+#else
+            const bool truncated = ftruncate(fileno(m_file), (off_t)position) == 0;
+#endif
+            if (!truncated)
+            {
+                Close();
+                return false;
+            }
+        }
+
+        m_length = position;
+        m_records = start.records + tail_records;
+        m_sequence = start.sequence;
+        m_checkpointLength = start.length;
+        recovery.records = m_records;
+        recovery.tail_records = tail_records;
+        recovery.scanned_bytes = size - start.length;
+        recovery.dropped_bytes = size - position;
+
+        // So the next recovery does not validate the same tail again.
+        if (position != start.length)
+        {
+            Checkpoint();
+        }
+        return true;
+    }
+
+    bool CaptureJournal::Create()
+    {
+        JournalFileHeader header{};
+        std::memcpy(header.magic, JOURNAL_MAGIC, sizeof(header.magic));
+        header.version = JOURNAL_VERSION;
+        header.checkpoints[0] = {0, sizeof(header), 0, 0, 0};
+        header.checkpoints[0].crc = CheckpointCrc(header.checkpoints[0]);
+        if (!WriteAt(0, &header, sizeof(header)) || std::fflush(m_file) != 0 || !Sync())
+        {
+            return false;
+        }
+        m_length = m_checkpointLength = sizeof(header);
+        m_records = 0;
+        m_sequence = 0;
+        return true;
+    }
+
+    void CaptureJournal::Close()
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        Checkpoint();
+        std::fclose(m_file);
+        m_file = nullptr;
+    }
+
+    bool CaptureJournal::WriteAt(uint64_t offset, const void *data, size_t size)
+    {
+        if (m_observer)
+        {
+            m_observer(m_observerData, offset, data, size);
+        }
+        return std::fseek(m_file, (long)offset, SEEK_SET) == 0 && std::fwrite(data, 1, size, m_file) == size;
+    }
+
+    bool CaptureJournal::Sync() { return SyncFile(m_file); }
+
+    bool CaptureJournal::Append(JournalRecordType type, const void *payload, size_t size)
+    {
+        if (!m_file || m_failed || size > JOURNAL_MAX_PAYLOAD)
+        {
+            return false;
+        }
+
+        uint8_t record[MAX_RECORD_SIZE];
+        JournalRecordHeader header{0, (uint16_t)size, (uint8_t)type, 0};
+        header.crc = RecordCrc(header, payload);
+        std::memcpy(record, &header, sizeof(header));
+        std::memcpy(record + sizeof(header), payload, size);
+        if (!WriteAt(m_length, record, sizeof(header) + size) || std::fflush(m_file) != 0)
+        {
+            m_failed = true;
+            return false;
+        }
+        m_length += sizeof(header) + size;
+        ++m_records;
+        return true;
+    }
+
+    bool CaptureJournal::Checkpoint()
+    {
+        if (!m_file || m_failed)
+        {
+            return false;
+        }
+        JournalCheckpoint checkpoint;
+        if (!PrepareCheckpoint(checkpoint))
+        {
+            return true; // Nothing new.
+        }
+
+        // Records first, then the slot that covers them. A failed record sync leaves both slots
+        // as they were; the reserved sequence number is simply skipped.
+        if (std::fflush(m_file) != 0 || !Sync())
+        {
+            return false;
+        }
+        const bool written = WriteAt(SlotOffset(checkpoint), &checkpoint, sizeof(checkpoint)) && std::fflush(m_file) == 0 && Sync();
+        FinishCheckpoint(checkpoint, written);
+        return written;
+    }
+
+    bool CaptureJournal::PrepareCheckpoint(JournalCheckpoint &out)
+    {
+        if (!m_file || m_failed || m_checkpointLength == m_length)
+        {
+            return false;
+        }
+        // Reserved now, so a later checkpoint always gets a higher number, even if this one is
+        // still being written elsewhere when the later one is taken (e.g. by Close).
+        out = {m_sequence + 1, m_length, m_records, 0, 0};
+        out.crc = CheckpointCrc(out);
+        m_sequence = out.sequence;
+        return true;
+    }
+
+    bool CaptureJournal::WriteCheckpoint(const char *path, const JournalCheckpoint &checkpoint)
+    {
+        FILE *file = path ? std::fopen(path, "r+b") : nullptr;
+        if (!file)
+        {
+            return false;
+        }
+        // fsync covers the whole file, including the records written through the owner's handle.
+        const bool written = SyncFile(file) && std::fseek(file, (long)SlotOffset(checkpoint), SEEK_SET) == 0 &&
+                             std::fwrite(&checkpoint, sizeof(checkpoint), 1, file) == 1 && std::fflush(file) == 0 && SyncFile(file);
+        std::fclose(file);
+        return written;
+    }
+
+    void CaptureJournal::FinishCheckpoint(const JournalCheckpoint &checkpoint, bool written)
+    {
+        if (!written)
+        {
+            m_failed = true;
+            return;
+        }
+        if (checkpoint.length > m_checkpointLength && checkpoint.length <= m_length)
+        {
+            m_checkpointLength = checkpoint.length;
+        }
+    }
+
+    // =================================================================================================
+    // 2. Reader
+    // =================================================================================================
+
+    bool JournalReader::Open(const char *path)
+    {
+        Close();
+        m_file = path ? std::fopen(path, "rb") : nullptr;
+        JournalFileHeader header;
+        if (!m_file || std::fread(&header, sizeof(header), 1, m_file) != 1 || !IsJournalHeader(header))
+        {
+            Close();
+            return false;
+        }
+        m_damaged = false;
+        m_position = sizeof(header);
+        m_size = FileSize(m_file);
+        std::fseek(m_file, (long)m_position, SEEK_SET);
+        return true;
+    }
+
+    void JournalReader::Close()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool JournalReader::Next(JournalRecordType &type, void *payload, size_t &size)
+    {
+        if (!m_file)
+        {
+            return false;
+        }
+        // The file size is looked up again only when a record runs past the last known end, so
+        // reading does not seek (and drop the read buffer) on every record.
+        size_t record_size = m_position + sizeof(JournalRecordHeader) <= m_size ? ReadRecord(m_file, m_size - m_position, type, payload) : 0;
+        if (record_size == 0)
+        {
+            const uint64_t known_size = m_size;
+            m_size = FileSize(m_file);
+            std::fseek(m_file, (long)m_position, SEEK_SET);
+            if (m_position >= m_size)
+            {
+                return false;
+            }
+            record_size = m_size != known_size ? ReadRecord(m_file, m_size - m_position, type, payload) : 0;
+        }
+        if (record_size == 0)
+        {
+            m_damaged = true;
+            return false;
+        }
+        m_position += record_size;
+        size = record_size - sizeof(JournalRecordHeader);
+        return true;
+    }
+
+} // namespace SPF_RedLightCamera
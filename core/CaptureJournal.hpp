@@ -0,0 +1,270 @@
+/**
+ * @file CaptureJournal.hpp
+ * @brief Append-only, checksummed journal of the fines, the screenshots the plugin takes and their outcome.
+ * @details Every record is one write of a header and its payload; the header's CRC-32C (see
+ * Crc32c.hpp) covers the rest of the header and the payload. Each append is flushed to the OS at
+ * once, so a game crash loses nothing; a power loss can leave a torn or zero-filled last record,
+ * which fails its checksum.
+ *
+ * The file header holds two checkpoint slots. `Checkpoint` syncs the records to disk first and
+ * only then writes the next slot (alternating, each with its own CRC) and syncs again, so a
+ * checkpoint never covers data that is not durable and a torn slot write leaves the other slot
+ * intact. `Open` starts from the newest valid checkpoint and validates only the records after it,
+ * truncating the file at the first bad one: recovery reads the unsynced tail, not the whole file.
+ *
+ * The journal never checkpoints on its own; the owner calls `Checkpoint` when `GetUnsyncedBytes`
+ * reaches `JOURNAL_CHECKPOINT_BYTES`, at a time of its choosing (a sync can take milliseconds).
+ * To keep the syncs off its own thread, the owner can instead split it: `PrepareCheckpoint`
+ * reserves the next slot, `WriteCheckpoint` syncs and writes it through a separate handle on
+ * another thread while appends continue, and `FinishCheckpoint` records the outcome.
+ */
+#pragma once
+
+#include "ScreenshotTracker.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t JOURNAL_MAX_PAYLOAD = 256;
+  constexpr uint64_t JOURNAL_CHECKPOINT_BYTES = 16 * 1024; ///< Unsynced bytes after which the owner should checkpoint.
+
+  /** @brief Magic bytes at the start of the journal ("RLCJ"). */
+  constexpr char JOURNAL_MAGIC[4] = {'R', 'L', 'C', 'J'};
+
+  /**
+   * @brief Format version. Bump whenever the header, record or payload layout changes. A new record
+   *        type needs no bump: readers skip the types they do not know.
+   */
+  constexpr uint16_t JOURNAL_VERSION = 1;
+
+  enum class JournalRecordType : uint8_t
+  {
+    Screenshot = 1,       ///< JournalScreenshot: a screenshot command was issued.
+    ScreenshotResult = 2, ///< JournalScreenshotResult: the game log confirmed, failed or never answered it.
+    Fine = 3,             ///< JournalFine: the player was fined.
+    CaptureNamed = 4,     ///< JournalCaptureNamed: the first screenshot of a capture was named.
+    ScreenshotQuality = 5, ///< JournalScreenshotQuality: a saved red light screenshot was checked.
+  };
+
+  constexpr size_t JOURNAL_OFFENCE_SIZE = 32;
+  constexpr size_t JOURNAL_TRUCK_ID_SIZE = 64;
+  constexpr size_t JOURNAL_PLATE_SIZE = 32;
+
+  /** @brief What became of a fine's capture. */
+  enum class JournalFineCapture : uint8_t
+  {
+    None = 0,     ///< Not an offence the plugin captures.
+    Started = 1,  ///< Started a capture (`capture_id`).
+    Queued = 2,   ///< Queued behind the capture in progress (`capture_id`).
+    Attached = 3, ///< Repeat fine folded into an earlier capture (`capture_id`).
+    Dropped = 4,  ///< A capture was already queued.
+    Count
+  };
+
+#pragma pack(push, 1)
+  struct JournalCheckpoint
+  {
+    uint64_t sequence; ///< Higher is newer.
+    uint64_t length;   ///< Durable, validated bytes from the start of the file.
+    uint64_t records;  ///< Records within `length`.
+    uint32_t crc;      ///< CRC-32C of the fields above.
+    uint32_t reserved;
+  };
+
+  struct JournalFileHeader
+  {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    JournalCheckpoint checkpoints[2];
+  };
+
+  struct JournalRecordHeader
+  {
+    uint32_t crc;  ///< CRC-32C of the fields below and the payload.
+    uint16_t size; ///< Payload bytes that follow.
+    uint8_t type;  ///< JournalRecordType.
+    uint8_t reserved;
+  };
+
+  struct JournalScreenshot
+  {
+    uint64_t simulation_time; ///< us, as in the screenshot name.
+    double x, y, z;
+    int32_t shot;     ///< Fly-by shot, or -1 for a still.
+    uint32_t attempt; ///< 0 for the first try.
+    char label[SCREENSHOT_LABEL_SIZE];
+    char name[SCREENSHOT_NAME_SIZE];
+  };
+
+  struct JournalScreenshotResult
+  {
+    uint64_t latency_us;
+    uint32_t attempt;
+    uint8_t outcome; ///< ScreenshotOutcome.
+    uint8_t retry_queued;
+    char name[SCREENSHOT_NAME_SIZE];
+  };
+
+  /**
+   * @brief A fine, written when it arrives. Its screenshot is named later: capture ids restart
+   *        every session, so a reader pairs it with the next `JournalCaptureNamed` of that id.
+   */
+  struct JournalFine
+  {
+    uint64_t simulation_time; ///< us.
+    double x, y, z;
+    double heading; ///< 0..1, as in the telemetry.
+    int64_t fine_amount;
+    float speed;         ///< m/s.
+    uint32_t capture_id; ///< 0 unless `capture` is Started, Queued or Attached.
+    uint8_t capture;     ///< JournalFineCapture.
+    char offence[JOURNAL_OFFENCE_SIZE];
+    char truck_id[JOURNAL_TRUCK_ID_SIZE]; ///< SPF_TruckConstants::id.
+    char plate[JOURNAL_PLATE_SIZE];       ///< SPF_TruckConstants::license_plate.
+  };
+
+  struct JournalCaptureNamed
+  {
+    uint32_t capture_id;
+    char name[SCREENSHOT_NAME_SIZE];
+  };
+
+  /** @brief The quality check of a saved screenshot (see ScreenshotQuality.hpp). */
+  struct JournalScreenshotQuality
+  {
+    float mean_luma;
+    float laplacian_variance;
+    float difference; ///< -1 without a previous screenshot to compare.
+    uint32_t width, height;
+    uint32_t attempt;
+    uint8_t flags;  ///< QualityFlags; 0 is a good capture.
+    uint8_t retake; ///< A retake was queued.
+    char name[SCREENSHOT_NAME_SIZE];
+  };
+#pragma pack(pop)
+
+  static_assert(sizeof(JournalScreenshot) <= JOURNAL_MAX_PAYLOAD && sizeof(JournalScreenshotResult) <= JOURNAL_MAX_PAYLOAD &&
+                    sizeof(JournalFine) <= JOURNAL_MAX_PAYLOAD && sizeof(JournalCaptureNamed) <= JOURNAL_MAX_PAYLOAD &&
+                    sizeof(JournalScreenshotQuality) <= JOURNAL_MAX_PAYLOAD,
+                "Journal payload too large.");
+
+  /** @brief What `CaptureJournal::Open` found. */
+  struct JournalRecovery
+  {
+    uint64_t records = 0;       ///< Records in the journal after recovery.
+    uint64_t tail_records = 0;  ///< Of those, found after the checkpoint.
+    uint64_t scanned_bytes = 0; ///< Bytes validated after the checkpoint, including the dropped ones.
+    uint64_t dropped_bytes = 0; ///< Torn or corrupt bytes truncated from the end.
+    bool created = false;       ///< The file did not exist (or held only a torn header) and was created.
+  };
+
+  class CaptureJournal
+  {
+  public:
+    /** @brief Called before every write to the file, with its offset and bytes (for fault injection). */
+    using WriteObserver = void (*)(void *user_data, uint64_t offset, const void *data, size_t size);
+
+    CaptureJournal() = default;
+    ~CaptureJournal() { Close(); }
+    CaptureJournal(const CaptureJournal &) = delete;
+    CaptureJournal &operator=(const CaptureJournal &) = delete;
+
+    /**
+     * @brief Opens or creates the journal and recovers its tail.
+     * @return false if the file cannot be opened or is not a journal (it is then left untouched).
+     */
+    bool Open(const char *path, JournalRecovery &recovery);
+
+    /** @brief Checkpoints and closes the journal. */
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    /**
+     * @brief Appends one record in a single write and flushes it to the OS.
+     * @return false if the journal is closed, the payload too large or the write failed. After a
+     *         failed write the journal refuses further appends; the next `Open` drops the torn record.
+     */
+    bool Append(JournalRecordType type, const void *payload, size_t size);
+
+    /** @brief Syncs the records to disk and records their length in the next checkpoint slot. */
+    bool Checkpoint();
+
+    /**
+     * @brief Fills in the checkpoint for every record appended so far and reserves its sequence
+     *        number, for `WriteCheckpoint`.
+     * @return false if there is nothing new to checkpoint, or the journal is closed or failed.
+     */
+    bool PrepareCheckpoint(JournalCheckpoint &out);
+
+    /**
+     * @brief Makes a prepared checkpoint durable: syncs the file, then writes the checkpoint's slot
+     *        and syncs again, through a handle of its own.
+     * @details Writes only the header slot, so it may run on another thread while the owner keeps
+     *          appending. The records it covers must already be flushed to the OS (`Append` does).
+     */
+    static bool WriteCheckpoint(const char *path, const JournalCheckpoint &checkpoint);
+
+    /**
+     * @brief Records the outcome of `WriteCheckpoint`.
+     * @details As with `Checkpoint`, a failed write stops further appends.
+     */
+    void FinishCheckpoint(const JournalCheckpoint &checkpoint, bool written);
+
+    uint64_t GetRecordCount() const { return m_records; }
+    uint64_t GetLength() const { return m_length; }
+    uint64_t GetUnsyncedBytes() const { return m_length - m_checkpointLength; }
+
+    void SetWriteObserver(WriteObserver observer, void *user_data)
+    {
+      m_observer = observer;
+      m_observerData = user_data;
+    }
+
+  private:
+    bool Create();
+    bool WriteAt(uint64_t offset, const void *data, size_t size);
+    bool Sync();
+
+    FILE *m_file = nullptr;
+    uint64_t m_length = 0;
+    uint64_t m_records = 0;
+    uint64_t m_sequence = 0;
+    uint64_t m_checkpointLength = 0;
+    bool m_failed = false;
+    WriteObserver m_observer = nullptr;
+    void *m_observerData = nullptr;
+  };
+
+  /** @brief Reads the records of a journal from the start, without changing it. */
+  class JournalReader
+  {
+  public:
+    JournalReader() = default;
+    ~JournalReader() { Close(); }
+    JournalReader(const JournalReader &) = delete;
+    JournalReader &operator=(const JournalReader &) = delete;
+
+    bool Open(const char *path);
+    void Close();
+
+    /**
+     * @brief Next valid record; `payload` must hold `JOURNAL_MAX_PAYLOAD` bytes.
+     * @return false at the end, or at a torn or corrupt record (see `IsDamaged`).
+     */
+    bool Next(JournalRecordType &type, void *payload, size_t &size);
+
+    bool IsDamaged() const { return m_damaged; }
+
+  private:
+    FILE *m_file = nullptr;
+    uint64_t m_position = 0;
+    uint64_t m_size = 0; ///< File size when last looked up.
+    bool m_damaged = false;
+  };
+
+} // namespace SPF_RedLightCamera
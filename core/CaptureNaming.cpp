@@ -0,0 +1,49 @@
+/**
+ * @file CaptureNaming.cpp
+ * @brief Implementation of the screenshot command builder.
+ */
+
+#include "CaptureNaming.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    static constexpr char SCREENSHOT_COMMAND[] = "screenshot ";
+
+    size_t FormatScreenshotCommand(char *out, size_t size, const char *label, const SPF_DVector &truck, uint64_t simulation_time, int32_t shot)
+    {
+        if (!out || size == 0)
+        {
+            return 0;
+        }
+
+        int written;
+        if (shot < 0)
+        {
+            written = std::snprintf(out, size, "%s%s_X%d_Y%d_Z%d_T%llu", SCREENSHOT_COMMAND, label,
+                                    (int)truck.x, (int)truck.y, (int)truck.z, (unsigned long long)simulation_time);
+        }
+        else
+        {
+            written = std::snprintf(out, size, "%s%s_X%d_Y%d_Z%d_T%llu_S%d", SCREENSHOT_COMMAND, label,
+                                    (int)truck.x, (int)truck.y, (int)truck.z, (unsigned long long)simulation_time, shot);
+        }
+
+        if (written < 0 || (size_t)written >= size)
+        {
+            out[0] = '\0';
+            return 0;
+        }
+        return (size_t)written;
+    }
+
+    const char *ScreenshotNameOf(const char *command)
+    {
+        const size_t prefix = sizeof(SCREENSHOT_COMMAND) - 1;
+        return command && std::strncmp(command, SCREENSHOT_COMMAND, prefix) == 0 ? command + prefix : command;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,27 @@
+/**
+ * @file CaptureNaming.hpp
+ * @brief Builds the `screenshot` console command, and with it the screenshot file name.
+ * @details Format: `screenshot <label>_X<x>_Y<y>_Z<z>_T<simulation time>`, with `_S<shot>`
+ * appended for the shots of a fly-by. Coordinates are truncated to whole metres.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /**
+   * @brief Writes the screenshot command into `out`.
+   * @param shot Shot index for fly-by captures, or -1 for a single still.
+   * @return Length of the command, or 0 if it did not fit.
+   */
+  size_t FormatScreenshotCommand(char *out, size_t size, const char *label, const SPF_DVector &truck, uint64_t simulation_time, int32_t shot);
+
+  /** @brief The file name part of a command built by `FormatScreenshotCommand` (after "screenshot "). */
+  const char *ScreenshotNameOf(const char *command);
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,113 @@
+/**
+ * @file CaptureSequence.cpp
+ * @brief Implementation of the capture state machine.
+ */
+
+#include "CaptureSequence.hpp"
+
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        // Standard capture, indexed by frame - 1. The flash runs on its own clock (see FlashCurve.hpp);
+        // the fade frames only keep the sequence busy while it is at its brightest.
+        constexpr CaptureStep STANDARD_STEPS[] = {
+            CaptureStep::SnapshotAndPose,
+            CaptureStep::Screenshot,
+            CaptureStep::Restore,
+            CaptureStep::Fade,
+            CaptureStep::Fade,
+            CaptureStep::Fade,
+            CaptureStep::Finish,
+        };
+        constexpr int STANDARD_STEP_COUNT = (int)(sizeof(STANDARD_STEPS) / sizeof(STANDARD_STEPS[0]));
+    } // namespace
+
+    bool CaptureSequence::Start(const char *label, bool cinematic)
+    {
+        if (m_active)
+        {
+            return false;
+        }
+
+        std::strncpy(m_label, label ? label : RED_LIGHT_LABEL, sizeof(m_label) - 1);
+        m_label[sizeof(m_label) - 1] = '\0';
+        m_active = true;
+        m_cinematic = cinematic;
+        m_frame = 0;
+        return true;
+    }
+
+    FineOutcome CaptureSequence::OnFine(const char *offence, bool cinematic)
+    {
+        if (!offence || std::strcmp(offence, RED_LIGHT_OFFENCE) != 0)
+        {
+            return FineOutcome::Ignored;
+        }
+
+        if (!m_active)
+        {
+            Start(RED_LIGHT_LABEL, cinematic);
+            return FineOutcome::Started;
+        }
+
+        // A traffic capture must not cost the player's own shot: run it right after.
+        if (std::strcmp(m_label, RED_LIGHT_LABEL) != 0 && !m_redLightPending)
+        {
+            m_redLightPending = true;
+            m_pendingCinematic = cinematic;
+            return FineOutcome::Queued;
+        }
+
+        // Only one red light capture can be in flight; this fine goes unphotographed.
+        return FineOutcome::Dropped;
+    }
+
+    bool CaptureSequence::StartPending()
+    {
+        if (!m_redLightPending || m_active)
+        {
+            return false;
+        }
+        m_redLightPending = false;
+        return Start(RED_LIGHT_LABEL, m_pendingCinematic);
+    }
+
+    CaptureStep CaptureSequence::Advance()
+    {
+        if (!m_active)
+        {
+            return CaptureStep::Idle;
+        }
+
+        m_frame++;
+        if (m_cinematic)
+        {
+            return m_frame == 1 ? CaptureStep::CinematicSetup : CaptureStep::CinematicPlayback;
+        }
+
+        const CaptureStep step = STANDARD_STEPS[(m_frame < STANDARD_STEP_COUNT ? m_frame : STANDARD_STEP_COUNT) - 1];
+        if (step == CaptureStep::Finish)
+        {
+            Finish();
+        }
+        return step;
+    }
+
+    void CaptureSequence::Finish()
+    {
+        m_active = false;
+        m_cinematic = false;
+        m_frame = 0;
+    }
+
+    void CaptureSequence::DowngradeToStandard()
+    {
+        m_cinematic = false;
+        m_frame = 0;
+    }
+
+} // namespace SPF_RedLightCamera
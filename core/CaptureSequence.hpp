@@ -0,0 +1,92 @@
+/**
+ * @file CaptureSequence.hpp
+ * @brief The capture state machine: which step runs on which frame, and what happens to fines
+ *        that arrive while a capture is in flight.
+ * @details The sequence only decides; the plugin adapter carries each step out through the
+ * framework APIs. A standard capture runs one step per frame:
+ *
+ *     1 snapshot + pose   2 screenshot   3 restore   4-6 flash fade   7 finish
+ *
+ * A cinematic capture hands every frame after the first to the adapter's fly-by playback, which
+ * calls `Finish` when it is done.
+ *
+ * Only one capture runs at a time. A red light fine during a traffic or manual capture is queued and
+ * started by `StartPending` once the traffic capture finishes; any other overlapping red light
+ * fine is dropped.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief What the adapter has to do on the current frame. */
+  enum class CaptureStep : uint8_t
+  {
+    Idle,             ///< No capture in flight.
+    SnapshotAndPose,  ///< Save the player's camera, move the rig into place.
+    Screenshot,       ///< Take the screenshot.
+    Restore,          ///< Put the player's camera back.
+    Fade,             ///< Nothing to do; the flash is fading.
+    Finish,           ///< Record the completed capture; the sequence is idle again.
+    CinematicSetup,   ///< First frame of a fly-by: snapshot, build keyframes, start playback.
+    CinematicPlayback ///< Later fly-by frames; the adapter calls Finish() when done.
+  };
+
+  /** @brief Result of reporting a fine to the sequence. */
+  enum class FineOutcome : uint8_t
+  {
+    Ignored, ///< Not an offence that triggers a capture.
+    Started, ///< A capture starts on the next frame.
+    Queued,  ///< Starts when the capture in flight finishes.
+    Dropped  ///< A red light capture is already in flight or queued.
+  };
+
+  class CaptureSequence
+  {
+  public:
+    static constexpr const char *RED_LIGHT_OFFENCE = "red_signal";
+    static constexpr const char *RED_LIGHT_LABEL = "red_light";
+    static constexpr const char *MANUAL_LABEL = "manual";
+    static constexpr size_t MAX_LABEL = 64;
+
+    /**
+     * @brief Starts a capture on the next frame.
+     * @param label Screenshot file name prefix (e.g. "red_light", "traffic_1007_speeding").
+     * @return false if a capture is already in flight.
+     */
+    bool Start(const char *label, bool cinematic);
+
+    /** @brief Reports a `player.fined` event. Starts, queues or drops a red light capture. */
+    FineOutcome OnFine(const char *offence, bool cinematic);
+
+    /** @brief Starts the queued red light capture if the sequence is idle. */
+    bool StartPending();
+
+    /** @brief Moves to the next frame. */
+    CaptureStep Advance();
+
+    /** @brief Ends the capture in flight (cinematic captures, or after an abort). */
+    void Finish();
+
+    /** @brief Falls back from a cinematic capture to the standard steps, from frame 1. */
+    void DowngradeToStandard();
+
+    bool IsActive() const { return m_active; }
+    bool IsCinematic() const { return m_cinematic; }
+    bool HasPending() const { return m_redLightPending; }
+    int GetFrame() const { return m_frame; }
+    const char *GetLabel() const { return m_label; }
+
+  private:
+    bool m_active = false;
+    bool m_cinematic = false;
+    bool m_redLightPending = false;
+    bool m_pendingCinematic = false;
+    int m_frame = 0;
+    char m_label[MAX_LABEL] = "red_light";
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,68 @@
+/**
+ * @file CaptureStats.cpp
+ * @brief Implementation of the rolling capture statistics.
+ */
+
+#include "CaptureStats.hpp"
+
+#include <algorithm>
+
+namespace SPF_RedLightCamera
+{
+
+    void CaptureStats::RecordLatency(uint32_t micros)
+    {
+        m_latency[m_latencyCount % STATS_LATENCY_WINDOW] = micros;
+        m_latencyCount++;
+        m_lastLatency = micros;
+
+        // Nearest rank over at most STATS_LATENCY_WINDOW samples; the ring itself stays in arrival order.
+        uint32_t window[STATS_LATENCY_WINDOW];
+        const size_t count = m_latencyCount < STATS_LATENCY_WINDOW ? (size_t)m_latencyCount : STATS_LATENCY_WINDOW;
+        std::copy(m_latency, m_latency + count, window);
+        const size_t rank = (count * 95 + 99) / 100 - 1;
+        std::nth_element(window, window + rank, window + count);
+        m_p95Latency = window[rank];
+    }
+
+    void CaptureStats::RecordFrameCost(uint32_t micros)
+    {
+        m_currentWorst = std::max(m_currentWorst, micros);
+        if (++m_currentFrames < STATS_FRAMES_PER_BUCKET)
+        {
+            return;
+        }
+
+        m_buckets[m_nextBucket] = m_currentWorst;
+        m_nextBucket = (m_nextBucket + 1) % STATS_FRAME_BUCKETS;
+        m_bucketsFilled = std::min(m_bucketsFilled + 1, STATS_FRAME_BUCKETS);
+        m_currentWorst = 0;
+        m_currentFrames = 0;
+        m_framePeak = *std::max_element(m_buckets, m_buckets + m_bucketsFilled);
+        m_generation++;
+    }
+
+    bool Sparkline::Update(const CaptureStats &stats, float x, float y, float width, float height)
+    {
+        const float rect[4] = {x, y, width, height};
+        if (stats.GetFrameGeneration() == m_generation && std::equal(rect, rect + 4, m_rect))
+        {
+            return false;
+        }
+        m_generation = stats.GetFrameGeneration();
+        std::copy(rect, rect + 4, m_rect);
+
+        m_count = (int)stats.GetFrameBucketCount();
+        const float step = m_count > 1 ? width / (float)(STATS_FRAME_BUCKETS - 1) : 0.0f;
+        const float scale = stats.GetFramePeak() > 0 ? height / (float)stats.GetFramePeak() : 0.0f;
+        // Newest bucket on the right edge, so the line grows in from the right while it fills.
+        const float left = x + width - step * (float)(m_count > 0 ? m_count - 1 : 0);
+        for (int i = 0; i < m_count; ++i)
+        {
+            m_x[i] = left + step * (float)i;
+            m_y[i] = y + height - scale * (float)stats.GetFrameBucket((size_t)i);
+        }
+        return true;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,90 @@
+/**
+ * @file CaptureStats.hpp
+ * @brief Rolling capture statistics for the in-game HUD.
+ * @details Everything is updated incrementally when something happens, never when the HUD draws:
+ *
+ * - Fine-to-screenshot latency keeps the last `STATS_LATENCY_WINDOW` samples in a ring; the p95
+ *   is recomputed when a sample arrives (a few per minute at most).
+ * - Frame cost is folded into buckets of `STATS_FRAMES_PER_BUCKET` frames, each keeping its worst
+ *   frame. `STATS_FRAME_BUCKETS` buckets form the sparkline; a new bucket bumps the generation.
+ *
+ * `Sparkline` caches the polyline vertices for a screen rectangle and only rebuilds them when the
+ * generation or the rectangle changes, so an open HUD costs a table copy per frame at most.
+ * Fine counts and capture totals are not duplicated here; the HUD reads them from the metrics.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t STATS_LATENCY_WINDOW = 64;
+  constexpr size_t STATS_FRAME_BUCKETS = 60;
+  constexpr uint32_t STATS_FRAMES_PER_BUCKET = 30;
+
+  class CaptureStats
+  {
+  public:
+    void RecordLatency(uint32_t micros);
+    void RecordFrameCost(uint32_t micros);
+
+    uint32_t GetLastLatency() const { return m_lastLatency; }
+    /** @brief Nearest-rank p95 over the latency window; 0 before the first sample. */
+    uint32_t GetP95Latency() const { return m_p95Latency; }
+    uint64_t GetLatencyCount() const { return m_latencyCount; }
+
+    /** @brief Bumped every time a frame bucket rolls over. */
+    uint64_t GetFrameGeneration() const { return m_generation; }
+    /** @brief Number of completed buckets, up to `STATS_FRAME_BUCKETS`. */
+    size_t GetFrameBucketCount() const { return m_bucketsFilled; }
+    /** @brief Worst frame of completed bucket `index`, oldest first. */
+    uint32_t GetFrameBucket(size_t index) const
+    {
+      const size_t first = m_bucketsFilled < STATS_FRAME_BUCKETS ? 0 : m_nextBucket;
+      return m_buckets[(first + index) % STATS_FRAME_BUCKETS];
+    }
+    /** @brief Worst frame over all completed buckets. */
+    uint32_t GetFramePeak() const { return m_framePeak; }
+
+  private:
+    uint32_t m_latency[STATS_LATENCY_WINDOW] = {};
+    uint64_t m_latencyCount = 0;
+    uint32_t m_lastLatency = 0;
+    uint32_t m_p95Latency = 0;
+
+    uint32_t m_buckets[STATS_FRAME_BUCKETS] = {};
+    size_t m_nextBucket = 0;
+    size_t m_bucketsFilled = 0;
+    uint32_t m_currentWorst = 0;
+    uint32_t m_currentFrames = 0;
+    uint32_t m_framePeak = 0;
+    uint64_t m_generation = 0;
+  };
+
+  /** @brief Cached polyline vertices of the frame cost sparkline. */
+  class Sparkline
+  {
+  public:
+    /**
+     * @brief Rebuilds the vertices for the rectangle at (`x`, `y`) of `width` x `height` if the
+     *        stats rolled over or the rectangle changed. The line spans the rectangle's width; the
+     *        peak bucket touches its top.
+     * @return true if the vertices were rebuilt.
+     */
+    bool Update(const CaptureStats &stats, float x, float y, float width, float height);
+
+    const float *GetX() const { return m_x; }
+    const float *GetY() const { return m_y; }
+    int GetCount() const { return m_count; }
+
+  private:
+    float m_x[STATS_FRAME_BUCKETS] = {};
+    float m_y[STATS_FRAME_BUCKETS] = {};
+    int m_count = 0;
+    uint64_t m_generation = ~0ull;
+    float m_rect[4] = {};
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,79 @@
+/**
+ * @file CinematicPath.cpp
+ * @brief Implementation of the fly-by keyframe generator.
+ */
+
+#define _USE_MATH_DEFINES
+#include "CinematicPath.hpp"
+
+#include <cmath>
+
+namespace SPF_RedLightCamera
+{
+
+    void YawPitchToQuaternion(float yaw, float pitch, SPF_CameraState_t &state)
+    {
+        const float sy = std::sin(yaw * 0.5f), cy = std::cos(yaw * 0.5f);
+        const float sp = std::sin(pitch * 0.5f), cp = std::cos(pitch * 0.5f);
+        state.q_x = cy * sp;
+        state.q_y = sy * cp;
+        state.q_z = -sy * sp;
+        state.q_w = cy * cp;
+    }
+
+    size_t GenerateFlyByKeyframes(const SPF_DVector &truck, double heading, double origin_x, double origin_z,
+                                  const CinematicParams &params, SPF_CameraState_t *out)
+    {
+        size_t count = params.keyframes;
+        if (count < 2)
+        {
+            count = 2;
+        }
+        if (count > CINEMATIC_MAX_KEYFRAMES)
+        {
+            count = CINEMATIC_MAX_KEYFRAMES;
+        }
+
+        // Same heading convention as PositionAndOrientRedLightCamera: phi is the direction of the
+        // regular rig position; the arc is centred on it.
+        const double phi = (1.5 * M_PI) - (2.0 * M_PI * heading);
+        const double sweep = params.sweep_deg * M_PI / 180.0;
+        const double start = phi - sweep * 0.5;
+        const double step = sweep / (double)(count - 1);
+
+        // Unit direction (dx, dz) is rotated by a constant step: one sin/cos pair for the whole arc.
+        double dx = std::cos(start), dz = std::sin(start);
+        const double step_c = std::cos(step), step_s = std::sin(step);
+
+        const double horizontal = std::fabs(params.distance);
+        const float pitch = (float)std::atan2(-params.height, horizontal);
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double offset_x = dx * params.distance;
+            const double offset_z = dz * params.distance;
+
+            SPF_CameraState_t &state = out[i];
+            state.pos_x = (float)(truck.x + offset_x - origin_x);
+            state.pos_y = (float)(truck.y + params.height);
+            state.pos_z = (float)(truck.z + offset_z - origin_z);
+            state.internal_value = params.internal_value;
+            state.fov = params.fov;
+
+            // Look back at the truck: the look vector is the negated offset (see the rig solver).
+            const float yaw = (float)std::atan2(offset_x, offset_z);
+            YawPitchToQuaternion(yaw, horizontal > 0.0 ? pitch : 0.0f, state);
+
+            const double next_dx = dx * step_c - dz * step_s;
+            dz = dx * step_s + dz * step_c;
+            dx = next_dx;
+        }
+        return count;
+    }
+
+    float CinematicShotPosition(int32_t shot, int32_t count)
+    {
+        return count <= 1 ? 0.5f : (float)shot / (float)(count - 1);
+    }
+
+} // namespace SPF_RedLightCamera
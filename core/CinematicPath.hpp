@@ -0,0 +1,59 @@
+/**
+ * @file CinematicPath.hpp
+ * @brief Keyframe generation for the cinematic fly-by capture profile.
+ * @details The fly-by is an arc around the truck, starting at the regular rig position and sweeping
+ * sideways while always looking at the truck. Keyframes are written as `SPF_CameraState_t` into a
+ * caller-provided array in one pass: the arc is walked by rotating a unit vector with a constant
+ * complex step, so the loop has no per-keyframe trigonometry and no allocation. The game's camera
+ * animation engine interpolates between the keyframes.
+ */
+#pragma once
+
+#include <SPF_Camera_API.h>
+#include <SPF_TelemetryData.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Upper bound on keyframes per fly-by (sizes the caller's array). */
+  constexpr size_t CINEMATIC_MAX_KEYFRAMES = 32;
+
+  /** @brief Shape of the fly-by arc. */
+  struct CinematicParams
+  {
+    double distance = 25.0;    ///< Horizontal distance from the truck (the rig's distance_forward).
+    double height = 4.0;       ///< Height above the truck.
+    double sweep_deg = 90.0;   ///< Total arc swept, centred on the regular rig position.
+    float fov = 70.0f;
+    size_t keyframes = 8;      ///< Clamped to [2, CINEMATIC_MAX_KEYFRAMES].
+    float internal_value = 0.0f; ///< Copied into `SPF_CameraState_t::internal_value`.
+  };
+
+  /**
+   * @brief Writes the fly-by keyframes.
+   * @param truck Truck world position at fine time.
+   * @param heading Truck heading (telemetry convention, 0..1).
+   * @param origin_x, origin_z World position of the game's local grid origin; states are local.
+   * @param params Arc shape.
+   * @param out Array of at least `CINEMATIC_MAX_KEYFRAMES` states.
+   * @return Number of keyframes written.
+   */
+  size_t GenerateFlyByKeyframes(const SPF_DVector &truck, double heading, double origin_x, double origin_z,
+                                const CinematicParams &params, SPF_CameraState_t *out);
+
+  /**
+   * @brief Builds the orientation quaternion for a free-camera yaw/pitch (radians, zero roll).
+   * @details Yaw about +Y followed by pitch about the rotated +X, matching `Cam_SetFreeOrientation`.
+   */
+  void YawPitchToQuaternion(float yaw, float pitch, SPF_CameraState_t &state);
+
+  /**
+   * @brief Animation progress (0..1) at which shot `shot` of `count` is taken.
+   * @details Shots are evenly spaced over [0, 1]; a single shot is taken mid-arc.
+   */
+  float CinematicShotPosition(int32_t shot, int32_t count);
+
+} // namespace SPF_RedLightCamera
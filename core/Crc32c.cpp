@@ -0,0 +1,131 @@
+/**
+ * @file Crc32c.cpp
+ * @brief Implementation of CRC-32C, with the SSE4.2 instruction when available.
+ */
+
+#include "Crc32c.hpp"
+
+#include <array>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define RLC_CRC32C_X86 1
+#include <nmmintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define RLC_TARGET_SSE42
+#else
+#include <cpuid.h>
+#define RLC_TARGET_SSE42 __attribute__((target("sse4.2")))
+#endif
+#else
+#define RLC_CRC32C_X86 0
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr uint32_t POLYNOMIAL = 0x82F63B78u; // Reflected.
+
+        // Slicing-by-8: table k advances a byte that is k positions ahead of the end of the word.
+        using Crc32cTable = std::array<std::array<uint32_t, 256>, 8>;
+
+        constexpr Crc32cTable BuildTable()
+        {
+            Crc32cTable table{};
+            for (uint32_t i = 0; i < 256; ++i)
+            {
+                uint32_t crc = i;
+                for (int bit = 0; bit < 8; ++bit)
+                {
+                    crc = (crc >> 1) ^ ((crc & 1) ? POLYNOMIAL : 0);
+                }
+                table[0][i] = crc;
+            }
+            for (size_t k = 1; k < 8; ++k)
+            {
+                for (uint32_t i = 0; i < 256; ++i)
+                {
+                    table[k][i] = (table[k - 1][i] >> 8) ^ table[0][table[k - 1][i] & 0xFF];
+                }
+            }
+            return table;
+        }
+
+        constexpr Crc32cTable TABLE = BuildTable();
+
+        uint32_t Crc32cSoftware(const uint8_t *p, size_t size, uint32_t crc)
+        {
+            crc = ~crc;
+            for (; size >= 8; p += 8, size -= 8)
+            {
+                // Little-endian: the low four bytes are the ones the running CRC lines up with.
+                uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                word ^= crc;
+                crc = TABLE[7][word & 0xFF] ^ TABLE[6][(word >> 8) & 0xFF] ^ TABLE[5][(word >> 16) & 0xFF] ^ TABLE[4][(word >> 24) & 0xFF] ^
+                      TABLE[3][(word >> 32) & 0xFF] ^ TABLE[2][(word >> 40) & 0xFF] ^ TABLE[1][(word >> 48) & 0xFF] ^ TABLE[0][word >> 56];
+            }
+            for (; size != 0; ++p, --size)
+            {
+                crc = TABLE[0][(crc ^ *p) & 0xFF] ^ (crc >> 8);
+            }
+            return ~crc;
+        }
+
+#if RLC_CRC32C_X86
+        RLC_TARGET_SSE42 uint32_t Crc32cHardware(const uint8_t *p, size_t size, uint32_t crc)
+        {
+            crc = ~crc;
+#if defined(__x86_64__) || defined(_M_X64)
+            uint64_t wide = crc;
+            for (; size >= 8; p += 8, size -= 8)
+            {
+                uint64_t word;
+                std::memcpy(&word, p, sizeof(word));
+                wide = _mm_crc32_u64(wide, word);
+            }
+            crc = (uint32_t)wide;
+#endif
+            for (; size != 0; ++p, --size)
+            {
+                crc = _mm_crc32_u8(crc, *p);
+            }
+            return ~crc;
+        }
+
+        bool DetectSse42()
+        {
+#ifdef _MSC_VER
+            int info[4];
+            __cpuid(info, 1);
+            return (info[2] & (1 << 20)) != 0;
+#else
+            unsigned eax, ebx, ecx, edx;
+            return __get_cpuid(1, &eax, &ebx, &ecx, &edx) && (ecx & bit_SSE4_2) != 0;
+#endif
+        }
+
+        const bool HAS_SSE42 = DetectSse42();
+#else
+        const bool HAS_SSE42 = false;
+#endif
+    } // namespace
+
+    uint32_t Crc32c(const void *data, size_t size, uint32_t crc)
+    {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+#if RLC_CRC32C_X86
+        if (HAS_SSE42)
+        {
+            return Crc32cHardware(p, size, crc);
+        }
+#endif
+        return Crc32cSoftware(p, size, crc);
+    }
+
+    bool Crc32cUsesHardware() { return HAS_SSE42; }
+
+} // namespace SPF_RedLightCamera
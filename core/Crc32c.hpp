@@ -0,0 +1,27 @@
+/**
+ * @file Crc32c.hpp
+ * @brief CRC-32C (Castagnoli) for the plugin's own files.
+ * @details Uses the SSE4.2 `crc32` instruction when the CPU has it (checked once, at first use), and
+ * a slicing-by-8 table otherwise. Both give the standard CRC-32C (reflected polynomial 0x82F63B78,
+ * initial value and final XOR 0xFFFFFFFF), so files written on one machine verify on any other.
+ * SSE4.2 is not part of the x64 baseline, so the hardware path is compiled for it separately and
+ * only called after the check.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /**
+   * @brief CRC-32C of `size` bytes.
+   * @param crc A previous result, to continue a checksum over several buffers; 0 to start.
+   */
+  uint32_t Crc32c(const void *data, size_t size, uint32_t crc = 0);
+
+  /** @brief Whether `Crc32c` uses the SSE4.2 instruction on this CPU. */
+  bool Crc32cUsesHardware();
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,66 @@
+/**
+ * @file FlashCurve.cpp
+ * @brief Implementation of the flash curves.
+ */
+
+#include "FlashCurve.hpp"
+
+#include <cmath>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr float EXPONENTIAL_RATE = 6.0f;
+
+        // Shutter timing, as fractions of the flash duration.
+        constexpr float SHUTTER_PRE_FLASH_END = 0.08f;
+        constexpr float SHUTTER_MAIN_START = 0.2f;
+
+        float Exponential(float t)
+        {
+            const float floor = std::exp(-EXPONENTIAL_RATE);
+            return (std::exp(-EXPONENTIAL_RATE * t) - floor) / (1.0f - floor);
+        }
+    } // namespace
+
+    float EvaluateFlashCurve(FlashStyle style, float t)
+    {
+        t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+        switch (style)
+        {
+        case FlashStyle::Exponential:
+        case FlashStyle::Vignette:
+            return Exponential(t);
+        case FlashStyle::Shutter:
+        {
+            if (t < SHUTTER_PRE_FLASH_END)
+            {
+                return 1.0f;
+            }
+            if (t < SHUTTER_MAIN_START)
+            {
+                return 0.0f;
+            }
+            const float fade = 1.0f - (t - SHUTTER_MAIN_START) / (1.0f - SHUTTER_MAIN_START);
+            return fade * fade;
+        }
+        case FlashStyle::Linear:
+        default:
+            return 1.0f - t;
+        }
+    }
+
+    void FlashCurve::Build(FlashStyle style, uint32_t duration_us)
+    {
+        m_style = style < FlashStyle::Count ? style : FlashStyle::Linear;
+        m_durationUs = duration_us;
+        m_samplesPerMicro = duration_us > 0 ? (float)FLASH_CURVE_SAMPLES / (float)duration_us : 0.0f;
+        for (size_t i = 0; i <= FLASH_CURVE_SAMPLES; ++i)
+        {
+            m_table[i] = EvaluateFlashCurve(m_style, (float)i / (float)FLASH_CURVE_SAMPLES);
+        }
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,73 @@
+/**
+ * @file FlashCurve.hpp
+ * @brief Flash opacity over time, sampled into a lookup table.
+ * @details Each flash style is a curve from full opacity at the start of the capture to zero after
+ * the flash duration. The curve is sampled once into `FLASH_CURVE_SAMPLES` points when the
+ * settings are read; the draw callback only interpolates between two table entries.
+ *
+ *     Linear        1 - t
+ *     Exponential   fast decay with a long tail (normalised to reach 0 at t = 1)
+ *     Shutter       a short pre-flash, a dark gap, then the main flash fading out
+ *     Vignette      the exponential curve, drawn as a gradient from the screen edges
+ *
+ * Elapsed time is the caller's business; the adapter uses the game's render timestamps, so the
+ * flash keeps its length at any frame rate.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Flash style. Values are the `flash_style` setting. */
+  enum class FlashStyle : uint8_t
+  {
+    Linear = 0,
+    Exponential = 1,
+    Shutter = 2,
+    Vignette = 3,
+    Count
+  };
+
+  constexpr size_t FLASH_CURVE_SAMPLES = 64;
+
+  /** @brief The analytic curve for `style` at normalised time `t` (0..1). Used to build the table. */
+  float EvaluateFlashCurve(FlashStyle style, float t);
+
+  class FlashCurve
+  {
+  public:
+    /** @brief Samples the curve for `style` over `duration_us`. Unknown styles fall back to Linear. */
+    void Build(FlashStyle style, uint32_t duration_us);
+
+    /** @brief Opacity `elapsed_us` after the flash started; 0 once the flash is over. */
+    float Sample(uint64_t elapsed_us) const
+    {
+      if (elapsed_us >= m_durationUs)
+      {
+        return 0.0f;
+      }
+      const float position = (float)elapsed_us * m_samplesPerMicro;
+      const size_t index = (size_t)position;
+      if (index >= FLASH_CURVE_SAMPLES)
+      {
+        return m_table[FLASH_CURVE_SAMPLES];
+      }
+      const float fraction = position - (float)index;
+      return m_table[index] + (m_table[index + 1] - m_table[index]) * fraction;
+    }
+
+    bool IsOver(uint64_t elapsed_us) const { return elapsed_us >= m_durationUs; }
+    FlashStyle GetStyle() const { return m_style; }
+    uint32_t GetDurationMicros() const { return m_durationUs; }
+
+  private:
+    FlashStyle m_style = FlashStyle::Linear;
+    uint32_t m_durationUs = 0;
+    float m_samplesPerMicro = 0.0f;
+    float m_table[FLASH_CURVE_SAMPLES + 1] = {}; ///< Last entry is t = 1, so interpolation never reads past the end.
+  };
+
+} // namespace SPF_RedLightCamera
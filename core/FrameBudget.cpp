@@ -0,0 +1,71 @@
+/**
+ * @file FrameBudget.cpp
+ * @brief Implementation of the per-frame time budget governor.
+ */
+
+#include "FrameBudget.hpp"
+
+namespace SPF_RedLightCamera
+{
+
+    bool FrameBudgetGovernor::BeginFrame()
+    {
+        bool overrun = false;
+        if (m_frames > 0)
+        {
+            m_lastFrameNs = m_frameNs;
+            if (m_lastFrameNs > m_peakFrameNs)
+            {
+                m_peakFrameNs = m_lastFrameNs;
+            }
+            if (m_budgetUs != 0 && m_lastFrameNs > (uint64_t)m_budgetUs * 1000u)
+            {
+                m_overruns++;
+                overrun = true;
+            }
+        }
+
+        m_frames++;
+        m_frameNs = 0;
+        return overrun;
+    }
+
+    void FrameBudgetGovernor::Defer(DeferredTask task)
+    {
+        Slot &slot = m_tasks[Index(task)];
+        if (!slot.pending)
+        {
+            slot.pending = true;
+            slot.waitedFrames = 0;
+        }
+    }
+
+    void FrameBudgetGovernor::RunDeferred()
+    {
+        for (Slot &slot : m_tasks)
+        {
+            if (!slot.pending)
+            {
+                continue;
+            }
+
+            // Over budget: postpone, unless the task has already waited too long.
+            if (!HasHeadroom() && slot.waitedFrames < MAX_DEFERRAL_FRAMES)
+            {
+                slot.waitedFrames++;
+                continue;
+            }
+
+            // Clear first so a task may re-request itself.
+            slot.pending = false;
+            slot.waitedFrames = 0;
+            if (slot.fn)
+            {
+                const Clock::time_point start = Clock::now();
+                slot.fn();
+                Charge(Clock::now() - start);
+            }
+        }
+    }
+
+} // namespace SPF_RedLightCamera
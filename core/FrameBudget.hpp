@@ -0,0 +1,116 @@
+/**
+ * @file FrameBudget.hpp
+ * @brief Per-frame time budget governor for the plugin's own work.
+ * @details The plugin's cost per frame is the time spent in `OnUpdate` plus the time spent in its
+ * draw callbacks. Both are measured with `FrameBudgetGovernor::Scope`. Work that does not have to
+ * happen on a particular frame (flushing the recording, re-posing the live preview, ...) is not
+ * run inline; it is requested with `Defer()` and executed by `RunDeferred()` after the measured
+ * part of `OnUpdate`, only while the frame is still under budget.
+ *
+ * A deferred task that has been postponed for `MAX_DEFERRAL_FRAMES` frames is run regardless,
+ * so sustained load delays optional work but never starves it.
+ */
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Optional work items that may be postponed to a later frame. */
+  enum class DeferredTask : uint8_t
+  {
+    FlushRecording = 0, ///< Flush the telemetry recording buffer to disk.
+    PreviewRepose,      ///< Re-apply the camera rig after a settings change (live preview).
+    PublishMetrics,     ///< Copy the accumulated metrics into the shared-memory segment.
+    CheckpointJournal,  ///< Hand a capture journal checkpoint to the worker pool.
+    Count
+  };
+
+  /**
+   * @brief Measures the plugin's per-frame cost and schedules deferred work within a budget.
+   * @details Not thread-safe; all calls are made from the game's render thread.
+   */
+  class FrameBudgetGovernor
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+    using TaskFn = void (*)();
+
+    /** @brief Frames a pending task may be postponed before it is forced through. */
+    static constexpr uint32_t MAX_DEFERRAL_FRAMES = 120;
+
+    /** @brief RAII timer that charges its lifetime to the current frame. */
+    class Scope
+    {
+    public:
+      explicit Scope(FrameBudgetGovernor &governor) : m_governor(governor), m_start(Clock::now()) {}
+      ~Scope() { m_governor.Charge(Clock::now() - m_start); }
+      Scope(const Scope &) = delete;
+      Scope &operator=(const Scope &) = delete;
+
+    private:
+      FrameBudgetGovernor &m_governor;
+      Clock::time_point m_start;
+    };
+
+    /** @brief Sets the per-frame budget in microseconds. 0 disables deferral (everything runs). */
+    void SetBudgetMicros(uint32_t budget_us) { m_budgetUs = budget_us; }
+    uint32_t GetBudgetMicros() const { return m_budgetUs; }
+
+    /** @brief Binds the function executed for a task. Unbound tasks are silently dropped. */
+    void SetTask(DeferredTask task, TaskFn fn) { m_tasks[Index(task)].fn = fn; }
+
+    /**
+     * @brief Closes the previous frame and starts a new one.
+     * @details Call once at the top of `OnUpdate`. The previous frame's total (its `OnUpdate`
+     * and any draw callbacks that ran after it) is compared against the budget here.
+     * @return true if the previous frame exceeded the budget.
+     */
+    bool BeginFrame();
+
+    /** @brief Adds time to the current frame. Normally called by `Scope`. */
+    void Charge(Clock::duration elapsed) { m_frameNs += (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(); }
+
+    /** @brief Requests a task. Repeated requests before it runs are coalesced. */
+    void Defer(DeferredTask task);
+
+    /**
+     * @brief Runs pending tasks, in enum order, while the current frame is under budget.
+     * @details Call at the end of `OnUpdate`, after its `Scope` has closed. The cost of each
+     * task is charged to the frame, so later tasks see the updated total.
+     */
+    void RunDeferred();
+
+    /** @brief True while the current frame has not yet used up its budget. */
+    bool HasHeadroom() const { return m_budgetUs == 0 || m_frameNs < (uint64_t)m_budgetUs * 1000u; }
+
+    uint64_t GetOverrunCount() const { return m_overruns; }
+    uint64_t GetFrameCount() const { return m_frames; }
+    /** @brief Total plugin time of the last completed frame, in microseconds. */
+    uint32_t GetLastFrameMicros() const { return (uint32_t)(m_lastFrameNs / 1000u); }
+    /** @brief Largest completed frame cost seen so far, in microseconds. */
+    uint32_t GetPeakFrameMicros() const { return (uint32_t)(m_peakFrameNs / 1000u); }
+
+  private:
+    struct Slot
+    {
+      TaskFn fn = nullptr;
+      bool pending = false;
+      uint32_t waitedFrames = 0;
+    };
+
+    static constexpr size_t Index(DeferredTask task) { return static_cast<size_t>(task); }
+
+    Slot m_tasks[static_cast<size_t>(DeferredTask::Count)];
+    uint32_t m_budgetUs = 0;
+    uint64_t m_frameNs = 0;
+    uint64_t m_lastFrameNs = 0;
+    uint64_t m_peakFrameNs = 0;
+    uint64_t m_frames = 0;
+    uint64_t m_overruns = 0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,662 @@
+/**
+ * @file HistoryStore.cpp
+ * @brief Implementation of the history block encoding, writer, reader and maintenance.
+ */
+
+#include "HistoryStore.hpp"
+#include "LzBlock.hpp"
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr size_t STORED_CAPACITY = LzCompressBound(HISTORY_BLOCK_CAPACITY);
+
+        // -------------------------------------------------------------------------------------------
+        // Varints
+        // -------------------------------------------------------------------------------------------
+
+        uint64_t ZigZag(int64_t value) { return ((uint64_t)value << 1) ^ (uint64_t)(value >> 63); }
+        int64_t UnZigZag(uint64_t value) { return (int64_t)(value >> 1) ^ -(int64_t)(value & 1); }
+
+        void PutVarint(uint8_t *&out, uint64_t value)
+        {
+            while (value >= 0x80)
+            {
+                *out++ = (uint8_t)(value | 0x80);
+                value >>= 7;
+            }
+            *out++ = (uint8_t)value;
+        }
+
+        bool GetVarint(const uint8_t *&in, const uint8_t *end, uint64_t &value)
+        {
+            value = 0;
+            for (int shift = 0; shift < 64 && in < end; shift += 7)
+            {
+                const uint8_t byte = *in++;
+                value |= (uint64_t)(byte & 0x7F) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        // -------------------------------------------------------------------------------------------
+        // Quantisation
+        // -------------------------------------------------------------------------------------------
+
+        struct Quantised
+        {
+            uint64_t time = 0;
+            int64_t position[3] = {0, 0, 0}; // Centimetres.
+            uint16_t heading = 0;            // 1/65536 of a turn.
+            int32_t speed = 0;               // Centimetres per second.
+        };
+
+        Quantised Quantise(const HistoryRecord &record)
+        {
+            Quantised q;
+            q.time = record.time_us;
+            q.position[0] = (int64_t)std::llround(record.position.x * 100.0);
+            q.position[1] = (int64_t)std::llround(record.position.y * 100.0);
+            q.position[2] = (int64_t)std::llround(record.position.z * 100.0);
+            q.heading = (uint16_t)((int64_t)std::llround(record.heading * 65536.0) & 0xFFFF);
+            q.speed = (int32_t)std::lround(record.speed * 100.0f);
+            return q;
+        }
+
+        // -------------------------------------------------------------------------------------------
+        // Files
+        // -------------------------------------------------------------------------------------------
+
+        HistorySegmentHeader MakeHeader(uint16_t flags, uint32_t last_sequence)
+        {
+            HistorySegmentHeader header{};
+            std::memcpy(header.magic, HISTORY_MAGIC, sizeof(header.magic));
+            header.version = HISTORY_VERSION;
+            header.flags = flags;
+            header.last_sequence = last_sequence;
+            return header;
+        }
+
+        bool IsValidHeader(const HistorySegmentHeader &header)
+        {
+            return std::memcmp(header.magic, HISTORY_MAGIC, sizeof(header.magic)) == 0 && header.version == HISTORY_VERSION;
+        }
+
+        bool IsValidBlock(const HistoryBlockHeader &block)
+        {
+            return block.record_count != 0 && block.record_count <= HISTORY_BLOCK_RECORDS && block.encoded_size <= HISTORY_BLOCK_CAPACITY &&
+                   block.stored_size <= STORED_CAPACITY && block.codec <= (uint8_t)HistoryCodec::Lz &&
+                   (block.codec != (uint8_t)HistoryCodec::Raw || block.stored_size == block.encoded_size);
+        }
+
+        bool ReadSegmentHeader(const char *path, HistorySegmentHeader &header, uint64_t &size)
+        {
+            FILE *file = std::fopen(path, "rb");
+            if (!file)
+            {
+                return false;
+            }
+            const bool ok = std::fread(&header, sizeof(header), 1, file) == 1 && IsValidHeader(header);
+            std::fseek(file, 0, SEEK_END);
+            const long end = std::ftell(file);
+            size = end > 0 ? (uint64_t)end : 0;
+            std::fclose(file);
+            return ok;
+        }
+
+        // Atomically replaces `path` with `temp_path`.
+        bool ReplaceFile(const char *temp_path, const char *path)
+        {
+#ifdef _WIN32
+            return MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            return std::rename(temp_path, path) == 0;
+#endif
+        }
+
+        /**
+         * @brief Copies the blocks of the segment `in` (past its header) to `out`, compressing raw
+         *        ones if `compress`. Stops quietly at a torn or invalid block.
+         */
+        bool CopyBlocks(FILE *in, FILE *out, bool compress, uint64_t &written)
+        {
+            uint8_t payload[STORED_CAPACITY];
+            uint8_t compressed[STORED_CAPACITY];
+            HistoryBlockHeader block;
+            while (std::fread(&block, sizeof(block), 1, in) == 1 && IsValidBlock(block) && std::fread(payload, 1, block.stored_size, in) == block.stored_size)
+            {
+                const uint8_t *data = payload;
+                if (compress && block.codec == (uint8_t)HistoryCodec::Raw)
+                {
+                    const size_t size = LzCompressBlock(payload, block.encoded_size, compressed, sizeof(compressed));
+                    if (size != 0 && size < block.encoded_size)
+                    {
+                        block.codec = (uint8_t)HistoryCodec::Lz;
+                        block.stored_size = (uint32_t)size;
+                        data = compressed;
+                    }
+                }
+                if (std::fwrite(&block, sizeof(block), 1, out) != 1 || std::fwrite(data, 1, block.stored_size, out) != block.stored_size)
+                {
+                    return false;
+                }
+                written += sizeof(block) + block.stored_size;
+            }
+            return true;
+        }
+
+        /** @brief Writes the blocks of `sequences` (sealing raw ones) into one sealed segment at `target`. */
+        bool WriteSealed(const char *directory, const uint32_t *sequences, size_t count, const char *target, uint64_t &written)
+        {
+            char temp_path[HISTORY_PATH_SIZE + 8];
+            std::snprintf(temp_path, sizeof(temp_path), "%s.tmp", target);
+            FILE *out = std::fopen(temp_path, "wb");
+            if (!out)
+            {
+                return false;
+            }
+
+            const HistorySegmentHeader header = MakeHeader(HISTORY_SEGMENT_SEALED, sequences[count - 1]);
+            bool ok = std::fwrite(&header, sizeof(header), 1, out) == 1;
+            written = sizeof(header);
+            for (size_t i = 0; i < count && ok; ++i)
+            {
+                char path[HISTORY_PATH_SIZE];
+                FILE *in = FormatHistorySegmentPath(path, sizeof(path), directory, sequences[i]) ? std::fopen(path, "rb") : nullptr;
+                HistorySegmentHeader source;
+                ok = in && std::fread(&source, sizeof(source), 1, in) == 1 && IsValidHeader(source) && CopyBlocks(in, out, true, written);
+                if (in)
+                {
+                    std::fclose(in);
+                }
+            }
+            ok = std::fclose(out) == 0 && ok;
+            if (!ok)
+            {
+                std::remove(temp_path);
+                return false;
+            }
+            return ReplaceFile(temp_path, target);
+        }
+
+        int CompareSequence(const void *a, const void *b)
+        {
+            const uint32_t x = *static_cast<const uint32_t *>(a), y = *static_cast<const uint32_t *>(b);
+            return x < y ? -1 : (x > y ? 1 : 0);
+        }
+
+        bool ParseSegmentName(const char *name, uint32_t &sequence)
+        {
+            static const char PREFIX[] = "history_";
+            static const char SUFFIX[] = ".rlhs";
+            if (std::strncmp(name, PREFIX, sizeof(PREFIX) - 1) != 0)
+            {
+                return false;
+            }
+            char *end = nullptr;
+            const unsigned long value = std::strtoul(name + sizeof(PREFIX) - 1, &end, 10);
+            if (end == name + sizeof(PREFIX) - 1 || std::strcmp(end, SUFFIX) != 0 || value == 0 || value > 0xFFFFFFFFul)
+            {
+                return false;
+            }
+            sequence = (uint32_t)value;
+            return true;
+        }
+    } // namespace
+
+    // =================================================================================================
+    // 1. Block Encoding
+    // =================================================================================================
+
+    size_t EncodeHistoryBlock(const HistoryRecord *records, size_t count, uint8_t *out, size_t capacity)
+    {
+        if (count > HISTORY_BLOCK_RECORDS || capacity < count * HISTORY_MAX_RECORD_BYTES)
+        {
+            return 0;
+        }
+        uint8_t *cursor = out;
+        Quantised previous;
+        for (size_t i = 0; i < count; ++i)
+        {
+            const Quantised q = Quantise(records[i]);
+            PutVarint(cursor, ZigZag((int64_t)(q.time - previous.time)));
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                PutVarint(cursor, ZigZag(q.position[axis] - previous.position[axis]));
+            }
+            PutVarint(cursor, ZigZag((int16_t)(uint16_t)(q.heading - previous.heading)));
+            PutVarint(cursor, ZigZag((int64_t)q.speed - previous.speed));
+            *cursor++ = (uint8_t)records[i].kind;
+            previous = q;
+        }
+        return (size_t)(cursor - out);
+    }
+
+    bool DecodeHistoryBlock(const uint8_t *data, size_t size, size_t count, HistoryRecord *out)
+    {
+        const uint8_t *in = data;
+        const uint8_t *const end = data + size;
+        Quantised q;
+        for (size_t i = 0; i < count; ++i)
+        {
+            uint64_t value;
+            if (!GetVarint(in, end, value))
+            {
+                return false;
+            }
+            q.time += (uint64_t)UnZigZag(value);
+            for (int axis = 0; axis < 3; ++axis)
+            {
+                if (!GetVarint(in, end, value))
+                {
+                    return false;
+                }
+                q.position[axis] += UnZigZag(value);
+            }
+            if (!GetVarint(in, end, value))
+            {
+                return false;
+            }
+            q.heading = (uint16_t)(q.heading + (uint16_t)UnZigZag(value));
+            if (!GetVarint(in, end, value) || in == end)
+            {
+                return false;
+            }
+            q.speed += (int32_t)UnZigZag(value);
+
+            HistoryRecord &record = out[i];
+            record.time_us = q.time;
+            record.position = {q.position[0] / 100.0, q.position[1] / 100.0, q.position[2] / 100.0};
+            record.heading = q.heading / 65536.0;
+            record.speed = q.speed / 100.0f;
+            record.kind = (HistoryKind)*in++;
+        }
+        return in == end;
+    }
+
+    // =================================================================================================
+    // 2. Writer
+    // =================================================================================================
+
+    bool HistoryWriter::Open(const char *directory)
+    {
+        Close();
+        if (!directory || std::snprintf(m_directory, sizeof(m_directory), "%s", directory) >= (int)sizeof(m_directory))
+        {
+            return false;
+        }
+
+        // After every existing segment, and after every sequence a merge already covered.
+        uint32_t sequences[HISTORY_MAX_SEGMENTS];
+        const size_t count = ListHistorySegments(directory, sequences, HISTORY_MAX_SEGMENTS);
+        uint32_t last = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            char path[HISTORY_PATH_SIZE];
+            HistorySegmentHeader header;
+            uint64_t size;
+            last = sequences[i] > last ? sequences[i] : last;
+            if (FormatHistorySegmentPath(path, sizeof(path), directory, sequences[i]) && ReadSegmentHeader(path, header, size))
+            {
+                last = header.last_sequence > last ? header.last_sequence : last;
+            }
+        }
+        m_recordCount = 0;
+        m_bytesWritten = 0;
+        m_rolledOver = false;
+        return OpenSegment(last + 1);
+    }
+
+    bool HistoryWriter::OpenSegment(uint32_t sequence)
+    {
+        char path[HISTORY_PATH_SIZE];
+        if (!FormatHistorySegmentPath(path, sizeof(path), m_directory, sequence))
+        {
+            return false;
+        }
+        m_file = std::fopen(path, "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+        // Flushed at once, so a segment with records always has its header on disk first.
+        const HistorySegmentHeader header = MakeHeader(0, sequence);
+        if (std::fwrite(&header, sizeof(header), 1, m_file) != 1 || std::fflush(m_file) != 0)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+            std::remove(path);
+            return false;
+        }
+        m_bytesWritten += sizeof(header);
+        m_sequence = sequence;
+        m_segmentRecords = 0;
+        return true;
+    }
+
+    void HistoryWriter::Append(const HistoryRecord &record)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        m_pending[m_pendingCount++] = record;
+        ++m_recordCount;
+        if (m_pendingCount == HISTORY_BLOCK_RECORDS)
+        {
+            WriteBlock();
+        }
+    }
+
+    void HistoryWriter::Flush()
+    {
+        if (m_file && m_pendingCount != 0)
+        {
+            WriteBlock();
+        }
+    }
+
+    void HistoryWriter::WriteBlock()
+    {
+        HistoryBlockHeader block{};
+        block.encoded_size = (uint32_t)EncodeHistoryBlock(m_pending, m_pendingCount, m_block, sizeof(m_block));
+        block.stored_size = block.encoded_size;
+        block.record_count = (uint16_t)m_pendingCount;
+        block.codec = (uint8_t)HistoryCodec::Raw;
+        const bool written = std::fwrite(&block, sizeof(block), 1, m_file) == 1 && std::fwrite(m_block, 1, block.encoded_size, m_file) == block.encoded_size &&
+                             std::fflush(m_file) == 0;
+        m_segmentRecords += m_pendingCount;
+        m_pendingCount = 0;
+        if (!written)
+        {
+            // A block after a torn one could not be read, so the writer stops here. The segment
+            // keeps what was written; maintenance drops the torn block when it seals it.
+            std::fclose(m_file);
+            m_file = nullptr;
+            m_rolledOver = true;
+            return;
+        }
+        m_bytesWritten += sizeof(block) + block.encoded_size;
+
+        if (m_segmentRecords >= HISTORY_SEGMENT_RECORDS)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+            m_rolledOver = true;
+            OpenSegment(m_sequence + 1);
+        }
+    }
+
+    void HistoryWriter::Close()
+    {
+        if (!m_file)
+        {
+            return;
+        }
+        Flush();
+        if (!m_file)
+        {
+            return; // The flush failed, or it rolled over and the next segment could not be opened.
+        }
+        std::fclose(m_file);
+        m_file = nullptr;
+
+        // Nothing was written to it (e.g. it was opened by the last rollover).
+        char path[HISTORY_PATH_SIZE];
+        if (m_segmentRecords == 0 && FormatHistorySegmentPath(path, sizeof(path), m_directory, m_sequence))
+        {
+            std::remove(path);
+        }
+    }
+
+    // =================================================================================================
+    // 3. Reader
+    // =================================================================================================
+
+    bool HistoryReader::Open(const char *path)
+    {
+        Close();
+        m_file = path ? std::fopen(path, "rb") : nullptr;
+        if (!m_file)
+        {
+            return false;
+        }
+        if (std::fread(&m_header, sizeof(m_header), 1, m_file) != 1 || !IsValidHeader(m_header))
+        {
+            Close();
+            return false;
+        }
+        m_count = m_next = 0;
+        m_blockCount = 0;
+        m_damaged = false;
+        return true;
+    }
+
+    void HistoryReader::Close()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool HistoryReader::ReadBlock()
+    {
+        HistoryBlockHeader block;
+        if (std::fread(&block, sizeof(block), 1, m_file) != 1)
+        {
+            m_damaged = !std::feof(m_file);
+            return false;
+        }
+        if (!IsValidBlock(block) || std::fread(m_stored, 1, block.stored_size, m_file) != block.stored_size)
+        {
+            m_damaged = true;
+            return false;
+        }
+
+        const uint8_t *encoded = m_stored;
+        if (block.codec == (uint8_t)HistoryCodec::Lz)
+        {
+            if (LzDecompressBlock(m_stored, block.stored_size, m_encoded, sizeof(m_encoded)) != block.encoded_size)
+            {
+                m_damaged = true;
+                return false;
+            }
+            encoded = m_encoded;
+        }
+        if (!DecodeHistoryBlock(encoded, block.encoded_size, block.record_count, m_records))
+        {
+            m_damaged = true;
+            return false;
+        }
+        m_count = block.record_count;
+        m_next = 0;
+        ++m_blockCount;
+        return true;
+    }
+
+    bool HistoryReader::Next(HistoryRecord &record)
+    {
+        if (!m_file || (m_next == m_count && !ReadBlock()))
+        {
+            return false;
+        }
+        record = m_records[m_next++];
+        return true;
+    }
+
+    // =================================================================================================
+    // 4. Segments and Maintenance
+    // =================================================================================================
+
+    bool FormatHistorySegmentPath(char *out, size_t size, const char *directory, uint32_t sequence)
+    {
+        const int written = std::snprintf(out, size, "%s/history_%08u.rlhs", directory, sequence);
+        return written > 0 && (size_t)written < size;
+    }
+
+    size_t ListHistorySegments(const char *directory, uint32_t *out, size_t capacity)
+    {
+        size_t count = 0;
+#ifdef _WIN32
+        char pattern[HISTORY_PATH_SIZE];
+        std::snprintf(pattern, sizeof(pattern), "%s\\history_*.rlhs", directory);
+        WIN32_FIND_DATAA entry;
+        HANDLE find = FindFirstFileA(pattern, &entry);
+        if (find == INVALID_HANDLE_VALUE)
+        {
+            return 0;
+        }
+        do
+        {
+            uint32_t sequence;
+            if (count < capacity && ParseSegmentName(entry.cFileName, sequence))
+            {
+                out[count++] = sequence;
+            }
+        } while (FindNextFileA(find, &entry));
+        FindClose(find);
+#else
+        DIR *dir = opendir(directory);
+        if (!dir)
+        {
+            return 0;
+        }
+        while (const dirent *entry = readdir(dir))
+        {
+            uint32_t sequence;
+            if (count < capacity && ParseSegmentName(entry->d_name, sequence))
+            {
+                out[count++] = sequence;
+            }
+        }
+        closedir(dir);
+#endif
+        std::qsort(out, count, sizeof(uint32_t), CompareSequence);
+        return count;
+    }
+
+    HistoryMaintenanceResult MaintainHistory(const char *directory, uint32_t active_sequence)
+    {
+        HistoryMaintenanceResult result;
+        uint32_t sequences[HISTORY_MAX_SEGMENTS];
+        uint64_t sizes[HISTORY_MAX_SEGMENTS];
+        bool sealed_now[HISTORY_MAX_SEGMENTS]; // Already counted in the byte totals.
+        const size_t listed = ListHistorySegments(directory, sequences, HISTORY_MAX_SEGMENTS);
+
+        // Pass 1: drop merge leftovers, seal closed segments.
+        size_t count = 0;
+        uint32_t covered = 0;
+        for (size_t i = 0; i < listed; ++i)
+        {
+            const uint32_t sequence = sequences[i];
+            char path[HISTORY_PATH_SIZE];
+            HistorySegmentHeader header;
+            uint64_t size = 0;
+            if (!FormatHistorySegmentPath(path, sizeof(path), directory, sequence))
+            {
+                continue;
+            }
+            if (active_sequence != 0 && sequence >= active_sequence)
+            {
+                continue; // Still being written, or rolled over to since the run started; never merged either.
+            }
+            if (sequence <= covered)
+            {
+                std::remove(path); // Already copied into an earlier segment by a merge.
+                result.leftovers++;
+                continue;
+            }
+            if (!ReadSegmentHeader(path, header, size))
+            {
+                result.failures++;
+                continue;
+            }
+            covered = header.last_sequence > sequence ? header.last_sequence : sequence;
+
+            sealed_now[count] = (header.flags & HISTORY_SEGMENT_SEALED) == 0;
+            if (sealed_now[count])
+            {
+                uint64_t written = 0;
+                if (!WriteSealed(directory, &sequence, 1, path, written))
+                {
+                    result.failures++;
+                    continue;
+                }
+                result.sealed++;
+                result.bytes_before += size;
+                result.bytes_after += written;
+                size = written;
+            }
+            sequences[count] = sequence;
+            sizes[count] = size;
+            ++count;
+        }
+
+        // Pass 2: merge runs of small sealed segments into the first of each run.
+        for (size_t begin = 0; begin < count;)
+        {
+            size_t end = begin;
+            uint64_t total = 0;
+            while (end < count && sizes[end] < HISTORY_SMALL_SEGMENT_BYTES && total < HISTORY_MERGED_SEGMENT_BYTES)
+            {
+                total += sizes[end++];
+            }
+            if (end - begin < 2)
+            {
+                begin = end > begin ? end : begin + 1;
+                continue;
+            }
+
+            char target[HISTORY_PATH_SIZE];
+            uint64_t written = 0;
+            FormatHistorySegmentPath(target, sizeof(target), directory, sequences[begin]);
+            if (!WriteSealed(directory, sequences + begin, end - begin, target, written))
+            {
+                result.failures++;
+                begin = end;
+                continue;
+            }
+            for (size_t i = begin; i < end; ++i)
+            {
+                if (sealed_now[i])
+                {
+                    result.bytes_after -= sizes[i];
+                }
+                else
+                {
+                    result.bytes_before += sizes[i];
+                }
+                char path[HISTORY_PATH_SIZE];
+                if (i > begin && FormatHistorySegmentPath(path, sizeof(path), directory, sequences[i]))
+                {
+                    std::remove(path);
+                }
+            }
+            result.merged += (uint32_t)(end - begin - 1);
+            result.bytes_after += written;
+            begin = end;
+        }
+        return result;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,253 @@
+/**
+ * @file HistoryStore.hpp
+ * @brief Compact, segmented store for the truck's path and the fines along it.
+ * @details Records are written in blocks of up to `HISTORY_BLOCK_RECORDS`. Inside a block every
+ * field is stored as the zigzag varint of its difference to the previous record (the first record
+ * against zero), after quantising: time in microseconds, position to 1 cm, heading to 1/65536 of a
+ * turn, speed to 1 cm/s. A sample taken once a second while driving takes 10-14 bytes instead of
+ * the 41 of the fixed layout. Blocks decode on their own, so a reader needs one block in memory
+ * and compaction can move blocks without decoding them.
+ *
+ * A segment is one file, `history_<sequence>.rlhs` in the plugin's data directory. The writer
+ * appends raw blocks to the active segment and rolls over to the next sequence after
+ * `HISTORY_SEGMENT_RECORDS` records. Maintenance, meant for a background thread, then:
+ *
+ * - seals every closed segment: each block is LZ-compressed (see LzBlock.hpp) unless that does not
+ *   make it smaller, and the file is replaced through a temporary file;
+ * - merges runs of small sealed segments (sessions that ended early) into the first of the run by
+ *   copying their blocks. The merged file records the last sequence it covers, so leftovers of a
+ *   merge interrupted before they were deleted are recognised and removed instead of read twice.
+ *
+ * An active segment that was not closed (the game crashed) is sealed by the next maintenance run;
+ * a torn last block is dropped.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t HISTORY_BLOCK_RECORDS = 256;
+  constexpr size_t HISTORY_SEGMENT_RECORDS = 64 * HISTORY_BLOCK_RECORDS;
+  constexpr size_t HISTORY_MAX_RECORD_BYTES = 49; ///< Worst case of one encoded record: 10 + 3 x 10 + 3 + 5 + 1.
+  constexpr size_t HISTORY_BLOCK_CAPACITY = HISTORY_BLOCK_RECORDS * HISTORY_MAX_RECORD_BYTES;
+  constexpr uint64_t HISTORY_SMALL_SEGMENT_BYTES = 64 * 1024;  ///< Sealed segments below this are merged.
+  constexpr uint64_t HISTORY_MERGED_SEGMENT_BYTES = 512 * 1024; ///< A merge stops once it reaches this.
+  constexpr size_t HISTORY_MAX_SEGMENTS = 4096;                ///< Listed per maintenance run.
+  constexpr size_t HISTORY_PATH_SIZE = 640;
+
+  /** @brief Magic bytes at the start of every segment ("RLHS"). */
+  constexpr char HISTORY_MAGIC[4] = {'R', 'L', 'H', 'S'};
+
+  /** @brief Format version. Bump whenever the block or record encoding changes. */
+  constexpr uint16_t HISTORY_VERSION = 1;
+
+  /** @brief What a record marks. */
+  enum class HistoryKind : uint8_t
+  {
+    Sample = 0,      ///< Periodic position while driving.
+    RedLightFine = 1,
+    OtherFine = 2,
+    Count
+  };
+
+  struct HistoryRecord
+  {
+    uint64_t time_us = 0; ///< Simulation time.
+    SPF_DVector position = {0.0, 0.0, 0.0};
+    double heading = 0.0; ///< 0..1, as in the telemetry.
+    float speed = 0.0f;   ///< m/s.
+    HistoryKind kind = HistoryKind::Sample;
+  };
+
+  enum class HistoryCodec : uint8_t
+  {
+    Raw = 0, ///< Encoded records as written by the writer.
+    Lz = 1,  ///< Encoded records, LZ-compressed when the segment was sealed.
+  };
+
+  constexpr uint16_t HISTORY_SEGMENT_SEALED = 1;
+
+#pragma pack(push, 1)
+  struct HistorySegmentHeader
+  {
+    char magic[4];
+    uint16_t version;
+    uint16_t flags;         ///< HISTORY_SEGMENT_SEALED once compressed.
+    uint32_t last_sequence; ///< Last segment merged into this one; its own sequence if none.
+  };
+
+  struct HistoryBlockHeader
+  {
+    uint32_t encoded_size; ///< Size of the encoded records.
+    uint32_t stored_size;  ///< Size of the payload that follows.
+    uint16_t record_count;
+    uint8_t codec; ///< HistoryCodec.
+    uint8_t reserved;
+  };
+
+  /** @brief The fixed layout the encoding is measured against (see rlc_bench). */
+  struct HistoryFixedRecord
+  {
+    uint64_t time_us;
+    double x, y, z;
+    float heading;
+    float speed;
+    uint8_t kind;
+  };
+#pragma pack(pop)
+
+  // =================================================================================================
+  // 1. Block Encoding
+  // =================================================================================================
+
+  /**
+   * @brief Encodes up to `HISTORY_BLOCK_RECORDS` records.
+   * @return Encoded size; at most `count * HISTORY_MAX_RECORD_BYTES`, 0 if `capacity` is smaller.
+   */
+  size_t EncodeHistoryBlock(const HistoryRecord *records, size_t count, uint8_t *out, size_t capacity);
+
+  /**
+   * @brief Decodes `count` records of an encoded block.
+   * @return false if the block is shorter than its records or has bytes left over.
+   */
+  bool DecodeHistoryBlock(const uint8_t *data, size_t size, size_t count, HistoryRecord *out);
+
+  // =================================================================================================
+  // 2. Writer (game thread)
+  // =================================================================================================
+
+  class HistoryWriter
+  {
+  public:
+    HistoryWriter() = default;
+    ~HistoryWriter() { Close(); }
+    HistoryWriter(const HistoryWriter &) = delete;
+    HistoryWriter &operator=(const HistoryWriter &) = delete;
+
+    /** @brief Starts a new segment after the highest one in `directory`. */
+    bool Open(const char *directory);
+
+    /** @brief Writes the buffered block and closes the active segment. */
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    /**
+     * @brief Buffers a record; writes a block when it is full and rolls the segment over when that is full.
+     * @details A failed write closes the writer (`IsOpen` turns false); the records written so far stay.
+     */
+    void Append(const HistoryRecord &record);
+
+    /** @brief Writes the buffered records as a (short) block, so they survive a crash. */
+    void Flush();
+
+    /**
+     * @brief Sequence of the active segment, or of the last one after `Close` or a failed write.
+     *        Maintenance leaves it and every later one alone. 0 before the first `Open`.
+     */
+    uint32_t GetActiveSequence() const { return m_sequence; }
+
+    /** @brief true once after each rollover, when a closed segment is waiting to be sealed. */
+    bool ConsumeRollover()
+    {
+      const bool rolled = m_rolledOver;
+      m_rolledOver = false;
+      return rolled;
+    }
+
+    uint64_t GetRecordCount() const { return m_recordCount; }
+    uint64_t GetBytesWritten() const { return m_bytesWritten; }
+
+  private:
+    bool OpenSegment(uint32_t sequence);
+    void WriteBlock();
+
+    char m_directory[HISTORY_PATH_SIZE] = "";
+    FILE *m_file = nullptr;
+    uint32_t m_sequence = 0;
+    size_t m_segmentRecords = 0;
+    HistoryRecord m_pending[HISTORY_BLOCK_RECORDS];
+    size_t m_pendingCount = 0;
+    uint8_t m_block[HISTORY_BLOCK_CAPACITY];
+    uint64_t m_recordCount = 0;
+    uint64_t m_bytesWritten = 0;
+    bool m_rolledOver = false;
+  };
+
+  // =================================================================================================
+  // 3. Reader (any thread)
+  // =================================================================================================
+
+  /** @brief Streams the records of one segment, decompressing one block at a time. */
+  class HistoryReader
+  {
+  public:
+    HistoryReader() = default;
+    ~HistoryReader() { Close(); }
+    HistoryReader(const HistoryReader &) = delete;
+    HistoryReader &operator=(const HistoryReader &) = delete;
+
+    bool Open(const char *path);
+    void Close();
+
+    /**
+     * @brief Next record.
+     * @return false at the end of the segment, or at a torn or corrupt block (see `IsDamaged`).
+     */
+    bool Next(HistoryRecord &record);
+
+    bool IsSealed() const { return (m_header.flags & HISTORY_SEGMENT_SEALED) != 0; }
+    uint32_t GetLastSequence() const { return m_header.last_sequence; }
+    bool IsDamaged() const { return m_damaged; }
+    uint64_t GetBlockCount() const { return m_blockCount; }
+
+  private:
+    bool ReadBlock();
+
+    FILE *m_file = nullptr;
+    HistorySegmentHeader m_header{};
+    HistoryRecord m_records[HISTORY_BLOCK_RECORDS];
+    size_t m_count = 0;
+    size_t m_next = 0;
+    uint64_t m_blockCount = 0;
+    bool m_damaged = false;
+    uint8_t m_stored[HISTORY_BLOCK_CAPACITY + HISTORY_BLOCK_CAPACITY / 255 + 16];
+    uint8_t m_encoded[HISTORY_BLOCK_CAPACITY];
+  };
+
+  // =================================================================================================
+  // 4. Segments and Maintenance (background thread)
+  // =================================================================================================
+
+  /** @brief Writes the path of segment `sequence` in `directory` to `out`. */
+  bool FormatHistorySegmentPath(char *out, size_t size, const char *directory, uint32_t sequence);
+
+  /**
+   * @brief Lists the segment sequences in `directory`, ascending.
+   * @return Number written to `out`, at most `capacity`.
+   */
+  size_t ListHistorySegments(const char *directory, uint32_t *out, size_t capacity);
+
+  struct HistoryMaintenanceResult
+  {
+    uint32_t sealed = 0;        ///< Segments compressed.
+    uint32_t merged = 0;        ///< Segments merged into another one (and deleted).
+    uint32_t leftovers = 0;     ///< Segments deleted because a merge already covered them.
+    uint64_t bytes_before = 0;  ///< Size of the segments touched, before.
+    uint64_t bytes_after = 0;   ///< ... and after.
+    uint32_t failures = 0;
+  };
+
+  /**
+   * @brief Seals every closed segment in `directory` and merges runs of small sealed ones.
+   * @param active_sequence Segment being written, or 0 once the writer is closed for good. It and
+   *        every later segment (the writer may roll over while this runs) are left alone.
+   */
+  HistoryMaintenanceResult MaintainHistory(const char *directory, uint32_t active_sequence);
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,189 @@
+/**
+ * @file LogMatcher.cpp
+ * @brief Implementation of the Aho–Corasick log matcher.
+ */
+
+#include "LogMatcher.hpp"
+
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        unsigned char FoldCase(unsigned char byte) { return (byte >= 'A' && byte <= 'Z') ? (unsigned char)(byte - 'A' + 'a') : byte; }
+
+        struct ScreenshotPhrase
+        {
+            const char *text;
+            uint8_t flags;
+        };
+
+        // Phrases the game (and its console) use for screenshot results, across the versions seen
+        // in the wild. A line may carry both flags, e.g. "saving screenshot ... failed"; the caller
+        // treats FAILED as winning.
+        constexpr ScreenshotPhrase SCREENSHOT_PHRASES[] = {
+            {"screenshot saved", SCREENSHOT_LOG_SAVED},
+            {"saved screenshot", SCREENSHOT_LOG_SAVED},
+            {"saving screenshot", SCREENSHOT_LOG_SAVED},
+            {"screenshot written", SCREENSHOT_LOG_SAVED},
+            {"screenshot taken", SCREENSHOT_LOG_SAVED},
+            {"screenshot failed", SCREENSHOT_LOG_FAILED},
+            {"failed to save screenshot", SCREENSHOT_LOG_FAILED},
+            {"failed to write screenshot", SCREENSHOT_LOG_FAILED},
+            {"unable to save screenshot", SCREENSHOT_LOG_FAILED},
+            {"cannot save screenshot", SCREENSHOT_LOG_FAILED},
+            {"screenshot error", SCREENSHOT_LOG_FAILED},
+        };
+    } // namespace
+
+    MultiPatternMatcher::MultiPatternMatcher()
+    {
+        std::memset(m_classOf, 0, sizeof(m_classOf));
+        std::memset(m_next, 0, sizeof(m_next));
+        std::memset(m_output, 0, sizeof(m_output));
+    }
+
+    bool MultiPatternMatcher::AddPattern(const char *pattern, uint8_t flags)
+    {
+        if (m_built || !pattern || !*pattern || flags == 0)
+        {
+            return false;
+        }
+
+        // Check capacity first so a rejected pattern leaves the automaton untouched.
+        size_t new_classes = 0;
+        size_t new_states = 0;
+        {
+            bool seen[256] = {};
+            size_t state = 0;
+            bool on_trie = true;
+            for (const unsigned char *p = (const unsigned char *)pattern; *p; ++p)
+            {
+                const unsigned char byte = FoldCase(*p);
+                if (m_classOf[byte] == 0 && !seen[byte])
+                {
+                    seen[byte] = true;
+                    new_classes++;
+                }
+                if (on_trie && m_classOf[byte] != 0 && m_next[state][m_classOf[byte]] != 0)
+                {
+                    state = m_next[state][m_classOf[byte]];
+                }
+                else
+                {
+                    on_trie = false;
+                    new_states++;
+                }
+            }
+        }
+        if (m_classCount + new_classes > MAX_CLASSES || m_stateCount + new_states > MAX_STATES)
+        {
+            return false;
+        }
+
+        size_t state = 0;
+        for (const unsigned char *p = (const unsigned char *)pattern; *p; ++p)
+        {
+            const unsigned char byte = FoldCase(*p);
+            if (m_classOf[byte] == 0)
+            {
+                const uint8_t cls = (uint8_t)m_classCount++;
+                m_classOf[byte] = cls;
+                if (byte >= 'a' && byte <= 'z')
+                {
+                    m_classOf[byte - 'a' + 'A'] = cls;
+                }
+            }
+            uint8_t &edge = m_next[state][m_classOf[byte]];
+            if (edge == 0)
+            {
+                edge = (uint8_t)m_stateCount++;
+            }
+            state = edge;
+        }
+        m_output[state] |= flags;
+        return true;
+    }
+
+    void MultiPatternMatcher::Build()
+    {
+        if (m_built)
+        {
+            return;
+        }
+
+        // Breadth-first over the trie. A missing edge is replaced by the edge of the failure state,
+        // which is shallower and therefore already complete, turning the trie into a DFA.
+        uint8_t fail[MAX_STATES] = {};
+        uint8_t queue[MAX_STATES];
+        size_t head = 0, tail = 0;
+
+        for (size_t c = 0; c < m_classCount; ++c)
+        {
+            const uint8_t child = m_next[0][c];
+            if (child != 0)
+            {
+                fail[child] = 0;
+                queue[tail++] = child;
+            }
+        }
+
+        while (head < tail)
+        {
+            const uint8_t state = queue[head++];
+            m_output[state] |= m_output[fail[state]];
+            for (size_t c = 0; c < m_classCount; ++c)
+            {
+                const uint8_t child = m_next[state][c];
+                if (child != 0)
+                {
+                    fail[child] = m_next[fail[state]][c];
+                    queue[tail++] = child;
+                }
+                else
+                {
+                    m_next[state][c] = m_next[fail[state]][c];
+                }
+            }
+        }
+        m_built = true;
+    }
+
+    uint8_t MultiPatternMatcher::Feed(const char *text, size_t length, uint8_t &state) const
+    {
+        uint8_t flags = 0;
+        uint8_t s = state;
+        const unsigned char *bytes = (const unsigned char *)text;
+        for (size_t i = 0; i < length; ++i)
+        {
+            s = m_next[s][ClassOf(bytes[i])];
+            flags |= m_output[s];
+        }
+        state = s;
+        return flags;
+    }
+
+    uint8_t MultiPatternMatcher::Scan(const char *text) const
+    {
+        uint8_t flags = 0;
+        uint8_t s = 0;
+        for (const unsigned char *p = (const unsigned char *)text; *p; ++p)
+        {
+            s = m_next[s][ClassOf(*p)];
+            flags |= m_output[s];
+        }
+        return flags;
+    }
+
+    ScreenshotLogMatcher::ScreenshotLogMatcher()
+    {
+        for (const ScreenshotPhrase &phrase : SCREENSHOT_PHRASES)
+        {
+            m_matcher.AddPattern(phrase.text, phrase.flags);
+        }
+        m_matcher.Build();
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,78 @@
+/**
+ * @file LogMatcher.hpp
+ * @brief Allocation-free multi-pattern matcher for the game log stream.
+ * @details `MultiPatternMatcher` is an Aho–Corasick automaton compiled into a dense DFA over a
+ * compressed, case-folded alphabet: every byte of the input costs one class lookup and one
+ * transition lookup, independent of the number of patterns, with no branches on the pattern set.
+ * All tables are fixed-size members, so building and matching never allocate. Each pattern carries
+ * a flag bit; a scan returns the OR of the flags of every pattern found in the text.
+ *
+ * The scan state only depends on the previous state and the current byte, so text can be fed in
+ * pieces (`Feed`) as well as whole lines (`Scan`).
+ *
+ * `ScreenshotLogMatcher` preloads the phrases the game writes when a screenshot is saved or fails.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  class MultiPatternMatcher
+  {
+  public:
+    static constexpr size_t MAX_STATES = 256;  ///< Trie nodes, including the root.
+    static constexpr size_t MAX_CLASSES = 48;  ///< Distinct (case-folded) pattern bytes + 1.
+
+    MultiPatternMatcher();
+
+    /**
+     * @brief Adds a pattern, matched case-insensitively (ASCII).
+     * @param flags Bits reported when the pattern is found. Must be non-zero.
+     * @return false if the automaton is full or already built.
+     */
+    bool AddPattern(const char *pattern, uint8_t flags);
+
+    /** @brief Computes failure links and folds them into the transition table. Call once. */
+    void Build();
+
+    /** @brief Advances `state` over `length` bytes and returns the flags of every match ending in them. */
+    uint8_t Feed(const char *text, size_t length, uint8_t &state) const;
+
+    /** @brief Scans a NUL-terminated string from the start state. */
+    uint8_t Scan(const char *text) const;
+
+  private:
+    uint8_t ClassOf(unsigned char byte) const { return m_classOf[byte]; }
+
+    uint8_t m_classOf[256];                       ///< Byte -> alphabet class; 0 for bytes in no pattern.
+    uint8_t m_next[MAX_STATES][MAX_CLASSES];      ///< Trie edges, then the full DFA after `Build`.
+    uint8_t m_output[MAX_STATES];                 ///< Flags of the patterns ending in each state.
+    size_t m_stateCount = 1;
+    size_t m_classCount = 1;
+    bool m_built = false;
+  };
+
+  /** @brief What a game log line says about a screenshot. */
+  enum ScreenshotLogFlags : uint8_t
+  {
+    SCREENSHOT_LOG_SAVED = 1 << 0,
+    SCREENSHOT_LOG_FAILED = 1 << 1,
+  };
+
+  /** @brief `MultiPatternMatcher` preloaded with the game's screenshot saved/failed phrases. */
+  class ScreenshotLogMatcher
+  {
+  public:
+    ScreenshotLogMatcher();
+
+    /** @brief Returns `ScreenshotLogFlags` for a log line; 0 for the vast majority of lines. */
+    uint8_t Classify(const char *line) const { return m_matcher.Scan(line); }
+
+  private:
+    MultiPatternMatcher m_matcher;
+  };
+
+} // namespace SPF_RedLightCamera
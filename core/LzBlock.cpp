@@ -0,0 +1,187 @@
+/**
+ * @file LzBlock.cpp
+ * @brief Implementation of the LZ77 block compressor.
+ */
+
+#include "LzBlock.hpp"
+
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr size_t MIN_MATCH = 4;
+        constexpr size_t MAX_OFFSET = 65535;
+        constexpr int HASH_BITS = 12;
+
+        uint32_t Load32(const uint8_t *p)
+        {
+            uint32_t value;
+            std::memcpy(&value, p, sizeof(value));
+            return value;
+        }
+
+        uint32_t Hash(uint32_t sequence) { return (sequence * 2654435761u) >> (32 - HASH_BITS); }
+
+        // Writes the extra length bytes for a nibble that overflowed.
+        bool PutLength(uint8_t *&out, const uint8_t *end, size_t length)
+        {
+            for (; length >= 255; length -= 255)
+            {
+                if (out == end)
+                {
+                    return false;
+                }
+                *out++ = 255;
+            }
+            if (out == end)
+            {
+                return false;
+            }
+            *out++ = (uint8_t)length;
+            return true;
+        }
+
+        bool GetLength(const uint8_t *&in, const uint8_t *end, size_t &length)
+        {
+            uint8_t byte;
+            do
+            {
+                if (in == end)
+                {
+                    return false;
+                }
+                byte = *in++;
+                length += byte;
+            } while (byte == 255);
+            return true;
+        }
+
+        bool PutSequence(uint8_t *&out, const uint8_t *end, const uint8_t *literals, size_t literal_count, size_t offset, size_t match_length)
+        {
+            if (out == end)
+            {
+                return false;
+            }
+            const size_t match_code = match_length ? match_length - MIN_MATCH : 0;
+            uint8_t &token = *out++;
+            token = (uint8_t)(((literal_count < 15 ? literal_count : 15) << 4) | (match_code < 15 ? match_code : 15));
+            if (literal_count >= 15 && !PutLength(out, end, literal_count - 15))
+            {
+                return false;
+            }
+            if ((size_t)(end - out) < literal_count)
+            {
+                return false;
+            }
+            std::memcpy(out, literals, literal_count);
+            out += literal_count;
+            if (match_length == 0)
+            {
+                return true; // Last sequence.
+            }
+            if (end - out < 2)
+            {
+                return false;
+            }
+            *out++ = (uint8_t)(offset & 0xFF);
+            *out++ = (uint8_t)(offset >> 8);
+            return match_code < 15 || PutLength(out, end, match_code - 15);
+        }
+    } // namespace
+
+    size_t LzCompressBlock(const uint8_t *data, size_t size, uint8_t *out, size_t capacity)
+    {
+        uint32_t table[1u << HASH_BITS] = {}; // Position + 1; 0 is empty.
+        uint8_t *cursor = out;
+        const uint8_t *const end = out + capacity;
+
+        size_t anchor = 0, i = 0;
+        while (i + MIN_MATCH <= size)
+        {
+            const uint32_t sequence = Load32(data + i);
+            uint32_t &slot = table[Hash(sequence)];
+            const size_t candidate = slot;
+            slot = (uint32_t)(i + 1);
+            if (candidate == 0 || i - (candidate - 1) > MAX_OFFSET || Load32(data + candidate - 1) != sequence)
+            {
+                ++i;
+                continue;
+            }
+
+            const size_t match = candidate - 1;
+            size_t length = MIN_MATCH;
+            while (i + length < size && data[match + length] == data[i + length])
+            {
+                ++length;
+            }
+            if (!PutSequence(cursor, end, data + anchor, i - anchor, i - match, length))
+            {
+                return 0;
+            }
+            i += length;
+            anchor = i;
+        }
+
+        if (!PutSequence(cursor, end, data + anchor, size - anchor, 0, 0))
+        {
+            return 0;
+        }
+        return (size_t)(cursor - out);
+    }
+
+    size_t LzDecompressBlock(const uint8_t *data, size_t size, uint8_t *out, size_t capacity)
+    {
+        const uint8_t *in = data;
+        const uint8_t *const in_end = data + size;
+        size_t written = 0;
+        while (in < in_end)
+        {
+            const uint8_t token = *in++;
+            size_t literal_count = token >> 4;
+            if (literal_count == 15 && !GetLength(in, in_end, literal_count))
+            {
+                return SIZE_MAX;
+            }
+            if ((size_t)(in_end - in) < literal_count || capacity - written < literal_count)
+            {
+                return SIZE_MAX;
+            }
+            std::memcpy(out + written, in, literal_count);
+            in += literal_count;
+            written += literal_count;
+            if (in == in_end)
+            {
+                break; // The last sequence has no match.
+            }
+
+            if (in_end - in < 2)
+            {
+                return SIZE_MAX;
+            }
+            const size_t offset = (size_t)in[0] | ((size_t)in[1] << 8);
+            in += 2;
+            size_t length = token & 15;
+            if (length == 15 && !GetLength(in, in_end, length))
+            {
+                return SIZE_MAX;
+            }
+            length += MIN_MATCH;
+            if (offset == 0 || offset > written || capacity - written < length)
+            {
+                return SIZE_MAX;
+            }
+            // Byte by byte: the match may overlap what it writes (runs).
+            const uint8_t *from = out + written - offset;
+            for (size_t k = 0; k < length; ++k)
+            {
+                out[written + k] = from[k];
+            }
+            written += length;
+        }
+        return written;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,38 @@
+/**
+ * @file LzBlock.hpp
+ * @brief Small LZ77 block compressor for the plugin's own files.
+ * @details The format follows LZ4's block layout: a sequence is a token byte (literal count in the
+ * high nibble, match length - 4 in the low nibble, 15 meaning "more length bytes follow"), the
+ * literals, a 16-bit little-endian offset and the extra match length bytes (255 each, then the
+ * rest). The last sequence has literals only. Matches are found through a 4096-entry hash of the
+ * next four bytes, greedily; that is enough for the short, repetitive blocks it is used for (e.g.
+ * the capture history) and keeps compression at a few hundred MB/s.
+ *
+ * Both directions work on whole blocks in caller-provided buffers and never allocate.
+ * Decompression checks every read and write against the buffer sizes, so a corrupt block fails
+ * instead of overrunning.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Largest output of `LzCompressBlock` for `size` input bytes. */
+  constexpr size_t LzCompressBound(size_t size) { return size + size / 255 + 16; }
+
+  /**
+   * @brief Compresses `size` bytes into `out`.
+   * @return Compressed size, or 0 if it would exceed `capacity` (store the block raw instead).
+   */
+  size_t LzCompressBlock(const uint8_t *data, size_t size, uint8_t *out, size_t capacity);
+
+  /**
+   * @brief Decompresses a block produced by `LzCompressBlock`.
+   * @return Decompressed size, or `SIZE_MAX` if the block is corrupt or does not fit `capacity`.
+   */
+  size_t LzDecompressBlock(const uint8_t *data, size_t size, uint8_t *out, size_t capacity);
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,99 @@
+/**
+ * @file MappedFile.cpp
+ * @brief Implementation of the read-only file mapping.
+ */
+
+#include "MappedFile.hpp"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    bool MappedFile::Open(const char *path)
+    {
+        Close();
+        if (!path)
+        {
+            return false;
+        }
+
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            return false;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart <= 0 || (unsigned long long)size.QuadPart > (size_t)-1)
+        {
+            CloseHandle(file);
+            return false;
+        }
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file); // The mapping keeps the file open.
+        if (!mapping)
+        {
+            return false;
+        }
+        const void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!view)
+        {
+            CloseHandle(mapping);
+            return false;
+        }
+        m_mapping = mapping;
+        m_data = view;
+        m_size = (size_t)size.QuadPart;
+        return true;
+#else
+        const int fd = open(path, O_RDONLY);
+        if (fd < 0)
+        {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size <= 0)
+        {
+            close(fd);
+            return false;
+        }
+        void *view = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd); // The mapping keeps the file alive.
+        if (view == MAP_FAILED)
+        {
+            return false;
+        }
+        m_data = view;
+        m_size = (size_t)info.st_size;
+        return true;
+#endif
+    }
+
+    void MappedFile::Close()
+    {
+        if (!m_data)
+        {
+            return;
+        }
+#ifdef _WIN32
+        UnmapViewOfFile(m_data);
+        CloseHandle(static_cast<HANDLE>(m_mapping));
+        m_mapping = nullptr;
+#else
+        munmap(const_cast<void *>(m_data), m_size);
+#endif
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,37 @@
+/**
+ * @file MappedFile.hpp
+ * @brief Read-only memory mapping of a whole file.
+ * @details Used to read files written by the plugin (e.g. the violation heatmap) in one go at
+ * activation, without copying them through stdio buffers. The view is only valid while the
+ * `MappedFile` is open; callers copy what they keep.
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace SPF_RedLightCamera
+{
+
+  class MappedFile
+  {
+  public:
+    MappedFile() = default;
+    ~MappedFile() { Close(); }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    /** @brief Maps `path` read-only. Fails for missing or empty files. */
+    bool Open(const char *path);
+    void Close();
+    bool IsOpen() const { return m_data != nullptr; }
+
+    const void *GetData() const { return m_data; }
+    size_t GetSize() const { return m_size; }
+
+  private:
+    const void *m_data = nullptr;
+    size_t m_size = 0;
+    void *m_mapping = nullptr; ///< Windows mapping handle; unused elsewhere.
+  };
+
+} // namespace SPF_RedLightCamera
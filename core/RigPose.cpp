@@ -0,0 +1,97 @@
+/**
+ * @file RigPose.cpp
+ * @brief Implementation of the rig pose maths.
+ */
+
+#define _USE_MATH_DEFINES
+#include "RigPose.hpp"
+
+#include <cmath>
+
+namespace SPF_RedLightCamera
+{
+
+    RigPose ComputeRigPose(const SPF_DVector &truck, double heading, double distance, double height, float fov)
+    {
+        // Convert the truck's heading from the SCS telemetry system to a standard mathematical angle.
+        // SCS telemetry `heading` is a normalized value (0.0 to 1.0) representing a full circle (360 degrees).
+        // In SCS, 0.0 `heading` points North (along the +Z axis in SCS world coordinates), and the angle increases clockwise.
+        // Standard mathematical functions (cos/sin) expect angles in radians, starting from the +X axis, increasing counter-clockwise.
+        // The formula `(1.5 * M_PI) - (2.0 * M_PI * heading)` performs this conversion.
+        const double phi = (1.5 * M_PI) - (2.0 * M_PI * heading);
+
+        RigPose pose;
+        pose.camera = {truck.x + std::cos(phi) * distance, truck.y + height, truck.z + std::sin(phi) * distance};
+        pose.look_target = truck;
+        pose.fov = fov;
+        if (distance != 0.0 || height != 0.0)
+        {
+            AimRig(pose);
+        }
+        return pose;
+    }
+
+    void AimRig(RigPose &pose)
+    {
+        // The look-at vector points from the camera to the look-at point.
+        const double look_x = pose.look_target.x - pose.camera.x;
+        const double look_y = pose.look_target.y - pose.camera.y;
+        const double look_z = pose.look_target.z - pose.camera.z;
+        const double horizontal_dist = std::sqrt(look_x * look_x + look_z * look_z);
+
+        // atan2 for correct quadrant handling; the free camera looks down -Z at zero yaw.
+        pose.yaw = (float)std::atan2(-look_x, -look_z);
+        pose.pitch = (float)std::atan2(look_y, horizontal_dist);
+        pose.oriented = true;
+    }
+
+    void FrameRigTargets(RigPose &pose, const SPF_DVector *others, size_t count, double aspect, const FramingLimits &limits)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        // Aim at the centroid, with the truck weighted double so it stays the subject of the shot.
+        const SPF_DVector truck = pose.look_target;
+        SPF_DVector centroid = {truck.x * 2.0, truck.y * 2.0, truck.z * 2.0};
+        for (size_t i = 0; i < count; ++i)
+        {
+            centroid.x += others[i].x;
+            centroid.y += others[i].y;
+            centroid.z += others[i].z;
+        }
+        const double weight = 2.0 + (double)count;
+        pose.look_target = {centroid.x / weight, centroid.y / weight, centroid.z / weight};
+
+        // Widest horizontal angle between the new view axis and the truck or any framed vehicle.
+        const SPF_DVector &camera = pose.camera;
+        const double axis_yaw = std::atan2(pose.look_target.z - camera.z, pose.look_target.x - camera.x);
+        auto angle_to = [&](double x, double z) {
+            double delta = std::atan2(z - camera.z, x - camera.x) - axis_yaw;
+            while (delta > M_PI)
+                delta -= 2.0 * M_PI;
+            while (delta < -M_PI)
+                delta += 2.0 * M_PI;
+            return std::fabs(delta);
+        };
+        double max_angle = angle_to(truck.x, truck.z);
+        for (size_t i = 0; i < count; ++i)
+        {
+            const double angle = angle_to(others[i].x, others[i].z);
+            max_angle = angle > max_angle ? angle : max_angle;
+        }
+
+        // The free camera FOV is vertical; convert the horizontal half-angle using the viewport aspect.
+        const double safe_aspect = aspect > 0.0 ? aspect : 16.0 / 9.0;
+        const double half_h = std::fmin(max_angle * limits.margin, 85.0 * M_PI / 180.0);
+        const double required_fov = 2.0 * std::atan(std::tan(half_h) / safe_aspect) * 180.0 / M_PI;
+        if (required_fov > pose.fov)
+        {
+            pose.fov = (float)std::fmin(required_fov, limits.max_fov);
+        }
+
+        AimRig(pose);
+    }
+
+} // namespace SPF_RedLightCamera
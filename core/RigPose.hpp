@@ -0,0 +1,54 @@
+/**
+ * @file RigPose.hpp
+ * @brief Pose maths for the red light camera rig, independent of the framework APIs.
+ * @details The rig sits `distance` metres along the truck's heading and `height` metres above it,
+ * looking back at the truck. `FrameRigTargets` shifts the look-at point towards other vehicles
+ * and widens the FOV so they stay in shot. All positions are world coordinates; converting to
+ * the game's local grid is the adapter's job.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+
+#include <cstddef>
+
+namespace SPF_RedLightCamera
+{
+
+  struct RigPose
+  {
+    SPF_DVector camera;      ///< Camera world position.
+    SPF_DVector look_target; ///< World point the camera looks at.
+    float yaw = 0.0f;        ///< Free camera yaw (radians).
+    float pitch = 0.0f;      ///< Free camera pitch (radians).
+    float fov = 0.0f;        ///< Vertical FOV (degrees).
+    float roll = 0.0f;       ///< Free camera roll (radians).
+    bool oriented = false;   ///< false when the rig sits on the truck and has no look direction.
+  };
+
+  /**
+   * @brief Places the rig relative to the truck and aims it at the truck.
+   * @param heading Truck heading (telemetry convention, 0..1, clockwise from north).
+   */
+  RigPose ComputeRigPose(const SPF_DVector &truck, double heading, double distance, double height, float fov);
+
+  /** @brief Recomputes yaw and pitch after `look_target` was moved. */
+  void AimRig(RigPose &pose);
+
+  /** @brief Limits used by `FrameRigTargets`. */
+  struct FramingLimits
+  {
+    double margin = 1.15;  ///< Extra room around framed vehicles, as a multiple of their angular extent.
+    double max_fov = 110.0; ///< Upper limit for the widened FOV (degrees).
+  };
+
+  /**
+   * @brief Shifts the look-at point to the weighted centroid of the truck and `others`, and widens
+   *        the FOV so all of them fit horizontally.
+   * @details The truck (the incoming `look_target`) is weighted double so it stays the subject.
+   *          The FOV only ever grows. `AimRig` is called on the result.
+   * @param aspect Viewport width / height.
+   */
+  void FrameRigTargets(RigPose &pose, const SPF_DVector *others, size_t count, double aspect, const FramingLimits &limits);
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,209 @@
+/**
+ * @file RigPoseBatch.cpp
+ * @brief Implementation of the batch pose kernel.
+ */
+
+#include "RigPoseBatch.hpp"
+
+#include <cmath>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RLC_POSE_BATCH_SSE2 1
+#else
+#define RLC_POSE_BATCH_SSE2 0
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr float PI = 3.14159265358979323846f;
+        constexpr float HALF_PI = 1.57079632679489661923f;
+        constexpr float QUARTER_PI = 0.78539816339744830962f;
+        constexpr float TWO_PI = 6.28318530717958647692f;
+        constexpr float TAN_PI_8 = 0.41421356237309504880f;
+
+        // Taylor coefficients of sin (to x^9) and cos (to x^10) on |x| <= π/4.
+        constexpr float S3 = -1.0f / 6.0f;
+        constexpr float S5 = 1.0f / 120.0f;
+        constexpr float S7 = -1.0f / 5040.0f;
+        constexpr float S9 = 1.0f / 362880.0f;
+        constexpr float C2 = -0.5f;
+        constexpr float C4 = 1.0f / 24.0f;
+        constexpr float C6 = -1.0f / 720.0f;
+        constexpr float C8 = 1.0f / 40320.0f;
+        constexpr float C10 = -1.0f / 3628800.0f;
+
+        // Cephes atanf polynomial on |a| <= tan(π/8): atan(a) = a + a z (A3 + z (A5 + z (A7 + z A9))).
+        constexpr float A3 = -3.33329491539e-1f;
+        constexpr float A5 = 1.99777106478e-1f;
+        constexpr float A7 = -1.38776856032e-1f;
+        constexpr float A9 = 8.05374449538e-2f;
+
+        void ComputeOne(const RigPoseBatch &batch, size_t i)
+        {
+            float s, c;
+            FastSinCosTurns(0.75f - batch.heading[i], s, c);
+            const float offset_x = c * batch.distance[i];
+            const float offset_z = s * batch.distance[i];
+            batch.offset_x[i] = offset_x;
+            batch.offset_z[i] = offset_z;
+            // The scalar version aims along target - camera = -offset.
+            batch.yaw[i] = FastAtan2(offset_x, offset_z);
+            batch.pitch[i] = FastAtan2(-batch.height[i], std::sqrt(offset_x * offset_x + offset_z * offset_z));
+        }
+
+#if RLC_POSE_BATCH_SSE2
+        inline __m128 Select(__m128 mask, __m128 if_set, __m128 if_clear)
+        {
+            return _mm_or_ps(_mm_and_ps(mask, if_set), _mm_andnot_ps(mask, if_clear));
+        }
+
+        inline __m128 Atan2x4(__m128 y, __m128 x)
+        {
+            const __m128 sign = _mm_set1_ps(-0.0f);
+            const __m128 ax = _mm_andnot_ps(sign, x);
+            const __m128 ay = _mm_andnot_ps(sign, y);
+            const __m128 hi = _mm_max_ps(ax, ay);
+            const __m128 lo = _mm_min_ps(ax, ay);
+            // 0/0 for the (0, 0) lanes is masked to 0.
+            __m128 a = _mm_and_ps(_mm_cmpgt_ps(hi, _mm_setzero_ps()), _mm_div_ps(lo, hi));
+
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 folded = _mm_cmpgt_ps(a, _mm_set1_ps(TAN_PI_8));
+            a = Select(folded, _mm_div_ps(_mm_sub_ps(a, one), _mm_add_ps(a, one)), a);
+            const __m128 base = _mm_and_ps(folded, _mm_set1_ps(QUARTER_PI));
+
+            const __m128 z = _mm_mul_ps(a, a);
+            __m128 poly = _mm_add_ps(_mm_set1_ps(A7), _mm_mul_ps(z, _mm_set1_ps(A9)));
+            poly = _mm_add_ps(_mm_set1_ps(A5), _mm_mul_ps(z, poly));
+            poly = _mm_add_ps(_mm_set1_ps(A3), _mm_mul_ps(z, poly));
+            __m128 r = _mm_add_ps(base, _mm_add_ps(a, _mm_mul_ps(_mm_mul_ps(a, z), poly)));
+
+            r = Select(_mm_cmpgt_ps(ay, ax), _mm_sub_ps(_mm_set1_ps(HALF_PI), r), r);
+            r = Select(_mm_cmplt_ps(x, _mm_setzero_ps()), _mm_sub_ps(_mm_set1_ps(PI), r), r);
+            return _mm_xor_ps(r, _mm_and_ps(sign, y));
+        }
+
+        void ComputeFour(const RigPoseBatch &batch, size_t i)
+        {
+            // --- sincos in turns ---
+            const __m128 turns = _mm_sub_ps(_mm_set1_ps(0.75f), _mm_loadu_ps(batch.heading + i));
+            const __m128i quarter_index = _mm_cvtps_epi32(_mm_mul_ps(turns, _mm_set1_ps(4.0f))); // Round to nearest, as nearbyint.
+            const __m128 quarters = _mm_cvtepi32_ps(quarter_index);
+            const __m128 x = _mm_mul_ps(_mm_sub_ps(turns, _mm_mul_ps(quarters, _mm_set1_ps(0.25f))), _mm_set1_ps(TWO_PI));
+            const __m128 x2 = _mm_mul_ps(x, x);
+
+            __m128 sin_poly = _mm_add_ps(_mm_set1_ps(S7), _mm_mul_ps(x2, _mm_set1_ps(S9)));
+            sin_poly = _mm_add_ps(_mm_set1_ps(S5), _mm_mul_ps(x2, sin_poly));
+            sin_poly = _mm_add_ps(_mm_set1_ps(S3), _mm_mul_ps(x2, sin_poly));
+            const __m128 sin_x = _mm_add_ps(x, _mm_mul_ps(_mm_mul_ps(x, x2), sin_poly));
+
+            __m128 cos_poly = _mm_add_ps(_mm_set1_ps(C8), _mm_mul_ps(x2, _mm_set1_ps(C10)));
+            cos_poly = _mm_add_ps(_mm_set1_ps(C6), _mm_mul_ps(x2, cos_poly));
+            cos_poly = _mm_add_ps(_mm_set1_ps(C4), _mm_mul_ps(x2, cos_poly));
+            cos_poly = _mm_add_ps(_mm_set1_ps(C2), _mm_mul_ps(x2, cos_poly));
+            const __m128 cos_x = _mm_add_ps(_mm_set1_ps(1.0f), _mm_mul_ps(x2, cos_poly));
+
+            // Quadrant: odd quarters swap sin and cos; bit 1 of q (sin) and of q + 1 (cos) flips the sign.
+            const __m128i one = _mm_set1_epi32(1);
+            const __m128i two = _mm_set1_epi32(2);
+            const __m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quarter_index, one), one));
+            const __m128 sin_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quarter_index, two), 30));
+            const __m128 cos_sign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quarter_index, one), two), 30));
+            const __m128 s = _mm_xor_ps(Select(swap, cos_x, sin_x), sin_sign);
+            const __m128 c = _mm_xor_ps(Select(swap, sin_x, cos_x), cos_sign);
+
+            // --- offsets and aim ---
+            const __m128 distance = _mm_loadu_ps(batch.distance + i);
+            const __m128 offset_x = _mm_mul_ps(c, distance);
+            const __m128 offset_z = _mm_mul_ps(s, distance);
+            _mm_storeu_ps(batch.offset_x + i, offset_x);
+            _mm_storeu_ps(batch.offset_z + i, offset_z);
+
+            const __m128 horizontal = _mm_sqrt_ps(_mm_add_ps(_mm_mul_ps(offset_x, offset_x), _mm_mul_ps(offset_z, offset_z)));
+            const __m128 neg_height = _mm_xor_ps(_mm_loadu_ps(batch.height + i), _mm_set1_ps(-0.0f));
+            _mm_storeu_ps(batch.yaw + i, Atan2x4(offset_x, offset_z));
+            _mm_storeu_ps(batch.pitch + i, Atan2x4(neg_height, horizontal));
+        }
+#endif
+    } // namespace
+
+    void FastSinCosTurns(float turns, float &sin_out, float &cos_out)
+    {
+        const float quarters = std::nearbyint(turns * 4.0f);
+        // Exact: `quarters * 0.25` is representable and within a factor of two of `turns`.
+        const float x = (turns - quarters * 0.25f) * TWO_PI;
+        const float x2 = x * x;
+        const float sin_x = x + x * x2 * (S3 + x2 * (S5 + x2 * (S7 + x2 * S9)));
+        const float cos_x = 1.0f + x2 * (C2 + x2 * (C4 + x2 * (C6 + x2 * (C8 + x2 * C10))));
+        switch ((int32_t)quarters & 3)
+        {
+        case 0:
+            sin_out = sin_x;
+            cos_out = cos_x;
+            break;
+        case 1:
+            sin_out = cos_x;
+            cos_out = -sin_x;
+            break;
+        case 2:
+            sin_out = -sin_x;
+            cos_out = -cos_x;
+            break;
+        default:
+            sin_out = -cos_x;
+            cos_out = sin_x;
+            break;
+        }
+    }
+
+    float FastAtan2(float y, float x)
+    {
+        const float ax = std::fabs(x);
+        const float ay = std::fabs(y);
+        const float hi = ax > ay ? ax : ay;
+        const float lo = ax > ay ? ay : ax;
+        float a = hi > 0.0f ? lo / hi : 0.0f;
+
+        float base = 0.0f;
+        if (a > TAN_PI_8)
+        {
+            a = (a - 1.0f) / (a + 1.0f);
+            base = QUARTER_PI;
+        }
+        const float z = a * a;
+        float r = base + (a + a * z * (A3 + z * (A5 + z * (A7 + z * A9))));
+
+        if (ay > ax)
+        {
+            r = HALF_PI - r;
+        }
+        if (x < 0.0f)
+        {
+            r = PI - r;
+        }
+        return std::signbit(y) ? -r : r;
+    }
+
+    bool RigPoseBatchUsesSimd() { return RLC_POSE_BATCH_SSE2 != 0; }
+
+    void ComputeRigPoseBatch(const RigPoseBatch &batch)
+    {
+        size_t i = 0;
+#if RLC_POSE_BATCH_SSE2
+        for (; i + 4 <= batch.count; i += 4)
+        {
+            ComputeFour(batch, i);
+        }
+#endif
+        for (; i < batch.count; ++i)
+        {
+            ComputeOne(batch, i);
+        }
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,70 @@
+/**
+ * @file RigPoseBatch.hpp
+ * @brief Batch version of `ComputeRigPose` for many rig/subject pairs at once.
+ * @details Inputs and outputs are structure-of-arrays, one entry per pair, and the kernel runs four
+ * pairs per step with SSE2 (the x64 baseline; other targets use the same maths one lane at a time).
+ * It works in single precision relative to the subject: the outputs are the camera offset from the
+ * subject and the aim angles, and the caller adds the offset to the subject's double-precision world
+ * position. The vertical offset is the rig height and is not repeated in the output.
+ *
+ * `cos`/`sin` and `atan2` are replaced with polynomials:
+ *
+ * - sincos works in turns, as the heading does: `phi = 2π (0.75 - heading)` is reduced exactly to
+ *   a quarter turn `q` and a remainder `|x| <= π/4`, where Taylor polynomials to x^9 (sin) and x^10
+ *   (cos) have truncation errors below 2e-9 and 1.2e-10. The subtraction `0.75 - heading` rounds by
+ *   at most half an ulp of 0.75 (1.9e-7 rad), the scaling to radians by one ulp, and Horner
+ *   evaluation by about one ulp of the result: `RIG_BATCH_SINCOS_ERROR` bounds the sum.
+ * - atan2 folds its argument onto `|a| <= tan(π/8)` and uses the Cephes `atanf` polynomial (relative
+ *   error 1.9e-7 there); the fold and the octant corrections add at most three half-ulps of π.
+ *
+ * Offsets inherit the sincos bound times the distance (`RIG_BATCH_OFFSET_ERROR` is relative to
+ * |distance|); yaw and pitch inherit the offset error as an angle plus the atan2 error
+ * (`RIG_BATCH_ANGLE_ERROR`). rlc_bench checks all three against the scalar double-precision
+ * `ComputeRigPose` over millions of random poses.
+ */
+#pragma once
+
+#include <cstddef>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Absolute error of the polynomial sin and cos, for any heading in [-8, 8] turns. */
+  constexpr float RIG_BATCH_SINCOS_ERROR = 5.0e-7f;
+  /** @brief Absolute error of the polynomial atan2, in radians. */
+  constexpr float RIG_BATCH_ATAN2_ERROR = 4.0e-7f;
+  /** @brief Error of `offset_x`/`offset_z` as a fraction of |distance| (plus one float ulp of it). */
+  constexpr float RIG_BATCH_OFFSET_ERROR = 6.0e-7f;
+  /** @brief Error of `yaw` and `pitch` in radians (yaw compared modulo 2π). */
+  constexpr float RIG_BATCH_ANGLE_ERROR = 2.0e-6f;
+
+  /**
+   * @brief Caller-owned arrays for `ComputeRigPoseBatch`, all `count` long.
+   * @details Outputs must not alias inputs. Pairs with zero distance and height have no look direction
+   *          (`RigPose::oriented` is false in the scalar version); their yaw and pitch are 0.
+   */
+  struct RigPoseBatch
+  {
+    size_t count = 0;
+    const float *heading = nullptr;  ///< Subject heading (telemetry convention, 0..1, clockwise from north).
+    const float *distance = nullptr; ///< Metres along the heading.
+    const float *height = nullptr;   ///< Metres above the subject.
+    float *offset_x = nullptr;       ///< Out: camera x minus subject x.
+    float *offset_z = nullptr;       ///< Out: camera z minus subject z.
+    float *yaw = nullptr;            ///< Out: free camera yaw aimed at the subject (radians).
+    float *pitch = nullptr;          ///< Out: free camera pitch aimed at the subject (radians).
+  };
+
+  /** @brief Computes every pose in the batch. */
+  void ComputeRigPoseBatch(const RigPoseBatch &batch);
+
+  /** @brief true if `ComputeRigPoseBatch` runs four lanes per step in this build. */
+  bool RigPoseBatchUsesSimd();
+
+  /** @brief One lane of the polynomial sincos: sin and cos of `turns` full turns. */
+  void FastSinCosTurns(float turns, float &sin_out, float &cos_out);
+
+  /** @brief One lane of the polynomial atan2. Returns 0 for (0, 0). */
+  float FastAtan2(float y, float x);
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,86 @@
+/**
+ * @file RigPresets.cpp
+ * @brief Implementation of the rig preset table and preset pose.
+ */
+
+#define _USE_MATH_DEFINES
+#include "RigPresets.hpp"
+
+#include <cmath>
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    RigPose ComputePresetPose(const SPF_DVector &truck, double heading, const RigPreset &preset)
+    {
+        // Same heading conversion as ComputeRigPose. Viewed from above (X east, Z south), the
+        // truck's right is the forward vector turned a quarter clockwise: (-sin, cos).
+        const double phi = (1.5 * M_PI) - (2.0 * M_PI * heading);
+        const double forward_x = std::cos(phi), forward_z = std::sin(phi);
+
+        RigPose pose;
+        pose.camera = {truck.x + forward_x * preset.distance - forward_z * preset.lateral,
+                       truck.y + preset.height,
+                       truck.z + forward_z * preset.distance + forward_x * preset.lateral};
+        pose.look_target = truck;
+        pose.fov = preset.fov;
+        pose.roll = (float)(preset.roll * M_PI / 180.0);
+        if (preset.distance != 0.0f || preset.height != 0.0f || preset.lateral != 0.0f)
+        {
+            AimRig(pose);
+            pose.yaw += (float)(preset.yaw_offset * M_PI / 180.0);
+            if (preset.has_pitch)
+            {
+                pose.pitch = (float)(preset.pitch * M_PI / 180.0);
+            }
+        }
+        return pose;
+    }
+
+    void RigPresetTable::Resize(size_t count)
+    {
+        m_count = count < RIG_MAX_PRESETS ? count : RIG_MAX_PRESETS;
+        for (size_t i = m_count; i < RIG_MAX_PRESETS; ++i)
+        {
+            m_presets[i].valid = false;
+        }
+    }
+
+    bool RigPresetTable::SetProfile(const char *key, int32_t preset)
+    {
+        if (!key || std::strlen(key) >= RIG_PROFILE_KEY_SIZE)
+        {
+            return false;
+        }
+        for (size_t i = 0; i < m_profileCount; ++i)
+        {
+            if (std::strcmp(m_profiles[i].key, key) == 0)
+            {
+                m_profiles[i].preset = preset;
+                return true;
+            }
+        }
+        if (m_profileCount == RIG_MAX_PROFILES)
+        {
+            return false;
+        }
+        Profile &profile = m_profiles[m_profileCount++];
+        std::strcpy(profile.key, key);
+        profile.preset = preset;
+        return true;
+    }
+
+    int32_t RigPresetTable::FindProfile(const char *key) const
+    {
+        for (size_t i = 0; key && i < m_profileCount; ++i)
+        {
+            if (std::strcmp(m_profiles[i].key, key) == 0)
+            {
+                return m_profiles[i].preset;
+            }
+        }
+        return -1;
+    }
+
+} // namespace SPF_RedLightCamera
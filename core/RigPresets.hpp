@@ -0,0 +1,90 @@
+/**
+ * @file RigPresets.hpp
+ * @brief Named rig presets and the offence profiles that select them.
+ * @details A preset is a complete camera placement: distance along the truck's heading, sideways
+ * offset, height, yaw offset and optional pitch override relative to the aimed rig, FOV and roll.
+ * Presets live in a flat, cache-line aligned array indexed by position, so a capture resolves its
+ * preset once (by offence) and then only does an index lookup. Parsing the presets from the config
+ * is the adapter's job (see `RigPresetConfig.hpp`); this table never sees JSON.
+ *
+ * An offence profile maps a capture kind ("red_signal", "traffic", "manual", or any fine offence
+ * id) to a preset index. Kinds without a profile, or with index -1, use the camera sliders.
+ */
+#pragma once
+
+#include "RigPose.hpp"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t RIG_MAX_PRESETS = 16;
+  constexpr size_t RIG_PRESET_NAME_SIZE = 24;
+  constexpr size_t RIG_MAX_PROFILES = 16;
+  constexpr size_t RIG_PROFILE_KEY_SIZE = 32;
+
+  /** @brief One preset, one cache line. Angles are in degrees. */
+  struct alignas(64) RigPreset
+  {
+    float distance = 25.0f;  ///< Metres along the truck's heading.
+    float height = 4.0f;     ///< Metres above the truck.
+    float lateral = 0.0f;    ///< Metres to the truck's right (negative: left).
+    float yaw_offset = 0.0f; ///< Added to the yaw that aims the rig at the truck.
+    float pitch = 0.0f;      ///< Replaces the aimed pitch when `has_pitch` is set.
+    float fov = 70.0f;
+    float roll = 0.0f;
+    bool has_pitch = false;
+    bool valid = false; ///< false for slots past the end of the array or entries that failed to parse.
+    char name[RIG_PRESET_NAME_SIZE] = "";
+  };
+
+  static_assert(sizeof(RigPreset) == 64, "RigPreset should fill exactly one cache line.");
+
+  /**
+   * @brief Places the rig from a preset and aims it at the truck, then applies the preset's yaw
+   *        offset, pitch override and roll.
+   * @param heading Truck heading (telemetry convention, 0..1, clockwise from north).
+   */
+  RigPose ComputePresetPose(const SPF_DVector &truck, double heading, const RigPreset &preset);
+
+  class RigPresetTable
+  {
+  public:
+    /** @brief Sets the number of presets. Slots at or past `count` are invalidated. */
+    void Resize(size_t count);
+
+    /** @brief Writable slot for the parser, or nullptr if `index` is out of range. */
+    RigPreset *Slot(size_t index) { return index < RIG_MAX_PRESETS ? &m_presets[index] : nullptr; }
+
+    /** @brief The preset at `index`, or nullptr if there is no valid preset there (including -1). */
+    const RigPreset *Get(int32_t index) const
+    {
+      return (index >= 0 && (size_t)index < m_count && m_presets[index].valid) ? &m_presets[index] : nullptr;
+    }
+
+    size_t GetCount() const { return m_count; }
+
+    void ClearProfiles() { m_profileCount = 0; }
+
+    /** @brief Maps `key` to `preset`. Returns false if the profile table is full or the key too long. */
+    bool SetProfile(const char *key, int32_t preset);
+
+    /** @brief The preset index for `key`, or -1 if it has no profile. */
+    int32_t FindProfile(const char *key) const;
+
+  private:
+    struct Profile
+    {
+      char key[RIG_PROFILE_KEY_SIZE];
+      int32_t preset;
+    };
+
+    RigPreset m_presets[RIG_MAX_PRESETS];
+    size_t m_count = 0;
+    Profile m_profiles[RIG_MAX_PROFILES];
+    size_t m_profileCount = 0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,876 @@
+/**
+ * @file ScreenshotQuality.cpp
+ * @brief Implementation of the screenshot quality check.
+ * @details The inflater follows RFC 1951 directly. Huffman codes of up to 10 bits are decoded with
+ * one table lookup and longer ones canonically, bit by bit (they are rare in image data). The bit
+ * buffer is refilled eight bytes at a time, so the hot loop seldom touches the input. Adler-32 and
+ * the chunk CRCs are not verified: a corrupt file is rejected by the decoder or shows up as noise,
+ * and the game wrote the file a moment ago.
+ */
+
+#include "ScreenshotQuality.hpp"
+#include "MappedFile.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define RLC_QUALITY_SSE2 1
+#else
+#define RLC_QUALITY_SSE2 0
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+
+        constexpr uint16_t LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+        constexpr uint8_t LENGTH_EXTRA[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+        constexpr uint16_t DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+        constexpr uint8_t DISTANCE_EXTRA[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+        constexpr uint8_t CODE_LENGTH_ORDER[19] = {16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15};
+
+        constexpr uint32_t FAST_BITS = 10;
+
+        uint32_t ReadBigEndian32(const uint8_t *p) { return (uint32_t)p[0] << 24 | (uint32_t)p[1] << 16 | (uint32_t)p[2] << 8 | p[3]; }
+
+        uint8_t Paeth(uint8_t a, uint8_t b, uint8_t c)
+        {
+            const int p = (int)a + b - c;
+            const int pa = std::abs(p - a), pb = std::abs(p - b), pc = std::abs(p - c);
+            return pa <= pb && pa <= pc ? a : (pb <= pc ? b : c);
+        }
+
+        bool BuildHuffman(uint16_t (&fast)[1 << FAST_BITS], uint16_t (&counts)[16], uint16_t (&symbols)[288], const uint8_t *lengths, size_t count)
+        {
+            std::memset(counts, 0, sizeof(counts));
+            for (size_t i = 0; i < count; ++i)
+            {
+                counts[lengths[i]]++;
+            }
+            counts[0] = 0;
+
+            // Over-subscribed sets are invalid; incomplete ones are allowed (a single distance code).
+            int32_t left = 1;
+            uint16_t offsets[16];
+            offsets[1] = 0;
+            for (uint32_t length = 1; length < 16; ++length)
+            {
+                left = (left << 1) - counts[length];
+                if (left < 0)
+                {
+                    return false;
+                }
+                if (length < 15)
+                {
+                    offsets[length + 1] = (uint16_t)(offsets[length] + counts[length]);
+                }
+            }
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (lengths[i] != 0)
+                {
+                    symbols[offsets[lengths[i]]++] = (uint16_t)i;
+                }
+            }
+
+            // Every short code fills the entries whose low bits are its bit-reversed code.
+            std::memset(fast, 0, sizeof(fast));
+            uint32_t code = 0;
+            size_t index = 0;
+            for (uint32_t length = 1; length <= FAST_BITS; ++length)
+            {
+                for (uint32_t n = 0; n < counts[length]; ++n, ++code)
+                {
+                    uint32_t reversed = 0;
+                    for (uint32_t bit = 0; bit < length; ++bit)
+                    {
+                        reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+                    }
+                    const uint16_t entry = (uint16_t)(symbols[index++] << 4 | length);
+                    for (uint32_t slot = reversed; slot < (1u << FAST_BITS); slot += 1u << length)
+                    {
+                        fast[slot] = entry;
+                    }
+                }
+                code <<= 1;
+            }
+            return true;
+        }
+    } // namespace
+
+    // =================================================================================================
+    // Metrics
+    // =================================================================================================
+
+    size_t FormatQualityFlags(char *out, size_t size, uint8_t flags)
+    {
+        static const char *const NAMES[] = {"black", "blurred", "stale", "unreadable", "missing"};
+        if (size == 0)
+        {
+            return 0;
+        }
+        out[0] = '\0';
+        size_t length = 0;
+        for (size_t bit = 0; bit < sizeof(NAMES) / sizeof(NAMES[0]); ++bit)
+        {
+            if ((flags & (1u << bit)) && length < size)
+            {
+                const int written = std::snprintf(out + length, size - length, "%s%s", length ? "," : "", NAMES[bit]);
+                length += written > 0 ? (size_t)written : 0;
+            }
+        }
+        if (length == 0)
+        {
+            length = (size_t)std::snprintf(out, size, "ok");
+        }
+        return length < size ? length : size - 1;
+    }
+
+    void MeasureQuality(const QualityImage &image, const QualityImage *previous, const QualityThresholds &thresholds, QualityMetrics &out)
+    {
+        const uint32_t width = image.width, height = image.height;
+        const size_t pixels = (size_t)width * height;
+        const uint8_t *data = image.pixels;
+        const bool compare = previous && previous->width == width && previous->height == height;
+
+        uint64_t luma_sum = 0, difference_sum = 0;
+        size_t i = 0;
+#if RLC_QUALITY_SSE2
+        __m128i luma = _mm_setzero_si128(), difference = _mm_setzero_si128();
+        for (; i + 16 <= pixels; i += 16)
+        {
+            const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            luma = _mm_add_epi64(luma, _mm_sad_epu8(a, _mm_setzero_si128()));
+            if (compare)
+            {
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(previous->pixels + i));
+                difference = _mm_add_epi64(difference, _mm_sad_epu8(a, b));
+            }
+        }
+        alignas(16) uint64_t totals[4];
+        _mm_store_si128(reinterpret_cast<__m128i *>(totals), luma);
+        _mm_store_si128(reinterpret_cast<__m128i *>(totals + 2), difference);
+        luma_sum = totals[0] + totals[1];
+        difference_sum = totals[2] + totals[3];
+#endif
+        for (; i < pixels; ++i)
+        {
+            luma_sum += data[i];
+            difference_sum += compare ? (uint64_t)std::abs((int)data[i] - (int)previous->pixels[i]) : 0;
+        }
+
+        // Laplacian over the interior: 4c - left - right - up - down, in [-1020, 1020].
+        int64_t laplacian_sum = 0, laplacian_squares = 0;
+        for (uint32_t y = 1; y + 1 < height; ++y)
+        {
+            const uint8_t *up = data + (size_t)(y - 1) * width;
+            const uint8_t *row = up + width;
+            const uint8_t *down = row + width;
+            uint32_t x = 1;
+#if RLC_QUALITY_SSE2
+            // Per row, each 32-bit lane sums at most 2 x 1020^2 per step: no overflow below 1000 steps.
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i ones = _mm_set1_epi16(1);
+            __m128i sum = zero, squares = zero;
+            for (; x + 9 <= width; x += 8)
+            {
+                const __m128i c = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x)), zero);
+                const __m128i l = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x - 1)), zero);
+                const __m128i r = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(row + x + 1)), zero);
+                const __m128i u = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(up + x)), zero);
+                const __m128i d = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(down + x)), zero);
+                const __m128i value = _mm_sub_epi16(_mm_slli_epi16(c, 2), _mm_add_epi16(_mm_add_epi16(l, r), _mm_add_epi16(u, d)));
+                sum = _mm_add_epi32(sum, _mm_madd_epi16(value, ones));
+                squares = _mm_add_epi32(squares, _mm_madd_epi16(value, value));
+            }
+            alignas(16) int32_t lanes[8];
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes), sum);
+            _mm_store_si128(reinterpret_cast<__m128i *>(lanes + 4), squares);
+            laplacian_sum += (int64_t)lanes[0] + lanes[1] + lanes[2] + lanes[3];
+            laplacian_squares += (int64_t)(uint32_t)lanes[4] + (uint32_t)lanes[5] + (uint32_t)lanes[6] + (uint32_t)lanes[7];
+#endif
+            for (; x + 1 < width; ++x)
+            {
+                const int value = 4 * row[x] - row[x - 1] - row[x + 1] - up[x] - down[x];
+                laplacian_sum += value;
+                laplacian_squares += value * value;
+            }
+        }
+
+        const size_t interior = width > 2 && height > 2 ? (size_t)(width - 2) * (height - 2) : 0;
+        out.mean_luma = pixels ? (float)((double)luma_sum / (double)pixels) : 0.0f;
+        if (interior)
+        {
+            const double mean = (double)laplacian_sum / (double)interior;
+            out.laplacian_variance = (float)((double)laplacian_squares / (double)interior - mean * mean);
+        }
+        else
+        {
+            out.laplacian_variance = 0.0f;
+        }
+        out.difference = compare && pixels ? (float)((double)difference_sum / (double)pixels) : -1.0f;
+
+        // A black frame has no edges either; it is reported as black only.
+        out.flags = 0;
+        if (out.mean_luma < thresholds.black_luma)
+        {
+            out.flags |= QUALITY_BLACK;
+        }
+        else if (out.laplacian_variance < thresholds.blur_variance)
+        {
+            out.flags |= QUALITY_BLURRED;
+        }
+        if (out.difference >= 0.0f && out.difference < thresholds.stale_difference)
+        {
+            out.flags |= QUALITY_STALE;
+        }
+    }
+
+    // =================================================================================================
+    // 1. PNG Decoder
+    // =================================================================================================
+
+    PngLumaDecoder::~PngLumaDecoder() { std::free(m_idat); }
+
+    bool PngLumaDecoder::Decode(const uint8_t *data, size_t size, QualityImage &out, uint32_t &source_width, uint32_t &source_height)
+    {
+        source_width = source_height = 0;
+        if (!data || size < sizeof(PNG_SIGNATURE) + 25 || std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0)
+        {
+            return false;
+        }
+
+        // Walk the chunks: IHDR first, then every IDAT joined in order.
+        size_t idat_size = 0;
+        bool header = false;
+        size_t pos = sizeof(PNG_SIGNATURE);
+        while (pos + 12 <= size)
+        {
+            const uint32_t length = ReadBigEndian32(data + pos);
+            const uint8_t *type = data + pos + 4;
+            const uint8_t *payload = data + pos + 8;
+            if (length > size - pos - 12)
+            {
+                return false;
+            }
+            if (std::memcmp(type, "IHDR", 4) == 0 && length >= 13)
+            {
+                m_width = ReadBigEndian32(payload);
+                m_height = ReadBigEndian32(payload + 4);
+                const uint8_t bit_depth = payload[8], color_type = payload[9], interlace = payload[12];
+                m_channels = color_type == 0 ? 1 : color_type == 4 ? 2 : color_type == 2 ? 3 : color_type == 6 ? 4 : 0;
+                if (bit_depth != 8 || m_channels == 0 || interlace != 0 || m_width == 0 || m_height == 0 || m_width > QUALITY_MAX_DIMENSION ||
+                    m_height > QUALITY_MAX_DIMENSION)
+                {
+                    return false;
+                }
+                header = true;
+            }
+            else if (std::memcmp(type, "IDAT", 4) == 0 && header)
+            {
+                if (idat_size + length > m_idatCapacity)
+                {
+                    const size_t capacity = (idat_size + length) + (idat_size + length) / 2;
+                    uint8_t *grown = static_cast<uint8_t *>(std::realloc(m_idat, capacity));
+                    if (!grown)
+                    {
+                        return false;
+                    }
+                    m_idat = grown;
+                    m_idatCapacity = capacity;
+                }
+                std::memcpy(m_idat + idat_size, payload, length);
+                idat_size += length;
+            }
+            else if (std::memcmp(type, "IEND", 4) == 0)
+            {
+                break;
+            }
+            pos += 12 + (size_t)length;
+        }
+        if (!header || idat_size == 0)
+        {
+            return false;
+        }
+
+        // Boxes of step x step pixels; the remainder at the right and bottom is left out.
+        m_step = (m_width + QUALITY_IMAGE_SIZE - 1) / QUALITY_IMAGE_SIZE;
+        const uint32_t step_height = (m_height + QUALITY_IMAGE_SIZE - 1) / QUALITY_IMAGE_SIZE;
+        m_step = m_step > step_height ? m_step : step_height;
+        out.width = m_width / m_step;
+        out.height = m_height / m_step;
+        if (out.width == 0 || out.height == 0)
+        {
+            return false;
+        }
+        m_stride = (size_t)m_width * m_channels;
+        m_row = 0;
+        m_badFilter = false;
+        m_image = &out;
+        std::memset(m_sums, 0, sizeof(m_sums));
+        std::memset(m_rows[1], 0, m_stride); // The scanline above the first one.
+
+        source_width = m_width;
+        source_height = m_height;
+        return Inflate(m_idat, idat_size) && m_row == m_height && !m_badFilter;
+    }
+
+    void PngLumaDecoder::Refill()
+    {
+        if (m_inEnd - m_in >= 8)
+        {
+            // Whole bytes that fit; the partial one is loaded again next time, at the same position.
+            uint64_t word;
+            std::memcpy(&word, m_in, sizeof(word));
+            m_bits |= word << m_bitCount;
+            m_in += (63 - m_bitCount) >> 3;
+            m_bitCount |= 56;
+            return;
+        }
+        while (m_bitCount <= 56)
+        {
+            if (m_in < m_inEnd)
+            {
+                m_bits |= (uint64_t)*m_in++ << m_bitCount;
+            }
+            else
+            {
+                ++m_padding;
+            }
+            m_bitCount += 8;
+        }
+    }
+
+    uint32_t PngLumaDecoder::Bits(uint32_t count)
+    {
+        if (m_bitCount < count)
+        {
+            Refill();
+        }
+        const uint32_t value = (uint32_t)(m_bits & ((1ull << count) - 1));
+        m_bits >>= count;
+        m_bitCount -= count;
+        return value;
+    }
+
+    int32_t PngLumaDecoder::DecodeSymbol(const Huffman &table)
+    {
+        if (m_bitCount < 15)
+        {
+            Refill();
+        }
+        const uint16_t entry = table.fast[m_bits & ((1u << FAST_BITS) - 1)];
+        if (entry != 0)
+        {
+            const uint32_t length = entry & 15;
+            m_bits >>= length;
+            m_bitCount -= length;
+            return entry >> 4;
+        }
+
+        // Canonical decoding, one bit at a time (codes come most significant bit first).
+        int32_t code = 0, first = 0, index = 0;
+        for (uint32_t length = 1; length <= 15; ++length)
+        {
+            code |= (int32_t)(m_bits & 1);
+            m_bits >>= 1;
+            m_bitCount--;
+            const int32_t count = table.count[length];
+            if (code - first < count)
+            {
+                return table.symbol[index + (code - first)];
+            }
+            index += count;
+            first = (first + count) << 1;
+            code <<= 1;
+        }
+        return -1;
+    }
+
+    bool PngLumaDecoder::ReadDynamicTables()
+    {
+        const uint32_t literal_count = Bits(5) + 257;
+        const uint32_t distance_count = Bits(5) + 1;
+        const uint32_t code_length_count = Bits(4) + 4;
+        if (literal_count > 286 || distance_count > 30)
+        {
+            return false;
+        }
+
+        uint8_t lengths[286 + 30] = {};
+        for (uint32_t i = 0; i < code_length_count; ++i)
+        {
+            lengths[CODE_LENGTH_ORDER[i]] = (uint8_t)Bits(3);
+        }
+        Huffman &code_lengths = m_literals; // Rebuilt below.
+        if (!BuildHuffman(code_lengths.fast, code_lengths.count, code_lengths.symbol, lengths, 19))
+        {
+            return false;
+        }
+
+        uint8_t all[286 + 30] = {};
+        uint32_t n = 0;
+        while (n < literal_count + distance_count)
+        {
+            const int32_t symbol = DecodeSymbol(code_lengths);
+            if (symbol < 0)
+            {
+                return false;
+            }
+            if (symbol < 16)
+            {
+                all[n++] = (uint8_t)symbol;
+                continue;
+            }
+            uint8_t value = 0;
+            uint32_t repeat;
+            if (symbol == 16)
+            {
+                if (n == 0)
+                {
+                    return false;
+                }
+                value = all[n - 1];
+                repeat = 3 + Bits(2);
+            }
+            else if (symbol == 17)
+            {
+                repeat = 3 + Bits(3);
+            }
+            else
+            {
+                repeat = 11 + Bits(7);
+            }
+            if (n + repeat > literal_count + distance_count)
+            {
+                return false;
+            }
+            std::memset(all + n, value, repeat);
+            n += repeat;
+        }
+        if (all[256] == 0)
+        {
+            return false; // No end-of-block code.
+        }
+        return BuildHuffman(m_literals.fast, m_literals.count, m_literals.symbol, all, literal_count) &&
+               BuildHuffman(m_distances.fast, m_distances.count, m_distances.symbol, all + literal_count, distance_count);
+    }
+
+    bool PngLumaDecoder::Inflate(const uint8_t *data, size_t size)
+    {
+        // zlib header: deflate, no preset dictionary.
+        if (size < 2 || (data[0] & 0x0F) != 8 || ((uint32_t)data[0] << 8 | data[1]) % 31 != 0 || (data[1] & 0x20) != 0)
+        {
+            return false;
+        }
+        m_in = data + 2;
+        m_inEnd = data + size;
+        m_bits = 0;
+        m_bitCount = 0;
+        m_padding = 0;
+        m_outPos = 0;
+        m_consumed = 0;
+
+        if (!m_fixedBuilt)
+        {
+            uint8_t lengths[288 + 30];
+            std::memset(lengths, 8, 144);
+            std::memset(lengths + 144, 9, 112);
+            std::memset(lengths + 256, 7, 24);
+            std::memset(lengths + 280, 8, 8);
+            std::memset(lengths + 288, 5, 30);
+            m_fixedBuilt = BuildHuffman(m_fixedLiterals.fast, m_fixedLiterals.count, m_fixedLiterals.symbol, lengths, 288) &&
+                           BuildHuffman(m_fixedDistances.fast, m_fixedDistances.count, m_fixedDistances.symbol, lengths + 288, 30);
+        }
+
+        bool last = false;
+        while (!last && m_row < m_height)
+        {
+            last = Bits(1) != 0;
+            const uint32_t type = Bits(2);
+            bool ok;
+            if (type == 0)
+            {
+                ok = InflateStored();
+            }
+            else if (type == 1)
+            {
+                ok = InflateBlock(m_fixedLiterals, m_fixedDistances);
+            }
+            else if (type == 2)
+            {
+                ok = ReadDynamicTables() && InflateBlock(m_literals, m_distances);
+            }
+            else
+            {
+                ok = false;
+            }
+            if (!ok)
+            {
+                return false;
+            }
+        }
+        ConsumeScanlines();
+        return true;
+    }
+
+    bool PngLumaDecoder::InflateStored()
+    {
+        // Byte-aligned LEN and ~LEN, then raw bytes.
+        Bits(m_bitCount & 7);
+        const uint32_t length = Bits(16);
+        if ((Bits(16) ^ 0xFFFF) != length)
+        {
+            return false;
+        }
+
+        uint32_t remaining = length;
+        while (remaining != 0 && m_bitCount >= 8)
+        {
+            m_window[m_outPos++] = (uint8_t)Bits(8);
+            --remaining;
+        }
+        if (remaining == 0)
+        {
+            return !Overrun();
+        }
+
+        // The bit buffer is empty; what it loaded beyond its count is read again from the input.
+        m_bits = 0;
+        while (remaining != 0)
+        {
+            if (m_outPos >= FLUSH_AT)
+            {
+                ConsumeScanlines();
+            }
+            const size_t room = FLUSH_AT - m_outPos;
+            const size_t copy = remaining < room ? remaining : room;
+            if ((size_t)(m_inEnd - m_in) < copy)
+            {
+                return false;
+            }
+            std::memcpy(m_window + m_outPos, m_in, copy);
+            m_in += copy;
+            m_outPos += copy;
+            remaining -= (uint32_t)copy;
+        }
+        return true;
+    }
+
+    bool PngLumaDecoder::InflateBlock(const Huffman &literals, const Huffman &distances)
+    {
+        uint8_t *window = m_window;
+        for (;;)
+        {
+            if (m_outPos >= FLUSH_AT)
+            {
+                ConsumeScanlines();
+                if (Overrun() || m_badFilter)
+                {
+                    return false;
+                }
+                if (m_row == m_height)
+                {
+                    return true; // Every scanline is in; the rest of the stream is not needed.
+                }
+            }
+
+            const int32_t symbol = DecodeSymbol(literals);
+            if (symbol < 256)
+            {
+                if (symbol < 0)
+                {
+                    return false;
+                }
+                window[m_outPos++] = (uint8_t)symbol;
+                continue;
+            }
+            if (symbol == 256)
+            {
+                return !Overrun();
+            }
+            if (symbol > 285)
+            {
+                return false;
+            }
+
+            const uint32_t length = LENGTH_BASE[symbol - 257] + Bits(LENGTH_EXTRA[symbol - 257]);
+            const int32_t distance_symbol = DecodeSymbol(distances);
+            if (distance_symbol < 0 || distance_symbol > 29)
+            {
+                return false;
+            }
+            const uint32_t distance = DISTANCE_BASE[distance_symbol] + Bits(DISTANCE_EXTRA[distance_symbol]);
+            if (distance > m_outPos)
+            {
+                return false;
+            }
+
+            uint8_t *to = window + m_outPos;
+            const uint8_t *from = to - distance;
+            if (distance >= 8)
+            {
+                // Eight bytes at a time; each copy only reads bytes written before it. May write up
+                // to 7 bytes past the match, which the window's slack absorbs.
+                for (uint32_t n = 0; n < length; n += 8)
+                {
+                    std::memcpy(to + n, from + n, 8);
+                }
+            }
+            else if (distance == 1)
+            {
+                std::memset(to, *from, length);
+            }
+            else
+            {
+                for (uint32_t n = 0; n < length; ++n)
+                {
+                    to[n] = from[n];
+                }
+            }
+            m_outPos += length;
+        }
+    }
+
+    void PngLumaDecoder::ConsumeScanlines()
+    {
+        while (m_row < m_height && m_outPos - m_consumed >= m_stride + 1)
+        {
+            AddScanline(m_window + m_consumed);
+            m_consumed += m_stride + 1;
+        }
+
+        // Keep 32 KB of history and whatever is not unfiltered yet.
+        const size_t history = m_outPos > WINDOW ? m_outPos - WINDOW : 0;
+        const size_t keep_from = m_consumed < history ? m_consumed : history;
+        if (keep_from != 0)
+        {
+            std::memmove(m_window, m_window + keep_from, m_outPos - keep_from);
+            m_outPos -= keep_from;
+            m_consumed -= keep_from;
+        }
+    }
+
+    void PngLumaDecoder::AddScanline(const uint8_t *scanline)
+    {
+        const uint8_t filter = scanline[0];
+        const uint8_t *in = scanline + 1;
+        const uint8_t *above = m_rows[(m_row + 1) & 1];
+        uint8_t *row = m_rows[m_row & 1];
+        const size_t stride = m_stride;
+        const size_t bpp = m_channels;
+
+        if (filter == 2) // Up
+        {
+            size_t i = 0;
+#if RLC_QUALITY_SSE2
+            for (; i + 16 <= stride; i += 16)
+            {
+                const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(in + i));
+                const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i *>(above + i));
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(row + i), _mm_add_epi8(x, b));
+            }
+#endif
+            for (; i < stride; ++i)
+            {
+                row[i] = (uint8_t)(in[i] + above[i]);
+            }
+        }
+        else if (filter == 0) // None
+        {
+            std::memcpy(row, in, stride);
+        }
+        else if (filter > 4)
+        {
+            // Not a PNG filter: the data is corrupt. Decode fails once the scanline is summed.
+            m_badFilter = true;
+            std::memset(row, 0, stride);
+        }
+        else if (!UnfilterPixels(filter, in, above, row))
+        {
+            UnfilterBytes(filter, in, above, row);
+        }
+
+        // Channels summed into the boxes of this image row; weighted (BT.601) once the boxes are full.
+        QualityImage &image = *m_image;
+        const uint32_t step = m_step;
+        const uint32_t image_row = m_row / step;
+        if (image_row < image.height)
+        {
+            const uint8_t *pixel = row;
+            if (bpp >= 3)
+            {
+                for (uint32_t x = 0; x < image.width; ++x)
+                {
+                    uint32_t r = 0, g = 0, b = 0;
+                    for (uint32_t n = 0; n < step; ++n, pixel += bpp)
+                    {
+                        r += pixel[0];
+                        g += pixel[1];
+                        b += pixel[2];
+                    }
+                    m_sums[0][x] += r;
+                    m_sums[1][x] += g;
+                    m_sums[2][x] += b;
+                }
+            }
+            else
+            {
+                for (uint32_t x = 0; x < image.width; ++x)
+                {
+                    uint32_t v = 0;
+                    for (uint32_t n = 0; n < step; ++n, pixel += bpp)
+                    {
+                        v += pixel[0];
+                    }
+                    m_sums[0][x] += v;
+                }
+            }
+            if (m_row % step == step - 1)
+            {
+                const uint32_t box = step * step * 256;
+                uint8_t *out = image.pixels + (size_t)image_row * image.width;
+                for (uint32_t x = 0; x < image.width; ++x)
+                {
+                    const uint32_t luma = bpp >= 3 ? 77u * m_sums[0][x] + 150u * m_sums[1][x] + 29u * m_sums[2][x] : 256u * m_sums[0][x];
+                    out[x] = (uint8_t)((luma + box / 2) / box);
+                    m_sums[0][x] = m_sums[1][x] = m_sums[2][x] = 0;
+                }
+            }
+        }
+        ++m_row;
+    }
+
+    void PngLumaDecoder::UnfilterBytes(uint8_t filter, const uint8_t *in, const uint8_t *above, uint8_t *row) const
+    {
+        const size_t stride = m_stride;
+        const size_t bpp = m_channels;
+        switch (filter)
+        {
+        case 1: // Sub
+            std::memcpy(row, in, bpp);
+            for (size_t i = bpp; i < stride; ++i)
+            {
+                row[i] = (uint8_t)(in[i] + row[i - bpp]);
+            }
+            break;
+        case 3: // Average
+            for (size_t i = 0; i < bpp; ++i)
+            {
+                row[i] = (uint8_t)(in[i] + (above[i] >> 1));
+            }
+            for (size_t i = bpp; i < stride; ++i)
+            {
+                row[i] = (uint8_t)(in[i] + (((uint32_t)row[i - bpp] + above[i]) >> 1));
+            }
+            break;
+        default: // Paeth
+            for (size_t i = 0; i < bpp; ++i)
+            {
+                row[i] = (uint8_t)(in[i] + above[i]);
+            }
+            for (size_t i = bpp; i < stride; ++i)
+            {
+                row[i] = (uint8_t)(in[i] + Paeth(row[i - bpp], above[i], above[i - bpp]));
+            }
+            break;
+        }
+    }
+
+    bool PngLumaDecoder::UnfilterPixels(uint8_t filter, const uint8_t *in, const uint8_t *above, uint8_t *row) const
+    {
+#if RLC_QUALITY_SSE2
+        // Sub, Average and Paeth depend on the pixel to the left, so the SIMD unit works on one whole
+        // pixel at a time. Loads and stores are four bytes wide: with three channels they run one
+        // byte past the scanline, into the next filter byte or the buffers' slack.
+        const size_t bpp = m_channels;
+        if (bpp < 3)
+        {
+            return false;
+        }
+        const size_t stride = m_stride;
+        const __m128i zero = _mm_setzero_si128();
+        __m128i a = zero, c = zero; // Left and upper-left pixels, zero before the first one.
+        for (size_t i = 0; i < stride; i += bpp)
+        {
+            int32_t word;
+            std::memcpy(&word, in + i, 4);
+            const __m128i x = _mm_cvtsi32_si128(word);
+            std::memcpy(&word, above + i, 4);
+            const __m128i b = _mm_cvtsi32_si128(word);
+            __m128i value;
+            if (filter == 1) // Sub
+            {
+                value = _mm_add_epi8(x, a);
+            }
+            else if (filter == 3) // Average: the rounding of _mm_avg_epu8 taken back.
+            {
+                const __m128i average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+                value = _mm_add_epi8(x, average);
+            }
+            else // Paeth, on 16-bit lanes.
+            {
+                const __m128i a16 = _mm_unpacklo_epi8(a, zero), b16 = _mm_unpacklo_epi8(b, zero), c16 = _mm_unpacklo_epi8(c, zero);
+                const __m128i pa = _mm_sub_epi16(b16, c16);
+                const __m128i pb = _mm_sub_epi16(a16, c16);
+                __m128i pc = _mm_add_epi16(pa, pb);
+                const __m128i abs_pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+                const __m128i abs_pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+                pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+                const __m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(abs_pa, abs_pb));
+                // Ties favour a over b over c.
+                const __m128i use_b = _mm_cmpeq_epi16(smallest, abs_pb);
+                const __m128i use_a = _mm_cmpeq_epi16(smallest, abs_pa);
+                __m128i predictor = _mm_or_si128(_mm_and_si128(use_b, b16), _mm_andnot_si128(use_b, c16));
+                predictor = _mm_or_si128(_mm_and_si128(use_a, a16), _mm_andnot_si128(use_a, predictor));
+                value = _mm_add_epi8(x, _mm_packus_epi16(predictor, zero));
+                c = b;
+            }
+            word = _mm_cvtsi128_si32(value);
+            std::memcpy(row + i, &word, 4);
+            a = value;
+        }
+        return true;
+#else
+        (void)filter;
+        (void)in;
+        (void)above;
+        (void)row;
+        return false;
+#endif
+    }
+
+    // =================================================================================================
+    // 2. Checker
+    // =================================================================================================
+
+    bool ScreenshotQualityChecker::Check(const char *path, const QualityThresholds &thresholds, QualityMetrics &out)
+    {
+        out = QualityMetrics();
+        QualityImage &image = m_images[m_hasPrevious ? 1 - m_previous : m_previous];
+        MappedFile file;
+        if (!path || !file.Open(path))
+        {
+            out.flags = QUALITY_UNREADABLE | QUALITY_MISSING;
+            return false;
+        }
+        if (!m_decoder.Decode(static_cast<const uint8_t *>(file.GetData()), file.GetSize(), image, out.width, out.height))
+        {
+            out.flags = QUALITY_UNREADABLE;
+            return false;
+        }
+        file.Close();
+
+        MeasureQuality(image, m_hasPrevious ? &m_images[m_previous] : nullptr, thresholds, out);
+        m_previous = (size_t)(&image - m_images);
+        m_hasPrevious = true;
+        return true;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,179 @@
+/**
+ * @file ScreenshotQuality.hpp
+ * @brief Checks a saved screenshot for black, blurred or stale frames.
+ * @details The game writes screenshots as PNG. `PngLumaDecoder` decodes one straight into a small
+ * luminance image: the zlib stream is inflated into a sliding window, every scanline is unfiltered
+ * as soon as it is complete, and its pixels are averaged into boxes of `step` x `step` source
+ * pixels, so a 4K frame becomes a 480 x 270 image without the full frame ever being held in memory.
+ * Eight-bit grey, grey-alpha, RGB and RGBA images are supported; interlaced, palette and 16-bit
+ * ones (which the game does not write) are reported as unreadable, as are scanlines with a filter
+ * type PNG does not define.
+ *
+ * `MeasureQuality` then computes, with SSE2 where available:
+ *
+ * - the mean luminance (0-255): a black frame is far below any daylight or night scene;
+ * - the variance of the Laplacian (4-neighbour) of the small image: low when the frame is motion-
+ *   blurred or out of focus, since box averaging keeps only edges wider than a few pixels;
+ * - the mean absolute difference to the previously checked screenshot of the same size: near zero
+ *   when the game saved the same frame again, e.g. the cab view before the camera switched.
+ *
+ * Everything is plain memory and file work for a background thread. A checker is about 1 MB;
+ * keep it in static storage or on the heap.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr uint32_t QUALITY_IMAGE_SIZE = 480;    ///< Longest side of the downscaled image, at most.
+  constexpr uint32_t QUALITY_MAX_DIMENSION = 16384; ///< Larger sources are rejected.
+  constexpr size_t QUALITY_WINDOW_CHUNK = 256 * 1024; ///< Inflated bytes between two scanline passes.
+  constexpr size_t QUALITY_PATH_SIZE = 640;
+
+  enum QualityFlags : uint8_t
+  {
+    QUALITY_BLACK = 1 << 0,
+    QUALITY_BLURRED = 1 << 1,
+    QUALITY_STALE = 1 << 2,
+    QUALITY_UNREADABLE = 1 << 3, ///< Missing, truncated, corrupt or not a supported PNG; no metrics.
+    QUALITY_MISSING = 1 << 4,    ///< With UNREADABLE: there is no file at the path.
+  };
+
+  struct QualityThresholds
+  {
+    float black_luma = 10.0f;       ///< Mean luminance below this is black.
+    float blur_variance = 25.0f;    ///< Laplacian variance below this is blurred.
+    float stale_difference = 1.0f;  ///< Mean difference to the previous screenshot below this is stale.
+  };
+
+  struct QualityMetrics
+  {
+    uint32_t width = 0, height = 0; ///< Of the screenshot.
+    float mean_luma = 0.0f;
+    float laplacian_variance = 0.0f;
+    float difference = -1.0f; ///< -1 without a previous screenshot of the same size.
+    uint8_t flags = 0;        ///< QualityFlags.
+  };
+
+  /** @brief A downscaled luminance image, rows packed. */
+  struct QualityImage
+  {
+    uint32_t width = 0, height = 0;
+    uint8_t pixels[QUALITY_IMAGE_SIZE * QUALITY_IMAGE_SIZE];
+  };
+
+  /** @brief Writes the flags as "black,stale", or "ok" for none. Returns the length written. */
+  size_t FormatQualityFlags(char *out, size_t size, uint8_t flags);
+
+  /**
+   * @brief Computes the metrics of `image` and sets the flags that `thresholds` call for.
+   * @param previous Compared against if it has the same size; may be nullptr.
+   */
+  void MeasureQuality(const QualityImage &image, const QualityImage *previous, const QualityThresholds &thresholds, QualityMetrics &out);
+
+  // =================================================================================================
+  // 1. PNG Decoder
+  // =================================================================================================
+
+  class PngLumaDecoder
+  {
+  public:
+    PngLumaDecoder() = default;
+    ~PngLumaDecoder();
+    PngLumaDecoder(const PngLumaDecoder &) = delete;
+    PngLumaDecoder &operator=(const PngLumaDecoder &) = delete;
+
+    /**
+     * @brief Decodes a whole PNG file in memory into a downscaled luminance image.
+     * @param source_width, source_height Receive the PNG's size.
+     * @return false if the file is not a supported PNG, is truncated or is corrupt.
+     */
+    bool Decode(const uint8_t *data, size_t size, QualityImage &out, uint32_t &source_width, uint32_t &source_height);
+
+  private:
+    struct Huffman
+    {
+      uint16_t fast[1 << 10]; ///< By the next 10 bits: symbol << 4 | length, 0 for longer codes.
+      uint16_t count[16];     ///< Codes per length.
+      uint16_t symbol[288];   ///< Symbols in canonical order.
+    };
+
+    bool Inflate(const uint8_t *data, size_t size);
+    bool ReadDynamicTables();
+    bool InflateBlock(const Huffman &literals, const Huffman &distances);
+    bool InflateStored();
+    void ConsumeScanlines();
+    void AddScanline(const uint8_t *scanline);
+    void UnfilterBytes(uint8_t filter, const uint8_t *in, const uint8_t *above, uint8_t *row) const;
+    bool UnfilterPixels(uint8_t filter, const uint8_t *in, const uint8_t *above, uint8_t *row) const; ///< SSE2, three or four channels.
+
+    void Refill();
+    uint32_t Bits(uint32_t count);
+    int32_t DecodeSymbol(const Huffman &table);
+    bool Overrun() const { return (uint64_t)m_padding * 8 > m_bitCount; } ///< Read past the end of the stream.
+
+    // Bit reader over the zlib stream.
+    const uint8_t *m_in = nullptr;
+    const uint8_t *m_inEnd = nullptr;
+    uint64_t m_bits = 0;
+    uint32_t m_bitCount = 0;
+    uint32_t m_padding = 0; ///< Zero bytes loaded past the end of the stream.
+
+    Huffman m_literals;
+    Huffman m_distances;
+    Huffman m_fixedLiterals;
+    Huffman m_fixedDistances;
+    bool m_fixedBuilt = false;
+
+    // Inflated stream: the last 32 KB stay for back-references; complete scanlines are consumed.
+    static constexpr size_t WINDOW = 32 * 1024;
+    static constexpr size_t WINDOW_CAPACITY = WINDOW + QUALITY_WINDOW_CHUNK + 4 * QUALITY_MAX_DIMENSION + 512;
+    static constexpr size_t FLUSH_AT = WINDOW_CAPACITY - 258 - 8; ///< Room for a match and its 8-byte overshoot.
+    uint8_t m_window[WINDOW_CAPACITY];
+    size_t m_outPos = 0;   ///< Write position in the window.
+    size_t m_consumed = 0; ///< Start of the first scanline not yet unfiltered.
+
+    // Scanline state.
+    uint32_t m_width = 0, m_height = 0, m_channels = 0;
+    size_t m_stride = 0; ///< Bytes per scanline, filter byte excluded.
+    uint32_t m_row = 0;  ///< Scanlines unfiltered so far.
+    uint32_t m_step = 1; ///< Source pixels per image pixel, in each direction.
+    bool m_badFilter = false; ///< A scanline had a filter type above 4.
+    uint8_t m_rows[2][4 * QUALITY_MAX_DIMENSION + 16]; ///< Unfiltered scanlines, alternating.
+    uint32_t m_sums[3][QUALITY_IMAGE_SIZE];            ///< Channel sums of the image row being summed.
+    QualityImage *m_image = nullptr;
+
+    // IDAT chunks, joined; grown as needed and kept for the next file.
+    uint8_t *m_idat = nullptr;
+    size_t m_idatCapacity = 0;
+  };
+
+  // =================================================================================================
+  // 2. Checker
+  // =================================================================================================
+
+  /** @brief Checks screenshot files one after another, each against the one before. */
+  class ScreenshotQualityChecker
+  {
+  public:
+    /**
+     * @brief Maps and decodes `path` and measures it.
+     * @return false (with `QUALITY_UNREADABLE` set, and `QUALITY_MISSING` if it could not be
+     *         opened) if the file could not be decoded; the previous screenshot is kept for the next check.
+     */
+    bool Check(const char *path, const QualityThresholds &thresholds, QualityMetrics &out);
+
+    /** @brief Forgets the previous screenshot. */
+    void Reset() { m_hasPrevious = false; }
+
+  private:
+    PngLumaDecoder m_decoder;
+    QualityImage m_images[2];
+    size_t m_previous = 0;
+    bool m_hasPrevious = false;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,166 @@
+/**
+ * @file ScreenshotTracker.cpp
+ * @brief Implementation of the screenshot confirmation tracker.
+ */
+
+#include "ScreenshotTracker.hpp"
+#include "LogMatcher.hpp"
+
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        void CopyString(char *out, size_t size, const char *text)
+        {
+            std::strncpy(out, text ? text : "", size - 1);
+            out[size - 1] = '\0';
+        }
+
+        // Characters the plugin's screenshot names are made of (see CaptureNaming.hpp).
+        bool IsNameChar(char c)
+        {
+            return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_' || c == '-';
+        }
+
+        // True if `name` appears in `line` as a whole file name, so "..._T4" does not match "..._T45".
+        bool ContainsName(const char *line, const char *name)
+        {
+            const size_t length = std::strlen(name);
+            if (length == 0)
+            {
+                return false;
+            }
+            for (const char *hit = std::strstr(line, name); hit; hit = std::strstr(hit + 1, name))
+            {
+                if ((hit == line || !IsNameChar(hit[-1])) && !IsNameChar(hit[length]))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    } // namespace
+
+    void ScreenshotLogLine::Assign(const char *line, uint8_t line_flags, uint64_t time_us)
+    {
+        at_us = time_us;
+        flags = line_flags;
+        const size_t length = line ? std::strlen(line) : 0;
+        const size_t keep = length < sizeof(text) ? length : sizeof(text) - 1;
+        std::memcpy(text, line + (length - keep), keep);
+        text[keep] = '\0';
+    }
+
+    bool ScreenshotTracker::Track(const char *name, const char *label, uint32_t attempt, uint64_t issued_us, const SPF_DVector &position)
+    {
+        bool dropped = false;
+        if (m_pendingCount == SCREENSHOT_MAX_PENDING)
+        {
+            m_pendingHead = (m_pendingHead + 1) % SCREENSHOT_MAX_PENDING;
+            m_pendingCount--;
+            dropped = true;
+        }
+
+        Pending &entry = m_pending[(m_pendingHead + m_pendingCount) % SCREENSHOT_MAX_PENDING];
+        CopyString(entry.name, sizeof(entry.name), name);
+        CopyString(entry.label, sizeof(entry.label), label);
+        entry.issued_us = issued_us;
+        entry.attempt = attempt;
+        entry.position = position;
+        m_pendingCount++;
+        return !dropped;
+    }
+
+    bool ScreenshotTracker::Resolve(uint8_t flags, const char *line, uint64_t at_us, uint32_t max_retries, ScreenshotResult &out)
+    {
+        if (m_pendingCount == 0 || (flags & (SCREENSHOT_LOG_SAVED | SCREENSHOT_LOG_FAILED)) == 0)
+        {
+            return false;
+        }
+
+        // Names are unique (they embed the simulation time), so the first hit is the one. A line that
+        // names none of them belongs to a screenshot the plugin did not take.
+        size_t index = m_pendingCount;
+        for (size_t i = 0; line && i < m_pendingCount; ++i)
+        {
+            if (ContainsName(line, m_pending[(m_pendingHead + i) % SCREENSHOT_MAX_PENDING].name))
+            {
+                index = i;
+                break;
+            }
+        }
+        if (index == m_pendingCount)
+        {
+            return false;
+        }
+
+        const bool failed = (flags & SCREENSHOT_LOG_FAILED) != 0;
+        const Pending &entry = m_pending[(m_pendingHead + index) % SCREENSHOT_MAX_PENDING];
+        const bool retry = failed && entry.attempt < max_retries && QueueRetry(entry.label, entry.attempt + 1);
+
+        Take(index, failed ? ScreenshotOutcome::Failed : ScreenshotOutcome::Saved, at_us, out);
+        out.retry_queued = retry;
+        return true;
+    }
+
+    bool ScreenshotTracker::Expire(uint64_t now_us, uint64_t timeout_us, ScreenshotResult &out)
+    {
+        if (m_pendingCount == 0 || now_us - m_pending[m_pendingHead].issued_us < timeout_us)
+        {
+            return false;
+        }
+        Take(0, ScreenshotOutcome::TimedOut, now_us, out);
+        out.retry_queued = false;
+        return true;
+    }
+
+    bool ScreenshotTracker::QueueRetry(const char *label, uint32_t attempt)
+    {
+        if (m_retryCount == MAX_RETRIES_QUEUED)
+        {
+            return false;
+        }
+        Retry &queued = m_retries[m_retryCount++];
+        CopyString(queued.label, sizeof(queued.label), label);
+        queued.attempt = attempt;
+        return true;
+    }
+
+    bool ScreenshotTracker::TakeRetry(char (&label)[SCREENSHOT_LABEL_SIZE], uint32_t &attempt)
+    {
+        if (m_retryCount == 0)
+        {
+            return false;
+        }
+        std::memcpy(label, m_retries[0].label, sizeof(label));
+        attempt = m_retries[0].attempt;
+        m_retryCount--;
+        for (size_t i = 0; i < m_retryCount; ++i)
+        {
+            m_retries[i] = m_retries[i + 1];
+        }
+        return true;
+    }
+
+    void ScreenshotTracker::Take(size_t index, ScreenshotOutcome outcome, uint64_t at_us, ScreenshotResult &out)
+    {
+        const Pending &entry = m_pending[(m_pendingHead + index) % SCREENSHOT_MAX_PENDING];
+        out.outcome = outcome;
+        out.latency_us = at_us > entry.issued_us ? at_us - entry.issued_us : 0;
+        out.attempt = entry.attempt;
+        out.position = entry.position;
+        std::memcpy(out.name, entry.name, sizeof(out.name));
+        std::memcpy(out.label, entry.label, sizeof(out.label));
+
+        // Close the gap, keeping issue order.
+        for (size_t i = index; i + 1 < m_pendingCount; ++i)
+        {
+            m_pending[(m_pendingHead + i) % SCREENSHOT_MAX_PENDING] = m_pending[(m_pendingHead + i + 1) % SCREENSHOT_MAX_PENDING];
+        }
+        m_pendingCount--;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,125 @@
+/**
+ * @file ScreenshotTracker.hpp
+ * @brief Correlates issued `screenshot` commands with the game log lines that report their result.
+ * @details Every command the plugin issues is tracked by its file name (see `CaptureNaming.hpp`)
+ * with the time it was issued. When the log reports a saved or failed screenshot, the line is
+ * matched against the pending names as whole file names; a line that names none of them (a
+ * screenshot the player took, or a game version that only prints the directory) is ignored rather
+ * than guessed at. Screenshots the log never mentions expire after a timeout.
+ *
+ * A failed screenshot is queued for a retry under the same label until the retry limit is reached;
+ * the owner may queue retakes of saved ones too.
+ * All storage is fixed-size; the tracker is used from the game thread only.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t SCREENSHOT_MAX_PENDING = 16;
+  constexpr size_t SCREENSHOT_NAME_SIZE = 96;
+  constexpr size_t SCREENSHOT_LABEL_SIZE = 64;
+  constexpr size_t SCREENSHOT_LOG_LINE_SIZE = 256;
+
+  /**
+   * @brief A game log line that mentions a screenshot, copied off the logging thread.
+   * @details Long lines keep their end, where the file name is.
+   */
+  struct ScreenshotLogLine
+  {
+    uint64_t at_us;
+    uint8_t flags; ///< `ScreenshotLogFlags`.
+    char text[SCREENSHOT_LOG_LINE_SIZE];
+
+    void Assign(const char *line, uint8_t line_flags, uint64_t time_us);
+  };
+
+  enum class ScreenshotOutcome : uint8_t
+  {
+    Saved,   ///< The log confirmed the file was written.
+    Failed,  ///< The log reported an error.
+    TimedOut ///< The log said nothing within the timeout.
+  };
+
+  /** @brief A resolved screenshot, as returned by `Resolve` and `Expire`. */
+  struct ScreenshotResult
+  {
+    ScreenshotOutcome outcome;
+    uint64_t latency_us; ///< Command to log line (or to expiry).
+    uint32_t attempt;    ///< 0 for the first try, 1 for the first retry, ...
+    bool retry_queued;   ///< A retry was queued for this failure.
+    SPF_DVector position; ///< Of the truck when the command was issued.
+    char name[SCREENSHOT_NAME_SIZE];
+    char label[SCREENSHOT_LABEL_SIZE];
+  };
+
+  class ScreenshotTracker
+  {
+  public:
+    /**
+     * @brief Starts tracking a screenshot taken with the truck at `position`.
+     * @details When the table is full the oldest entry is dropped to make room.
+     * @return false if an entry had to be dropped.
+     */
+    bool Track(const char *name, const char *label, uint32_t attempt, uint64_t issued_us, const SPF_DVector &position);
+
+    /**
+     * @brief Resolves the pending screenshot a log line refers to.
+     * @details The line must name the screenshot as a whole file name; the name may be followed
+     *          by an extension or quote but not by more name characters.
+     * @param flags `ScreenshotLogFlags` of the line; FAILED wins over SAVED.
+     * @param max_retries Failed screenshots below this attempt count are queued for a retry.
+     * @return false if the line names no pending screenshot.
+     */
+    bool Resolve(uint8_t flags, const char *line, uint64_t at_us, uint32_t max_retries, ScreenshotResult &out);
+
+    /** @brief Removes one screenshot older than `timeout_us`, if any. Call until it returns false. */
+    bool Expire(uint64_t now_us, uint64_t timeout_us, ScreenshotResult &out);
+
+    /**
+     * @brief Queues a retake under `label`, e.g. of a saved screenshot that turned out unusable.
+     * @return false if the retry queue is full.
+     */
+    bool QueueRetry(const char *label, uint32_t attempt);
+
+    /** @brief Takes the oldest queued retry. Returns false if none is queued. */
+    bool TakeRetry(char (&label)[SCREENSHOT_LABEL_SIZE], uint32_t &attempt);
+
+    bool HasRetry() const { return m_retryCount != 0; }
+    size_t GetPendingCount() const { return m_pendingCount; }
+
+  private:
+    struct Pending
+    {
+      char name[SCREENSHOT_NAME_SIZE];
+      char label[SCREENSHOT_LABEL_SIZE];
+      uint64_t issued_us;
+      uint32_t attempt;
+      SPF_DVector position;
+    };
+
+    struct Retry
+    {
+      char label[SCREENSHOT_LABEL_SIZE];
+      uint32_t attempt;
+    };
+
+    static constexpr size_t MAX_RETRIES_QUEUED = 4;
+
+    /** @brief Removes pending entry `index` (in issue order) and fills `out`. */
+    void Take(size_t index, ScreenshotOutcome outcome, uint64_t at_us, ScreenshotResult &out);
+
+    Pending m_pending[SCREENSHOT_MAX_PENDING]; ///< Ring in issue order.
+    size_t m_pendingHead = 0;
+    size_t m_pendingCount = 0;
+
+    Retry m_retries[MAX_RETRIES_QUEUED];
+    size_t m_retryCount = 0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,302 @@
+/**
+ * @file SharedMetrics.cpp
+ * @brief Implementation of the shared-memory metrics writer and reader.
+ */
+
+#include "SharedMetrics.hpp"
+#include "ScreenshotQuality.hpp"
+
+#include <atomic>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+#ifdef _WIN32
+        const char *METRICS_SEGMENT_NAME = "Local\\SPF_RedLightCamera.Metrics";
+#else
+        const char *METRICS_SEGMENT_NAME = "/SPF_RedLightCamera.Metrics";
+#endif
+
+        /**
+         * @brief Offence ids reported by the game in `player.fined` events.
+         * @details Order is part of the layout: index `i` here is index `i` in `fines_by_offence`.
+         * Append only; anything not listed is counted in the last slot.
+         */
+        const char *const KNOWN_OFFENCES[] = {
+            "red_signal",
+            "speeding",
+            "speeding_camera",
+            "crash",
+            "wrong_way",
+            "no_lights",
+            "avoid_sleeping",
+            "avoid_weighing",
+            "avoid_inspection",
+            "illegal_trailer",
+            "illegal_border_crossing",
+            "hard_shoulder_violation",
+            "damaged_vehicle_usage",
+            "generic",
+        };
+        constexpr size_t KNOWN_OFFENCE_COUNT = sizeof(KNOWN_OFFENCES) / sizeof(KNOWN_OFFENCES[0]);
+        static_assert(KNOWN_OFFENCE_COUNT < METRICS_MAX_OFFENCES, "One slot is reserved for unknown offences.");
+
+        // Maps the segment and returns its base address, or nullptr. `writable` also creates it.
+        void *MapSegment(bool writable, void *&out_mapping)
+        {
+            out_mapping = nullptr;
+#ifdef _WIN32
+            HANDLE mapping = writable
+                                 ? CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, (DWORD)sizeof(MetricsBlock), METRICS_SEGMENT_NAME)
+                                 : OpenFileMappingA(FILE_MAP_READ, FALSE, METRICS_SEGMENT_NAME);
+            if (!mapping)
+            {
+                return nullptr;
+            }
+            void *view = MapViewOfFile(mapping, writable ? FILE_MAP_WRITE : FILE_MAP_READ, 0, 0, sizeof(MetricsBlock));
+            if (!view)
+            {
+                CloseHandle(mapping);
+                return nullptr;
+            }
+            out_mapping = mapping;
+            return view;
+#else
+            const int fd = writable ? shm_open(METRICS_SEGMENT_NAME, O_CREAT | O_RDWR, 0644)
+                                    : shm_open(METRICS_SEGMENT_NAME, O_RDONLY, 0);
+            if (fd < 0)
+            {
+                return nullptr;
+            }
+            if (writable && ftruncate(fd, sizeof(MetricsBlock)) != 0)
+            {
+                close(fd);
+                return nullptr;
+            }
+            void *view = mmap(nullptr, sizeof(MetricsBlock), writable ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+            close(fd); // The mapping keeps the segment alive.
+            return view == MAP_FAILED ? nullptr : view;
+#endif
+        }
+
+        void UnmapSegment(const void *view, void *mapping)
+        {
+            if (!view)
+            {
+                return;
+            }
+#ifdef _WIN32
+            UnmapViewOfFile(view);
+            if (mapping)
+            {
+                CloseHandle(static_cast<HANDLE>(mapping));
+            }
+#else
+            (void)mapping;
+            munmap(const_cast<void *>(view), sizeof(MetricsBlock));
+#endif
+        }
+
+        std::atomic_ref<uint32_t> Sequence(const MetricsBlock *block)
+        {
+            // Readers map the segment read-only; an atomic load never writes, so dropping const is safe.
+            return std::atomic_ref<uint32_t>(const_cast<MetricsBlock *>(block)->sequence);
+        }
+    } // namespace
+
+    size_t MetricsBucketIndex(uint32_t micros)
+    {
+        size_t index = 0;
+        while (micros != 0 && index < METRICS_HISTOGRAM_BUCKETS - 1)
+        {
+            micros >>= 1;
+            index++;
+        }
+        return index;
+    }
+
+    // =================================================================================================
+    // 1. SharedMetricsWriter
+    // =================================================================================================
+
+    SharedMetricsWriter::SharedMetricsWriter()
+    {
+        std::memset(&m_local, 0, sizeof(m_local));
+        std::memcpy(m_local.magic, METRICS_MAGIC, sizeof(m_local.magic));
+        m_local.version = METRICS_VERSION;
+        m_local.size = sizeof(MetricsBlock);
+        m_local.offence_count = (uint32_t)KNOWN_OFFENCE_COUNT + 1;
+        for (size_t i = 0; i < KNOWN_OFFENCE_COUNT; ++i)
+        {
+            std::strncpy(m_local.offence_names[i], KNOWN_OFFENCES[i], METRICS_OFFENCE_NAME_SIZE - 1);
+        }
+        std::strncpy(m_local.offence_names[KNOWN_OFFENCE_COUNT], "other", METRICS_OFFENCE_NAME_SIZE - 1);
+    }
+
+    bool SharedMetricsWriter::Open()
+    {
+        if (m_shared)
+        {
+            return true;
+        }
+
+        m_shared = static_cast<MetricsBlock *>(MapSegment(true, m_mapping));
+        if (m_shared)
+        {
+            // Continue from whatever sequence a previous session left so readers never see it go back.
+            m_local.sequence = Sequence(m_shared).load(std::memory_order_relaxed) & ~1u;
+            Publish();
+        }
+        return m_shared != nullptr;
+    }
+
+    void SharedMetricsWriter::Close()
+    {
+        // The segment itself is left in place so a dashboard can still show the final values.
+        UnmapSegment(m_shared, m_mapping);
+        m_shared = nullptr;
+        m_mapping = nullptr;
+    }
+
+    void SharedMetricsWriter::RecordFine(const char *offence)
+    {
+        size_t index = KNOWN_OFFENCE_COUNT;
+        if (offence)
+        {
+            for (size_t i = 0; i < KNOWN_OFFENCE_COUNT; ++i)
+            {
+                if (std::strcmp(offence, KNOWN_OFFENCES[i]) == 0)
+                {
+                    index = i;
+                    break;
+                }
+            }
+        }
+        m_local.fines_by_offence[index]++;
+    }
+
+    void SharedMetricsWriter::RecordScreenshotQuality(uint8_t flags, bool retake)
+    {
+        m_local.screenshots_checked++;
+        m_local.screenshots_black += (flags & QUALITY_BLACK) ? 1 : 0;
+        m_local.screenshots_blurred += (flags & QUALITY_BLURRED) ? 1 : 0;
+        m_local.screenshots_stale += (flags & QUALITY_STALE) ? 1 : 0;
+        m_local.screenshots_unreadable += (flags & QUALITY_UNREADABLE) ? 1 : 0;
+        m_local.quality_retakes += retake ? 1 : 0;
+    }
+
+    void SharedMetricsWriter::RecordFrameCost(uint32_t micros, bool overrun, uint32_t budget_us)
+    {
+        AddSample(m_local.frame_cost, micros);
+        if (overrun)
+        {
+            m_local.frame_overruns++;
+        }
+        m_local.frame_budget_us = budget_us;
+    }
+
+    void SharedMetricsWriter::Publish()
+    {
+        m_local.publish_count++;
+        if (!m_shared)
+        {
+            return;
+        }
+
+        std::atomic_ref<uint32_t> sequence = Sequence(m_shared);
+        const uint32_t start = m_local.sequence;
+
+        // Odd: publish in progress. The release fence keeps the copy below from moving above it.
+        sequence.store(start + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        // The copy rewrites `sequence` with the same odd value, so it stays odd until the final store.
+        m_local.sequence = start + 1;
+        std::memcpy(m_shared, &m_local, sizeof(MetricsBlock));
+
+        m_local.sequence = start + 2;
+        sequence.store(start + 2, std::memory_order_release);
+    }
+
+    void SharedMetricsWriter::AddSample(MetricsHistogram &histogram, uint32_t micros)
+    {
+        histogram.count++;
+        histogram.sum_us += micros;
+        histogram.last_us = micros;
+        if (micros > histogram.max_us)
+        {
+            histogram.max_us = micros;
+        }
+        histogram.buckets[MetricsBucketIndex(micros)]++;
+    }
+
+    // =================================================================================================
+    // 2. SharedMetricsReader
+    // =================================================================================================
+
+    bool SharedMetricsReader::Open()
+    {
+        Close();
+        m_shared = static_cast<const MetricsBlock *>(MapSegment(false, m_mapping));
+        if (!m_shared)
+        {
+            return false;
+        }
+
+        if (std::memcmp(m_shared->magic, METRICS_MAGIC, sizeof(METRICS_MAGIC)) != 0 ||
+            m_shared->version != METRICS_VERSION || m_shared->size != sizeof(MetricsBlock))
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void SharedMetricsReader::Close()
+    {
+        UnmapSegment(m_shared, m_mapping);
+        m_shared = nullptr;
+        m_mapping = nullptr;
+    }
+
+    bool SharedMetricsReader::Read(MetricsBlock &out, int max_attempts) const
+    {
+        if (!m_shared)
+        {
+            return false;
+        }
+
+        std::atomic_ref<uint32_t> sequence = Sequence(m_shared);
+        for (int attempt = 0; attempt < max_attempts; ++attempt)
+        {
+            const uint32_t before = sequence.load(std::memory_order_acquire);
+            if (before & 1u)
+            {
+                continue; // Writer is mid-publish.
+            }
+
+            std::memcpy(&out, m_shared, sizeof(MetricsBlock));
+            std::atomic_thread_fence(std::memory_order_acquire);
+
+            if (sequence.load(std::memory_order_relaxed) == before)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,202 @@
+/**
+ * @file SharedMetrics.hpp
+ * @brief Live plugin metrics published to a named shared-memory segment.
+ * @details The segment holds a single `MetricsBlock` with a fixed, versioned layout, so an
+ * external dashboard can map it and poll it at any rate without touching the game or parsing logs.
+ *
+ * The plugin accumulates metrics in a private copy and publishes it with `Publish()`, which copies
+ * the whole block under a seqlock: `sequence` is odd while a copy is in progress and is bumped to
+ * the next even value when it completes. Readers copy the block and retry if `sequence` was odd or
+ * changed during their copy. The writer never waits for readers.
+ *
+ * Segment names: `Local\SPF_RedLightCamera.Metrics` (Windows), `/SPF_RedLightCamera.Metrics` (POSIX).
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SPF_RedLightCamera
+{
+
+  // =================================================================================================
+  // 1. Layout
+  // =================================================================================================
+
+  /** @brief Magic bytes at the start of the segment ("RLCMETR\0"). */
+  constexpr char METRICS_MAGIC[8] = {'R', 'L', 'C', 'M', 'E', 'T', 'R', '\0'};
+
+  /** @brief Layout version. Bump whenever `MetricsBlock` changes. */
+  constexpr uint32_t METRICS_VERSION = 5;
+
+  constexpr size_t METRICS_MAX_OFFENCES = 16;
+  constexpr size_t METRICS_OFFENCE_NAME_SIZE = 32;
+  constexpr size_t METRICS_HISTOGRAM_BUCKETS = 24;
+
+  /** @brief Capture phases timed from the moment the fine is received. */
+  enum class CapturePhase : uint32_t
+  {
+    Posed = 0,  ///< Camera rig positioned (sequence frame 1).
+    Screenshot, ///< Screenshot command issued (sequence frame 2).
+    Restored,   ///< Original camera restored (sequence frame 3).
+    Finished,   ///< Sequence fully finished (flash faded out).
+    Count
+  };
+
+  /**
+   * @brief Log2 latency histogram in microseconds.
+   * @details Bucket 0 counts values below 1 us; bucket `i` counts values in `[2^(i-1), 2^i)` us;
+   * the last bucket also absorbs everything larger.
+   */
+  struct MetricsHistogram
+  {
+    uint64_t count;
+    uint64_t sum_us;
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t buckets[METRICS_HISTOGRAM_BUCKETS];
+  };
+
+  /** @brief The complete shared-memory segment. All fields are naturally aligned. */
+  struct MetricsBlock
+  {
+    // --- Header ---
+    char magic[8];
+    uint32_t version;
+    uint32_t size;                   ///< sizeof(MetricsBlock), for readers built against another version.
+    uint32_t sequence;               ///< Seqlock counter: odd while a publish is in progress. Access via std::atomic_ref.
+    uint32_t offence_count;          ///< Number of valid entries in `offence_names`/`fines_by_offence`.
+    uint64_t publish_count;
+
+    // --- Fines ---
+    char offence_names[METRICS_MAX_OFFENCES][METRICS_OFFENCE_NAME_SIZE];
+    uint64_t fines_by_offence[METRICS_MAX_OFFENCES]; ///< The last entry counts unknown offences.
+
+    // --- Captures ---
+    uint64_t captures_completed;
+    uint64_t captures_dropped; ///< Fines that should have been captured but were not (e.g. busy).
+    uint32_t queue_depth;      ///< Captures in progress or waiting.
+    uint32_t reserved0;
+    MetricsHistogram phase_latency[static_cast<size_t>(CapturePhase::Count)];
+
+    // --- Frame cost ---
+    MetricsHistogram frame_cost;
+    uint64_t frame_overruns;
+    uint32_t frame_budget_us;
+    uint32_t reserved1;
+
+    // --- Screenshot confirmation (from the game log, version 2) ---
+    uint64_t screenshots_saved;
+    uint64_t screenshots_failed;
+    uint64_t screenshots_unconfirmed; ///< No log line within the timeout.
+    uint64_t screenshot_retries;
+    MetricsHistogram screenshot_write_latency; ///< Console command to the "saved" log line.
+
+    // --- Manual captures (keybind, version 3) ---
+    uint64_t manual_captures;
+    uint64_t manual_captures_ignored; ///< Key presses while another capture was in flight.
+    MetricsHistogram manual_capture_latency; ///< Key press to screenshot command.
+
+    // --- Deduplication (version 4) ---
+    uint64_t captures_deduplicated; ///< Repeated fines attached to an earlier capture at the same place.
+
+    // --- Screenshot quality (see ScreenshotQuality.hpp, version 5) ---
+    uint64_t screenshots_checked;
+    uint64_t screenshots_black;
+    uint64_t screenshots_blurred;
+    uint64_t screenshots_stale;
+    uint64_t screenshots_unreadable;
+    uint64_t quality_retakes; ///< Retakes queued for a bad screenshot.
+  };
+
+  static_assert(offsetof(MetricsBlock, sequence) % 4 == 0, "Seqlock counter must be 4-byte aligned.");
+
+  // =================================================================================================
+  // 2. Writer / Reader
+  // =================================================================================================
+
+  /**
+   * @brief Owns the metrics segment on the plugin side.
+   * @details All `Record*` calls update the private copy only; nothing is visible to readers until
+   * `Publish()`. If the segment cannot be created the writer still accumulates, so callers never
+   * need to check `IsShared()`.
+   */
+  class SharedMetricsWriter
+  {
+  public:
+    SharedMetricsWriter();
+    ~SharedMetricsWriter() { Close(); }
+    SharedMetricsWriter(const SharedMetricsWriter &) = delete;
+    SharedMetricsWriter &operator=(const SharedMetricsWriter &) = delete;
+
+    /** @brief Creates (or attaches to) the named segment. */
+    bool Open();
+    void Close();
+    bool IsShared() const { return m_shared != nullptr; }
+
+    void RecordFine(const char *offence);
+    void RecordCaptureCompleted() { m_local.captures_completed++; }
+    void RecordCaptureDropped() { m_local.captures_dropped++; }
+    void SetQueueDepth(uint32_t depth) { m_local.queue_depth = depth; }
+    void RecordPhaseLatency(CapturePhase phase, uint32_t micros) { AddSample(m_local.phase_latency[static_cast<size_t>(phase)], micros); }
+    void RecordFrameCost(uint32_t micros, bool overrun, uint32_t budget_us);
+    void RecordScreenshotSaved(uint32_t micros)
+    {
+      m_local.screenshots_saved++;
+      AddSample(m_local.screenshot_write_latency, micros);
+    }
+    void RecordScreenshotFailed() { m_local.screenshots_failed++; }
+    void RecordScreenshotUnconfirmed() { m_local.screenshots_unconfirmed++; }
+    void RecordScreenshotRetry() { m_local.screenshot_retries++; }
+    void RecordManualCapture(uint32_t micros)
+    {
+      m_local.manual_captures++;
+      AddSample(m_local.manual_capture_latency, micros);
+    }
+    void RecordManualCaptureIgnored() { m_local.manual_captures_ignored++; }
+    void RecordCaptureDeduplicated() { m_local.captures_deduplicated++; }
+    /** @brief Counts a checked screenshot under each of its `QualityFlags`. */
+    void RecordScreenshotQuality(uint8_t flags, bool retake);
+
+    /** @brief Copies the private block into the segment under the seqlock. */
+    void Publish();
+
+    /** @brief Read-only view of the accumulated (unpublished) metrics. */
+    const MetricsBlock &GetLocal() const { return m_local; }
+
+  private:
+    static void AddSample(MetricsHistogram &histogram, uint32_t micros);
+
+    MetricsBlock m_local;
+    MetricsBlock *m_shared = nullptr;
+    void *m_mapping = nullptr; ///< Platform mapping handle (Windows only).
+  };
+
+  /** @brief Maps the segment read-only and takes consistent snapshots of it. */
+  class SharedMetricsReader
+  {
+  public:
+    SharedMetricsReader() = default;
+    ~SharedMetricsReader() { Close(); }
+    SharedMetricsReader(const SharedMetricsReader &) = delete;
+    SharedMetricsReader &operator=(const SharedMetricsReader &) = delete;
+
+    /** @brief Opens an existing segment and validates its header. */
+    bool Open();
+    void Close();
+
+    /**
+     * @brief Copies a consistent snapshot of the block.
+     * @return false if no consistent copy could be taken within `max_attempts` tries.
+     */
+    bool Read(MetricsBlock &out, int max_attempts = 1000) const;
+
+  private:
+    const MetricsBlock *m_shared = nullptr;
+    void *m_mapping = nullptr;
+  };
+
+  /** @brief Returns the bucket index a sample falls into (see `MetricsHistogram`). */
+  size_t MetricsBucketIndex(uint32_t micros);
+
+} // namespace SPF_RedLightCamera
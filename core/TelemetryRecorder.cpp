@@ -0,0 +1,183 @@
+/**
+ * @file TelemetryRecorder.cpp
+ * @brief Implementation of the telemetry recording writer and reader.
+ */
+
+#include "TelemetryRecorder.hpp"
+
+#include <cstdlib>
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    // Large enough that a typical session only hits the disk every few seconds.
+    static constexpr size_t RECORDER_BUFFER_SIZE = 256 * 1024;
+
+    // Copies at most size - 1 bytes and always terminates, even when text fills its whole array.
+    static void CopyString(char *out, size_t size, const char *text)
+    {
+        const size_t length = ::strnlen(text, size - 1);
+        std::memcpy(out, text, length);
+        out[length] = '\0';
+    }
+
+    // =================================================================================================
+    // 1. TelemetryRecorder
+    // =================================================================================================
+
+    bool TelemetryRecorder::Open(const char *path)
+    {
+        Close();
+        if (!path)
+        {
+            return false;
+        }
+
+        m_file = std::fopen(path, "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+
+        m_buffer = static_cast<char *>(std::malloc(RECORDER_BUFFER_SIZE));
+        if (m_buffer)
+        {
+            std::setvbuf(m_file, m_buffer, _IOFBF, RECORDER_BUFFER_SIZE);
+        }
+
+        RecordingHeader header{};
+        std::memcpy(header.magic, RECORDING_MAGIC, sizeof(header.magic));
+        header.version = RECORDING_VERSION;
+        std::fwrite(&header, sizeof(header), 1, m_file);
+
+        m_recordCount = 0;
+        return true;
+    }
+
+    void TelemetryRecorder::Close()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+        // The buffer must outlive the stream, so it is only released after fclose.
+        std::free(m_buffer);
+        m_buffer = nullptr;
+    }
+
+    void TelemetryRecorder::WriteFrame(const SPF_TruckData &truck, const SPF_Timestamps &timestamps)
+    {
+        FrameRecord record{};
+        record.timestamps = timestamps;
+        record.world_placement = truck.world_placement;
+        record.local_linear_velocity = truck.local_linear_velocity;
+        record.local_linear_acceleration = truck.local_linear_acceleration;
+        record.speed = truck.speed;
+        WriteRecord(RecordType::Frame, &record, sizeof(record));
+    }
+
+    void TelemetryRecorder::WriteEvent(const char *event_id, const SPF_GameplayEvents *data)
+    {
+        if (!event_id)
+        {
+            return;
+        }
+
+        EventRecord record{};
+        CopyString(record.event_id, sizeof(record.event_id), event_id);
+        if (data && std::strcmp(event_id, "player.fined") == 0)
+        {
+            CopyString(record.fine_offence, sizeof(record.fine_offence), data->player_fined.fine_offence);
+            record.fine_amount = data->player_fined.fine_amount;
+        }
+        WriteRecord(RecordType::GameplayEvent, &record, sizeof(record));
+    }
+
+    void TelemetryRecorder::Flush()
+    {
+        if (m_file)
+        {
+            std::fflush(m_file);
+        }
+    }
+
+    void TelemetryRecorder::WriteRecord(RecordType type, const void *payload, size_t size)
+    {
+        if (!m_file)
+        {
+            return;
+        }
+
+        const uint8_t tag = static_cast<uint8_t>(type);
+        std::fwrite(&tag, sizeof(tag), 1, m_file);
+        std::fwrite(payload, size, 1, m_file);
+        m_recordCount++;
+    }
+
+    // =================================================================================================
+    // 2. TelemetryReader
+    // =================================================================================================
+
+    bool TelemetryReader::Open(const char *path)
+    {
+        Close();
+        if (!path)
+        {
+            return false;
+        }
+
+        m_file = std::fopen(path, "rb");
+        if (!m_file)
+        {
+            return false;
+        }
+
+        RecordingHeader header{};
+        if (std::fread(&header, sizeof(header), 1, m_file) != 1 ||
+            std::memcmp(header.magic, RECORDING_MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != RECORDING_VERSION)
+        {
+            Close();
+            return false;
+        }
+        return true;
+    }
+
+    void TelemetryReader::Close()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    bool TelemetryReader::Next(ReplayRecord &out)
+    {
+        if (!m_file)
+        {
+            return false;
+        }
+
+        uint8_t tag = 0;
+        if (std::fread(&tag, sizeof(tag), 1, m_file) != 1)
+        {
+            return false;
+        }
+
+        out.type = static_cast<RecordType>(tag);
+        switch (out.type)
+        {
+        case RecordType::Frame:
+            return std::fread(&out.frame, sizeof(out.frame), 1, m_file) == 1;
+        case RecordType::GameplayEvent:
+            return std::fread(&out.event, sizeof(out.event), 1, m_file) == 1;
+        default:
+            // Unknown tag: the rest of the file cannot be framed reliably.
+            return false;
+        }
+    }
+
+} // namespace SPF_RedLightCamera
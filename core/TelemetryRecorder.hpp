@@ -0,0 +1,136 @@
+/**
+ * @file TelemetryRecorder.hpp
+ * @brief Compact binary recording of the telemetry stream consumed by the plugin.
+ * @details A recording is a small file header followed by a flat sequence of tagged records.
+ * Each record is a one-byte `RecordType` tag followed by the packed payload for that type.
+ * Only the subset of `SPF_TruckData` the plugin actually reads is stored, which keeps an
+ * hour of driving at 60 FPS in the order of 20 MB.
+ *
+ * The same file is read back by the offline replay driver (`tools/replay`), which feeds it
+ * into the plugin through stand-in API tables to reproduce field reports deterministically.
+ */
+#pragma once
+
+#include <SPF_TelemetryData.h>
+
+#include <cstdint>
+#include <cstdio>
+
+namespace SPF_RedLightCamera
+{
+
+  // =================================================================================================
+  // 1. File Format
+  // =================================================================================================
+
+  /** @brief Magic bytes at the start of every recording ("RLCR"). */
+  constexpr char RECORDING_MAGIC[4] = {'R', 'L', 'C', 'R'};
+
+  /** @brief Format version. Bump whenever a payload layout changes. */
+  constexpr uint16_t RECORDING_VERSION = 1;
+
+  /** @brief Tag that precedes every record payload in the file. */
+  enum class RecordType : uint8_t
+  {
+    Frame = 1,        ///< One `FrameRecord`, written once per `OnUpdate`.
+    GameplayEvent = 2 ///< One `EventRecord`, written from `OnGameplayEvents`.
+  };
+
+#pragma pack(push, 1)
+  /** @brief Fixed header written once at the start of the file. */
+  struct RecordingHeader
+  {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+  };
+
+  /** @brief Per-frame telemetry snapshot (the `SPF_TruckData` subset used by the plugin). */
+  struct FrameRecord
+  {
+    SPF_Timestamps timestamps;
+    SPF_DPlacement world_placement;
+    SPF_FVector local_linear_velocity;
+    SPF_FVector local_linear_acceleration;
+    float speed;
+  };
+
+  /** @brief A gameplay event as delivered to `OnGameplayEvents`. */
+  struct EventRecord
+  {
+    char event_id[32];
+    char fine_offence[SPF_TELEMETRY_ID_MAX_SIZE];
+    int64_t fine_amount;
+  };
+#pragma pack(pop)
+
+  /** @brief A decoded record, as returned by `TelemetryReader::Next`. */
+  struct ReplayRecord
+  {
+    RecordType type = RecordType::Frame;
+    FrameRecord frame{};
+    EventRecord event{};
+  };
+
+  // =================================================================================================
+  // 2. Writer / Reader
+  // =================================================================================================
+
+  /**
+   * @brief Appends telemetry records to a recording file.
+   * @details Writes go through a large stdio buffer so the per-frame cost is a `memcpy`.
+   * The buffer is flushed explicitly via `Flush()` (e.g. when the plugin has spare frame time)
+   * and on `Close()`.
+   */
+  class TelemetryRecorder
+  {
+  public:
+    TelemetryRecorder() = default;
+    ~TelemetryRecorder() { Close(); }
+    TelemetryRecorder(const TelemetryRecorder &) = delete;
+    TelemetryRecorder &operator=(const TelemetryRecorder &) = delete;
+
+    /** @brief Creates (truncates) the file and writes the header. */
+    bool Open(const char *path);
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    void WriteFrame(const SPF_TruckData &truck, const SPF_Timestamps &timestamps);
+    void WriteEvent(const char *event_id, const SPF_GameplayEvents *data);
+    void Flush();
+
+    /** @brief Number of records written since `Open`. */
+    uint64_t GetRecordCount() const { return m_recordCount; }
+
+  private:
+    void WriteRecord(RecordType type, const void *payload, size_t size);
+
+    FILE *m_file = nullptr;
+    char *m_buffer = nullptr;
+    uint64_t m_recordCount = 0;
+  };
+
+  /** @brief Sequentially reads a recording produced by `TelemetryRecorder`. */
+  class TelemetryReader
+  {
+  public:
+    TelemetryReader() = default;
+    ~TelemetryReader() { Close(); }
+    TelemetryReader(const TelemetryReader &) = delete;
+    TelemetryReader &operator=(const TelemetryReader &) = delete;
+
+    /** @brief Opens the file and validates the header. */
+    bool Open(const char *path);
+    void Close();
+
+    /**
+     * @brief Reads the next record.
+     * @return false at end of file or on a truncated/unknown record.
+     */
+    bool Next(ReplayRecord &out);
+
+  private:
+    FILE *m_file = nullptr;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,340 @@
+/**
+ * @file TrackExport.cpp
+ * @brief Implementation of the GeoJSON/GPX track export.
+ */
+
+#include "TrackExport.hpp"
+
+#include <cstdarg>
+#include <cstring>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        double Longitude(const SPF_DVector &position) { return position.x / TRACK_METRES_PER_DEGREE; }
+        double Latitude(const SPF_DVector &position) { return -position.z / TRACK_METRES_PER_DEGREE; }
+
+        // Squared distance from p to the segment a-b.
+        double SegmentDistanceSquared(const SPF_DVector &p, const SPF_DVector &a, const SPF_DVector &b)
+        {
+            const double abx = b.x - a.x, aby = b.y - a.y, abz = b.z - a.z;
+            double apx = p.x - a.x, apy = p.y - a.y, apz = p.z - a.z;
+            const double length_squared = abx * abx + aby * aby + abz * abz;
+            if (length_squared > 0.0)
+            {
+                double t = (apx * abx + apy * aby + apz * abz) / length_squared;
+                t = t < 0.0 ? 0.0 : (t > 1.0 ? 1.0 : t);
+                apx -= t * abx;
+                apy -= t * aby;
+                apz -= t * abz;
+            }
+            return apx * apx + apy * apy + apz * apz;
+        }
+
+        bool ReplaceFile(const char *temp_path, const char *path)
+        {
+#ifdef _WIN32
+            return MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            return std::rename(temp_path, path) == 0;
+#endif
+        }
+    } // namespace
+
+    size_t DecimateTrack(const HistoryRecord *points, size_t count, double tolerance, uint8_t *keep, uint32_t *stack)
+    {
+        if (count < 3 || tolerance <= 0.0)
+        {
+            std::memset(keep, 1, count);
+            return count;
+        }
+        std::memset(keep, 0, count);
+        keep[0] = 1;
+        keep[count - 1] = 1;
+        size_t kept = 2;
+
+        // Every pending span ends at a kept point, so at most `count` spans are pending.
+        const double tolerance_squared = tolerance * tolerance;
+        size_t top = 0;
+        stack[top++] = 0;
+        stack[top++] = (uint32_t)(count - 1);
+        while (top != 0)
+        {
+            const uint32_t last = stack[--top];
+            const uint32_t first = stack[--top];
+            const SPF_DVector &a = points[first].position;
+            const SPF_DVector &b = points[last].position;
+            double farthest = tolerance_squared;
+            uint32_t split = 0;
+            for (uint32_t i = first + 1; i < last; ++i)
+            {
+                const double distance = SegmentDistanceSquared(points[i].position, a, b);
+                if (distance > farthest)
+                {
+                    farthest = distance;
+                    split = i;
+                }
+            }
+            if (split != 0)
+            {
+                keep[split] = 1;
+                ++kept;
+                stack[top++] = first;
+                stack[top++] = split;
+                stack[top++] = split;
+                stack[top++] = last;
+            }
+        }
+        return kept;
+    }
+
+    // =================================================================================================
+    // 1. Writer
+    // =================================================================================================
+
+    bool TrackWriter::Open(const char *path, TrackFormat format)
+    {
+        Close();
+        m_file = std::fopen(path, "wb");
+        if (!m_file)
+        {
+            return false;
+        }
+        std::setvbuf(m_file, m_buffer, _IOFBF, sizeof(m_buffer));
+        m_format = format;
+        m_tracks = 0;
+        m_bytes = 0;
+        m_failed = false;
+        if (m_format == TrackFormat::Gpx)
+        {
+            Print("<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                  "<gpx version=\"1.1\" creator=\"SPF_RedLightCamera\" xmlns=\"http://www.topografix.com/GPX/1/1\">\n");
+        }
+        else
+        {
+            Print("{\"type\":\"FeatureCollection\",\"features\":[");
+        }
+        return !m_failed;
+    }
+
+    bool TrackWriter::Close()
+    {
+        if (!m_file)
+        {
+            return false;
+        }
+        Print(m_format == TrackFormat::Gpx ? "</gpx>\n" : "\n]}\n");
+        const bool ok = std::fclose(m_file) == 0 && !m_failed;
+        m_file = nullptr;
+        return ok;
+    }
+
+    void TrackWriter::Print(const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        const int written = std::vfprintf(m_file, format, args);
+        va_end(args);
+        if (written < 0)
+        {
+            m_failed = true;
+            return;
+        }
+        m_bytes += (uint64_t)written;
+    }
+
+    bool TrackWriter::WriteTrack(const HistoryRecord *points, size_t count, const uint8_t *keep)
+    {
+        if (!m_file || count == 0)
+        {
+            return false;
+        }
+        ++m_tracks;
+        if (m_format == TrackFormat::Gpx)
+        {
+            WriteGpx(points, count, keep);
+        }
+        else
+        {
+            WriteGeoJson(points, count, keep);
+        }
+        return !m_failed;
+    }
+
+    void TrackWriter::WriteGeoJson(const HistoryRecord *points, size_t count, const uint8_t *keep)
+    {
+        const HistoryRecord &fine = points[count - 1];
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i)
+        {
+            kept += keep[i];
+        }
+
+        // A LineString needs two positions; a fine with no samples before it is only a point.
+        if (kept >= 2)
+        {
+            Print("%s\n{\"type\":\"Feature\",\"geometry\":{\"type\":\"LineString\",\"coordinates\":[", m_tracks == 1 ? "" : ",");
+            const char *separator = "";
+            for (size_t i = 0; i < count; ++i)
+            {
+                if (keep[i])
+                {
+                    Print("%s[%.7f,%.7f,%.2f]", separator, Longitude(points[i].position), Latitude(points[i].position), points[i].position.y);
+                    separator = ",";
+                }
+            }
+            Print("]},\"properties\":{\"fine\":%llu,\"role\":\"path\",\"start_time_us\":%llu,\"time_us\":%llu,\"points\":%zu,\"raw_points\":%zu}},",
+                  (unsigned long long)m_tracks, (unsigned long long)points[0].time_us, (unsigned long long)fine.time_us, kept, count);
+        }
+        else
+        {
+            Print("%s", m_tracks == 1 ? "" : ",");
+        }
+        Print("\n{\"type\":\"Feature\",\"geometry\":{\"type\":\"Point\",\"coordinates\":[%.7f,%.7f,%.2f]},"
+              "\"properties\":{\"fine\":%llu,\"role\":\"violation\",\"time_us\":%llu,\"x\":%.2f,\"y\":%.2f,\"z\":%.2f,\"heading\":%.5f,\"speed\":%.2f}}",
+              Longitude(fine.position), Latitude(fine.position), fine.position.y, (unsigned long long)m_tracks, (unsigned long long)fine.time_us,
+              fine.position.x, fine.position.y, fine.position.z, fine.heading, fine.speed);
+    }
+
+    void TrackWriter::WriteGpx(const HistoryRecord *points, size_t count, const uint8_t *keep)
+    {
+        const HistoryRecord &fine = points[count - 1];
+        Print("<trk><name>Red light fine %llu</name><desc>time_us=%llu speed=%.2f m/s x=%.2f y=%.2f z=%.2f</desc><type>red_light_fine</type><trkseg>\n",
+              (unsigned long long)m_tracks, (unsigned long long)fine.time_us, fine.speed, fine.position.x, fine.position.y, fine.position.z);
+        for (size_t i = 0; i + 1 < count; ++i)
+        {
+            if (keep[i])
+            {
+                Print("<trkpt lat=\"%.7f\" lon=\"%.7f\"><ele>%.2f</ele></trkpt>\n", Latitude(points[i].position), Longitude(points[i].position),
+                      points[i].position.y);
+            }
+        }
+        Print("<trkpt lat=\"%.7f\" lon=\"%.7f\"><ele>%.2f</ele><name>Red light fine</name></trkpt>\n</trkseg></trk>\n", Latitude(fine.position),
+              Longitude(fine.position), fine.position.y);
+    }
+
+    // =================================================================================================
+    // 2. Export Job
+    // =================================================================================================
+
+    namespace
+    {
+        // Everything the export needs, allocated once: it is too large for a worker's stack.
+        struct TrackExportState
+        {
+            uint32_t sequences[HISTORY_MAX_SEGMENTS];
+            HistoryRecord ring[TRACK_WINDOW_POINTS];
+            HistoryRecord path[TRACK_WINDOW_POINTS + 1];
+            uint8_t keep[TRACK_WINDOW_POINTS + 1];
+            uint32_t stack[2 * (TRACK_WINDOW_POINTS + 1)];
+            HistoryReader reader;
+            TrackWriter writer;
+        };
+    } // namespace
+
+    TrackExportResult ExportTracks(const char *directory, const char *out_path, const TrackExportOptions &options)
+    {
+        TrackExportResult result;
+        char temp_path[HISTORY_PATH_SIZE + 8];
+        if (!directory || !out_path || std::snprintf(temp_path, sizeof(temp_path), "%s.tmp", out_path) >= (int)sizeof(temp_path))
+        {
+            return result;
+        }
+
+        const std::unique_ptr<TrackExportState> state(new TrackExportState());
+        TrackWriter &writer = state->writer;
+        if (!writer.Open(temp_path, options.format))
+        {
+            std::remove(temp_path);
+            return result;
+        }
+
+        const uint64_t window_us = options.window_s > 0.0 ? (uint64_t)(options.window_s * 1e6) : 0;
+        const size_t count = ListHistorySegments(directory, state->sequences, HISTORY_MAX_SEGMENTS);
+        size_t ring_head = 0; // Oldest sample.
+        size_t ring_count = 0;
+        uint64_t last_time = 0;
+        uint32_t covered = 0;
+        bool ok = true;
+        for (size_t s = 0; s < count && ok; ++s)
+        {
+            // Leftovers of an interrupted merge repeat records a merged segment already holds.
+            const uint32_t sequence = state->sequences[s];
+            char path[HISTORY_PATH_SIZE];
+            if (sequence <= covered || !FormatHistorySegmentPath(path, sizeof(path), directory, sequence))
+            {
+                continue;
+            }
+            HistoryReader &reader = state->reader;
+            if (!reader.Open(path))
+            {
+                result.damaged = true;
+                continue;
+            }
+            covered = reader.GetLastSequence() > sequence ? reader.GetLastSequence() : sequence;
+            result.segments++;
+
+            HistoryRecord record;
+            while (ok && reader.Next(record))
+            {
+                result.records++;
+                if (record.time_us < last_time)
+                {
+                    ring_count = 0; // A new session: its clock started again.
+                }
+                last_time = record.time_us;
+
+                if (record.kind == HistoryKind::RedLightFine)
+                {
+                    // Freeze the window: the samples back to `window_s` before the fine, then the fine.
+                    size_t first = ring_count;
+                    while (first != 0 && record.time_us - state->ring[(ring_head + first - 1) % TRACK_WINDOW_POINTS].time_us <= window_us)
+                    {
+                        --first;
+                    }
+                    size_t points = 0;
+                    for (size_t i = first; i < ring_count; ++i)
+                    {
+                        state->path[points++] = state->ring[(ring_head + i) % TRACK_WINDOW_POINTS];
+                    }
+                    state->path[points++] = record;
+                    const size_t kept = DecimateTrack(state->path, points, options.tolerance_m, state->keep, state->stack);
+                    ok = writer.WriteTrack(state->path, points, state->keep);
+                    result.points_in += points;
+                    result.points_out += kept;
+                }
+
+                // Fines are positions on the path too.
+                if (ring_count == TRACK_WINDOW_POINTS)
+                {
+                    ring_head = (ring_head + 1) % TRACK_WINDOW_POINTS;
+                    --ring_count;
+                }
+                state->ring[(ring_head + ring_count) % TRACK_WINDOW_POINTS] = record;
+                ++ring_count;
+            }
+            result.damaged = result.damaged || reader.IsDamaged();
+            reader.Close();
+        }
+
+        result.tracks = writer.GetTrackCount();
+        ok = writer.Close() && ok;
+        result.bytes = writer.GetBytesWritten();
+        result.ok = ok && ReplaceFile(temp_path, out_path);
+        if (!result.ok)
+        {
+            std::remove(temp_path);
+        }
+        return result;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,123 @@
+/**
+ * @file TrackExport.hpp
+ * @brief Streams the path the truck drove before each red light fine to GeoJSON or GPX.
+ * @details The source is the capture history (see HistoryStore.hpp): its periodic samples are the
+ * path and its `RedLightFine` records the violations. The exporter reads the segments in order and
+ * keeps the samples of the last `window_s` seconds in a ring. At each fine that window is frozen,
+ * the fine's own position appended as its last point, and the path decimated with Douglas-Peucker
+ * before it is written, so a session with thousands of fines stays small.
+ *
+ * - GeoJSON: a FeatureCollection with two features per fine, the path (LineString) and the
+ *   violation (Point), linked by their `fine` property.
+ * - GPX 1.1: one track per fine. Its last track point is the violation, named "Red light fine".
+ *
+ * Both formats are written as the segments are read, feature by feature, with no document held in
+ * memory. They need longitude and latitude, so game metres are laid out on a flat map around
+ * 0 N 0 E: east is +x, north is -z, one degree is `TRACK_METRES_PER_DEGREE`. Shapes and distances
+ * are preserved; the positions are not real-world places. The game coordinates are kept in the
+ * GeoJSON properties.
+ */
+#pragma once
+
+#include "HistoryStore.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t TRACK_WINDOW_POINTS = 8192; ///< Samples kept before a fine; older ones are cut from the path.
+  constexpr double TRACK_METRES_PER_DEGREE = 111319.49;
+
+  enum class TrackFormat : uint8_t
+  {
+    GeoJson = 0,
+    Gpx = 1,
+    Count
+  };
+
+  struct TrackExportOptions
+  {
+    TrackFormat format = TrackFormat::GeoJson;
+    double tolerance_m = 2.0; ///< Douglas-Peucker tolerance; 0 keeps every point.
+    double window_s = 30.0;   ///< Driving before the fine that is exported.
+  };
+
+  /**
+   * @brief Marks the points Douglas-Peucker keeps, measuring the distance to the segment (not the
+   *        line) in 3D. The first and last points are always kept.
+   * @param keep Receives one flag per point.
+   * @param stack Scratch space for `2 * count` entries; the recursion is iterative.
+   * @return Number of points kept.
+   */
+  size_t DecimateTrack(const HistoryRecord *points, size_t count, double tolerance, uint8_t *keep, uint32_t *stack);
+
+  // =================================================================================================
+  // 1. Writer
+  // =================================================================================================
+
+  /** @brief Writes fines and their paths as they come, in either format. */
+  class TrackWriter
+  {
+  public:
+    TrackWriter() = default;
+    ~TrackWriter() { Close(); }
+    TrackWriter(const TrackWriter &) = delete;
+    TrackWriter &operator=(const TrackWriter &) = delete;
+
+    /** @brief Creates `path` and writes the document's opening. */
+    bool Open(const char *path, TrackFormat format);
+
+    /** @brief Writes the document's closing and closes the file. */
+    bool Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    /**
+     * @brief Writes one fine.
+     * @param points The path, oldest first; the last point is the fine.
+     * @param keep Points of the path to write (see `DecimateTrack`).
+     */
+    bool WriteTrack(const HistoryRecord *points, size_t count, const uint8_t *keep);
+
+    uint64_t GetTrackCount() const { return m_tracks; }
+    uint64_t GetBytesWritten() const { return m_bytes; }
+
+  private:
+    void Print(const char *format, ...);
+    void WriteGeoJson(const HistoryRecord *points, size_t count, const uint8_t *keep);
+    void WriteGpx(const HistoryRecord *points, size_t count, const uint8_t *keep);
+
+    FILE *m_file = nullptr;
+    TrackFormat m_format = TrackFormat::GeoJson;
+    uint64_t m_tracks = 0;
+    uint64_t m_bytes = 0;
+    bool m_failed = false;
+    char m_buffer[64 * 1024];
+  };
+
+  // =================================================================================================
+  // 2. Export Job
+  // =================================================================================================
+
+  struct TrackExportResult
+  {
+    uint64_t tracks = 0;
+    uint64_t points_in = 0;  ///< Path points before decimation, fines included.
+    uint64_t points_out = 0; ///< ... and after.
+    uint64_t records = 0;    ///< History records read.
+    uint64_t bytes = 0;
+    uint32_t segments = 0;
+    bool damaged = false; ///< A segment ended in a torn block (normal for the one being written).
+    bool ok = false;      ///< The file was written and moved into place.
+  };
+
+  /**
+   * @brief Exports every red light fine in the history segments of `directory` to `out_path`,
+   *        through a temporary file.
+   * @details Run it while no maintenance runs on the same directory: a merge deletes segments.
+   */
+  TrackExportResult ExportTracks(const char *directory, const char *out_path, const TrackExportOptions &options);
+
+} // namespace SPF_RedLightCamera
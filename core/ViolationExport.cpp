@@ -0,0 +1,662 @@
+/**
+ * @file ViolationExport.cpp
+ * @brief Implementation of the Arrow IPC violation export.
+ * @details The Arrow metadata is a FlatBuffer (Message.fbs, Schema.fbs). Rather than depend on the
+ * FlatBuffers library for two small messages, `FlatWriter` lays them out directly: front to back,
+ * each table right after its vtable, children after their parent so every offset points forward,
+ * and every scalar at its natural alignment, which is what the Arrow readers verify.
+ */
+
+#include "ViolationExport.hpp"
+
+#include <cstring>
+#include <memory>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        // -------------------------------------------------------------------------------------------
+        // FlatBuffers
+        // -------------------------------------------------------------------------------------------
+
+        constexpr size_t METADATA_CAPACITY = 4096;
+
+        /** @brief A table field: its id in the schema, inline size (1, 2, 4 or 8) and value. An offset is a 4-byte field patched later. */
+        struct FlatSlot
+        {
+            uint16_t id;
+            uint8_t size;
+            uint64_t value;
+        };
+
+        class FlatWriter
+        {
+        public:
+            explicit FlatWriter(uint8_t *buffer) : m_buffer(buffer) {}
+
+            size_t Pos() const { return m_size; }
+            bool Ok() const { return !m_overflow; }
+
+            void Put(const void *data, size_t size)
+            {
+                if (m_size + size > METADATA_CAPACITY)
+                {
+                    m_overflow = true;
+                    return;
+                }
+                std::memcpy(m_buffer + m_size, data, size);
+                m_size += size;
+            }
+
+            template <typename T> void Put(T value) { Put(&value, sizeof(value)); }
+
+            void Align(size_t alignment)
+            {
+                static const uint8_t zeros[8] = {};
+                Put(zeros, (alignment - m_size % alignment) % alignment);
+            }
+
+            /** @brief Points the offset field at `at` to `target`, which must come after it. */
+            void Patch(size_t at, size_t target)
+            {
+                if (!m_overflow)
+                {
+                    const uint32_t offset = (uint32_t)(target - at);
+                    std::memcpy(m_buffer + at, &offset, sizeof(offset));
+                }
+            }
+
+            /**
+             * @brief Writes a vtable and its table. Fields go in decreasing size after the vtable
+             *        offset, so each lands on its natural alignment.
+             * @param positions Receives the position of each field by id (for patching offsets).
+             */
+            size_t Table(const FlatSlot *slots, size_t count, size_t *positions = nullptr)
+            {
+                uint16_t field_offsets[16] = {};
+                size_t slot_count = 0;
+                uint16_t inline_size = 4;
+                for (const size_t size : {8, 4, 2, 1})
+                {
+                    for (size_t i = 0; i < count; ++i)
+                    {
+                        if (slots[i].size != size)
+                        {
+                            continue;
+                        }
+                        inline_size = (uint16_t)((inline_size + size - 1) / size * size);
+                        field_offsets[slots[i].id] = inline_size;
+                        inline_size = (uint16_t)(inline_size + size);
+                        slot_count = slots[i].id + 1u > slot_count ? slots[i].id + 1u : slot_count;
+                    }
+                }
+
+                Align(2);
+                const size_t vtable = m_size;
+                Put((uint16_t)(4 + 2 * slot_count));
+                Put(inline_size);
+                Put(field_offsets, 2 * slot_count);
+                Align(8);
+                const size_t table = m_size;
+                Put((int32_t)(table - vtable));
+                while (m_size < table + inline_size)
+                {
+                    Put((uint8_t)0);
+                }
+                for (size_t i = 0; i < count && !m_overflow; ++i)
+                {
+                    const size_t at = table + field_offsets[slots[i].id];
+                    std::memcpy(m_buffer + at, &slots[i].value, slots[i].size); // Little-endian.
+                    if (positions)
+                    {
+                        positions[slots[i].id] = at;
+                    }
+                }
+                return table;
+            }
+
+            /**
+             * @brief Writes the length of a vector of `count` elements of `element_size` bytes; the
+             *        caller writes the elements. Returns the vector's position (its length field).
+             */
+            size_t Vector(uint32_t count, size_t element_size)
+            {
+                // The length sits right before the elements, which need their natural alignment.
+                Align(4);
+                if (element_size > 4 && m_size % 8 == 0)
+                {
+                    Put((uint32_t)0);
+                }
+                const size_t at = m_size;
+                Put(count);
+                return at;
+            }
+
+            size_t String(const char *text)
+            {
+                const size_t length = std::strlen(text);
+                const size_t at = Vector((uint32_t)length, 1);
+                Put(text, length + 1);
+                return at;
+            }
+
+        private:
+            uint8_t *m_buffer;
+            size_t m_size = 0;
+            bool m_overflow = false;
+        };
+
+        // -------------------------------------------------------------------------------------------
+        // Arrow schema
+        // -------------------------------------------------------------------------------------------
+
+        constexpr int16_t METADATA_V5 = 4;
+        constexpr uint8_t HEADER_SCHEMA = 1;
+        constexpr uint8_t HEADER_RECORD_BATCH = 3;
+        constexpr uint8_t TYPE_INT = 2;
+        constexpr uint8_t TYPE_FLOATING_POINT = 3;
+        constexpr uint8_t TYPE_UTF8 = 5;
+        constexpr int16_t PRECISION_SINGLE = 1;
+        constexpr int16_t PRECISION_DOUBLE = 2;
+
+        enum class ColumnType : uint8_t
+        {
+            Int64,
+            Float32,
+            Float64,
+            Utf8
+        };
+
+        struct ColumnSpec
+        {
+            const char *name;
+            ColumnType type;
+            bool nullable;
+        };
+
+        // Must match the order of the column data in `WriteBatch`.
+        constexpr ColumnSpec COLUMNS[] = {
+            {"time_us", ColumnType::Int64, false},  {"x", ColumnType::Float64, false},        {"y", ColumnType::Float64, false},
+            {"z", ColumnType::Float64, false},      {"heading", ColumnType::Float64, false},  {"speed", ColumnType::Float32, false},
+            {"offence", ColumnType::Utf8, false},   {"fine_amount", ColumnType::Int64, false}, {"capture", ColumnType::Utf8, false},
+            {"truck_id", ColumnType::Utf8, false},  {"plate", ColumnType::Utf8, false},       {"screenshot", ColumnType::Utf8, true},
+        };
+        constexpr size_t COLUMN_COUNT = sizeof(COLUMNS) / sizeof(COLUMNS[0]);
+        constexpr size_t MAX_BUFFERS = 3 * COLUMN_COUNT;
+
+        const char *CAPTURE_NAMES[] = {"none", "started", "queued", "attached", "dropped"};
+        static_assert(sizeof(CAPTURE_NAMES) / sizeof(CAPTURE_NAMES[0]) == static_cast<size_t>(JournalFineCapture::Count), "Capture name table out of date.");
+
+        /** @brief Writes the Message table around a header; returns the position of the header offset. */
+        size_t WriteMessageTable(FlatWriter &writer, uint8_t header_type, uint64_t body_length)
+        {
+            writer.Put((uint32_t)0); // Root offset.
+            const FlatSlot message[] = {{0, 2, (uint16_t)METADATA_V5}, {1, 1, header_type}, {2, 4, 0}, {3, 8, body_length}};
+            size_t positions[4];
+            const size_t table = writer.Table(message, 4, positions);
+            writer.Patch(0, table);
+            return positions[2];
+        }
+
+        size_t BuildSchema(uint8_t *buffer)
+        {
+            FlatWriter writer(buffer);
+            const size_t header = WriteMessageTable(writer, HEADER_SCHEMA, 0);
+
+            size_t positions[2];
+            const FlatSlot schema[] = {{0, 2, 0}, {1, 4, 0}}; // Little-endian, fields.
+            writer.Patch(header, writer.Table(schema, 2, positions));
+
+            writer.Patch(positions[1], writer.Vector(COLUMN_COUNT, 4));
+            const size_t field_offsets = writer.Pos();
+            for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            {
+                writer.Put((uint32_t)0);
+            }
+
+            for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            {
+                const ColumnSpec &column = COLUMNS[i];
+                const uint8_t type = column.type == ColumnType::Utf8 ? TYPE_UTF8 : (column.type == ColumnType::Int64 ? TYPE_INT : TYPE_FLOATING_POINT);
+
+                // name, nullable, type_type, type, children.
+                const FlatSlot field[] = {{0, 4, 0}, {1, 1, column.nullable ? 1u : 0u}, {2, 1, type}, {3, 4, 0}, {5, 4, 0}};
+                size_t field_positions[6];
+                writer.Patch(field_offsets + 4 * i, writer.Table(field, 5, field_positions));
+                writer.Patch(field_positions[0], writer.String(column.name));
+
+                size_t type_table;
+                if (column.type == ColumnType::Int64)
+                {
+                    const FlatSlot int_type[] = {{0, 4, 64}, {1, 1, 1}}; // bitWidth, is_signed.
+                    type_table = writer.Table(int_type, 2);
+                }
+                else if (column.type == ColumnType::Utf8)
+                {
+                    type_table = writer.Table(nullptr, 0);
+                }
+                else
+                {
+                    const FlatSlot float_type[] = {{0, 2, (uint16_t)(column.type == ColumnType::Float32 ? PRECISION_SINGLE : PRECISION_DOUBLE)}};
+                    type_table = writer.Table(float_type, 1);
+                }
+                writer.Patch(field_positions[3], type_table);
+                writer.Patch(field_positions[5], writer.Vector(0, 4));
+            }
+            writer.Align(8);
+            return writer.Ok() ? writer.Pos() : 0;
+        }
+
+        struct BufferSpan
+        {
+            const void *data;
+            size_t size;
+        };
+
+        /** @brief Writes a RecordBatch message: the body is `buffers`, each padded to 8 bytes. */
+        size_t BuildRecordBatch(uint8_t *buffer, uint64_t rows, const uint64_t *null_counts, const BufferSpan *buffers, size_t buffer_count, uint64_t &body_length)
+        {
+            body_length = 0;
+            for (size_t i = 0; i < buffer_count; ++i)
+            {
+                body_length += (buffers[i].size + 7) / 8 * 8;
+            }
+
+            FlatWriter writer(buffer);
+            const size_t header = WriteMessageTable(writer, HEADER_RECORD_BATCH, body_length);
+
+            size_t positions[3];
+            const FlatSlot batch[] = {{0, 8, rows}, {1, 4, 0}, {2, 4, 0}}; // length, nodes, buffers.
+            writer.Patch(header, writer.Table(batch, 3, positions));
+
+            writer.Patch(positions[1], writer.Vector(COLUMN_COUNT, 16));
+            for (size_t i = 0; i < COLUMN_COUNT; ++i)
+            {
+                writer.Put((int64_t)rows);
+                writer.Put((int64_t)null_counts[i]);
+            }
+
+            writer.Patch(positions[2], writer.Vector((uint32_t)buffer_count, 16));
+            uint64_t offset = 0;
+            for (size_t i = 0; i < buffer_count; ++i)
+            {
+                writer.Put((int64_t)offset);
+                writer.Put((int64_t)buffers[i].size);
+                offset += (buffers[i].size + 7) / 8 * 8;
+            }
+            writer.Align(8);
+            return writer.Ok() ? writer.Pos() : 0;
+        }
+
+        void CopyString(char *out, size_t size, const char *text, size_t text_size)
+        {
+            const size_t length = ::strnlen(text, text_size < size ? text_size : size - 1);
+            std::memcpy(out, text, length);
+            out[length] = '\0';
+        }
+
+        bool ReplaceFile(const char *temp_path, const char *path)
+        {
+#ifdef _WIN32
+            return MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            return std::rename(temp_path, path) == 0;
+#endif
+        }
+    } // namespace
+
+    const char *FineCaptureName(JournalFineCapture capture)
+    {
+        return capture < JournalFineCapture::Count ? CAPTURE_NAMES[static_cast<size_t>(capture)] : "unknown";
+    }
+
+    // =================================================================================================
+    // 1. Arrow Writer
+    // =================================================================================================
+
+    bool ViolationArrowWriter::Open(const char *path)
+    {
+        Close();
+        m_file = path ? std::fopen(path, "wb") : nullptr;
+        if (!m_file)
+        {
+            return false;
+        }
+        m_failed = false;
+        m_rows = 0;
+        m_rowCount = m_batchCount = m_bytesWritten = 0;
+        m_screenshotNulls = 0;
+        for (StringColumn &column : m_strings)
+        {
+            column.offsets[0] = 0;
+        }
+        return WriteSchema();
+    }
+
+    bool ViolationArrowWriter::Close()
+    {
+        if (!m_file)
+        {
+            return false;
+        }
+        const uint32_t end_of_stream[2] = {0xFFFFFFFFu, 0};
+        const bool ok = (m_rows == 0 || WriteBatch()) && WriteBytes(end_of_stream, sizeof(end_of_stream)) && std::fflush(m_file) == 0 && !m_failed;
+        std::fclose(m_file);
+        m_file = nullptr;
+        return ok;
+    }
+
+    bool ViolationArrowWriter::WriteBytes(const void *data, size_t size)
+    {
+        if (m_failed || (size && std::fwrite(data, 1, size, m_file) != size))
+        {
+            m_failed = true;
+            return false;
+        }
+        m_bytesWritten += size;
+        return true;
+    }
+
+    bool ViolationArrowWriter::WriteMessage(const uint8_t *metadata, size_t size)
+    {
+        // Continuation marker, then the metadata length (padded so the body starts 8-aligned).
+        const uint32_t prefix[2] = {0xFFFFFFFFu, (uint32_t)size};
+        return size != 0 && WriteBytes(prefix, sizeof(prefix)) && WriteBytes(metadata, size);
+    }
+
+    bool ViolationArrowWriter::WriteSchema()
+    {
+        uint8_t metadata[METADATA_CAPACITY];
+        return WriteMessage(metadata, BuildSchema(metadata));
+    }
+
+    bool ViolationArrowWriter::Append(const ViolationRow &row)
+    {
+        if (!m_file || m_failed)
+        {
+            return false;
+        }
+
+        const char *strings[STRING_COLUMNS] = {row.offence, FineCaptureName(row.capture), row.truck_id, row.plate, row.screenshot};
+        const size_t limits[STRING_COLUMNS] = {sizeof(row.offence), SIZE_MAX, sizeof(row.truck_id), sizeof(row.plate), sizeof(row.screenshot)};
+        size_t lengths[STRING_COLUMNS];
+        bool fits = m_rows < VIOLATION_BATCH_ROWS;
+        for (size_t i = 0; i < STRING_COLUMNS; ++i)
+        {
+            lengths[i] = ::strnlen(strings[i], limits[i]);
+            fits = fits && (size_t)m_strings[i].offsets[m_rows] + lengths[i] <= VIOLATION_BATCH_STRING_BYTES;
+        }
+        if (!fits && !WriteBatch())
+        {
+            return false;
+        }
+
+        const size_t i = m_rows;
+        m_time[i] = (int64_t)row.time_us;
+        m_x[i] = row.x;
+        m_y[i] = row.y;
+        m_z[i] = row.z;
+        m_heading[i] = row.heading;
+        m_speed[i] = row.speed;
+        m_amount[i] = row.fine_amount;
+        for (size_t c = 0; c < STRING_COLUMNS; ++c)
+        {
+            StringColumn &column = m_strings[c];
+            std::memcpy(column.data + column.offsets[i], strings[c], lengths[c]);
+            column.offsets[i + 1] = column.offsets[i] + (int32_t)lengths[c];
+        }
+
+        // Validity bitmap, least significant bit first; an empty path is null.
+        const uint8_t bit = (uint8_t)(1u << (i % 8));
+        if (i % 8 == 0)
+        {
+            m_screenshotValid[i / 8] = 0;
+        }
+        if (lengths[STRING_COLUMNS - 1] != 0)
+        {
+            m_screenshotValid[i / 8] |= bit;
+        }
+        else
+        {
+            ++m_screenshotNulls;
+        }
+
+        ++m_rows;
+        ++m_rowCount;
+        return true;
+    }
+
+    bool ViolationArrowWriter::WriteBatch()
+    {
+        const size_t rows = m_rows;
+        BufferSpan buffers[MAX_BUFFERS];
+        uint64_t null_counts[COLUMN_COUNT] = {};
+        size_t buffer_count = 0;
+
+        const void *fixed[] = {m_time, m_x, m_y, m_z, m_heading, m_speed, nullptr, m_amount};
+        size_t next_string = 0;
+        for (size_t c = 0; c < COLUMN_COUNT; ++c)
+        {
+            const ColumnSpec &column = COLUMNS[c];
+            // Validity first; zero length means "all valid".
+            const bool has_nulls = column.nullable && m_screenshotNulls != 0;
+            null_counts[c] = has_nulls ? m_screenshotNulls : 0;
+            buffers[buffer_count++] = {m_screenshotValid, has_nulls ? (rows + 7) / 8 : 0};
+            if (column.type == ColumnType::Utf8)
+            {
+                const StringColumn &strings = m_strings[next_string++];
+                buffers[buffer_count++] = {strings.offsets, (rows + 1) * sizeof(int32_t)};
+                buffers[buffer_count++] = {strings.data, (size_t)strings.offsets[rows]};
+            }
+            else
+            {
+                buffers[buffer_count++] = {fixed[c], rows * (column.type == ColumnType::Float32 ? sizeof(float) : sizeof(int64_t))};
+            }
+        }
+
+        uint8_t metadata[METADATA_CAPACITY];
+        uint64_t body_length = 0;
+        if (!WriteMessage(metadata, BuildRecordBatch(metadata, rows, null_counts, buffers, buffer_count, body_length)))
+        {
+            m_failed = true;
+            return false;
+        }
+        static const uint8_t padding[8] = {};
+        for (size_t i = 0; i < buffer_count; ++i)
+        {
+            if (!WriteBytes(buffers[i].data, buffers[i].size) || !WriteBytes(padding, (8 - buffers[i].size % 8) % 8))
+            {
+                return false;
+            }
+        }
+
+        m_rows = 0;
+        m_screenshotNulls = 0;
+        ++m_batchCount;
+        return true;
+    }
+
+    // =================================================================================================
+    // 2. Journal Scanner
+    // =================================================================================================
+
+    bool ViolationJournalScanner::Open(const char *journal_path, const char *screenshot_dir)
+    {
+        m_head = m_count = 0;
+        m_linkNext = 0;
+        m_records = 0;
+        m_end = false;
+        std::memset(m_links, 0, sizeof(m_links));
+        CopyString(m_screenshotDir, sizeof(m_screenshotDir), screenshot_dir ? screenshot_dir : "", sizeof(m_screenshotDir));
+        return m_reader.Open(journal_path);
+    }
+
+    void ViolationJournalScanner::SetScreenshot(ViolationRow &row, const char *name) const
+    {
+        if (!name[0])
+        {
+            return;
+        }
+        // The journal keeps the name the screenshot command was given; the game saves it as PNG.
+        const int length = m_screenshotDir[0] ? std::snprintf(row.screenshot, sizeof(row.screenshot), "%s/%.*s.png", m_screenshotDir, (int)SCREENSHOT_NAME_SIZE, name)
+                                              : std::snprintf(row.screenshot, sizeof(row.screenshot), "%.*s.png", (int)SCREENSHOT_NAME_SIZE, name);
+        if (length < 0 || (size_t)length >= sizeof(row.screenshot))
+        {
+            row.screenshot[0] = '\0'; // A cut path would name the wrong file.
+        }
+    }
+
+    bool ViolationJournalScanner::ReadRecord()
+    {
+        uint8_t payload[JOURNAL_MAX_PAYLOAD];
+        JournalRecordType type;
+        size_t size = 0;
+        if (!m_reader.Next(type, payload, size))
+        {
+            return false;
+        }
+        ++m_records;
+
+        if (type == JournalRecordType::Fine && size == sizeof(JournalFine))
+        {
+            JournalFine fine;
+            std::memcpy(&fine, payload, sizeof(fine));
+            Pending &pending = m_window[(m_head + m_count++) % VIOLATION_LINK_WINDOW]; // Next() keeps a slot free.
+            ViolationRow &row = pending.row;
+            row.time_us = fine.simulation_time;
+            row.x = fine.x;
+            row.y = fine.y;
+            row.z = fine.z;
+            row.heading = fine.heading;
+            row.speed = fine.speed;
+            row.fine_amount = fine.fine_amount;
+            row.capture = fine.capture < (uint8_t)JournalFineCapture::Count ? (JournalFineCapture)fine.capture : JournalFineCapture::None;
+            CopyString(row.offence, sizeof(row.offence), fine.offence, sizeof(fine.offence));
+            CopyString(row.truck_id, sizeof(row.truck_id), fine.truck_id, sizeof(fine.truck_id));
+            CopyString(row.plate, sizeof(row.plate), fine.plate, sizeof(fine.plate));
+            row.screenshot[0] = '\0';
+            pending.capture_id = fine.capture_id;
+            pending.read_at = m_records;
+            pending.waiting = fine.capture_id != 0 && row.capture != JournalFineCapture::None && row.capture != JournalFineCapture::Dropped;
+
+            if (row.capture == JournalFineCapture::Attached)
+            {
+                // Folded into a capture that may already have its name.
+                for (size_t i = 1; i <= LINKS && pending.waiting; ++i)
+                {
+                    const Link &link = m_links[(m_linkNext + LINKS - i) % LINKS];
+                    if (link.capture_id == fine.capture_id)
+                    {
+                        SetScreenshot(row, link.name);
+                        pending.waiting = false;
+                    }
+                }
+            }
+            else if (pending.waiting)
+            {
+                // Ids restart every session: a new capture hides older names under the same id.
+                for (Link &link : m_links)
+                {
+                    link.capture_id = link.capture_id == fine.capture_id ? 0 : link.capture_id;
+                }
+            }
+        }
+        else if (type == JournalRecordType::CaptureNamed && size == sizeof(JournalCaptureNamed))
+        {
+            JournalCaptureNamed named;
+            std::memcpy(&named, payload, sizeof(named));
+            named.name[sizeof(named.name) - 1] = '\0';
+            for (size_t i = 0; i < m_count; ++i)
+            {
+                Pending &pending = m_window[(m_head + i) % VIOLATION_LINK_WINDOW];
+                if (pending.waiting && pending.capture_id == named.capture_id)
+                {
+                    SetScreenshot(pending.row, named.name);
+                    pending.waiting = false;
+                }
+            }
+            Link &link = m_links[m_linkNext];
+            link.capture_id = named.capture_id;
+            std::memcpy(link.name, named.name, sizeof(link.name));
+            m_linkNext = (m_linkNext + 1) % LINKS;
+        }
+        return true;
+    }
+
+    bool ViolationJournalScanner::Next(ViolationRow &row)
+    {
+        for (;;)
+        {
+            if (m_count != 0)
+            {
+                const Pending &oldest = m_window[m_head];
+                if (!oldest.waiting || m_end || m_records - oldest.read_at >= VIOLATION_LINK_RECORDS || m_count == VIOLATION_LINK_WINDOW)
+                {
+                    row = oldest.row;
+                    m_head = (m_head + 1) % VIOLATION_LINK_WINDOW;
+                    --m_count;
+                    return true;
+                }
+            }
+            if (m_end)
+            {
+                return false;
+            }
+            m_end = !ReadRecord();
+        }
+    }
+
+    // =================================================================================================
+    // 3. Export Job
+    // =================================================================================================
+
+    ViolationExportResult ExportViolations(const char *journal_path, const char *out_path, const char *screenshot_dir)
+    {
+        ViolationExportResult result;
+        char temp_path[VIOLATION_PATH_SIZE + 8];
+        if (!journal_path || !out_path || std::snprintf(temp_path, sizeof(temp_path), "%s.tmp", out_path) >= (int)sizeof(temp_path))
+        {
+            return result;
+        }
+
+        // Both are too large for a worker's stack.
+        const std::unique_ptr<ViolationJournalScanner> scanner(new ViolationJournalScanner());
+        const std::unique_ptr<ViolationArrowWriter> writer(new ViolationArrowWriter());
+        if (!scanner->Open(journal_path, screenshot_dir) || !writer->Open(temp_path))
+        {
+            writer->Close();
+            std::remove(temp_path);
+            return result;
+        }
+
+        ViolationRow row;
+        bool ok = true;
+        while (ok && scanner->Next(row))
+        {
+            ok = writer->Append(row);
+        }
+        result.rows = writer->GetRowCount();
+        ok = writer->Close() && ok;
+        result.batches = writer->GetBatchCount();
+        result.bytes = writer->GetBytesWritten();
+        result.journal_records = scanner->GetRecordCount();
+        result.damaged = scanner->IsDamaged();
+        scanner->Close();
+
+        result.ok = ok && ReplaceFile(temp_path, out_path);
+        if (!result.ok)
+        {
+            std::remove(temp_path);
+        }
+        return result;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,194 @@
+/**
+ * @file ViolationExport.hpp
+ * @brief Streams the fines in the capture journal to an Apache Arrow IPC stream for analytics.
+ * @details One row per fine (see `JournalFine`), in journal order, with the path of the screenshot
+ * its capture produced. The file is the Arrow IPC streaming format (a schema message, record batch
+ * messages, an end-of-stream marker; format version V5, little-endian), so it loads directly with
+ * `pyarrow.ipc.open_stream(...).read_pandas()`, Polars or DuckDB.
+ *
+ * Memory stays bounded however long the journal is:
+ *
+ * - The writer holds one record batch in fixed column arrays: at most `VIOLATION_BATCH_ROWS` rows,
+ *   and fewer when a string column's `VIOLATION_BATCH_STRING_BYTES` would overflow. A full batch is
+ *   written straight from the columns, with no copy, and the arrays are reused.
+ * - A fine is written before its screenshot is named, so the scanner keeps the most recent fines in
+ *   a window of `VIOLATION_LINK_WINDOW` rows until their `JournalCaptureNamed` record arrives. A fine
+ *   whose capture never took a screenshot leaves the window after `VIOLATION_LINK_RECORDS` journal
+ *   records with a null screenshot.
+ *
+ * Both classes are plain file I/O and meant for a background thread; `ExportViolations` is the
+ * whole job. The journal may be appended to while it runs: the export stops at the last complete
+ * record.
+ */
+#pragma once
+
+#include "CaptureJournal.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr size_t VIOLATION_BATCH_ROWS = 4096;
+  constexpr size_t VIOLATION_BATCH_STRING_BYTES = 256 * 1024; ///< Per string column and batch.
+  constexpr size_t VIOLATION_PATH_SIZE = 640;
+  constexpr size_t VIOLATION_LINK_WINDOW = 64;    ///< Fines held back waiting for their screenshot name.
+  constexpr uint64_t VIOLATION_LINK_RECORDS = 256; ///< Journal records a fine waits at most.
+
+  /** @brief One exported fine. */
+  struct ViolationRow
+  {
+    uint64_t time_us = 0; ///< Simulation time.
+    double x = 0.0, y = 0.0, z = 0.0;
+    double heading = 0.0; ///< 0..1, as in the telemetry.
+    float speed = 0.0f;   ///< m/s.
+    int64_t fine_amount = 0;
+    JournalFineCapture capture = JournalFineCapture::None;
+    char offence[JOURNAL_OFFENCE_SIZE] = "";
+    char truck_id[JOURNAL_TRUCK_ID_SIZE] = "";
+    char plate[JOURNAL_PLATE_SIZE] = "";
+    char screenshot[VIOLATION_PATH_SIZE] = ""; ///< Path of the .png file; empty (exported as null) if no screenshot is known.
+  };
+
+  /** @brief Lower-case name of a capture disposition, as exported. */
+  const char *FineCaptureName(JournalFineCapture capture);
+
+  // =================================================================================================
+  // 1. Arrow Writer
+  // =================================================================================================
+
+  /**
+   * @brief Writes `ViolationRow`s as an Arrow IPC stream.
+   * @details Columns: time_us (int64), x, y, z, heading (float64), speed (float32), offence (utf8),
+   *          fine_amount (int64), capture (utf8), truck_id (utf8), plate (utf8) and screenshot
+   *          (utf8, nullable). About 2 MB; keep it in static storage or on the heap.
+   */
+  class ViolationArrowWriter
+  {
+  public:
+    ViolationArrowWriter() = default;
+    ~ViolationArrowWriter() { Close(); }
+    ViolationArrowWriter(const ViolationArrowWriter &) = delete;
+    ViolationArrowWriter &operator=(const ViolationArrowWriter &) = delete;
+
+    /** @brief Creates `path` and writes the schema. */
+    bool Open(const char *path);
+
+    /** @brief Writes the last batch and the end-of-stream marker and closes the file. */
+    bool Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    /** @brief Adds a row; writes the batch first if the row does not fit. */
+    bool Append(const ViolationRow &row);
+
+    uint64_t GetRowCount() const { return m_rowCount; }
+    uint64_t GetBatchCount() const { return m_batchCount; }
+    uint64_t GetBytesWritten() const { return m_bytesWritten; }
+
+  private:
+    struct StringColumn
+    {
+      int32_t offsets[VIOLATION_BATCH_ROWS + 1];
+      char data[VIOLATION_BATCH_STRING_BYTES];
+    };
+
+    static constexpr size_t STRING_COLUMNS = 5;
+
+    bool WriteSchema();
+    bool WriteBatch();
+    bool WriteMessage(const uint8_t *metadata, size_t size);
+    bool WriteBytes(const void *data, size_t size);
+
+    FILE *m_file = nullptr;
+    bool m_failed = false;
+    size_t m_rows = 0;
+    uint64_t m_rowCount = 0;
+    uint64_t m_batchCount = 0;
+    uint64_t m_bytesWritten = 0;
+
+    int64_t m_time[VIOLATION_BATCH_ROWS];
+    double m_x[VIOLATION_BATCH_ROWS];
+    double m_y[VIOLATION_BATCH_ROWS];
+    double m_z[VIOLATION_BATCH_ROWS];
+    double m_heading[VIOLATION_BATCH_ROWS];
+    float m_speed[VIOLATION_BATCH_ROWS];
+    int64_t m_amount[VIOLATION_BATCH_ROWS];
+    StringColumn m_strings[STRING_COLUMNS]; ///< offence, capture, truck_id, plate, screenshot.
+    uint8_t m_screenshotValid[VIOLATION_BATCH_ROWS / 8];
+    size_t m_screenshotNulls = 0;
+  };
+
+  // =================================================================================================
+  // 2. Journal Scanner
+  // =================================================================================================
+
+  /** @brief Reads the fines of a capture journal as rows, each with its screenshot path once known. */
+  class ViolationJournalScanner
+  {
+  public:
+    /**
+     * @param screenshot_dir Prefixed to screenshot names ("<dir>/<name>"); nullptr or "" for the bare name.
+     */
+    bool Open(const char *journal_path, const char *screenshot_dir);
+    void Close() { m_reader.Close(); }
+
+    /** @brief Next fine in journal order. */
+    bool Next(ViolationRow &row);
+
+    bool IsDamaged() const { return m_reader.IsDamaged(); }
+    uint64_t GetRecordCount() const { return m_records; }
+
+  private:
+    struct Pending
+    {
+      ViolationRow row;
+      uint32_t capture_id;
+      uint64_t read_at; ///< Journal record index.
+      bool waiting;
+    };
+
+    struct Link
+    {
+      uint32_t capture_id;
+      char name[SCREENSHOT_NAME_SIZE];
+    };
+
+    static constexpr size_t LINKS = 16;
+
+    bool ReadRecord();
+    void SetScreenshot(ViolationRow &row, const char *name) const;
+
+    JournalReader m_reader;
+    char m_screenshotDir[VIOLATION_PATH_SIZE] = "";
+    Pending m_window[VIOLATION_LINK_WINDOW];
+    size_t m_head = 0;
+    size_t m_count = 0;
+    Link m_links[LINKS] = {}; ///< Most recent screenshot names, for repeat fines of a named capture.
+    size_t m_linkNext = 0;
+    uint64_t m_records = 0;
+    bool m_end = false;
+  };
+
+  // =================================================================================================
+  // 3. Export Job
+  // =================================================================================================
+
+  struct ViolationExportResult
+  {
+    uint64_t rows = 0;
+    uint64_t batches = 0;
+    uint64_t bytes = 0;
+    uint64_t journal_records = 0;
+    bool damaged = false; ///< The journal ended in a torn record (normal while it is being written).
+    bool ok = false;      ///< The file was written and moved into place.
+  };
+
+  /**
+   * @brief Exports every fine in `journal_path` to `out_path`, through a temporary file.
+   * @param screenshot_dir See `ViolationJournalScanner::Open`.
+   */
+  ViolationExportResult ExportViolations(const char *journal_path, const char *out_path, const char *screenshot_dir);
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,284 @@
+/**
+ * @file ViolationHeatmap.cpp
+ * @brief Implementation of the violation heatmap grid, its file and its screen view.
+ */
+
+#include "ViolationHeatmap.hpp"
+
+#include <cmath>
+#include <cstring>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        size_t SlotOf(int32_t cell_x, int32_t cell_z)
+        {
+            // Same spreading primes as the traffic index.
+            const uint32_t h = (uint32_t)cell_x * 73856093u ^ (uint32_t)cell_z * 19349663u;
+            return h & (HEATMAP_INDEX_SLOTS - 1);
+        }
+
+        HeatmapFileHeader MakeHeader()
+        {
+            HeatmapFileHeader header{};
+            std::memcpy(header.magic, HEATMAP_MAGIC, sizeof(header.magic));
+            header.version = HEATMAP_VERSION;
+            header.cell_size = (float)HEATMAP_CELL_SIZE;
+            return header;
+        }
+
+        // A log this much longer than the grid is rewritten on open.
+        constexpr uint64_t COMPACT_RATIO = 4;
+        constexpr uint64_t COMPACT_SLACK = 256;
+
+        bool ReplaceFile(const char *temp_path, const char *path)
+        {
+#ifdef _WIN32
+            return MoveFileExA(temp_path, path, MOVEFILE_REPLACE_EXISTING) != 0;
+#else
+            return std::rename(temp_path, path) == 0;
+#endif
+        }
+    } // namespace
+
+    // =================================================================================================
+    // 1. HeatmapGrid
+    // =================================================================================================
+
+    HeatmapGrid::HeatmapGrid() { Clear(); }
+
+    int32_t HeatmapGrid::CellOf(double coordinate) { return (int32_t)std::floor(coordinate / HEATMAP_CELL_SIZE); }
+
+    void HeatmapGrid::Clear()
+    {
+        std::memset(m_index, 0, sizeof(m_index));
+        m_cellCount = 0;
+        m_maxCount = 0;
+        m_total = 0;
+        m_dropped = 0;
+        ++m_generation;
+    }
+
+    bool HeatmapGrid::Increment(int32_t cell_x, int32_t cell_z, uint32_t count)
+    {
+        size_t slot = SlotOf(cell_x, cell_z);
+        while (m_index[slot] != 0)
+        {
+            HeatmapCell &cell = m_cells[m_index[slot] - 1];
+            if (cell.x == cell_x && cell.z == cell_z)
+            {
+                cell.count += count;
+                m_maxCount = cell.count > m_maxCount ? cell.count : m_maxCount;
+                m_total += count;
+                ++m_generation;
+                return true;
+            }
+            slot = (slot + 1) & (HEATMAP_INDEX_SLOTS - 1);
+        }
+
+        if (m_cellCount == HEATMAP_MAX_CELLS)
+        {
+            m_dropped += count;
+            return false;
+        }
+        m_cells[m_cellCount] = {cell_x, cell_z, count};
+        m_index[slot] = (uint16_t)(++m_cellCount);
+        m_maxCount = count > m_maxCount ? count : m_maxCount;
+        m_total += count;
+        ++m_generation;
+        return true;
+    }
+
+    void HeatmapGrid::Add(double x, double z)
+    {
+        const HeatmapRecord record = {CellOf(x), CellOf(z), 1};
+        if (!Increment(record.cell_x, record.cell_z, record.count) || !m_file)
+        {
+            return;
+        }
+        // One record per fine, flushed at once; fines are seconds apart at the very least.
+        std::fwrite(&record, sizeof(record), 1, m_file);
+        std::fflush(m_file);
+    }
+
+    bool HeatmapGrid::Load(const char *path, bool &needs_rewrite)
+    {
+        needs_rewrite = false;
+        FILE *file = std::fopen(path, "rb");
+        if (!file)
+        {
+            return false;
+        }
+
+        const HeatmapFileHeader expected = MakeHeader();
+        HeatmapFileHeader header{};
+        if (std::fread(&header, sizeof(header), 1, file) != 1 || std::memcmp(&header, &expected, sizeof(header)) != 0)
+        {
+            // Another version or cell size: start over rather than misplace every fine.
+            std::fclose(file);
+            needs_rewrite = true;
+            return false;
+        }
+
+        HeatmapRecord records[256];
+        size_t read;
+        while ((read = std::fread(records, 1, sizeof(records), file)) != 0)
+        {
+            for (size_t i = 0; i < read / sizeof(HeatmapRecord); ++i)
+            {
+                Increment(records[i].cell_x, records[i].cell_z, records[i].count);
+            }
+            m_loadedRecords += read / sizeof(HeatmapRecord);
+            if (read % sizeof(HeatmapRecord) != 0)
+            {
+                needs_rewrite = true; // Torn tail: appending after it would misalign every record.
+                break;
+            }
+        }
+        std::fclose(file);
+
+        needs_rewrite = needs_rewrite || m_loadedRecords > m_cellCount * COMPACT_RATIO + COMPACT_SLACK;
+        return true;
+    }
+
+    bool HeatmapGrid::Rewrite(const char *path)
+    {
+        // Write next to the file and swap it in, so a crash half way leaves the old one.
+        char temp_path[1024];
+        if (std::snprintf(temp_path, sizeof(temp_path), "%s.tmp", path) >= (int)sizeof(temp_path))
+        {
+            return false;
+        }
+        FILE *file = std::fopen(temp_path, "wb");
+        if (!file)
+        {
+            return false;
+        }
+
+        const HeatmapFileHeader header = MakeHeader();
+        bool ok = std::fwrite(&header, sizeof(header), 1, file) == 1;
+        for (size_t i = 0; i < m_cellCount && ok; ++i)
+        {
+            const HeatmapRecord record = {m_cells[i].x, m_cells[i].z, m_cells[i].count};
+            ok = std::fwrite(&record, sizeof(record), 1, file) == 1;
+        }
+        ok = std::fclose(file) == 0 && ok;
+        if (!ok || !ReplaceFile(temp_path, path))
+        {
+            std::remove(temp_path);
+            return false;
+        }
+        return true;
+    }
+
+    bool HeatmapGrid::Open(const char *path)
+    {
+        Close();
+        Clear();
+        m_loadedRecords = 0;
+        m_compacted = false;
+        if (!path)
+        {
+            return false;
+        }
+
+        bool needs_rewrite = false;
+        const bool loaded = Load(path, needs_rewrite);
+        if (!loaded || needs_rewrite)
+        {
+            if (!Rewrite(path))
+            {
+                return false;
+            }
+            m_compacted = loaded;
+        }
+
+        m_file = std::fopen(path, "ab");
+        return m_file != nullptr;
+    }
+
+    void HeatmapGrid::Close()
+    {
+        if (m_file)
+        {
+            std::fclose(m_file);
+            m_file = nullptr;
+        }
+    }
+
+    // =================================================================================================
+    // 2. HeatmapView
+    // =================================================================================================
+
+    bool HeatmapView::Update(const HeatmapGrid &grid, double centre_x, double centre_z, double range, float x, float y, float width, float height)
+    {
+        const int32_t centre_cell[2] = {HeatmapGrid::CellOf(centre_x), HeatmapGrid::CellOf(centre_z)};
+        if (grid.GetGeneration() == m_generation && centre_cell[0] == m_centreCell[0] && centre_cell[1] == m_centreCell[1] && range == m_range &&
+            x == m_rect[0] && y == m_rect[1] && width == m_rect[2] && height == m_rect[3])
+        {
+            return false;
+        }
+        m_generation = grid.GetGeneration();
+        m_centreCell[0] = centre_cell[0];
+        m_centreCell[1] = centre_cell[1];
+        m_range = range;
+        m_rect[0] = x;
+        m_rect[1] = y;
+        m_rect[2] = width;
+        m_rect[3] = height;
+
+        // The centre snaps to the middle of the truck's cell, so the rectangles stay put while it
+        // drives through it.
+        m_centre[0] = (centre_cell[0] + 0.5) * HEATMAP_CELL_SIZE;
+        m_centre[1] = (centre_cell[1] + 0.5) * HEATMAP_CELL_SIZE;
+        m_origin[0] = x + width * 0.5f;
+        m_origin[1] = y + height * 0.5f;
+        const float half_extent = (width < height ? width : height) * 0.5f;
+        m_scale = range > 0.0 ? half_extent / range : 1.0;
+
+        m_count = 0;
+        const float cell_pixels = (float)(HEATMAP_CELL_SIZE * m_scale);
+        const float grow = cell_pixels < HEATMAP_MIN_QUAD_SIZE ? (HEATMAP_MIN_QUAD_SIZE - cell_pixels) * 0.5f : 0.0f;
+        const double level_scale = grid.GetMaxCount() > 1 ? (HEATMAP_LEVELS - 1) / std::log((double)grid.GetMaxCount()) : 0.0;
+        const HeatmapCell *cells = grid.GetCells();
+        for (size_t i = 0; i < grid.GetCellCount(); ++i)
+        {
+            const HeatmapCell &cell = cells[i];
+            HeatmapQuad quad;
+            ToScreen(cell.x * HEATMAP_CELL_SIZE, cell.z * HEATMAP_CELL_SIZE, quad.x0, quad.y0);
+            quad.x1 = quad.x0 + cell_pixels + grow;
+            quad.y1 = quad.y0 + cell_pixels + grow;
+            quad.x0 -= grow;
+            quad.y0 -= grow;
+            if (quad.x1 <= x || quad.y1 <= y || quad.x0 >= x + width || quad.y0 >= y + height)
+            {
+                continue; // Outside the window.
+            }
+            quad.x0 = quad.x0 < x ? x : quad.x0;
+            quad.y0 = quad.y0 < y ? y : quad.y0;
+            quad.x1 = quad.x1 > x + width ? x + width : quad.x1;
+            quad.y1 = quad.y1 > y + height ? y + height : quad.y1;
+
+            // Logarithmic, so one busy junction does not wash out the rest.
+            const uint32_t level = (uint32_t)(std::log((double)cell.count) * level_scale + 0.5);
+            quad.level = level < HEATMAP_LEVELS ? level : (uint32_t)HEATMAP_LEVELS - 1;
+            m_quads[m_count++] = quad;
+        }
+        return true;
+    }
+
+    void HeatmapView::ToScreen(double x, double z, float &out_x, float &out_y) const
+    {
+        out_x = m_origin[0] + (float)((x - m_centre[0]) * m_scale);
+        out_y = m_origin[1] + (float)((z - m_centre[1]) * m_scale);
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,157 @@
+/**
+ * @file ViolationHeatmap.hpp
+ * @brief World-space heatmap of where red light fines happen, kept across sessions.
+ * @details Fines are counted per world cell of `HEATMAP_CELL_SIZE` metres (x, z). Only cells that
+ * saw a fine exist: they are stored densely, in the order they first appeared, and found through a
+ * fixed open-addressing index (linear probing), so adding a fine is one hash probe and one counter
+ * increment.
+ *
+ * The grid persists as an append-only file: a header, then one 12-byte record per fine (cell and
+ * count). Adding a fine appends and flushes its record, so a crash loses nothing. Opening the file
+ * folds the records back into the grid; when the log holds many more records than cells, or ends
+ * in a torn record, it is rewritten with one record per cell before appending to it again.
+ *
+ * `HeatmapView` turns the grid into screen rectangles for a window: it culls cells outside the
+ * window, assigns each a colour level (logarithmic in its count) and caches the result. The view is
+ * centred on the cell the truck is in, so the cache is rebuilt only when the grid changes, the
+ * truck crosses into another cell, or the window or range changes; otherwise a draw is a loop over
+ * cached rectangles.
+ */
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+namespace SPF_RedLightCamera
+{
+
+  constexpr double HEATMAP_CELL_SIZE = 50.0;    ///< Metres; about one junction.
+  constexpr size_t HEATMAP_MAX_CELLS = 4096;    ///< Fines in further cells are counted as dropped.
+  constexpr size_t HEATMAP_INDEX_SLOTS = 8192;  ///< Power of two, at most half full.
+  constexpr size_t HEATMAP_LEVELS = 8;          ///< Colour levels, 0 (one fine) to the busiest cell.
+  constexpr float HEATMAP_MIN_QUAD_SIZE = 3.0f; ///< Pixels; cells are never drawn smaller.
+
+  /** @brief Magic bytes at the start of a heatmap file ("RLCH"). */
+  constexpr char HEATMAP_MAGIC[4] = {'R', 'L', 'C', 'H'};
+
+  /** @brief Format version. Bump whenever the record layout changes. */
+  constexpr uint16_t HEATMAP_VERSION = 1;
+
+#pragma pack(push, 1)
+  struct HeatmapFileHeader
+  {
+    char magic[4];
+    uint16_t version;
+    uint16_t reserved;
+    float cell_size; ///< A file with another cell size is discarded.
+  };
+
+  /** @brief `count` fines in the cell; appended per fine with a count of 1. */
+  struct HeatmapRecord
+  {
+    int32_t cell_x;
+    int32_t cell_z;
+    uint32_t count;
+  };
+#pragma pack(pop)
+
+  struct HeatmapCell
+  {
+    int32_t x;
+    int32_t z;
+    uint32_t count;
+  };
+
+  class HeatmapGrid
+  {
+  public:
+    HeatmapGrid();
+    ~HeatmapGrid() { Close(); }
+    HeatmapGrid(const HeatmapGrid &) = delete;
+    HeatmapGrid &operator=(const HeatmapGrid &) = delete;
+
+    /**
+     * @brief Loads the heatmap file at `path` (if any) and keeps it open for appending.
+     * @return false if the file could not be created or opened; the grid still holds what was read.
+     */
+    bool Open(const char *path);
+    void Close();
+    bool IsOpen() const { return m_file != nullptr; }
+
+    /** @brief Counts a fine at world (x, z) and appends it to the file if one is open. */
+    void Add(double x, double z);
+
+    /** @brief Forgets every cell (the file is left as it is). */
+    void Clear();
+
+    const HeatmapCell *GetCells() const { return m_cells; }
+    size_t GetCellCount() const { return m_cellCount; }
+    uint32_t GetMaxCount() const { return m_maxCount; }
+    uint64_t GetTotal() const { return m_total; }
+    uint64_t GetDropped() const { return m_dropped; }
+    /** @brief Records read by the last `Open`, and whether it rewrote the file. */
+    uint64_t GetLoadedRecords() const { return m_loadedRecords; }
+    bool WasCompacted() const { return m_compacted; }
+    /** @brief Bumped by every change to a count. */
+    uint64_t GetGeneration() const { return m_generation; }
+
+    static int32_t CellOf(double coordinate);
+
+  private:
+    bool Increment(int32_t cell_x, int32_t cell_z, uint32_t count);
+    bool Load(const char *path, bool &needs_rewrite);
+    bool Rewrite(const char *path);
+
+    HeatmapCell m_cells[HEATMAP_MAX_CELLS];
+    uint16_t m_index[HEATMAP_INDEX_SLOTS]; ///< Cell index + 1; 0 is an empty slot.
+    size_t m_cellCount = 0;
+    uint32_t m_maxCount = 0;
+    uint64_t m_total = 0;
+    uint64_t m_dropped = 0;
+    uint64_t m_loadedRecords = 0;
+    uint64_t m_generation = 0;
+    bool m_compacted = false;
+    FILE *m_file = nullptr;
+  };
+
+  /** @brief One cell on screen. */
+  struct HeatmapQuad
+  {
+    float x0, y0, x1, y1;
+    uint32_t level; ///< 0 .. HEATMAP_LEVELS - 1.
+  };
+
+  /** @brief Cached, culled screen rectangles of a `HeatmapGrid`. */
+  class HeatmapView
+  {
+  public:
+    /**
+     * @brief Rebuilds the rectangles for a window at (`x`, `y`) of `width` x `height`, showing
+     *        `range` metres from its centre to its nearer edge around world (`centre_x`,
+     *        `centre_z`), if anything they depend on changed. North (-z) is up.
+     * @return true if the rectangles were rebuilt.
+     */
+    bool Update(const HeatmapGrid &grid, double centre_x, double centre_z, double range, float x, float y, float width, float height);
+
+    const HeatmapQuad *GetQuads() const { return m_quads; }
+    size_t GetCount() const { return m_count; }
+
+    /** @brief Projects world (x, z) with the transform of the last `Update`. */
+    void ToScreen(double x, double z, float &out_x, float &out_y) const;
+
+  private:
+    HeatmapQuad m_quads[HEATMAP_MAX_CELLS];
+    size_t m_count = 0;
+    uint64_t m_generation = ~0ull;
+    int32_t m_centreCell[2] = {0, 0};
+    float m_rect[4] = {};
+    double m_range = 0.0;
+
+    // World to screen: screen = m_origin + (world - m_centre) * m_scale.
+    double m_centre[2] = {0.0, 0.0};
+    float m_origin[2] = {0.0f, 0.0f};
+    double m_scale = 1.0;
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,199 @@
+/**
+ * @file ViolationSites.cpp
+ * @brief Implementation of the violation site index.
+ */
+
+#include "ViolationSites.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        size_t HashBucket(int32_t x, int32_t z)
+        {
+            // Same spreading primes as the traffic index.
+            return (size_t)((uint32_t)x * 73856093u ^ (uint32_t)z * 19349663u);
+        }
+
+        bool CellLess(const HeatmapRecord &a, const HeatmapRecord &b) { return a.cell_x != b.cell_x ? a.cell_x < b.cell_x : a.cell_z < b.cell_z; }
+
+        struct BucketedSite
+        {
+            int32_t bucket_x;
+            int32_t bucket_z;
+            ViolationSite site;
+        };
+    } // namespace
+
+    int32_t ViolationSiteIndex::BucketOf(double coordinate) { return (int32_t)std::floor(coordinate / SITE_BUCKET_SIZE); }
+
+    void ViolationSiteIndex::Clear()
+    {
+        m_sites.clear();
+        m_table.clear();
+        m_bucketCount = 0;
+    }
+
+    void ViolationSiteIndex::Build(const HeatmapRecord *records, size_t record_count, double cell_size)
+    {
+        Clear();
+        if (!records || record_count == 0 || cell_size <= 0.0)
+        {
+            return;
+        }
+
+        // Sum repeated cells.
+        std::vector<HeatmapRecord> cells(records, records + record_count);
+        std::sort(cells.begin(), cells.end(), CellLess);
+        size_t unique = 0;
+        for (size_t i = 0; i < cells.size(); ++i)
+        {
+            if (unique != 0 && cells[unique - 1].cell_x == cells[i].cell_x && cells[unique - 1].cell_z == cells[i].cell_z)
+            {
+                cells[unique - 1].count += cells[i].count;
+            }
+            else
+            {
+                cells[unique++] = cells[i];
+            }
+        }
+        cells.resize(unique);
+
+        // Cell centres, grouped by bucket.
+        std::vector<BucketedSite> bucketed(unique);
+        for (size_t i = 0; i < unique; ++i)
+        {
+            const double x = (cells[i].cell_x + 0.5) * cell_size;
+            const double z = (cells[i].cell_z + 0.5) * cell_size;
+            bucketed[i] = {BucketOf(x), BucketOf(z), {(float)x, (float)z, cells[i].count}};
+        }
+        std::sort(bucketed.begin(), bucketed.end(), [](const BucketedSite &a, const BucketedSite &b) {
+            return a.bucket_x != b.bucket_x ? a.bucket_x < b.bucket_x : a.bucket_z < b.bucket_z;
+        });
+
+        size_t bucket_count = 0;
+        for (size_t i = 0; i < unique; ++i)
+        {
+            bucket_count += (i == 0 || bucketed[i].bucket_x != bucketed[i - 1].bucket_x || bucketed[i].bucket_z != bucketed[i - 1].bucket_z) ? 1 : 0;
+        }
+        size_t table_size = 16;
+        while (table_size < bucket_count * 2)
+        {
+            table_size <<= 1;
+        }
+        m_table.assign(table_size, Bucket{0, 0, 0, 0});
+        m_sites.resize(unique);
+
+        for (size_t begin = 0; begin < unique;)
+        {
+            size_t end = begin;
+            while (end < unique && bucketed[end].bucket_x == bucketed[begin].bucket_x && bucketed[end].bucket_z == bucketed[begin].bucket_z)
+            {
+                m_sites[end] = bucketed[end].site;
+                ++end;
+            }
+            size_t slot = HashBucket(bucketed[begin].bucket_x, bucketed[begin].bucket_z) & (table_size - 1);
+            while (m_table[slot].end != 0)
+            {
+                slot = (slot + 1) & (table_size - 1);
+            }
+            m_table[slot] = {bucketed[begin].bucket_x, bucketed[begin].bucket_z, (uint32_t)begin, (uint32_t)end};
+            begin = end;
+        }
+        m_bucketCount = bucket_count;
+    }
+
+    bool ViolationSiteIndex::BuildFromHeatmapFile(const void *data, size_t size)
+    {
+        Clear();
+        HeatmapFileHeader header;
+        if (!data || size < sizeof(header))
+        {
+            return false;
+        }
+        std::memcpy(&header, data, sizeof(header));
+        if (std::memcmp(header.magic, HEATMAP_MAGIC, sizeof(header.magic)) != 0 || header.version != HEATMAP_VERSION)
+        {
+            return false;
+        }
+
+        // Records are packed and may sit at any offset, so they are copied rather than cast.
+        const size_t record_count = (size_t)(size - sizeof(header)) / sizeof(HeatmapRecord);
+        std::vector<HeatmapRecord> records(record_count);
+        if (record_count != 0)
+        {
+            std::memcpy(records.data(), static_cast<const char *>(data) + sizeof(header), record_count * sizeof(HeatmapRecord));
+        }
+        Build(records.data(), record_count, header.cell_size);
+        return true;
+    }
+
+    const ViolationSiteIndex::Bucket *ViolationSiteIndex::FindBucket(int32_t x, int32_t z) const
+    {
+        const size_t mask = m_table.size() - 1;
+        for (size_t slot = HashBucket(x, z) & mask;; slot = (slot + 1) & mask)
+        {
+            const Bucket &bucket = m_table[slot];
+            if (bucket.end == 0)
+            {
+                return nullptr;
+            }
+            if (bucket.x == x && bucket.z == z)
+            {
+                return &bucket;
+            }
+        }
+    }
+
+    bool ViolationSiteIndex::FindNearest(double x, double z, double radius, SiteHit &hit) const
+    {
+        if (m_sites.empty() || radius <= 0.0)
+        {
+            return false;
+        }
+        radius = radius < SITE_MAX_RADIUS ? radius : SITE_MAX_RADIUS;
+
+        const int32_t min_x = BucketOf(x - radius), max_x = BucketOf(x + radius);
+        const int32_t min_z = BucketOf(z - radius), max_z = BucketOf(z + radius);
+        const float fx = (float)x, fz = (float)z;
+        float best_sq = (float)(radius * radius);
+        const ViolationSite *best = nullptr;
+        for (int32_t bz = min_z; bz <= max_z; ++bz)
+        {
+            for (int32_t bx = min_x; bx <= max_x; ++bx)
+            {
+                const Bucket *bucket = FindBucket(bx, bz);
+                if (!bucket)
+                {
+                    continue;
+                }
+                for (uint32_t i = bucket->begin; i < bucket->end; ++i)
+                {
+                    const ViolationSite &site = m_sites[i];
+                    const float dx = site.x - fx, dz = site.z - fz;
+                    const float distance_sq = dx * dx + dz * dz;
+                    if (distance_sq <= best_sq)
+                    {
+                        best_sq = distance_sq;
+                        best = &site;
+                    }
+                }
+            }
+        }
+        if (!best)
+        {
+            return false;
+        }
+
+        hit.index = (uint32_t)(best - m_sites.data());
+        hit.count = best->count;
+        hit.distance = std::sqrt(best_sq);
+        return true;
+    }
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,369 @@
+/**
+ * @file WorkerPool.cpp
+ * @brief Implementation of the work-stealing worker pool.
+ */
+
+#include "WorkerPool.hpp"
+
+#include <cstdio>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/resource.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace SPF_RedLightCamera
+{
+
+    namespace
+    {
+        static_assert((WORKER_QUEUE_CAPACITY & (WORKER_QUEUE_CAPACITY - 1)) == 0, "Queue capacity must be a power of two.");
+
+        // Pool and worker index of the current thread, so jobs submitted from a job go to the local deque.
+        thread_local WorkerPool *t_pool = nullptr;
+        thread_local uint32_t t_workerIndex = 0;
+
+        // Applies the configured priority, affinity and a debugger-visible name to the calling thread.
+        // Failures are ignored: the pool works the same, only less politely.
+        void ConfigureCurrentThread(const WorkerPoolConfig &config, uint32_t index)
+        {
+            const int32_t priority = config.priority < -2 ? -2 : (config.priority > 2 ? 2 : config.priority);
+#ifdef _WIN32
+            // THREAD_PRIORITY_LOWEST .. THREAD_PRIORITY_HIGHEST are exactly -2 .. 2.
+            SetThreadPriority(GetCurrentThread(), priority);
+            if (config.affinity_mask != 0)
+            {
+                SetThreadAffinityMask(GetCurrentThread(), (DWORD_PTR)config.affinity_mask);
+            }
+            (void)index;
+#else
+            // Linux applies nice values per thread; five steps per priority level.
+            setpriority(PRIO_PROCESS, (id_t)syscall(SYS_gettid), -priority * 5);
+            if (config.affinity_mask != 0)
+            {
+                cpu_set_t set;
+                CPU_ZERO(&set);
+                for (uint32_t cpu = 0; cpu < 64 && cpu < CPU_SETSIZE; ++cpu)
+                {
+                    if (config.affinity_mask & (1ull << cpu))
+                    {
+                        CPU_SET(cpu, &set);
+                    }
+                }
+                pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+            }
+            char name[16];
+            std::snprintf(name, sizeof(name), "rlc-worker-%u", index);
+            pthread_setname_np(pthread_self(), name);
+#endif
+        }
+    } // namespace
+
+    // =================================================================================================
+    // 1. Work-Stealing Deque
+    // =================================================================================================
+
+    bool WorkStealingDeque::Push(WorkerJob *job)
+    {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        const int64_t top = m_top.load(std::memory_order_acquire);
+        if (bottom - top >= (int64_t)WORKER_QUEUE_CAPACITY)
+        {
+            return false;
+        }
+        m_slots[bottom & MASK].store(job, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        return true;
+    }
+
+    WorkerJob *WorkStealingDeque::Pop()
+    {
+        const int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            // Empty.
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        WorkerJob *job = m_slots[bottom & MASK].load(std::memory_order_relaxed);
+        if (top == bottom)
+        {
+            // Last job: race the thieves for it.
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            {
+                job = nullptr;
+            }
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return job;
+    }
+
+    WorkerJob *WorkStealingDeque::Steal()
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+        {
+            return nullptr;
+        }
+
+        WorkerJob *job = m_slots[top & MASK].load(std::memory_order_relaxed);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+        {
+            return nullptr; // Lost to the owner or another thief.
+        }
+        return job;
+    }
+
+    // =================================================================================================
+    // 2. Completion Queue
+    // =================================================================================================
+
+    void CompletionQueue::Push(WorkerJob *job)
+    {
+        job->next.store(nullptr, std::memory_order_relaxed);
+        WorkerJob *previous = m_head.exchange(job, std::memory_order_acq_rel);
+        previous->next.store(job, std::memory_order_release);
+    }
+
+    WorkerJob *CompletionQueue::Pop()
+    {
+        WorkerJob *tail = m_tail;
+        WorkerJob *next = tail->next.load(std::memory_order_acquire);
+        if (tail == &m_stub)
+        {
+            if (!next)
+            {
+                return nullptr;
+            }
+            m_tail = next;
+            tail = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+        if (next)
+        {
+            m_tail = next;
+            return tail;
+        }
+        if (tail != m_head.load(std::memory_order_acquire))
+        {
+            return nullptr; // A producer is mid-push; its job arrives on the next drain.
+        }
+        // `tail` is the last job: re-insert the stub behind it so it can be unlinked.
+        Push(&m_stub);
+        next = tail->next.load(std::memory_order_acquire);
+        if (next)
+        {
+            m_tail = next;
+            return tail;
+        }
+        return nullptr;
+    }
+
+    // =================================================================================================
+    // 3. Pool
+    // =================================================================================================
+
+    bool WorkerPool::Start(const WorkerPoolConfig &config)
+    {
+        if (IsRunning())
+        {
+            return false;
+        }
+
+        m_config = config;
+        if (config.run_inline)
+        {
+            m_stopping.store(false, std::memory_order_relaxed);
+            m_inline = true;
+            return true;
+        }
+        const uint32_t count = config.threads == 0 ? 1 : (config.threads > WORKER_MAX_THREADS ? WORKER_MAX_THREADS : config.threads);
+        m_stopping.store(false, std::memory_order_relaxed);
+        m_threadCount = count;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            m_threads[i] = std::thread(&WorkerPool::WorkerMain, this, i);
+        }
+        return true;
+    }
+
+    void WorkerPool::Stop()
+    {
+        if (m_inline)
+        {
+            m_stopping.store(true, std::memory_order_release);
+            m_inline = false;
+            DrainCompletions();
+            return;
+        }
+        if (m_threadCount == 0)
+        {
+            return;
+        }
+
+        m_stopping.store(true, std::memory_order_release);
+        Wake(true);
+        for (uint32_t i = 0; i < m_threadCount; ++i)
+        {
+            m_threads[i].join();
+        }
+        m_threadCount = 0;
+
+        // Every queued job has run; hand the last results back before the owner goes away.
+        DrainCompletions();
+    }
+
+    bool WorkerPool::Submit(WorkerJob *job)
+    {
+        if (m_inline && !m_stopping.load(std::memory_order_acquire))
+        {
+            m_submitted.fetch_add(1, std::memory_order_relaxed);
+            Execute(job);
+            return true;
+        }
+
+        m_queued.fetch_add(1, std::memory_order_acq_rel);
+        if (m_threadCount == 0 || m_stopping.load(std::memory_order_acquire))
+        {
+            // A job may still be submitted from a worker while the pool drains; only outsiders are refused.
+            if (t_pool != this)
+            {
+                m_queued.fetch_sub(1, std::memory_order_acq_rel);
+                m_rejected.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+        }
+
+        const bool queued = (t_pool == this && m_deques[t_workerIndex].Push(job)) || m_injection.Push(job);
+        if (!queued)
+        {
+            m_queued.fetch_sub(1, std::memory_order_acq_rel);
+            m_rejected.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        m_submitted.fetch_add(1, std::memory_order_relaxed);
+        Wake(false);
+        return true;
+    }
+
+    size_t WorkerPool::DrainCompletions(size_t max_jobs)
+    {
+        size_t drained = 0;
+        while (drained < max_jobs)
+        {
+            WorkerJob *job = m_completions.Pop();
+            if (!job)
+            {
+                break;
+            }
+            drained++;
+            job->complete(job);
+        }
+        return drained;
+    }
+
+    WorkerPoolStats WorkerPool::GetStats() const
+    {
+        return {m_submitted.load(std::memory_order_relaxed), m_rejected.load(std::memory_order_relaxed),
+                m_executed.load(std::memory_order_relaxed), m_stolen.load(std::memory_order_relaxed)};
+    }
+
+    void WorkerPool::WorkerMain(uint32_t index)
+    {
+        t_pool = this;
+        t_workerIndex = index;
+        ConfigureCurrentThread(m_config, index);
+
+        for (;;)
+        {
+            if (WorkerJob *job = FindJob(index))
+            {
+                Execute(job);
+                continue;
+            }
+
+            // Read the epoch before the final check, so a submission after the check wakes us.
+            const uint32_t epoch = m_epoch.load(std::memory_order_acquire);
+            if (WorkerJob *job = FindJob(index))
+            {
+                Execute(job);
+                continue;
+            }
+            if (m_stopping.load(std::memory_order_acquire) && m_queued.load(std::memory_order_acquire) == 0)
+            {
+                break;
+            }
+            m_epoch.wait(epoch, std::memory_order_acquire);
+        }
+
+        t_pool = nullptr;
+    }
+
+    WorkerJob *WorkerPool::FindJob(uint32_t index)
+    {
+        WorkerJob *job = m_deques[index].Pop();
+        if (!job && !m_injection.Pop(job))
+        {
+            job = nullptr;
+        }
+        for (uint32_t i = 1; !job && i < m_threadCount; ++i)
+        {
+            job = m_deques[(index + i) % m_threadCount].Steal();
+            if (job)
+            {
+                m_stolen.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+        if (job)
+        {
+            m_queued.fetch_sub(1, std::memory_order_acq_rel);
+        }
+        return job;
+    }
+
+    void WorkerPool::Execute(WorkerJob *job)
+    {
+        // Read `complete` first: without a completion callback the owner may reuse the job as soon as it has run.
+        const bool has_completion = job->complete != nullptr;
+        job->run(job);
+        m_executed.fetch_add(1, std::memory_order_relaxed);
+        if (has_completion)
+        {
+            m_completions.Push(job);
+        }
+        if (m_stopping.load(std::memory_order_acquire))
+        {
+            Wake(true); // Let idle workers re-check the exit condition.
+        }
+    }
+
+    void WorkerPool::Wake(bool all)
+    {
+        m_epoch.fetch_add(1, std::memory_order_release);
+        if (all)
+        {
+            m_epoch.notify_all();
+        }
+        else
+        {
+            m_epoch.notify_one();
+        }
+    }
+
+} // namespace SPF_RedLightCamera
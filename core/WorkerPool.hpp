@@ -0,0 +1,172 @@
+/**
+ * @file WorkerPool.hpp
+ * @brief Fixed-size work-stealing thread pool for work that must stay off the game's threads.
+ * @details Jobs are intrusive: the caller derives from `WorkerJob`, owns the storage and keeps it
+ * alive until the job's `complete` callback has run. Nothing in the pool allocates after `Start`.
+ *
+ * Each worker owns a bounded Chase-Lev deque. Jobs submitted from a worker go to its own deque;
+ * jobs submitted from any other thread go to a shared bounded MPMC injection queue. An idle worker
+ * takes from its own deque, then the injection queue, then steals from the other workers, and
+ * finally sleeps on an epoch counter (C++20 `atomic::wait`) that every submission bumps.
+ *
+ * When a job has run, it is pushed to an intrusive lock-free MPSC completion queue. The game
+ * thread drains it from `OnUpdate` via `DrainCompletions`, which calls each job's `complete`
+ * callback, so results are always consumed on the thread that owns the plugin state.
+ *
+ * `Stop` lets the workers finish every queued job, joins them and then drains the remaining
+ * completions on the calling thread, so shutdown is deterministic and no completion is lost.
+ *
+ * With `WorkerPoolConfig::run_inline` the pool starts no threads: `Submit` runs the job before it
+ * returns and queues its completion for the next drain. Results then arrive on the same frame on
+ * every run, which the replay driver needs for a reproducible call log.
+ */
+#pragma once
+
+#include "BoundedQueue.hpp"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+namespace SPF_RedLightCamera
+{
+
+  /** @brief Upper bound on pool threads. */
+  constexpr uint32_t WORKER_MAX_THREADS = 8;
+
+  /** @brief Capacity of each worker's deque and of the injection queue (power of two). */
+  constexpr size_t WORKER_QUEUE_CAPACITY = 256;
+
+  /**
+   * @brief Base of every pool job. Derive from it and recover the derived type in the callbacks.
+   * @details A job may be resubmitted from its `complete` callback. It must not be submitted
+   *          again while it is queued or running.
+   */
+  struct WorkerJob
+  {
+    using Fn = void (*)(WorkerJob *job);
+
+    Fn run = nullptr;      ///< Runs on a pool thread.
+    Fn complete = nullptr; ///< Runs on the thread that calls `DrainCompletions`. Optional.
+
+    std::atomic<WorkerJob *> next{nullptr}; ///< Completion queue link (pool-owned).
+  };
+
+  /** @brief Scheduling options applied to every pool thread when it starts. */
+  struct WorkerPoolConfig
+  {
+    uint32_t threads = 2;      ///< Clamped to [1, WORKER_MAX_THREADS].
+    int32_t priority = -1;     ///< -2 (lowest) .. 2 (highest), 0 is normal. Raising may need privileges.
+    uint64_t affinity_mask = 0; ///< Bit `i` allows logical CPU `i`. 0 leaves affinity to the OS.
+    bool run_inline = false;    ///< Start no threads; `Submit` runs each job on the calling thread (deterministic replays).
+  };
+
+  /** @brief Counters for diagnostics and the benchmark. Read with relaxed ordering. */
+  struct WorkerPoolStats
+  {
+    uint64_t submitted;
+    uint64_t rejected; ///< Submissions refused because the pool was stopped or the queue was full.
+    uint64_t executed;
+    uint64_t stolen;   ///< Jobs a worker took from another worker's deque.
+  };
+
+  /**
+   * @brief Bounded Chase-Lev work-stealing deque (Lê et al., "Correct and Efficient Work-Stealing
+   *        for Weak Memory Models", 2013).
+   * @details `Push` and `Pop` are called only by the owning worker; `Steal` by anyone.
+   */
+  class alignas(64) WorkStealingDeque
+  {
+  public:
+    bool Push(WorkerJob *job);
+    WorkerJob *Pop();
+    WorkerJob *Steal();
+
+  private:
+    static constexpr size_t MASK = WORKER_QUEUE_CAPACITY - 1;
+
+    alignas(64) std::atomic<int64_t> m_top{0};
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    std::atomic<WorkerJob *> m_slots[WORKER_QUEUE_CAPACITY] = {};
+  };
+
+  /**
+   * @brief Intrusive unbounded multi-producer single-consumer queue (Vyukov), used for completions.
+   * @details `Pop` may return nullptr while a producer is between its two steps; the job then
+   *          shows up on the next drain.
+   */
+  class CompletionQueue
+  {
+  public:
+    CompletionQueue() : m_head(&m_stub), m_tail(&m_stub) {}
+    void Push(WorkerJob *job);
+    WorkerJob *Pop(); ///< Single consumer only.
+
+  private:
+    WorkerJob m_stub;
+    alignas(64) std::atomic<WorkerJob *> m_head;
+    alignas(64) WorkerJob *m_tail;
+  };
+
+  /**
+   * @brief The pool. `Start`, `Stop` and `DrainCompletions` are called from the game thread;
+   *        `Submit` from any thread.
+   */
+  class WorkerPool
+  {
+  public:
+    WorkerPool() = default;
+    ~WorkerPool() { Stop(); }
+    WorkerPool(const WorkerPool &) = delete;
+    WorkerPool &operator=(const WorkerPool &) = delete;
+
+    /** @brief Starts the threads. Returns false if the pool is already running. */
+    bool Start(const WorkerPoolConfig &config);
+
+    /** @brief Finishes all queued jobs, joins the threads and drains the remaining completions. */
+    void Stop();
+
+    bool IsRunning() const { return m_threadCount != 0 || m_inline; }
+    uint32_t GetThreadCount() const { return m_threadCount; }
+
+    /**
+     * @brief Queues a job.
+     * @return false if the pool is not running or the target queue is full. The job is then untouched.
+     */
+    bool Submit(WorkerJob *job);
+
+    /**
+     * @brief Runs the `complete` callback of up to `max_jobs` finished jobs on the calling thread.
+     * @return Number of completions processed.
+     */
+    size_t DrainCompletions(size_t max_jobs = SIZE_MAX);
+
+    WorkerPoolStats GetStats() const;
+
+  private:
+    void WorkerMain(uint32_t index);
+    WorkerJob *FindJob(uint32_t index);
+    void Execute(WorkerJob *job);
+    void Wake(bool all);
+
+    WorkStealingDeque m_deques[WORKER_MAX_THREADS];
+    BoundedMpmcQueue<WorkerJob *, WORKER_QUEUE_CAPACITY> m_injection; ///< Submissions from outside the pool.
+    CompletionQueue m_completions;
+
+    std::thread m_threads[WORKER_MAX_THREADS];
+    uint32_t m_threadCount = 0;
+    bool m_inline = false; ///< Started with `run_inline`.
+    WorkerPoolConfig m_config;
+
+    alignas(64) std::atomic<uint32_t> m_epoch{0};  ///< Bumped on every submission; idle workers wait on it.
+    std::atomic<int64_t> m_queued{0};              ///< Jobs submitted but not yet taken by a worker.
+    std::atomic<bool> m_stopping{false};
+
+    std::atomic<uint64_t> m_submitted{0};
+    std::atomic<uint64_t> m_rejected{0};
+    std::atomic<uint64_t> m_executed{0};
+    std::atomic<uint64_t> m_stolen{0};
+  };
+
+} // namespace SPF_RedLightCamera
@@ -0,0 +1,678 @@
+/**
+ * @file CoreTests.cpp
+ * @brief Tests for the capture state machine, rig pose maths, screenshot naming, recordings, the
+ *        capture journal checkpoint, repeat-fine attachment, the capture history, the violation
+ *        heatmap and track decimation.
+ */
+
+#include "TestHarness.hpp"
+
+#include "CaptureDedup.hpp"
+#include "CaptureJournal.hpp"
+#include "CaptureNaming.hpp"
+#include "CaptureSequence.hpp"
+#include "HistoryStore.hpp"
+#include "LzBlock.hpp"
+#include "RigPose.hpp"
+#include "TelemetryRecorder.hpp"
+#include "TrackExport.hpp"
+#include "ViolationHeatmap.hpp"
+
+#include <cmath>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+
+using namespace SPF_RedLightCamera;
+
+// =================================================================================================
+// 1. CaptureSequence
+// =================================================================================================
+
+RLC_TEST(CaptureSequenceRunsStandardSteps)
+{
+    CaptureSequence sequence;
+    RLC_CHECK(sequence.OnFine("red_signal", false) == FineOutcome::Started);
+    RLC_CHECK(std::strcmp(sequence.GetLabel(), CaptureSequence::RED_LIGHT_LABEL) == 0);
+
+    const CaptureStep expected[] = {CaptureStep::SnapshotAndPose, CaptureStep::Screenshot, CaptureStep::Restore,
+                                    CaptureStep::Fade, CaptureStep::Fade, CaptureStep::Fade, CaptureStep::Finish};
+    for (CaptureStep step : expected)
+    {
+        RLC_CHECK(sequence.Advance() == step);
+    }
+    RLC_CHECK(!sequence.IsActive());
+    RLC_CHECK(sequence.Advance() == CaptureStep::Idle);
+}
+
+RLC_TEST(CaptureSequenceQueuesRedLightBehindTrafficCapture)
+{
+    CaptureSequence sequence;
+    RLC_CHECK(sequence.OnFine("speeding_camera", false) == FineOutcome::Ignored);
+    RLC_CHECK(sequence.Start("traffic_7_speeding", false));
+    RLC_CHECK(!sequence.Start("traffic_8_speeding", false));
+
+    RLC_CHECK(sequence.OnFine("red_signal", true) == FineOutcome::Queued);
+    RLC_CHECK(sequence.OnFine("red_signal", false) == FineOutcome::Dropped);
+    RLC_CHECK(!sequence.StartPending()); // Still busy with the traffic capture.
+
+    sequence.Finish();
+    RLC_CHECK(sequence.StartPending());
+    RLC_CHECK(sequence.IsCinematic());
+    RLC_CHECK(!sequence.HasPending());
+    RLC_CHECK(sequence.Advance() == CaptureStep::CinematicSetup);
+    RLC_CHECK(sequence.Advance() == CaptureStep::CinematicPlayback);
+
+    sequence.DowngradeToStandard();
+    RLC_CHECK(sequence.Advance() == CaptureStep::SnapshotAndPose);
+}
+
+RLC_TEST(CaptureSequenceTruncatesLongLabels)
+{
+    const std::string label(CaptureSequence::MAX_LABEL * 2, 'x');
+    CaptureSequence sequence;
+    RLC_CHECK(sequence.Start(label.c_str(), false));
+    RLC_CHECK(std::strlen(sequence.GetLabel()) == CaptureSequence::MAX_LABEL - 1);
+}
+
+// =================================================================================================
+// 2. Rig Pose
+// =================================================================================================
+
+RLC_TEST(RigPosePlacesCameraAheadAndAimsAtTruck)
+{
+    const SPF_DVector truck = {100.0, 10.0, -50.0};
+    const RigPose pose = ComputeRigPose(truck, 0.0, 25.0, 4.0, 70.0f);
+    RLC_CHECK_NEAR(pose.camera.x, 100.0, 1e-9);
+    RLC_CHECK_NEAR(pose.camera.y, 14.0, 1e-9);
+    RLC_CHECK_NEAR(pose.camera.z, -75.0, 1e-9);
+    RLC_CHECK(pose.oriented);
+    RLC_CHECK_NEAR(std::fabs(pose.yaw), 3.14159265, 1e-6); // Looking back down +Z.
+    RLC_CHECK_NEAR(pose.pitch, std::atan2(-4.0, 25.0), 1e-6);
+    RLC_CHECK(pose.fov == 70.0f);
+
+    // A quarter turn clockwise swings the camera round to the -X side.
+    const RigPose turned = ComputeRigPose(truck, 0.25, 25.0, 4.0, 70.0f);
+    RLC_CHECK_NEAR(turned.camera.x, 75.0, 1e-9);
+    RLC_CHECK_NEAR(turned.camera.z, -50.0, 1e-9);
+
+    // A rig on the truck has no look direction.
+    RLC_CHECK(!ComputeRigPose(truck, 0.0, 0.0, 0.0, 70.0f).oriented);
+}
+
+RLC_TEST(FrameRigTargetsOnlyWidensWithinLimits)
+{
+    RigPose pose = ComputeRigPose({0.0, 0.0, 0.0}, 0.0, 25.0, 4.0, 50.0f);
+    const SPF_DVector far_apart[] = {{-60.0, 0.0, 0.0}, {60.0, 0.0, 0.0}};
+    FramingLimits limits;
+    limits.max_fov = 90.0;
+    FrameRigTargets(pose, far_apart, 2, 16.0 / 9.0, limits);
+    RLC_CHECK(pose.fov > 50.0f);
+    RLC_CHECK(pose.fov <= 90.0f);
+    RLC_CHECK_NEAR(pose.look_target.x, 0.0, 1e-9);
+
+    RigPose narrow = ComputeRigPose({0.0, 0.0, 0.0}, 0.0, 25.0, 4.0, 100.0f);
+    const SPF_DVector close[] = {{1.0, 0.0, 0.0}};
+    FrameRigTargets(narrow, close, 1, 16.0 / 9.0, limits);
+    RLC_CHECK(narrow.fov == 100.0f);
+    RLC_CHECK_NEAR(narrow.look_target.x, 1.0 / 3.0, 1e-9);
+}
+
+// =================================================================================================
+// 3. Capture Naming
+// =================================================================================================
+
+RLC_TEST(ScreenshotCommandNamesCapture)
+{
+    char command[128];
+    const size_t length = FormatScreenshotCommand(command, sizeof(command), "red_light", {-140.7, 10.2, -112.9}, 15016967, -1);
+    RLC_CHECK(length == std::strlen(command));
+    RLC_CHECK(std::strcmp(command, "screenshot red_light_X-140_Y10_Z-112_T15016967") == 0);
+    RLC_CHECK(std::strcmp(ScreenshotNameOf(command), "red_light_X-140_Y10_Z-112_T15016967") == 0);
+
+    FormatScreenshotCommand(command, sizeof(command), "red_light", {1.0, 2.0, 3.0}, 4, 2);
+    RLC_CHECK(std::strcmp(command, "screenshot red_light_X1_Y2_Z3_T4_S2") == 0);
+}
+
+RLC_TEST(ScreenshotCommandRejectsShortBuffer)
+{
+    char command[16];
+    RLC_CHECK(FormatScreenshotCommand(command, sizeof(command), "red_light", {1.0, 2.0, 3.0}, 4, -1) == 0);
+    RLC_CHECK(command[0] == '\0');
+    RLC_CHECK(std::strcmp(ScreenshotNameOf("quit"), "quit") == 0);
+}
+
+// =================================================================================================
+// 4. Telemetry Recording
+// =================================================================================================
+
+RLC_TEST(TelemetryRecordingRoundTrips)
+{
+    const std::string path = std::string(Tests::TempDir()) + "/round_trip.rlcrec";
+    {
+        TelemetryRecorder recorder;
+        RLC_CHECK(recorder.Open(path.c_str()));
+        for (int i = 0; i < 3; ++i)
+        {
+            SPF_TruckData truck{};
+            SPF_Timestamps timestamps{};
+            truck.world_placement.position = {(double)i, 10.0, -(double)i};
+            truck.world_placement.orientation.heading = 0.125 * i;
+            truck.speed = 15.0f;
+            timestamps.simulation = (uint64_t)i * 16667;
+            recorder.WriteFrame(truck, timestamps);
+        }
+
+        SPF_GameplayEvents event{};
+        std::memset(event.player_fined.fine_offence, 'r', sizeof(event.player_fined.fine_offence)); // Unterminated.
+        event.player_fined.fine_amount = 300;
+        recorder.WriteEvent("player.fined", &event);
+        recorder.Close();
+    }
+
+    TelemetryReader reader;
+    RLC_CHECK(reader.Open(path.c_str()));
+    ReplayRecord record;
+    for (int i = 0; i < 3; ++i)
+    {
+        RLC_CHECK(reader.Next(record));
+        RLC_CHECK(record.type == RecordType::Frame);
+        RLC_CHECK(record.frame.world_placement.position.x == (double)i);
+        RLC_CHECK(record.frame.world_placement.orientation.heading == 0.125 * i);
+        RLC_CHECK(record.frame.timestamps.simulation == (uint64_t)i * 16667);
+    }
+    RLC_CHECK(reader.Next(record));
+    RLC_CHECK(record.type == RecordType::GameplayEvent);
+    RLC_CHECK(std::strcmp(record.event.event_id, "player.fined") == 0);
+    RLC_CHECK(std::strlen(record.event.fine_offence) == sizeof(record.event.fine_offence) - 1);
+    RLC_CHECK(record.event.fine_amount == 300);
+    RLC_CHECK(!reader.Next(record));
+}
+
+// =================================================================================================
+// 5. Capture Journal
+// =================================================================================================
+
+RLC_TEST(JournalCheckpointWrittenThroughSeparateHandle)
+{
+    const std::string path = std::string(Tests::TempDir()) + "/split_checkpoint.rlcj";
+    const std::string copy = std::string(Tests::TempDir()) + "/split_checkpoint_copy.rlcj";
+    const uint8_t payload[40] = {};
+
+    CaptureJournal journal;
+    JournalRecovery recovery;
+    RLC_CHECK(journal.Open(path.c_str(), recovery));
+    RLC_CHECK(recovery.created);
+    for (int i = 0; i < 3; ++i)
+    {
+        RLC_CHECK(journal.Append(JournalRecordType::Fine, payload, sizeof(payload)));
+    }
+
+    JournalCheckpoint checkpoint;
+    RLC_CHECK(journal.PrepareCheckpoint(checkpoint));
+    RLC_CHECK(checkpoint.length == journal.GetLength());
+    const uint64_t checkpointed = journal.GetLength();
+
+    // Appends carry on while the checkpoint is written elsewhere.
+    RLC_CHECK(journal.Append(JournalRecordType::Fine, payload, sizeof(payload)));
+    RLC_CHECK(CaptureJournal::WriteCheckpoint(path.c_str(), checkpoint));
+    journal.FinishCheckpoint(checkpoint, true);
+    RLC_CHECK(journal.GetUnsyncedBytes() == journal.GetLength() - checkpointed);
+
+    // A copy taken before Close sees the new slot and only has the last record to validate.
+    std::error_code error;
+    std::filesystem::copy_file(path, copy, std::filesystem::copy_options::overwrite_existing, error);
+    RLC_CHECK(!error);
+    CaptureJournal reopened;
+    RLC_CHECK(reopened.Open(copy.c_str(), recovery));
+    RLC_CHECK(recovery.records == 4);
+    RLC_CHECK(recovery.tail_records == 1);
+    RLC_CHECK(recovery.dropped_bytes == 0);
+    reopened.Close();
+
+    journal.Close();
+    RLC_CHECK(!journal.PrepareCheckpoint(checkpoint));
+}
+
+RLC_TEST(JournalStopsAfterFailedCheckpoint)
+{
+    const std::string path = std::string(Tests::TempDir()) + "/failed_checkpoint.rlcj";
+    const uint8_t payload[8] = {};
+
+    CaptureJournal journal;
+    JournalRecovery recovery;
+    RLC_CHECK(journal.Open(path.c_str(), recovery));
+    RLC_CHECK(journal.Append(JournalRecordType::Fine, payload, sizeof(payload)));
+
+    JournalCheckpoint checkpoint;
+    RLC_CHECK(journal.PrepareCheckpoint(checkpoint));
+    RLC_CHECK(!CaptureJournal::WriteCheckpoint(nullptr, checkpoint));
+    journal.FinishCheckpoint(checkpoint, false);
+    RLC_CHECK(!journal.Append(JournalRecordType::Fine, payload, sizeof(payload)));
+    journal.Close();
+}
+
+// =================================================================================================
+// 6. Capture History
+// =================================================================================================
+
+namespace
+{
+    // A fresh, empty directory under the test directory.
+    std::string MakeHistoryDir(const char *name)
+    {
+        const std::filesystem::path dir = std::filesystem::path(Tests::TempDir()) / name;
+        std::error_code error;
+        std::filesystem::remove_all(dir, error);
+        std::filesystem::create_directories(dir, error);
+        return dir.string();
+    }
+
+    HistoryRecord MakeHistoryRecord(uint64_t index)
+    {
+        HistoryRecord record;
+        record.time_us = 1000000 + index * 1000000;
+        record.position = {-5000.0 + (double)index * 7.25, 40.0 - (double)(index % 3), 12000.5 - (double)index * 3.5};
+        record.heading = (double)(index % 16) / 16.0;
+        record.speed = (float)(index % 30);
+        record.kind = index % 50 == 0 ? HistoryKind::RedLightFine : HistoryKind::Sample;
+        return record;
+    }
+
+    // Reads every segment in `directory` in sequence order; returns the records, -1 on a damaged one.
+    int64_t CountHistoryRecords(const char *directory, bool &in_order)
+    {
+        uint32_t sequences[64];
+        const size_t count = ListHistorySegments(directory, sequences, 64);
+        int64_t records = 0;
+        uint64_t last_time = 0;
+        in_order = true;
+        for (size_t i = 0; i < count; ++i)
+        {
+            char path[HISTORY_PATH_SIZE];
+            HistoryReader reader;
+            if (!FormatHistorySegmentPath(path, sizeof(path), directory, sequences[i]) || !reader.Open(path))
+            {
+                return -1;
+            }
+            HistoryRecord record;
+            while (reader.Next(record))
+            {
+                in_order = in_order && record.time_us > last_time;
+                last_time = record.time_us;
+                ++records;
+            }
+            if (reader.IsDamaged())
+            {
+                return -1;
+            }
+        }
+        return records;
+    }
+} // namespace
+
+RLC_TEST(HistoryBlockRoundTripsSignedDeltas)
+{
+    // Deltas of both signs, a heading that wraps past 1, a time jump and a stop.
+    HistoryRecord records[5];
+    records[0].time_us = 5;
+    records[0].position = {-123456.78, 0.01, 98765.43};
+    records[0].heading = 0.99;
+    records[0].speed = 27.5f;
+    records[1] = records[0];
+    records[1].time_us = 1000005;
+    records[1].position = {-123450.00, -3.2, 98770.00};
+    records[1].heading = 0.01;
+    records[2] = records[1];
+    records[2].time_us = (uint64_t)1 << 40;
+    records[2].position = {123456.78, 250.0, -98765.43};
+    records[2].heading = 0.5;
+    records[2].speed = -3.25f;
+    records[2].kind = HistoryKind::RedLightFine;
+    records[3] = records[2];
+    records[3].speed = 0.0f;
+    records[4] = records[3];
+    records[4].kind = HistoryKind::OtherFine;
+
+    uint8_t encoded[5 * HISTORY_MAX_RECORD_BYTES];
+    const size_t size = EncodeHistoryBlock(records, 5, encoded, sizeof(encoded));
+    RLC_CHECK(size != 0);
+    RLC_CHECK(EncodeHistoryBlock(records, 5, encoded, sizeof(encoded) - 1) == 0);
+
+    HistoryRecord decoded[5];
+    RLC_CHECK(DecodeHistoryBlock(encoded, size, 5, decoded));
+    for (int i = 0; i < 5; ++i)
+    {
+        RLC_CHECK(decoded[i].time_us == records[i].time_us);
+        RLC_CHECK_NEAR(decoded[i].position.x, records[i].position.x, 0.005);
+        RLC_CHECK_NEAR(decoded[i].position.y, records[i].position.y, 0.005);
+        RLC_CHECK_NEAR(decoded[i].position.z, records[i].position.z, 0.005);
+        RLC_CHECK_NEAR(decoded[i].heading, records[i].heading, 1.0 / 65536.0);
+        RLC_CHECK_NEAR(decoded[i].speed, records[i].speed, 0.005);
+        RLC_CHECK(decoded[i].kind == records[i].kind);
+    }
+
+    // A truncated block, or one with bytes left over, is refused.
+    RLC_CHECK(!DecodeHistoryBlock(encoded, size - 1, 5, decoded));
+    RLC_CHECK(!DecodeHistoryBlock(encoded, size, 4, decoded));
+}
+
+RLC_TEST(LzBlockRoundTrips)
+{
+    // An encoded history block: repetitive, as sealing sees it.
+    HistoryRecord records[HISTORY_BLOCK_RECORDS];
+    for (size_t i = 0; i < HISTORY_BLOCK_RECORDS; ++i)
+    {
+        records[i] = MakeHistoryRecord(i);
+    }
+    static uint8_t encoded[HISTORY_BLOCK_CAPACITY];
+    static uint8_t compressed[LzCompressBound(HISTORY_BLOCK_CAPACITY)];
+    static uint8_t decompressed[HISTORY_BLOCK_CAPACITY];
+    const size_t size = EncodeHistoryBlock(records, HISTORY_BLOCK_RECORDS, encoded, sizeof(encoded));
+    const size_t packed = LzCompressBlock(encoded, size, compressed, sizeof(compressed));
+    RLC_CHECK(packed != 0 && packed < size);
+    RLC_CHECK(LzDecompressBlock(compressed, packed, decompressed, sizeof(decompressed)) == size);
+    RLC_CHECK(std::memcmp(encoded, decompressed, size) == 0);
+
+    // Incompressible bytes still round trip within the bound.
+    uint32_t state = 0x12345678u;
+    for (size_t i = 0; i < size; ++i)
+    {
+        state = state * 1664525u + 1013904223u;
+        encoded[i] = (uint8_t)(state >> 24);
+    }
+    const size_t stored = LzCompressBlock(encoded, size, compressed, sizeof(compressed));
+    RLC_CHECK(stored != 0 && stored <= LzCompressBound(size));
+    RLC_CHECK(LzDecompressBlock(compressed, stored, decompressed, sizeof(decompressed)) == size);
+    RLC_CHECK(std::memcmp(encoded, decompressed, size) == 0);
+
+    // A truncated block fails instead of overrunning.
+    RLC_CHECK(LzDecompressBlock(compressed, stored / 2, decompressed, sizeof(decompressed)) == SIZE_MAX);
+}
+
+RLC_TEST(HistoryMaintenanceMergesSmallSegments)
+{
+    const std::string dir = MakeHistoryDir("history_merge");
+    auto writer = std::make_unique<HistoryWriter>();
+    uint64_t index = 0;
+    for (int session = 0; session < 3; ++session)
+    {
+        RLC_CHECK(writer->Open(dir.c_str()));
+        RLC_CHECK(writer->GetActiveSequence() == (uint32_t)session + 1);
+        for (int i = 0; i < 300; ++i)
+        {
+            writer->Append(MakeHistoryRecord(index++));
+        }
+        writer->Close();
+    }
+
+    // Keep a copy of segment 3 to play the leftover of a merge interrupted before its deletes.
+    char path[HISTORY_PATH_SIZE];
+    FormatHistorySegmentPath(path, sizeof(path), dir.c_str(), 3);
+    const std::string leftover = dir + "/leftover.bin";
+    std::error_code error;
+    std::filesystem::copy_file(path, leftover, error);
+    RLC_CHECK(!error);
+
+    HistoryMaintenanceResult result = MaintainHistory(dir.c_str(), 0);
+    RLC_CHECK(result.sealed == 3);
+    RLC_CHECK(result.merged == 2);
+    RLC_CHECK(result.failures == 0);
+    RLC_CHECK(result.bytes_after < result.bytes_before);
+
+    uint32_t sequences[8];
+    RLC_CHECK(ListHistorySegments(dir.c_str(), sequences, 8) == 1);
+    HistoryReader reader;
+    FormatHistorySegmentPath(path, sizeof(path), dir.c_str(), 1);
+    RLC_CHECK(reader.Open(path));
+    RLC_CHECK(reader.IsSealed());
+    RLC_CHECK(reader.GetLastSequence() == 3);
+    reader.Close();
+
+    bool in_order = false;
+    RLC_CHECK(CountHistoryRecords(dir.c_str(), in_order) == (int64_t)index);
+    RLC_CHECK(in_order);
+
+    // The leftover is recognised through last_sequence and removed, not read twice.
+    FormatHistorySegmentPath(path, sizeof(path), dir.c_str(), 3);
+    std::filesystem::rename(leftover, path, error);
+    RLC_CHECK(!error);
+    result = MaintainHistory(dir.c_str(), 0);
+    RLC_CHECK(result.leftovers == 1);
+    RLC_CHECK(!std::filesystem::exists(path));
+    RLC_CHECK(CountHistoryRecords(dir.c_str(), in_order) == (int64_t)index);
+
+    // A new writer numbers its segment after everything the merge covered.
+    RLC_CHECK(writer->Open(dir.c_str()));
+    RLC_CHECK(writer->GetActiveSequence() == 4);
+    writer->Close();
+}
+
+RLC_TEST(HistoryMaintenanceLeavesWriterSegmentsAlone)
+{
+    const std::string dir = MakeHistoryDir("history_active");
+    auto writer = std::make_unique<HistoryWriter>();
+    uint64_t index = 0;
+    RLC_CHECK(writer->Open(dir.c_str()));
+    for (int i = 0; i < 100; ++i)
+    {
+        writer->Append(MakeHistoryRecord(index++));
+    }
+    writer->Close();
+
+    RLC_CHECK(writer->Open(dir.c_str()));
+    const uint32_t active = writer->GetActiveSequence();
+    RLC_CHECK(active == 2);
+
+    // The run starts before the writer rolls over: neither the segment it was given nor the next
+    // one may be touched, while the writer keeps appending to them.
+    while (!writer->ConsumeRollover())
+    {
+        writer->Append(MakeHistoryRecord(index++));
+    }
+    RLC_CHECK(writer->GetActiveSequence() == active + 1);
+    for (int i = 0; i < 10; ++i)
+    {
+        writer->Append(MakeHistoryRecord(index++));
+    }
+    writer->Flush();
+
+    HistoryMaintenanceResult result = MaintainHistory(dir.c_str(), active);
+    RLC_CHECK(result.sealed == 1);
+    RLC_CHECK(result.merged == 0);
+    char path[HISTORY_PATH_SIZE];
+    HistoryReader reader;
+    FormatHistorySegmentPath(path, sizeof(path), dir.c_str(), active);
+    RLC_CHECK(reader.Open(path));
+    RLC_CHECK(!reader.IsSealed());
+    reader.Close();
+
+    for (int i = 0; i < 10; ++i)
+    {
+        writer->Append(MakeHistoryRecord(index++));
+    }
+    writer->Close();
+
+    // After Close the last segment is still left alone, so a reopen cannot race it.
+    RLC_CHECK(writer->GetActiveSequence() == active + 1);
+    result = MaintainHistory(dir.c_str(), writer->GetActiveSequence());
+    RLC_CHECK(result.sealed == 1);
+    FormatHistorySegmentPath(path, sizeof(path), dir.c_str(), active + 1);
+    RLC_CHECK(reader.Open(path));
+    RLC_CHECK(!reader.IsSealed());
+    reader.Close();
+
+    result = MaintainHistory(dir.c_str(), 0);
+    RLC_CHECK(result.sealed == 1);
+    RLC_CHECK(result.failures == 0);
+    bool in_order = false;
+    RLC_CHECK(CountHistoryRecords(dir.c_str(), in_order) == (int64_t)index);
+    RLC_CHECK(in_order);
+}
+
+// =================================================================================================
+// 7. Violation Heatmap
+// =================================================================================================
+
+RLC_TEST(HeatmapReloadsAndCompactsItsLog)
+{
+    const std::string path = std::string(Tests::TempDir()) + "/heatmap.rlch";
+    std::error_code error;
+    std::filesystem::remove(path, error);
+
+    auto grid = std::make_unique<HeatmapGrid>();
+    RLC_CHECK(grid->Open(path.c_str()));
+    RLC_CHECK(!grid->WasCompacted());
+    for (int i = 0; i < 3; ++i)
+    {
+        grid->Add(10.0, 10.0);
+    }
+    for (int i = 0; i < 2000; ++i)
+    {
+        grid->Add(1000.0 + i % 40, -520.0);
+    }
+    grid->Close();
+
+    // Far more records than cells: folded back, then rewritten with one record per cell.
+    const uint64_t compacted_size = sizeof(HeatmapFileHeader) + 2 * sizeof(HeatmapRecord);
+    RLC_CHECK(grid->Open(path.c_str()));
+    RLC_CHECK(grid->GetLoadedRecords() == 2003);
+    RLC_CHECK(grid->WasCompacted());
+    RLC_CHECK(grid->GetCellCount() == 2);
+    RLC_CHECK(grid->GetTotal() == 2003);
+    RLC_CHECK(grid->GetMaxCount() == 2000);
+    grid->Close();
+    RLC_CHECK(std::filesystem::file_size(path, error) == compacted_size);
+    RLC_CHECK(!std::filesystem::exists(path + ".tmp"));
+
+    RLC_CHECK(grid->Open(path.c_str()));
+    RLC_CHECK(grid->GetLoadedRecords() == 2);
+    RLC_CHECK(!grid->WasCompacted());
+    grid->Close();
+
+    // A torn last record is dropped by a rewrite, not appended after.
+    FILE *file = std::fopen(path.c_str(), "ab");
+    RLC_CHECK(file != nullptr);
+    if (file)
+    {
+        std::fwrite("torn", 1, 4, file);
+        std::fclose(file);
+    }
+    RLC_CHECK(grid->Open(path.c_str()));
+    RLC_CHECK(grid->WasCompacted());
+    RLC_CHECK(grid->GetTotal() == 2003);
+    grid->Close();
+    RLC_CHECK(std::filesystem::file_size(path, error) == compacted_size);
+}
+
+RLC_TEST(HeatmapKeepsFileWhenRewriteFails)
+{
+    const std::string path = std::string(Tests::TempDir()) + "/heatmap_blocked.rlch";
+    std::error_code error;
+    std::filesystem::remove(path, error);
+    std::filesystem::remove_all(path + ".tmp", error);
+
+    // Another version: the file has to be rewritten, but the temporary file cannot be created.
+    HeatmapFileHeader header{};
+    std::memcpy(header.magic, HEATMAP_MAGIC, sizeof(header.magic));
+    header.version = HEATMAP_VERSION + 1;
+    header.cell_size = (float)HEATMAP_CELL_SIZE;
+    FILE *file = std::fopen(path.c_str(), "wb");
+    RLC_CHECK(file != nullptr);
+    if (file)
+    {
+        std::fwrite(&header, sizeof(header), 1, file);
+        std::fclose(file);
+    }
+    std::filesystem::create_directory(path + ".tmp", error);
+
+    auto grid = std::make_unique<HeatmapGrid>();
+    RLC_CHECK(!grid->Open(path.c_str()));
+    RLC_CHECK(std::filesystem::file_size(path, error) == sizeof(header));
+
+    std::filesystem::remove_all(path + ".tmp", error);
+    RLC_CHECK(grid->Open(path.c_str()));
+    grid->Close();
+    RLC_CHECK(std::filesystem::file_size(path, error) == sizeof(HeatmapFileHeader));
+}
+
+// =================================================================================================
+// 8. Repeat Fines
+// =================================================================================================
+
+RLC_TEST(DedupAttachesRepeatFinesToLiveCapture)
+{
+    CaptureDedup dedup;
+    dedup.Configure(25.0, 10000000);
+    DedupHit hit{};
+    RLC_CHECK(!dedup.Attach(100.0, 100.0, 1000000, hit));
+    dedup.Record(100.0, 100.0, 1000000, 7);
+
+    // Before the capture has its screenshot name, and from the cell next to it.
+    RLC_CHECK(dedup.Attach(110.0, 95.0, 2000000, hit));
+    RLC_CHECK(hit.capture_id == 7);
+    RLC_CHECK(hit.attached == 1);
+    RLC_CHECK(std::strcmp(hit.name, "") == 0);
+    dedup.SetName(7, "red_light_X100_Y0_Z100_T1000000");
+    RLC_CHECK(dedup.Attach(90.0, 110.0, 3000000, hit));
+    RLC_CHECK(hit.capture_id == 7);
+    RLC_CHECK(hit.attached == 2);
+    RLC_CHECK(std::strcmp(hit.name, "red_light_X100_Y0_Z100_T1000000") == 0);
+
+    // Further than one cell size, or once the window has passed (attached fines do not extend it).
+    RLC_CHECK(!dedup.Attach(130.0, 100.0, 3000000, hit));
+    RLC_CHECK(!dedup.Attach(100.0, 100.0, 11000000, hit));
+    RLC_CHECK(dedup.GetSuppressed() == 2);
+
+    // A newer capture in the same cell replaces the earlier one.
+    dedup.Record(100.0, 100.0, 20000000, 8);
+    dedup.Record(105.0, 104.0, 21000000, 9);
+    RLC_CHECK(dedup.Attach(101.0, 101.0, 22000000, hit));
+    RLC_CHECK(hit.capture_id == 9);
+    RLC_CHECK(hit.attached == 1);
+
+    dedup.Configure(25.0, 0);
+    RLC_CHECK(!dedup.IsEnabled());
+    RLC_CHECK(!dedup.Attach(101.0, 101.0, 22000000, hit));
+}
+
+// =================================================================================================
+// 9. Track Export
+// =================================================================================================
+
+RLC_TEST(DecimateTrackKeepsCornersWithinTolerance)
+{
+    HistoryRecord points[101];
+    uint8_t keep[101];
+    uint32_t stack[2 * 101];
+
+    // A straight road with 0.5 m of jitter: only the ends are kept.
+    for (int i = 0; i < 101; ++i)
+    {
+        points[i].position = {i * 10.0, 0.0, (i % 2) * 0.5};
+    }
+    RLC_CHECK(DecimateTrack(points, 101, 2.0, keep, stack) == 2);
+    RLC_CHECK(keep[0] && keep[100]);
+
+    // A right-angle turn keeps the corner as well.
+    for (int i = 0; i < 101; ++i)
+    {
+        points[i].position = i <= 50 ? SPF_DVector{i * 10.0, 0.0, 0.0} : SPF_DVector{500.0, 0.0, (i - 50) * 10.0};
+    }
+    RLC_CHECK(DecimateTrack(points, 101, 2.0, keep, stack) == 3);
+    RLC_CHECK(keep[0] && keep[50] && keep[100]);
+
+    // Distances are to the segment: a point on the line but past its end is kept.
+    points[0].position = {0.0, 0.0, 0.0};
+    points[1].position = {200.0, 0.0, 0.0};
+    points[2].position = {100.0, 0.0, 0.0};
+    RLC_CHECK(DecimateTrack(points, 3, 2.0, keep, stack) == 3);
+
+    // A climb counts too (3D), and a zero tolerance keeps every point.
+    points[1].position = {50.0, 10.0, 0.0};
+    RLC_CHECK(DecimateTrack(points, 3, 2.0, keep, stack) == 3);
+    RLC_CHECK(DecimateTrack(points, 101, 0.0, keep, stack) == 101);
+    RLC_CHECK(DecimateTrack(points, 2, 2.0, keep, stack) == 2);
+}
@@ -0,0 +1,332 @@
+/**
+ * @file ScreenshotQualityTests.cpp
+ * @brief Tests for the PNG luminance decoder and the screenshot quality checker.
+ */
+
+#include "TestHarness.hpp"
+
+#include "ScreenshotQuality.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    // 24 x 16 RGB, written by zlib at level 9 (one dynamic Huffman block), scanline filters cycling
+    // through None, Sub, Up, Average and Paeth. 4 x 4 squares alternate between white and a colour
+    // ramp; see CheckerPixel.
+    const uint8_t CHECKER_PNG[] = {
+    0x89, 0x50, 0x4E, 0x47, 0x0D, 0x0A, 0x1A, 0x0A, 0x00, 0x00, 0x00, 0x0D, 0x49, 0x48, 0x44, 0x52,
+    0x00, 0x00, 0x00, 0x18, 0x00, 0x00, 0x00, 0x10, 0x08, 0x02, 0x00, 0x00, 0x00, 0x83, 0x46, 0x28,
+    0xC2, 0x00, 0x00, 0x02, 0x7A, 0x49, 0x44, 0x41, 0x54, 0x78, 0xDA, 0x6D, 0x94, 0x41, 0x48, 0x54,
+    0x41, 0x1C, 0xC6, 0xBF, 0x75, 0x9F, 0x4E, 0xBB, 0x36, 0xAF, 0x34, 0xB7, 0x30, 0xD2, 0x8B, 0x9D,
+    0x34, 0x92, 0x4D, 0x94, 0x24, 0x45, 0x06, 0x42, 0xB0, 0x45, 0xB6, 0x1E, 0x79, 0xD0, 0x3A, 0xA9,
+    0x20, 0x9B, 0xB6, 0x3D, 0x89, 0x90, 0x0C, 0xC4, 0x7D, 0x60, 0x18, 0x25, 0xEB, 0x62, 0x78, 0xD0,
+    0x46, 0x32, 0x0A, 0x31, 0x89, 0x58, 0xF1, 0x1D, 0xBC, 0x84, 0x30, 0x07, 0xE9, 0x90, 0x51, 0x20,
+    0x78, 0x90, 0xA0, 0x43, 0x88, 0xD2, 0x45, 0xF1, 0xD0, 0xA1, 0xD8, 0x66, 0xDD, 0x9C, 0xDD, 0xA9,
+    0xFE, 0x7C, 0x87, 0x37, 0xBF, 0x07, 0x1F, 0x7F, 0xE6, 0xFB, 0xDE, 0x03, 0x00, 0x02, 0x98, 0x40,
+    0x00, 0x48, 0xE5, 0xCC, 0x45, 0xA0, 0x09, 0x68, 0x06, 0x5A, 0x75, 0x6E, 0x03, 0x03, 0xC0, 0x10,
+    0x30, 0xA2, 0x73, 0x0F, 0xA8, 0x34, 0xF2, 0x64, 0xB4, 0xB3, 0xF7, 0x13, 0x87, 0x53, 0x6F, 0xFA,
+    0x14, 0x5F, 0xDC, 0xDB, 0x57, 0xBC, 0xDF, 0x2C, 0x52, 0x7C, 0x70, 0xEF, 0xBB, 0xE2, 0x79, 0xD2,
+    0x08, 0x54, 0xDA, 0xC9, 0x07, 0x2F, 0x72, 0x87, 0x1E, 0x01, 0xF5, 0x81, 0xFA, 0x41, 0x0B, 0x75,
+    0x7E, 0x1C, 0xB4, 0x08, 0xB4, 0x18, 0xF4, 0x44, 0x2E, 0xF6, 0xE2, 0x34, 0x0C, 0x92, 0x67, 0x10,
+    0xAF, 0xD4, 0xBD, 0xBE, 0x07, 0xEA, 0x05, 0x9F, 0x4E, 0x18, 0xA4, 0xC0, 0x20, 0x44, 0xAA, 0xBD,
+    0xEF, 0x8E, 0xE2, 0xCB, 0xD3, 0xB3, 0x06, 0xF1, 0x1B, 0xA4, 0x50, 0xAA, 0xB1, 0xAF, 0x4B, 0x71,
+    0x23, 0xB5, 0x91, 0x52, 0x87, 0xB2, 0x5A, 0xB9, 0xB6, 0x91, 0xD1, 0xDA, 0xC6, 0x96, 0xE2, 0x6D,
+    0xB5, 0x41, 0xC5, 0x27, 0x37, 0x3E, 0x2A, 0x3E, 0x56, 0x7B, 0x4D, 0x71, 0xED, 0xC2, 0xCE, 0xB0,
+    0x92, 0x0A, 0x56, 0x5A, 0xC9, 0xCA, 0x83, 0xAC, 0x22, 0x97, 0x5F, 0x67, 0x0D, 0x37, 0x18, 0xEB,
+    0x64, 0xCD, 0x11, 0x16, 0xCA, 0xE5, 0x4F, 0x58, 0xF7, 0x04, 0x8B, 0x4C, 0xB1, 0xE8, 0x2C, 0xBB,
+    0xEB, 0x91, 0xE7, 0xEC, 0x46, 0xE1, 0x52, 0x82, 0x82, 0x8C, 0xD6, 0x92, 0xEB, 0xD9, 0x8D, 0xC2,
+    0x2D, 0x8A, 0x4F, 0x26, 0x5F, 0x65, 0x37, 0x0A, 0xDF, 0x57, 0x3C, 0x4F, 0xBF, 0x48, 0x03, 0x34,
+    0x1F, 0xB4, 0x00, 0x94, 0xE8, 0xFC, 0x28, 0x28, 0x05, 0x35, 0x41, 0x8F, 0xE9, 0xBC, 0x04, 0x34,
+    0x00, 0x7A, 0x12, 0xF4, 0x94, 0x37, 0xB6, 0x1D, 0x1B, 0x75, 0x1F, 0x3D, 0x76, 0xC7, 0xE2, 0x6E,
+    0x62, 0x6B, 0xE6, 0x5B, 0xD4, 0x8A, 0xF6, 0x5A, 0xBD, 0x3D, 0x56, 0x4F, 0x7D, 0x84, 0xBD, 0x74,
+    0xE7, 0xE7, 0xDC, 0x37, 0x0B, 0x6E, 0xF2, 0xED, 0xCC, 0xBC, 0x65, 0x59, 0x61, 0x2B, 0x1C, 0xB2,
+    0x42, 0xFD, 0x91, 0xD8, 0x8A, 0xFB, 0x5E, 0xB8, 0x1F, 0x56, 0xDD, 0x4F, 0x03, 0x33, 0xB7, 0xEB,
+    0xAC, 0xBA, 0x1A, 0xAB, 0xA6, 0xDA, 0xAA, 0x36, 0xD2, 0xF1, 0xC3, 0x93, 0xEE, 0x01, 0xFE, 0x89,
+    0x1F, 0xBE, 0x43, 0xE9, 0xF1, 0xFF, 0x97, 0xC3, 0x01, 0x71, 0xFC, 0xA6, 0x53, 0x12, 0x70, 0xCA,
+    0xB5, 0x66, 0x3B, 0x57, 0x9B, 0x9C, 0x8E, 0x66, 0xA7, 0xBB, 0xD5, 0x89, 0x6A, 0xCD, 0x76, 0x9E,
+    0x0F, 0x38, 0xAF, 0x87, 0x9C, 0xA5, 0x11, 0xE7, 0x9D, 0xDE, 0xEC, 0xB8, 0x6C, 0x76, 0x61, 0x46,
+    0x3B, 0xF6, 0x97, 0x6C, 0xB3, 0xC7, 0xDB, 0x15, 0x5F, 0xB4, 0x1F, 0x66, 0x9B, 0x3D, 0x9E, 0x54,
+    0x7C, 0xD0, 0x3E, 0x9F, 0x6D, 0x76, 0xCA, 0x4E, 0xFD, 0xB0, 0xF7, 0x77, 0xED, 0x6D, 0xE9, 0x52,
+    0xC6, 0x83, 0x67, 0x79, 0x63, 0x15, 0x6F, 0xB9, 0xC0, 0xDB, 0x56, 0xED, 0xB9, 0x15, 0xFB, 0xD9,
+    0xB2, 0x9D, 0x90, 0x2E, 0x6D, 0x3C, 0x71, 0x93, 0xF3, 0x2E, 0x3E, 0x7F, 0x8B, 0xBB, 0x71, 0x3B,
+    0x3C, 0x6A, 0x5F, 0x8E, 0xD9, 0xF5, 0xD2, 0x65, 0x8C, 0xEF, 0x3E, 0xE5, 0xBF, 0xA6, 0xB9, 0xEF,
+    0x05, 0x0F, 0x78, 0x87, 0x87, 0x87, 0x95, 0x6B, 0x7C, 0x93, 0x1B, 0xC4, 0x77, 0x50, 0x5C, 0x7F,
+    0x4F, 0x95, 0xA5, 0xF8, 0xC2, 0xE6, 0xBA, 0x41, 0xA8, 0x41, 0x4C, 0xA9, 0x50, 0x55, 0xB9, 0xE2,
+    0xAB, 0x9B, 0x12, 0xCA, 0x0F, 0xA0, 0x38, 0xAD, 0xBF, 0xE3, 0x47, 0x3E, 0x50, 0x70, 0xF0, 0x47,
+    0xD0, 0xE3, 0x4F, 0x87, 0x62, 0x1E, 0x48, 0x8F, 0xFF, 0x0F, 0x34, 0xF5, 0x66, 0x8B, 0x86, 0x0A,
+    0x11, 0xAA, 0x14, 0x1D, 0x41, 0x11, 0xD1, 0x9A, 0x2D, 0x96, 0x6E, 0x08, 0xD1, 0x29, 0x3E, 0x47,
+    0xC4, 0x57, 0xAD, 0xD9, 0xE2, 0xDC, 0x84, 0xB8, 0x34, 0x25, 0xAE, 0xCC, 0x8A, 0xF6, 0xDF, 0xA5,
+    0x0A, 0x46, 0x1C, 0x3E, 0x6D, 0xDD, 0x6E, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4E, 0x44, 0xAE,
+    0x42, 0x60, 0x82};
+
+    constexpr uint32_t CHECKER_WIDTH = 24;
+    constexpr uint32_t CHECKER_HEIGHT = 16;
+
+    void CheckerPixel(uint32_t x, uint32_t y, uint32_t rgb[3])
+    {
+        const bool white = ((x / 4 + y / 4) & 1) != 0;
+        rgb[0] = white ? 255 : x * 7 % 256;
+        rgb[1] = white ? 255 : y * 13 % 256;
+        rgb[2] = white ? 255 : x * y % 256;
+    }
+
+    void PutBigEndian32(std::vector<uint8_t> &out, uint32_t value)
+    {
+        const uint8_t bytes[4] = {(uint8_t)(value >> 24), (uint8_t)(value >> 16), (uint8_t)(value >> 8), (uint8_t)value};
+        out.insert(out.end(), bytes, bytes + 4);
+    }
+
+    // The decoder does not verify chunk CRCs or the Adler-32, so they are left zero.
+    void PutChunk(std::vector<uint8_t> &out, const char *type, const uint8_t *payload, size_t size)
+    {
+        PutBigEndian32(out, (uint32_t)size);
+        out.insert(out.end(), type, type + 4);
+        out.insert(out.end(), payload, payload + size);
+        PutBigEndian32(out, 0);
+    }
+
+    /**
+     * Builds an 8-bit grey PNG of `value` in one stored (uncompressed) deflate block; scanline `y`
+     * gets filter byte `filters[y]`, or None without `filters`.
+     */
+    std::vector<uint8_t> BuildStoredPng(uint32_t width, uint32_t height, uint8_t value, const uint8_t *filters = nullptr)
+    {
+        std::vector<uint8_t> scanlines;
+        for (uint32_t y = 0; y < height; ++y)
+        {
+            scanlines.push_back(filters ? filters[y] : 0);
+            scanlines.insert(scanlines.end(), width, value);
+        }
+
+        std::vector<uint8_t> zlib = {0x78, 0x01, 0x01};
+        const uint16_t length = (uint16_t)scanlines.size();
+        const uint8_t header[4] = {(uint8_t)length, (uint8_t)(length >> 8), (uint8_t)~length, (uint8_t)(~length >> 8)};
+        zlib.insert(zlib.end(), header, header + 4);
+        zlib.insert(zlib.end(), scanlines.begin(), scanlines.end());
+        PutBigEndian32(zlib, 0);
+
+        std::vector<uint8_t> png = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+        std::vector<uint8_t> ihdr;
+        PutBigEndian32(ihdr, width);
+        PutBigEndian32(ihdr, height);
+        const uint8_t format[5] = {8, 0, 0, 0, 0}; // 8-bit grey, not interlaced.
+        ihdr.insert(ihdr.end(), format, format + 5);
+        PutChunk(png, "IHDR", ihdr.data(), ihdr.size());
+        PutChunk(png, "IDAT", zlib.data(), zlib.size());
+        PutChunk(png, "IEND", nullptr, 0);
+        return png;
+    }
+
+    /** Offset of the first IDAT chunk's payload in `png`, and its length. */
+    size_t FindIdat(const uint8_t *png, size_t size, size_t &length)
+    {
+        for (size_t pos = 8; pos + 8 <= size;)
+        {
+            length = (size_t)png[pos] << 24 | (size_t)png[pos + 1] << 16 | (size_t)png[pos + 2] << 8 | png[pos + 3];
+            if (std::memcmp(png + pos + 4, "IDAT", 4) == 0)
+            {
+                return pos + 8;
+            }
+            pos += 12 + length;
+        }
+        length = 0;
+        return 0;
+    }
+
+    bool WriteFile(const std::string &path, const std::vector<uint8_t> &data)
+    {
+        FILE *file = std::fopen(path.c_str(), "wb");
+        if (!file)
+        {
+            return false;
+        }
+        const bool written = std::fwrite(data.data(), 1, data.size(), file) == data.size();
+        return std::fclose(file) == 0 && written;
+    }
+
+    bool Decode(PngLumaDecoder &decoder, const std::vector<uint8_t> &png, QualityImage &image)
+    {
+        uint32_t width = 0, height = 0;
+        return decoder.Decode(png.data(), png.size(), image, width, height);
+    }
+} // namespace
+
+// =================================================================================================
+// 1. PNG Decoder
+// =================================================================================================
+
+RLC_TEST(DecoderReadsKnownPng)
+{
+    auto decoder = std::make_unique<PngLumaDecoder>();
+    auto image = std::make_unique<QualityImage>();
+    uint32_t width = 0, height = 0;
+    RLC_CHECK(decoder->Decode(CHECKER_PNG, sizeof(CHECKER_PNG), *image, width, height));
+    RLC_CHECK(width == CHECKER_WIDTH && height == CHECKER_HEIGHT);
+    RLC_CHECK(image->width == CHECKER_WIDTH && image->height == CHECKER_HEIGHT); // Small enough to keep every pixel.
+
+    // BT.601 weights in 1/256, rounded.
+    size_t mismatches = 0;
+    for (uint32_t y = 0; y < CHECKER_HEIGHT; ++y)
+    {
+        for (uint32_t x = 0; x < CHECKER_WIDTH; ++x)
+        {
+            uint32_t rgb[3];
+            CheckerPixel(x, y, rgb);
+            const uint32_t luma = (77 * rgb[0] + 150 * rgb[1] + 29 * rgb[2] + 128) / 256;
+            mismatches += image->pixels[y * image->width + x] != luma ? 1 : 0;
+        }
+    }
+    RLC_CHECK(mismatches == 0);
+}
+
+RLC_TEST(DecoderReadsEveryFilterType)
+{
+    const uint8_t filters[5] = {0, 1, 2, 3, 4};
+    auto decoder = std::make_unique<PngLumaDecoder>();
+    auto image = std::make_unique<QualityImage>();
+    RLC_CHECK(Decode(*decoder, BuildStoredPng(32, 5, 40, filters), *image));
+    RLC_CHECK(image->width == 32 && image->height == 5);
+    RLC_CHECK(image->pixels[0] == 40); // None
+    RLC_CHECK(image->pixels[32 + 1] == 80); // Sub: 40 + 40
+}
+
+RLC_TEST(DecoderRejectsUndefinedFilterType)
+{
+    const uint8_t filters[4] = {0, 1, 5, 0};
+    auto decoder = std::make_unique<PngLumaDecoder>();
+    auto image = std::make_unique<QualityImage>();
+    RLC_CHECK(!Decode(*decoder, BuildStoredPng(32, 4, 40, filters), *image));
+
+    const uint8_t last[4] = {0, 0, 0, 255};
+    RLC_CHECK(!Decode(*decoder, BuildStoredPng(32, 4, 40, last), *image));
+
+    // The decoder is reused for the next file.
+    RLC_CHECK(Decode(*decoder, BuildStoredPng(32, 4, 40), *image));
+}
+
+RLC_TEST(DecoderRejectsTruncatedPng)
+{
+    auto decoder = std::make_unique<PngLumaDecoder>();
+    auto image = std::make_unique<QualityImage>();
+    uint32_t width = 0, height = 0;
+    size_t idat_length = 0;
+    const size_t idat = FindIdat(CHECKER_PNG, sizeof(CHECKER_PNG), idat_length);
+    RLC_CHECK(idat != 0);
+
+    // Cut anywhere before the end of the IDAT chunk: the chunks no longer fit the file.
+    const size_t idat_end = idat + idat_length + 4;
+    size_t decoded = 0;
+    for (size_t cut = 0; cut < idat_end; ++cut)
+    {
+        decoded += decoder->Decode(CHECKER_PNG, cut, *image, width, height) ? 1 : 0;
+    }
+    RLC_CHECK(decoded == 0);
+
+    // A well-formed file whose compressed stream stops early (less than the 4-byte Adler-32 and
+    // at least one deflate byte missing).
+    for (size_t kept = 0; kept + 5 <= idat_length; ++kept)
+    {
+        std::vector<uint8_t> png(CHECKER_PNG, CHECKER_PNG + idat - 8);
+        PutChunk(png, "IDAT", CHECKER_PNG + idat, kept);
+        PutChunk(png, "IEND", nullptr, 0);
+        decoded += Decode(*decoder, png, *image) ? 1 : 0;
+    }
+    RLC_CHECK(decoded == 0);
+
+    // Without IEND is enough.
+    RLC_CHECK(decoder->Decode(CHECKER_PNG, idat_end, *image, width, height));
+}
+
+RLC_TEST(DecoderRejectsCorruptPng)
+{
+    auto decoder = std::make_unique<PngLumaDecoder>();
+    auto image = std::make_unique<QualityImage>();
+    const std::vector<uint8_t> original(CHECKER_PNG, CHECKER_PNG + sizeof(CHECKER_PNG));
+    size_t idat_length = 0;
+    const size_t idat = FindIdat(original.data(), original.size(), idat_length);
+
+    std::vector<uint8_t> png = original;
+    png[1] = 'J'; // Signature.
+    RLC_CHECK(!Decode(*decoder, png, *image));
+
+    png = original;
+    png[8 + 8 + 8] = 16; // IHDR bit depth.
+    RLC_CHECK(!Decode(*decoder, png, *image));
+
+    png = original;
+    png[8 + 8 + 9] = 3; // IHDR colour type: palette.
+    RLC_CHECK(!Decode(*decoder, png, *image));
+
+    png = original;
+    png[idat + 2] = 0x07; // Final block of the reserved type 3.
+    RLC_CHECK(!Decode(*decoder, png, *image));
+
+    png = original;
+    png[idat - 5] = 0xFF; // IDAT length far beyond the file.
+    RLC_CHECK(!Decode(*decoder, png, *image));
+
+    // Garbage in the compressed stream must fail cleanly or decode to something; never crash.
+    png = original;
+    for (size_t i = idat + 8; i < idat + idat_length - 4; i += 3)
+    {
+        png[i] ^= 0x5A;
+    }
+    Decode(*decoder, png, *image);
+    RLC_CHECK(Decode(*decoder, original, *image));
+}
+
+// =================================================================================================
+// 2. Checker
+// =================================================================================================
+
+RLC_TEST(CheckerFlagsBlackAndStaleFrames)
+{
+    const std::string black = std::string(Tests::TempDir()) + "/black.png";
+    const std::string checker = std::string(Tests::TempDir()) + "/checker.png";
+    RLC_CHECK(WriteFile(black, BuildStoredPng(64, 48, 2)));
+    RLC_CHECK(WriteFile(checker, std::vector<uint8_t>(CHECKER_PNG, CHECKER_PNG + sizeof(CHECKER_PNG))));
+
+    auto quality = std::make_unique<ScreenshotQualityChecker>();
+    const QualityThresholds thresholds;
+    QualityMetrics metrics;
+    RLC_CHECK(quality->Check(black.c_str(), thresholds, metrics));
+    RLC_CHECK(metrics.width == 64 && metrics.height == 48);
+    RLC_CHECK_NEAR(metrics.mean_luma, 2.0, 1e-3);
+    RLC_CHECK(metrics.flags == QUALITY_BLACK); // Not blurred as well: a black frame has no edges.
+    RLC_CHECK(metrics.difference < 0.0f); // Nothing to compare with yet.
+
+    RLC_CHECK(quality->Check(black.c_str(), thresholds, metrics));
+    RLC_CHECK(metrics.flags & QUALITY_STALE);
+
+    RLC_CHECK(quality->Check(checker.c_str(), thresholds, metrics));
+    RLC_CHECK(metrics.flags == 0);
+    RLC_CHECK(metrics.mean_luma > 100.0f);
+    RLC_CHECK(metrics.laplacian_variance > thresholds.blur_variance);
+}
+
+RLC_TEST(CheckerTellsMissingFromUnreadable)
+{
+    const std::string corrupt = std::string(Tests::TempDir()) + "/corrupt.png";
+    const uint8_t filters[2] = {9, 9};
+    RLC_CHECK(WriteFile(corrupt, BuildStoredPng(16, 2, 100, filters)));
+
+    auto quality = std::make_unique<ScreenshotQualityChecker>();
+    QualityMetrics metrics;
+    RLC_CHECK(!quality->Check((std::string(Tests::TempDir()) + "/absent.png").c_str(), QualityThresholds(), metrics));
+    RLC_CHECK(metrics.flags == (QUALITY_UNREADABLE | QUALITY_MISSING));
+    RLC_CHECK(!quality->Check(corrupt.c_str(), QualityThresholds(), metrics));
+    RLC_CHECK(metrics.flags == QUALITY_UNREADABLE);
+
+    char flags[48];
+    FormatQualityFlags(flags, sizeof(flags), QUALITY_UNREADABLE | QUALITY_MISSING);
+    RLC_CHECK(std::strcmp(flags, "unreadable,missing") == 0);
+    FormatQualityFlags(flags, sizeof(flags), 0);
+    RLC_CHECK(std::strcmp(flags, "ok") == 0);
+}
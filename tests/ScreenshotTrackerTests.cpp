@@ -0,0 +1,132 @@
+/**
+ * @file ScreenshotTrackerTests.cpp
+ * @brief Tests for the game log classifier and the screenshot confirmation tracker.
+ */
+
+#include "TestHarness.hpp"
+
+#include "LogMatcher.hpp"
+#include "ScreenshotTracker.hpp"
+
+#include <cstdio>
+#include <cstring>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    constexpr uint32_t NO_RETRIES = 0;
+    constexpr SPF_DVector ORIGIN = {0.0, 0.0, 0.0};
+} // namespace
+
+// =================================================================================================
+// 1. Log Classification
+// =================================================================================================
+
+RLC_TEST(LogMatcherClassifiesScreenshotLines)
+{
+    static const ScreenshotLogMatcher matcher;
+    RLC_CHECK(matcher.Classify("[sys] Screenshot saved: '/screenshot/red_light_X1_Y2_Z3_T4.png'") == SCREENSHOT_LOG_SAVED);
+    RLC_CHECK(matcher.Classify("[sys] FAILED TO SAVE SCREENSHOT '/screenshot/a.png'") & SCREENSHOT_LOG_FAILED);
+    RLC_CHECK(matcher.Classify("[sys] Loading sector (12, -4)") == 0);
+    RLC_CHECK(matcher.Classify("") == 0);
+}
+
+RLC_TEST(MultiPatternMatcherFindsOverlappingPatterns)
+{
+    static MultiPatternMatcher matcher;
+    RLC_CHECK(matcher.AddPattern("he", 1));
+    RLC_CHECK(matcher.AddPattern("she", 2));
+    RLC_CHECK(matcher.AddPattern("hers", 4));
+    matcher.Build();
+    RLC_CHECK(!matcher.AddPattern("late", 8));
+
+    RLC_CHECK(matcher.Scan("USHERS") == (1 | 2 | 4));
+    RLC_CHECK(matcher.Scan("hex") == 1);
+
+    // Feeding in pieces carries the state across the split.
+    uint8_t state = 0;
+    uint8_t flags = matcher.Feed("ush", 3, state);
+    flags |= matcher.Feed("ers", 3, state);
+    RLC_CHECK(flags == (1 | 2 | 4));
+}
+
+// =================================================================================================
+// 2. Screenshot Tracker
+// =================================================================================================
+
+RLC_TEST(TrackerResolvesByWholeName)
+{
+    ScreenshotTracker tracker;
+    RLC_CHECK(tracker.Track("red_light_X1_Y2_Z3_T4", "red_light", 0, 1000, ORIGIN));
+    RLC_CHECK(tracker.Track("red_light_X1_Y2_Z3_T45", "red_light", 0, 2000, {1.0, 2.0, 3.0}));
+
+    // The second name starts with the first; only the exact file name may match.
+    ScreenshotResult result;
+    RLC_CHECK(tracker.Resolve(SCREENSHOT_LOG_SAVED, "Screenshot saved: '/screenshot/red_light_X1_Y2_Z3_T45.png'", 5000, NO_RETRIES, result));
+    RLC_CHECK(std::strcmp(result.name, "red_light_X1_Y2_Z3_T45") == 0);
+    RLC_CHECK(result.outcome == ScreenshotOutcome::Saved);
+    RLC_CHECK(result.latency_us == 3000);
+    RLC_CHECK(result.position.x == 1.0 && result.position.z == 3.0); // Where it was issued, not where the truck is now.
+
+    RLC_CHECK(tracker.Resolve(SCREENSHOT_LOG_SAVED, "Screenshot saved: 'red_light_X1_Y2_Z3_T4.png'", 6000, NO_RETRIES, result));
+    RLC_CHECK(std::strcmp(result.name, "red_light_X1_Y2_Z3_T4") == 0);
+    RLC_CHECK(tracker.GetPendingCount() == 0);
+}
+
+RLC_TEST(TrackerIgnoresLinesNamingNoPendingScreenshot)
+{
+    ScreenshotTracker tracker;
+    RLC_CHECK(tracker.Track("red_light_X1_Y2_Z3_T4", "red_light", 0, 1000, ORIGIN));
+
+    ScreenshotResult result;
+    RLC_CHECK(!tracker.Resolve(SCREENSHOT_LOG_SAVED, "Screenshot saved: '/screenshot/ets2_00001.png'", 2000, NO_RETRIES, result));
+    RLC_CHECK(!tracker.Resolve(SCREENSHOT_LOG_FAILED, "Failed to save screenshot", 2000, 3, result));
+    RLC_CHECK(!tracker.Resolve(SCREENSHOT_LOG_SAVED, "Screenshot saved: 'xred_light_X1_Y2_Z3_T4.png'", 2000, NO_RETRIES, result));
+    RLC_CHECK(!tracker.Resolve(SCREENSHOT_LOG_SAVED, nullptr, 2000, NO_RETRIES, result));
+    RLC_CHECK(!tracker.Resolve(0, "red_light_X1_Y2_Z3_T4", 2000, NO_RETRIES, result));
+    RLC_CHECK(tracker.GetPendingCount() == 1);
+    RLC_CHECK(!tracker.HasRetry());
+}
+
+RLC_TEST(TrackerQueuesRetryForFailures)
+{
+    ScreenshotTracker tracker;
+    RLC_CHECK(tracker.Track("manual_X1_Y2_Z3_T4", "manual", 1, 1000, ORIGIN));
+    RLC_CHECK(tracker.Track("manual_X1_Y2_Z3_T5", "manual", 2, 1000, ORIGIN));
+
+    ScreenshotResult result;
+    RLC_CHECK(tracker.Resolve(SCREENSHOT_LOG_FAILED | SCREENSHOT_LOG_SAVED, "Failed to save screenshot 'manual_X1_Y2_Z3_T4.png'", 2000, 2, result));
+    RLC_CHECK(result.outcome == ScreenshotOutcome::Failed);
+    RLC_CHECK(result.retry_queued);
+
+    // Out of retries.
+    RLC_CHECK(tracker.Resolve(SCREENSHOT_LOG_FAILED, "Failed to save screenshot 'manual_X1_Y2_Z3_T5.png'", 2000, 2, result));
+    RLC_CHECK(!result.retry_queued);
+
+    char label[SCREENSHOT_LABEL_SIZE];
+    uint32_t attempt = 0;
+    RLC_CHECK(tracker.TakeRetry(label, attempt));
+    RLC_CHECK(std::strcmp(label, "manual") == 0);
+    RLC_CHECK(attempt == 2);
+    RLC_CHECK(!tracker.TakeRetry(label, attempt));
+}
+
+RLC_TEST(TrackerExpiresOldestFirstAndDropsWhenFull)
+{
+    ScreenshotTracker tracker;
+    char name[32];
+    for (size_t i = 0; i < SCREENSHOT_MAX_PENDING; ++i)
+    {
+        std::snprintf(name, sizeof(name), "shot_%zu", i);
+        RLC_CHECK(tracker.Track(name, "red_light", 0, 1000 + i, ORIGIN));
+    }
+    RLC_CHECK(!tracker.Track("shot_last", "red_light", 0, 5000, ORIGIN)); // Drops shot_0.
+
+    ScreenshotResult result;
+    RLC_CHECK(!tracker.Expire(1500, 1000, result));
+    RLC_CHECK(tracker.Expire(2001, 1000, result));
+    RLC_CHECK(std::strcmp(result.name, "shot_1") == 0);
+    RLC_CHECK(result.outcome == ScreenshotOutcome::TimedOut);
+    RLC_CHECK(!result.retry_queued);
+}
@@ -0,0 +1,59 @@
+/**
+ * @file TestHarness.hpp
+ * @brief Minimal test registry and check macros for the core library tests.
+ * @details Test cases register themselves at static initialisation; `rlc_tests` runs them all, or
+ * only those whose name contains its first argument. A failed check reports its file and line and
+ * marks the case failed without stopping it, so one run lists every broken expectation.
+ *
+ * @code
+ *   RLC_TEST(CaptureSequenceRunsStandardSteps)
+ *   {
+ *       CaptureSequence sequence;
+ *       RLC_CHECK(sequence.Start(nullptr, false));
+ *   }
+ * @endcode
+ */
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+
+namespace SPF_RedLightCamera::Tests
+{
+  struct TestCase
+  {
+    const char *name;
+    void (*run)();
+    TestCase *next = nullptr;
+  };
+
+  /** @brief Adds a case to the registry; used by `RLC_TEST`. */
+  struct TestRegistrar
+  {
+    explicit TestRegistrar(TestCase &test);
+  };
+
+  /** @brief Records a failed check against the running case. */
+  void ReportFailure(const char *file, int line, const char *expression);
+
+  /** @brief Directory for files a test writes; removed when the run ends. */
+  const char *TempDir();
+} // namespace SPF_RedLightCamera::Tests
+
+#define RLC_TEST(name)                                                                         \
+  static void name();                                                                          \
+  static ::SPF_RedLightCamera::Tests::TestCase name##_case{#name, name};                       \
+  static const ::SPF_RedLightCamera::Tests::TestRegistrar name##_registrar(name##_case);       \
+  static void name()
+
+#define RLC_CHECK(expression)                                                                  \
+  do                                                                                           \
+  {                                                                                            \
+    if (!(expression))                                                                         \
+    {                                                                                          \
+      ::SPF_RedLightCamera::Tests::ReportFailure(__FILE__, __LINE__, #expression);             \
+    }                                                                                          \
+  } while (0)
+
+#define RLC_CHECK_NEAR(actual, expected, tolerance) \
+  RLC_CHECK(std::fabs((double)(actual) - (double)(expected)) <= (double)(tolerance))
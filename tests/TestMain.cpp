@@ -0,0 +1,87 @@
+/**
+ * @file TestMain.cpp
+ * @brief Runner for the core library tests.
+ *
+ * Usage:
+ *   rlc_tests [<name filter>]
+ *
+ * Exits with status 1 if any check failed.
+ */
+
+#include "TestHarness.hpp"
+
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <system_error>
+
+namespace SPF_RedLightCamera::Tests
+{
+    namespace
+    {
+        TestCase *g_first = nullptr;
+        TestCase **g_last = &g_first;
+        const TestCase *g_running = nullptr;
+        size_t g_failedChecks = 0;
+        std::string g_tempDir;
+    } // namespace
+
+    TestRegistrar::TestRegistrar(TestCase &test)
+    {
+        // Append, so cases run in the order they appear in each file.
+        *g_last = &test;
+        g_last = &test.next;
+    }
+
+    void ReportFailure(const char *file, int line, const char *expression)
+    {
+        std::fprintf(stderr, "  %s:%d: %s: check failed: %s\n", file, line, g_running ? g_running->name : "?", expression);
+        g_failedChecks++;
+    }
+
+    const char *TempDir()
+    {
+        if (g_tempDir.empty())
+        {
+            std::error_code error;
+            std::filesystem::path dir = std::filesystem::temp_directory_path(error) / "rlc_tests";
+            std::filesystem::create_directories(dir, error);
+            g_tempDir = dir.string();
+        }
+        return g_tempDir.c_str();
+    }
+} // namespace SPF_RedLightCamera::Tests
+
+int main(int argc, char **argv)
+{
+    using namespace SPF_RedLightCamera::Tests;
+
+    const char *filter = argc > 1 ? argv[1] : nullptr;
+    size_t run = 0, failed = 0;
+    for (const TestCase *test = g_first; test; test = test->next)
+    {
+        if (filter && !std::strstr(test->name, filter))
+        {
+            continue;
+        }
+
+        const size_t before = g_failedChecks;
+        g_running = test;
+        test->run();
+        g_running = nullptr;
+        run++;
+
+        const bool ok = g_failedChecks == before;
+        failed += ok ? 0 : 1;
+        std::printf("%-4s %s\n", ok ? "ok" : "FAIL", test->name);
+    }
+
+    if (!g_tempDir.empty())
+    {
+        std::error_code error;
+        std::filesystem::remove_all(g_tempDir, error);
+    }
+
+    std::printf("%zu tests, %zu failed\n", run, failed);
+    return failed == 0 && run > 0 ? 0 : 1;
+}
@@ -0,0 +1,837 @@
+/**
+ * @file CoreBench.cpp
+ * @brief Micro-benchmark for the per-capture hot paths of the core library.
+ * @details Times the rig pose (scalar and the batch kernel), traffic framing, auto-framing (box and solve), screenshot naming, flash curve sampling (table
+ * against direct evaluation), the statistics HUD's per-frame work, the violation heatmap (adding a fine, rebuilding its view), the proximity alert query over 50,000 violation sites, the capture history (encoding, sealing and scanning a segment against fixed records, and its size per record), the track export's path decimation, the screenshot quality metrics, the capture journal's record checksum, fly-by keyframe generation, game log classification and capture state machine over a workload of truck placements, and the worker pool's throughput. The workload is read from a telemetry
+ * recording when one is given (every frame record is a placement, every red light fine drives a
+ * capture sequence); otherwise a synthetic loop drive is used. The same runs are the training
+ * workload for the PGO build (`rlc_pgo_train`). Everything except the worker pool runs on one
+ * thread, so ops/s is the throughput per core.
+ *
+ * Before timing, the batch pose kernel is checked against the scalar `ComputeRigPose` over
+ * `--pose-samples` random headings, distances and heights (plus edge cases) and must stay within
+ * the error bounds documented in RigPoseBatch.hpp. `--check-only` runs just that check (the
+ * `pose_batch_accuracy` CTest test).
+ *
+ * Usage:
+ *   rlc_bench [<recording.rlcrec>] [--iterations <n>] [--threads <n>] [--pose-samples <n>] [--check-only]
+ *
+ * Exits with status 1 if the batch kernel exceeds its error bounds or the worker pool loses or
+ * duplicates a completion.
+ */
+
+#include "AutoFraming.hpp"
+#include "CaptureJournal.hpp"
+#include "CaptureNaming.hpp"
+#include "CaptureStats.hpp"
+#include "CaptureSequence.hpp"
+#include "CinematicPath.hpp"
+#include "Crc32c.hpp"
+#include "FlashCurve.hpp"
+#include "HistoryStore.hpp"
+#include "LogMatcher.hpp"
+#include "LzBlock.hpp"
+#include "RigPose.hpp"
+#include "RigPoseBatch.hpp"
+#include "ScreenshotQuality.hpp"
+#include "TelemetryRecorder.hpp"
+#include "TrackExport.hpp"
+#include "ViolationHeatmap.hpp"
+#include "ViolationSites.hpp"
+#include "WorkerPool.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Placement
+    {
+        SPF_DVector position;
+        double heading;
+        uint64_t simulation_time;
+    };
+
+    struct Workload
+    {
+        std::vector<Placement> placements;
+        std::vector<std::string> fines; // Offence ids, in recording order.
+    };
+
+    // Values accumulated from every result so the optimizer cannot drop the timed work.
+    volatile double g_sink = 0.0;
+
+    bool LoadRecording(const char *path, Workload &workload)
+    {
+        TelemetryReader reader;
+        if (!reader.Open(path))
+        {
+            std::fprintf(stderr, "Cannot open recording '%s'.\n", path);
+            return false;
+        }
+
+        ReplayRecord record;
+        while (reader.Next(record))
+        {
+            if (record.type == RecordType::Frame)
+            {
+                workload.placements.push_back({record.frame.world_placement.position,
+                                               record.frame.world_placement.orientation.heading,
+                                               record.frame.timestamps.simulation});
+            }
+            else if (std::strcmp(record.event.event_id, "player.fined") == 0)
+            {
+                workload.fines.emplace_back(record.event.fine_offence);
+            }
+        }
+        return !workload.placements.empty();
+    }
+
+    // A truck driving a 2 km loop, one placement per 60 FPS frame, with a red light fine every minute.
+    void BuildSyntheticWorkload(Workload &workload)
+    {
+        const size_t frames = 60 * 60 * 5;
+        const double radius = 320.0;
+        for (size_t i = 0; i < frames; ++i)
+        {
+            const double t = (double)i / (double)frames;
+            const double angle = 2.0 * 3.14159265358979323846 * t;
+            workload.placements.push_back({{radius * std::cos(angle), 12.0 + std::sin(angle * 7.0), radius * std::sin(angle)},
+                                           std::fmod(1.0 - t, 1.0),
+                                           (uint64_t)i * 16667});
+        }
+        for (size_t i = 0; i < frames / 3600; ++i)
+        {
+            workload.fines.emplace_back(i % 3 == 2 ? "speeding_camera" : "red_signal");
+        }
+    }
+
+    // Pool job over a slice of the workload. Root jobs fan out into two children from the worker,
+    // so the children land in that worker's deque and idle workers have to steal them.
+    struct PoseJob : WorkerJob
+    {
+        const Placement *placements = nullptr;
+        size_t count = 0;
+        PoseJob *children = nullptr; ///< Two children, or nullptr for a leaf.
+        double result = 0.0;
+        size_t inline_children = 0; ///< Children that could not be queued and ran inside this job.
+        size_t *completed = nullptr;
+    };
+
+    WorkerPool *g_pool = nullptr;
+
+    void RunPoseJob(WorkerJob *job)
+    {
+        PoseJob &self = *static_cast<PoseJob *>(job);
+        for (PoseJob *child = self.children; child && child != self.children + 2; ++child)
+        {
+            if (!g_pool->Submit(child))
+            {
+                RunPoseJob(child); // Queues full: run it here and count it with the parent.
+                self.result += child->result;
+                self.inline_children++;
+            }
+        }
+        for (size_t i = 0; i < self.count; ++i)
+        {
+            const RigPose pose = ComputeRigPose(self.placements[i].position, self.placements[i].heading, 25.0, 4.0, 70.0f);
+            self.result += pose.yaw;
+        }
+    }
+
+    void CompletePoseJob(WorkerJob *job)
+    {
+        PoseJob &self = *static_cast<PoseJob *>(job);
+        *self.completed += 1 + self.inline_children;
+        g_sink = g_sink + self.result;
+    }
+
+    // Runs every job once through the pool. Returns false if a completion went missing or arrived twice.
+    bool RunPoolRound(WorkerPool &pool, std::vector<PoseJob> &jobs, size_t roots)
+    {
+        size_t completed = 0;
+        for (PoseJob &job : jobs)
+        {
+            job.result = 0.0;
+            job.inline_children = 0;
+            job.completed = &completed;
+        }
+        for (size_t i = 0; i < roots; ++i)
+        {
+            while (!pool.Submit(&jobs[i]))
+            {
+                pool.DrainCompletions();
+                std::this_thread::yield();
+            }
+        }
+        while (completed < jobs.size())
+        {
+            if (pool.DrainCompletions() == 0)
+            {
+                std::this_thread::yield();
+            }
+        }
+        return completed == jobs.size();
+    }
+
+    /** @brief Angle difference folded into [-π, π]. */
+    double AngleError(double a, double b)
+    {
+        const double two_pi = 2.0 * 3.14159265358979323846;
+        const double delta = std::fmod(a - b, two_pi);
+        return std::fabs(delta > two_pi / 2 ? delta - two_pi : (delta < -two_pi / 2 ? delta + two_pi : delta));
+    }
+
+    /**
+     * @brief Property check: for any heading, distance and height, the batch kernel matches the
+     *        scalar double-precision pose within the documented bounds.
+     */
+    bool CheckPoseBatchAccuracy(size_t samples)
+    {
+        const size_t chunk = 4096;
+        std::vector<float> heading(chunk), distance(chunk), height(chunk), offset_x(chunk), offset_z(chunk), yaw(chunk), pitch(chunk);
+        RigPoseBatch batch;
+        batch.heading = heading.data();
+        batch.distance = distance.data();
+        batch.height = height.data();
+        batch.offset_x = offset_x.data();
+        batch.offset_z = offset_z.data();
+        batch.yaw = yaw.data();
+        batch.pitch = pitch.data();
+
+        // Fixed seed: a failure reproduces. Edge cases lead the first chunk; the slider range is +-100 m.
+        std::mt19937_64 random(0x524c43u);
+        std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+        std::uniform_real_distribution<float> metres(-100.0f, 100.0f);
+        const float edge_headings[] = {0.0f, 0.125f, 0.25f, 0.375f, 0.5f, 0.625f, 0.75f, 0.875f, 0.99999994f, 1.0f, -0.25f, 2.5f};
+        const float edge_lengths[] = {0.0f, 1e-3f, -1e-3f, 100.0f, -100.0f, 25.0f};
+        size_t edge = 0;
+        const size_t edge_count = sizeof(edge_headings) / sizeof(edge_headings[0]) * 36;
+
+        double max_offset = 0.0, max_yaw = 0.0, max_pitch = 0.0;
+        size_t failures = 0;
+        for (size_t done = 0; done < samples; done += chunk)
+        {
+            batch.count = samples - done < chunk ? samples - done : chunk;
+            for (size_t i = 0; i < batch.count; ++i, ++edge)
+            {
+                if (edge < edge_count)
+                {
+                    heading[i] = edge_headings[edge / 36];
+                    distance[i] = edge_lengths[(edge / 6) % 6];
+                    height[i] = edge_lengths[edge % 6];
+                    continue;
+                }
+                heading[i] = unit(random);
+                distance[i] = metres(random);
+                height[i] = metres(random);
+            }
+            ComputeRigPoseBatch(batch);
+
+            for (size_t i = 0; i < batch.count; ++i)
+            {
+                const RigPose reference = ComputeRigPose({0.0, 0.0, 0.0}, heading[i], distance[i], height[i], 70.0f);
+                const double d = std::fabs((double)distance[i]);
+                const double offset_error = std::fmax(std::fabs(offset_x[i] - reference.camera.x), std::fabs(offset_z[i] - reference.camera.z));
+                const double offset_bound = RIG_BATCH_OFFSET_ERROR * d + std::ldexp(1.0, std::ilogb(d + 1e-30) - 23);
+                max_offset = std::fmax(max_offset, d > 0.0 ? offset_error / d : 0.0);
+                bool ok = offset_error <= offset_bound;
+                if (reference.oriented)
+                {
+                    // Straight up or down the yaw is arbitrary; elsewhere both angles must match.
+                    const double pitch_error = AngleError(pitch[i], reference.pitch);
+                    max_pitch = std::fmax(max_pitch, pitch_error);
+                    ok = ok && pitch_error <= RIG_BATCH_ANGLE_ERROR;
+                    if (distance[i] != 0.0f)
+                    {
+                        const double yaw_error = AngleError(yaw[i], reference.yaw);
+                        max_yaw = std::fmax(max_yaw, yaw_error);
+                        ok = ok && yaw_error <= RIG_BATCH_ANGLE_ERROR;
+                    }
+                }
+                if (!ok && failures++ < 5)
+                {
+                    std::fprintf(stderr, "Batch pose out of bounds: heading %.9g distance %.9g height %.9g -> offset (%.9g, %.9g) yaw %.9g pitch %.9g, "
+                                         "expected (%.9g, %.9g) yaw %.9g pitch %.9g\n",
+                                 heading[i], distance[i], height[i], offset_x[i], offset_z[i], yaw[i], pitch[i], reference.camera.x, reference.camera.z,
+                                 reference.yaw, reference.pitch);
+                }
+            }
+        }
+        std::printf("batch pose check: %zu samples (%s), max offset error %.2e x distance (bound %.1e), max yaw error %.2e rad, max pitch error %.2e rad (bound %.1e)%s\n",
+                    samples, RigPoseBatchUsesSimd() ? "SSE2" : "scalar", max_offset, RIG_BATCH_OFFSET_ERROR, max_yaw, max_pitch, RIG_BATCH_ANGLE_ERROR,
+                    failures ? ", FAILED" : "");
+        return failures == 0;
+    }
+
+    template <typename Body>
+    void Run(const char *name, size_t iterations, size_t ops_per_iteration, Body &&body)
+    {
+        body(); // Warm caches and the branch predictor.
+        const auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i)
+        {
+            body();
+        }
+        const double elapsed_ns = (double)std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count();
+        const double ops = (double)iterations * (double)ops_per_iteration;
+        std::printf("  %-16s %10.1f ns/op  %12.0f ops/s\n", name, ops > 0 ? elapsed_ns / ops : 0.0, elapsed_ns > 0 ? ops * 1e9 / elapsed_ns : 0.0);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *recording = nullptr;
+    size_t iterations = 20;
+    uint32_t threads = 4;
+    size_t pose_samples = 4000000;
+    bool check_only = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc)
+        {
+            threads = (uint32_t)std::strtoul(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--pose-samples") == 0 && i + 1 < argc)
+        {
+            pose_samples = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--check-only") == 0)
+        {
+            check_only = true;
+        }
+        else if (argv[i][0] != '-')
+        {
+            recording = argv[i];
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: rlc_bench [<recording.rlcrec>] [--iterations <n>] [--threads <n>] [--pose-samples <n>] [--check-only]\n");
+            return 2;
+        }
+    }
+
+    Workload workload;
+    if (recording)
+    {
+        if (!LoadRecording(recording, workload))
+        {
+            return 1;
+        }
+    }
+    else
+    {
+        BuildSyntheticWorkload(workload);
+    }
+
+    const std::vector<Placement> &placements = workload.placements;
+    std::printf("workload: %s, %zu placements, %zu fines, %zu iterations\n",
+                recording ? recording : "synthetic", placements.size(), workload.fines.size(), iterations);
+
+    if (!CheckPoseBatchAccuracy(pose_samples))
+    {
+        return 1;
+    }
+    if (check_only)
+    {
+        return 0;
+    }
+
+    Run("rig pose", iterations, placements.size(), [&] {
+        double sum = 0.0;
+        for (const Placement &p : placements)
+        {
+            const RigPose pose = ComputeRigPose(p.position, p.heading, 25.0, 4.0, 70.0f);
+            sum += pose.yaw + pose.pitch;
+        }
+        g_sink = g_sink + sum;
+    });
+
+    // The same poses through the batch kernel; the SoA inputs are built once, outside the timing.
+    {
+        std::vector<float> heading(placements.size()), distance(placements.size(), 25.0f), height(placements.size(), 4.0f);
+        std::vector<float> offset_x(placements.size()), offset_z(placements.size()), yaw(placements.size()), pitch(placements.size());
+        for (size_t i = 0; i < placements.size(); ++i)
+        {
+            heading[i] = (float)placements[i].heading;
+        }
+        RigPoseBatch batch;
+        batch.count = placements.size();
+        batch.heading = heading.data();
+        batch.distance = distance.data();
+        batch.height = height.data();
+        batch.offset_x = offset_x.data();
+        batch.offset_z = offset_z.data();
+        batch.yaw = yaw.data();
+        batch.pitch = pitch.data();
+        Run("rig pose batch", iterations, placements.size(), [&] {
+            ComputeRigPoseBatch(batch);
+            g_sink = g_sink + yaw[placements.size() / 2] + pitch[placements.size() - 1];
+        });
+    }
+
+    Run("traffic framing", iterations, placements.size(), [&] {
+        const FramingLimits limits;
+        double sum = 0.0;
+        for (const Placement &p : placements)
+        {
+            RigPose pose = ComputeRigPose(p.position, p.heading, 25.0, 4.0, 70.0f);
+            const SPF_DVector others[4] = {{p.position.x + 12.0, p.position.y, p.position.z + 3.0},
+                                           {p.position.x - 8.0, p.position.y, p.position.z + 15.0},
+                                           {p.position.x + 2.0, p.position.y + 1.0, p.position.z - 20.0},
+                                           {p.position.x - 18.0, p.position.y, p.position.z - 4.0}};
+            FrameRigTargets(pose, others, 4, 16.0 / 9.0, limits);
+            sum += pose.fov;
+        }
+        g_sink = g_sink + sum;
+    });
+
+    // Auto-framing: the box is rebuilt when the constants change, the solve when the request does.
+    {
+        static SPF_TruckConstants truck{};
+        static SPF_Trailer trailers[2]{};
+        auto add_wheels = [](SPF_WheelConstants *wheels, uint32_t &count, std::initializer_list<float> axles, float radius) {
+            for (float z : axles)
+            {
+                wheels[count++] = {true, false, false, false, radius, {-1.0f, radius, z}};
+                wheels[count++] = {true, false, false, false, radius, {1.0f, radius, z}};
+            }
+        };
+        add_wheels(truck.wheels, truck.wheel_count, {-3.7f, 0.0f, 1.35f}, 0.52f);
+        truck.hook_position = {0.0f, 1.15f, 0.65f};
+        for (SPF_Trailer &trailer : trailers)
+        {
+            add_wheels(trailer.constants.wheels, trailer.constants.wheel_count, {0.0f, 1.31f, 2.62f}, 0.45f);
+            trailer.constants.hook_position = {0.0f, 1.15f, -6.9f};
+        }
+
+        Run("combination box", iterations, placements.size(), [&] {
+            double sum = 0.0;
+            for (size_t i = 0; i < placements.size(); ++i)
+            {
+                sum += BuildCombinationBox(truck, trailers, (uint32_t)(i % 3)).max.z;
+            }
+            g_sink = g_sink + sum;
+        });
+
+        const FramingBox box = BuildCombinationBox(truck, trailers, 2);
+        Run("auto framing solve", iterations, placements.size(), [&] {
+            FramingRequest request;
+            double sum = 0.0;
+            for (size_t i = 0; i < placements.size(); ++i)
+            {
+                request.rig_offset = {0.0f, 4.0f, -(float)(10 + i % 40)};
+                request.mode = (i & 1) ? AutoFramingMode::Distance : AutoFramingMode::Fov;
+                sum += SolveFraming(box, request).fov;
+            }
+            g_sink = g_sink + sum;
+        });
+    }
+
+    Run("screenshot name", iterations, placements.size(), [&] {
+        char command[256];
+        size_t sum = 0;
+        for (const Placement &p : placements)
+        {
+            sum += FormatScreenshotCommand(command, sizeof(command), CaptureSequence::RED_LIGHT_LABEL, p.position, p.simulation_time, -1);
+        }
+        g_sink = g_sink + (double)sum;
+    });
+
+    // The flash is sampled once per draw; compare the table with evaluating the curve directly.
+    const uint32_t flash_duration_us = 300000;
+    FlashCurve flash;
+    flash.Build(FlashStyle::Exponential, flash_duration_us);
+    Run("flash curve (table)", iterations, placements.size(), [&] {
+        float sum = 0.0f;
+        for (const Placement &p : placements)
+        {
+            sum += flash.Sample(p.simulation_time % flash_duration_us);
+        }
+        g_sink = g_sink + sum;
+    });
+    Run("flash curve (direct)", iterations, placements.size(), [&] {
+        float sum = 0.0f;
+        for (const Placement &p : placements)
+        {
+            sum += EvaluateFlashCurve(FlashStyle::Exponential, (float)(p.simulation_time % flash_duration_us) / (float)flash_duration_us);
+        }
+        g_sink = g_sink + sum;
+    });
+
+    // With the HUD open, each frame records its cost and refreshes the sparkline (a no-op unless a
+    // bucket rolled over).
+    CaptureStats stats;
+    Sparkline sparkline;
+    Run("stats hud frame", iterations, placements.size(), [&] {
+        int sum = 0;
+        for (const Placement &p : placements)
+        {
+            stats.RecordFrameCost((uint32_t)(p.simulation_time % 997));
+            sparkline.Update(stats, 48.0f, 200.0f, 300.0f, 48.0f);
+            sum += sparkline.GetCount();
+        }
+        g_sink = g_sink + sum;
+    });
+
+    // Every placement counts as a fine, in memory only (the file append is one 12-byte write). The
+    // view is rebuilt over every cell seen so far, as when the truck enters another cell.
+    static HeatmapGrid heatmap;
+    static HeatmapView heatmap_view;
+    heatmap.Clear();
+    Run("heatmap add", iterations, placements.size(), [&] {
+        for (const Placement &p : placements)
+        {
+            heatmap.Add(p.position.x, p.position.z);
+        }
+        g_sink = g_sink + (double)heatmap.GetTotal();
+    });
+    const size_t view_stride = 60;
+    Run("heatmap view rebuild", iterations, (placements.size() + view_stride - 1) / view_stride, [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < placements.size(); i += view_stride)
+        {
+            // Alternate the range so every update is a rebuild.
+            heatmap_view.Update(heatmap, placements[i].position.x, placements[i].position.z, (i / view_stride) & 1 ? 2000.0 : 2001.0, 48.0f, 200.0f, 360.0f, 360.0f);
+            sum += heatmap_view.GetCount();
+        }
+        g_sink = g_sink + (double)sum;
+    });
+
+    // Proximity alerts query the site index while driving. Scatter 50,000 sites over the area the
+    // placements cover, with a margin, so every query sees a realistic neighbourhood.
+    {
+        double min_x = placements[0].position.x, max_x = min_x, min_z = placements[0].position.z, max_z = min_z;
+        for (const Placement &p : placements)
+        {
+            min_x = std::fmin(min_x, p.position.x);
+            max_x = std::fmax(max_x, p.position.x);
+            min_z = std::fmin(min_z, p.position.z);
+            max_z = std::fmax(max_z, p.position.z);
+        }
+        std::mt19937 rng(0x524c43);
+        std::uniform_real_distribution<double> site_x(min_x - 2000.0, max_x + 2000.0), site_z(min_z - 2000.0, max_z + 2000.0);
+        std::vector<HeatmapRecord> sites(50000);
+        for (HeatmapRecord &site : sites)
+        {
+            site = {HeatmapGrid::CellOf(site_x(rng)), HeatmapGrid::CellOf(site_z(rng)), 1u + (uint32_t)(rng() % 5)};
+        }
+        static ViolationSiteIndex site_index;
+        site_index.Build(sites.data(), sites.size(), HEATMAP_CELL_SIZE);
+        Run("proximity query", iterations, placements.size(), [&] {
+            uint64_t sum = 0;
+            SiteHit hit;
+            for (const Placement &p : placements)
+            {
+                sum += site_index.FindNearest(p.position.x, p.position.z, 250.0, hit) ? hit.count : 0;
+            }
+            g_sink = g_sink + (double)sum;
+        });
+    }
+
+    // Capture history: one segment of samples taken once a second (every 60th placement, lapping
+    // the workload as often as needed), encoded block by block and compressed as sealing does.
+    // The scans decode it the way HistoryReader does and compare against reading fixed records.
+    {
+        const size_t stride = 60;
+        const size_t lap_frames = placements.size();
+        const uint64_t lap_time = placements.back().simulation_time - placements.front().simulation_time + 16667;
+        std::vector<HistoryRecord> records(HISTORY_SEGMENT_RECORDS);
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            const size_t frame = (i * stride) % lap_frames;
+            const size_t lap = (i * stride) / lap_frames;
+            const Placement &p = placements[frame];
+            const Placement &previous = placements[frame >= stride ? frame - stride : 0];
+            const double dt = (double)(p.simulation_time - previous.simulation_time) * 1e-6;
+            const double dx = p.position.x - previous.position.x, dz = p.position.z - previous.position.z;
+            HistoryRecord &record = records[i];
+            record.time_us = p.simulation_time + lap * lap_time;
+            record.position = p.position;
+            record.heading = p.heading;
+            record.speed = dt > 0.0 ? (float)(std::sqrt(dx * dx + dz * dz) / dt) : 0.0f;
+            record.kind = i % 600 == 599 ? HistoryKind::RedLightFine : HistoryKind::Sample;
+        }
+
+        struct StoredBlock
+        {
+            size_t encoded_size;
+            size_t record_count;
+            std::vector<uint8_t> data;
+        };
+        const size_t block_count = records.size() / HISTORY_BLOCK_RECORDS;
+        std::vector<StoredBlock> blocks(block_count);
+        static uint8_t encoded[HISTORY_BLOCK_CAPACITY];
+        static uint8_t compressed[LzCompressBound(HISTORY_BLOCK_CAPACITY)];
+        size_t encoded_bytes = 0, sealed_bytes = 0;
+        for (size_t b = 0; b < block_count; ++b)
+        {
+            const size_t encoded_size = EncodeHistoryBlock(&records[b * HISTORY_BLOCK_RECORDS], HISTORY_BLOCK_RECORDS, encoded, sizeof(encoded));
+            const size_t compressed_size = LzCompressBlock(encoded, encoded_size, compressed, sizeof(compressed));
+            blocks[b] = {encoded_size, HISTORY_BLOCK_RECORDS, std::vector<uint8_t>(compressed, compressed + compressed_size)};
+            encoded_bytes += sizeof(HistoryBlockHeader) + encoded_size;
+            sealed_bytes += sizeof(HistoryBlockHeader) + compressed_size;
+        }
+
+        Run("history encode", iterations, records.size(), [&] {
+            size_t sum = 0;
+            for (size_t b = 0; b < block_count; ++b)
+            {
+                sum += EncodeHistoryBlock(&records[b * HISTORY_BLOCK_RECORDS], HISTORY_BLOCK_RECORDS, encoded, sizeof(encoded));
+            }
+            g_sink = g_sink + (double)sum;
+        });
+        Run("history seal", iterations, records.size(), [&] {
+            size_t sum = 0;
+            for (size_t b = 0; b < block_count; ++b)
+            {
+                const size_t encoded_size = EncodeHistoryBlock(&records[b * HISTORY_BLOCK_RECORDS], HISTORY_BLOCK_RECORDS, encoded, sizeof(encoded));
+                sum += LzCompressBlock(encoded, encoded_size, compressed, sizeof(compressed));
+            }
+            g_sink = g_sink + (double)sum;
+        });
+
+        static HistoryRecord decoded[HISTORY_BLOCK_RECORDS];
+        Run("history scan", iterations, records.size(), [&] {
+            double sum = 0.0;
+            for (const StoredBlock &block : blocks)
+            {
+                LzDecompressBlock(block.data.data(), block.data.size(), encoded, sizeof(encoded));
+                DecodeHistoryBlock(encoded, block.encoded_size, block.record_count, decoded);
+                for (size_t i = 0; i < block.record_count; ++i)
+                {
+                    sum += decoded[i].position.x;
+                }
+            }
+            g_sink = g_sink + sum;
+        });
+
+        std::vector<HistoryFixedRecord> fixed(records.size());
+        for (size_t i = 0; i < records.size(); ++i)
+        {
+            const HistoryRecord &r = records[i];
+            fixed[i] = {r.time_us, r.position.x, r.position.y, r.position.z, (float)r.heading, r.speed, (uint8_t)r.kind};
+        }
+        Run("history scan fixed", iterations, records.size(), [&] {
+            double sum = 0.0;
+            for (size_t b = 0; b < block_count; ++b)
+            {
+                // Same block-at-a-time shape: copy the block in, then convert.
+                static HistoryFixedRecord staged[HISTORY_BLOCK_RECORDS];
+                std::memcpy(staged, &fixed[b * HISTORY_BLOCK_RECORDS], sizeof(staged));
+                for (size_t i = 0; i < HISTORY_BLOCK_RECORDS; ++i)
+                {
+                    decoded[i].time_us = staged[i].time_us;
+                    decoded[i].position = {staged[i].x, staged[i].y, staged[i].z};
+                    decoded[i].heading = staged[i].heading;
+                    decoded[i].speed = staged[i].speed;
+                    decoded[i].kind = (HistoryKind)staged[i].kind;
+                    sum += decoded[i].position.x;
+                }
+            }
+            g_sink = g_sink + sum;
+        });
+        std::printf("  %-16s %.1f B/record fixed, %.1f delta, %.1f sealed (%zu records)\n", "history size", (double)sizeof(HistoryFixedRecord),
+                    (double)encoded_bytes / records.size(), (double)sealed_bytes / records.size(), records.size());
+    }
+
+    // The track export decimates the path before every fine: here 30 s windows of placements, as if
+    // the history were sampled every frame, at the default tolerance. One op is one window.
+    {
+        const size_t window = 1800;
+        std::vector<HistoryRecord> path(window);
+        std::vector<uint8_t> keep(window);
+        std::vector<uint32_t> stack(2 * window);
+        const size_t windows = placements.size() > window ? placements.size() / window : 1;
+        size_t points_in = 0, points_out = 0;
+        Run("track decimation", iterations, windows, [&] {
+            size_t kept = 0;
+            for (size_t w = 0; w < windows; ++w)
+            {
+                const size_t count = placements.size() < window ? placements.size() : window;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    path[i].position = placements[w * window + i].position;
+                }
+                kept += DecimateTrack(path.data(), count, TrackExportOptions().tolerance_m, keep.data(), stack.data());
+                points_in += count;
+            }
+            points_out += kept;
+            g_sink = g_sink + (double)kept;
+        });
+        std::printf("  %-16s %.1f%% of path points kept\n", "track size", points_in ? 100.0 * (double)points_out / (double)points_in : 0.0);
+    }
+
+    // The screenshot quality check measures the downscaled image of a 4K frame (480 x 270) against
+    // the one before; the PNG decode ahead of it is timed by rlc_quality on real files.
+    {
+        const std::unique_ptr<QualityImage[]> images(new QualityImage[2]);
+        std::mt19937 random(7);
+        for (size_t n = 0; n < 2; ++n)
+        {
+            images[n].width = 480;
+            images[n].height = 270;
+            for (size_t i = 0; i < (size_t)480 * 270; ++i)
+            {
+                images[n].pixels[i] = (uint8_t)((i % 480) / 4 + (i / 480) / 4 + random() % 32);
+            }
+        }
+        QualityMetrics metrics;
+        Run("quality metrics", iterations, placements.size() / 100 + 1, [&] {
+            float sum = 0.0f;
+            for (size_t i = 0; i < placements.size() / 100 + 1; ++i)
+            {
+                MeasureQuality(images[i & 1], &images[(i + 1) & 1], QualityThresholds(), metrics);
+                sum += metrics.laplacian_variance;
+            }
+            g_sink = g_sink + (double)sum;
+        });
+    }
+
+    // Every capture journal record is checksummed on the game thread.
+    {
+        JournalScreenshot record{};
+        std::snprintf(record.label, sizeof(record.label), "red_light");
+        Run(Crc32cUsesHardware() ? "crc32c (sse4.2)" : "crc32c (table)", iterations, placements.size(), [&] {
+            uint32_t sum = 0;
+            for (const Placement &p : placements)
+            {
+                record.simulation_time = p.simulation_time;
+                sum ^= Crc32c(&record, sizeof(record));
+            }
+            g_sink = g_sink + (double)sum;
+        });
+    }
+
+    // Every game log line goes through the classifier on the logging thread; almost none match.
+    static const char *const LOG_LINES[] = {
+        "[sys] Loading sound bank 'sound/truck/engine.bank'",
+        "[prism] Texture 'vehicle/truck/upgrade/lightbar.tobj' loaded in 3 ms",
+        "[sys] Screenshot saved: '/screenshot/red_light_X5_Y0_Z0_T80000.png'",
+        "[job] Delivery finished, revenue 12430, cargo damage 0%",
+        "[sys] Failed to save screenshot '/screenshot/red_light_X12_Y0_Z0_T192000.png'",
+        "[ai] Traffic spawn point 1834 skipped: not visible",
+    };
+    const size_t log_line_count = sizeof(LOG_LINES) / sizeof(LOG_LINES[0]);
+    ScreenshotLogMatcher log_matcher;
+    Run("log classify", iterations, placements.size(), [&] {
+        size_t sum = 0;
+        for (size_t i = 0; i < placements.size(); ++i)
+        {
+            sum += log_matcher.Classify(LOG_LINES[i % log_line_count]);
+        }
+        g_sink = g_sink + (double)sum;
+    });
+
+    // Fly-by generation runs once per capture, so sample a placement every second of driving.
+    const size_t flyby_stride = 60;
+    Run("fly-by keyframes", iterations, (placements.size() + flyby_stride - 1) / flyby_stride, [&] {
+        CinematicParams params;
+        SPF_CameraState_t keyframes[CINEMATIC_MAX_KEYFRAMES];
+        double sum = 0.0;
+        for (size_t i = 0; i < placements.size(); i += flyby_stride)
+        {
+            const size_t count = GenerateFlyByKeyframes(placements[i].position, placements[i].heading, 0.0, 0.0, params, keyframes);
+            sum += keyframes[count - 1].q_w;
+        }
+        g_sink = g_sink + sum;
+    });
+
+    // One op is one frame of the state machine; every fine in the workload runs a full sequence.
+    if (!workload.fines.empty())
+    {
+        size_t frames_per_iteration = 0;
+        {
+            CaptureSequence sequence;
+            for (const std::string &fine : workload.fines)
+            {
+                sequence.OnFine(fine.c_str(), false);
+                while (sequence.Advance() != CaptureStep::Idle)
+                {
+                    frames_per_iteration++;
+                }
+            }
+        }
+        Run("capture sequence", iterations, frames_per_iteration, [&] {
+            CaptureSequence sequence;
+            double sum = 0.0;
+            for (const std::string &fine : workload.fines)
+            {
+                sequence.OnFine(fine.c_str(), false);
+                CaptureStep step;
+                while ((step = sequence.Advance()) != CaptureStep::Idle)
+                {
+                    sum += (double)step;
+                }
+            }
+            g_sink = g_sink + sum;
+        });
+    }
+
+    // Worker pool: the rig pose over the workload, split into root jobs of 64 placements that each
+    // spawn two children. One op is one job, including its submission and completion round trip.
+    {
+        const size_t slice = 64;
+        const size_t roots = (placements.size() + slice - 1) / slice;
+        std::vector<PoseJob> jobs(roots * 3);
+        for (size_t i = 0; i < roots; ++i)
+        {
+            const size_t begin = i * slice;
+            const size_t count = placements.size() - begin < slice ? placements.size() - begin : slice;
+            const size_t third = count / 3;
+            PoseJob *children = &jobs[roots + i * 2];
+            jobs[i].placements = &placements[begin];
+            jobs[i].count = count - 2 * third;
+            jobs[i].children = children;
+            children[0].placements = &placements[begin + count - 2 * third];
+            children[0].count = third;
+            children[1].placements = &placements[begin + count - third];
+            children[1].count = third;
+        }
+        for (PoseJob &job : jobs)
+        {
+            job.run = RunPoseJob;
+            job.complete = CompletePoseJob;
+        }
+
+        WorkerPool pool;
+        WorkerPoolConfig config;
+        config.threads = threads;
+        config.priority = 0;
+        g_pool = &pool;
+        pool.Start(config);
+
+        bool intact = true;
+        Run("worker pool job", iterations, jobs.size(), [&] { intact = RunPoolRound(pool, jobs, roots) && intact; });
+
+        pool.Stop();
+        g_pool = nullptr;
+        const WorkerPoolStats stats = pool.GetStats();
+        std::printf("  %-16s %u threads, %llu jobs run, %llu stolen, %llu rejected\n", "", pool.GetThreadCount() ? pool.GetThreadCount() : threads,
+                    (unsigned long long)stats.executed, (unsigned long long)stats.stolen, (unsigned long long)stats.rejected);
+        if (!intact || stats.executed != stats.submitted)
+        {
+            std::fprintf(stderr, "Worker pool lost or duplicated completions.\n");
+            return 1;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,177 @@
+/**
+ * @file ExportTool.cpp
+ * @brief Exports the fines in a capture journal as an Apache Arrow IPC stream.
+ * @details Runs the same export as the plugin's export keybind. `--synthetic <n>` first writes a
+ * journal of `n` fines (captures started, dropped and repeat fines attached to them, most captures
+ * followed by their screenshot name two fines later) and then exports it, to time the
+ * export and to produce a file for checking with other Arrow readers:
+ *
+ *     python -c "import pyarrow.ipc as ipc; print(ipc.open_stream('violations.arrows').read_pandas())"
+ *
+ * Usage:
+ *   rlc_export <capture_journal.rlcj> <out.arrows> [--screenshots <directory>]
+ *   rlc_export --synthetic <n> <out.arrows> [--screenshots <directory>]
+ */
+
+#include "CaptureJournal.hpp"
+#include "ViolationExport.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    const char *OFFENCES[] = {"red_signal", "speeding", "red_signal", "speeding_camera", "red_signal", "wrong_way", "no_lights"};
+
+    bool WriteSyntheticJournal(const char *path, uint64_t fines)
+    {
+        std::remove(path);
+        static CaptureJournal journal;
+        JournalRecovery recovery;
+        if (!journal.Open(path, recovery))
+        {
+            std::fprintf(stderr, "Cannot create '%s'.\n", path);
+            return false;
+        }
+
+        uint32_t capture_id = 0;
+        uint32_t named_id = 0; // Last capture whose name is still to be written.
+        uint64_t named_at = 0;
+        for (uint64_t i = 0; i < fines; ++i)
+        {
+            JournalFine fine{};
+            fine.simulation_time = 1000000ull * i;
+            fine.x = 1000.0 + 37.0 * (double)(i % 977);
+            fine.y = 12.5;
+            fine.z = -500.0 + 11.0 * (double)(i % 541);
+            fine.heading = (double)(i % 100) / 100.0;
+            fine.speed = 5.0f + (float)(i % 20);
+            fine.fine_amount = 100 + (int64_t)(i % 9) * 50;
+            std::snprintf(fine.offence, sizeof(fine.offence), "%s", OFFENCES[i % (sizeof(OFFENCES) / sizeof(OFFENCES[0]))]);
+            std::snprintf(fine.truck_id, sizeof(fine.truck_id), "vehicle.scania.s_2016");
+            std::snprintf(fine.plate, sizeof(fine.plate), "RLC %03u", (unsigned)(i / 1000 % 1000));
+            if (std::strcmp(fine.offence, "red_signal") == 0)
+            {
+                // A new capture, unless one is still waiting for its screenshot: a repeat fine is
+                // attached to it and anything else is dropped.
+                if (named_id == 0)
+                {
+                    capture_id = capture_id % 1000 + 1; // Ids restart like those of a new session.
+                    fine.capture = (uint8_t)JournalFineCapture::Started;
+                    fine.capture_id = capture_id;
+                    named_id = capture_id;
+                    named_at = i;
+                }
+                else if (i % 2 == 0)
+                {
+                    fine.capture = (uint8_t)JournalFineCapture::Attached;
+                    fine.capture_id = named_id;
+                }
+                else
+                {
+                    fine.capture = (uint8_t)JournalFineCapture::Dropped;
+                }
+            }
+            if (!journal.Append(JournalRecordType::Fine, &fine, sizeof(fine)))
+            {
+                return false;
+            }
+
+            // Every capture but one in eight is named two fines later; the rest never take a screenshot.
+            if (named_id != 0 && i >= named_at + 2)
+            {
+                if (named_id % 8 != 0)
+                {
+                    JournalCaptureNamed named{};
+                    named.capture_id = named_id;
+                    std::snprintf(named.name, sizeof(named.name), "red_light_X%.0f_Y12_Z%.0f_T%llu", fine.x, fine.z, (unsigned long long)fine.simulation_time);
+                    if (!journal.Append(JournalRecordType::CaptureNamed, &named, sizeof(named)))
+                    {
+                        return false;
+                    }
+                }
+                named_id = 0;
+            }
+            if (journal.GetUnsyncedBytes() >= JOURNAL_CHECKPOINT_BYTES * 64)
+            {
+                journal.Checkpoint();
+            }
+        }
+        journal.Close();
+        return true;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *journal_path = nullptr;
+    const char *out_path = nullptr;
+    const char *screenshot_dir = nullptr;
+    uint64_t synthetic = 0;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--synthetic") == 0 && i + 1 < argc)
+        {
+            synthetic = std::strtoull(argv[++i], nullptr, 10);
+            usage = usage || synthetic == 0;
+        }
+        else if (std::strcmp(argv[i], "--screenshots") == 0 && i + 1 < argc)
+        {
+            screenshot_dir = argv[++i];
+        }
+        else if (argv[i][0] != '-' && !journal_path && !synthetic)
+        {
+            journal_path = argv[i];
+        }
+        else if (argv[i][0] != '-' && !out_path)
+        {
+            out_path = argv[i];
+        }
+        else
+        {
+            usage = true;
+        }
+    }
+    if (usage || !out_path || (!journal_path && !synthetic))
+    {
+        std::fprintf(stderr, "Usage: rlc_export <capture_journal.rlcj> <out.arrows> [--screenshots <directory>]\n"
+                             "       rlc_export --synthetic <n> <out.arrows> [--screenshots <directory>]\n");
+        return 2;
+    }
+
+    char synthetic_path[VIOLATION_PATH_SIZE];
+    if (synthetic)
+    {
+        std::snprintf(synthetic_path, sizeof(synthetic_path), "%s.rlcj", out_path);
+        const auto started = std::chrono::steady_clock::now();
+        if (!WriteSyntheticJournal(synthetic_path, synthetic))
+        {
+            return 1;
+        }
+        std::printf("synthetic journal: %llu fines in %.0f ms\n", (unsigned long long)synthetic,
+                    std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count());
+        journal_path = synthetic_path;
+    }
+
+    const auto started = std::chrono::steady_clock::now();
+    const ViolationExportResult result = ExportViolations(journal_path, out_path, screenshot_dir);
+    const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+    if (!result.ok)
+    {
+        std::fprintf(stderr, "Export of '%s' to '%s' failed.\n", journal_path, out_path);
+        return 1;
+    }
+    std::printf("%llu rows in %llu batches, %llu bytes, from %llu journal records in %.0f ms (%.0f rows/s)%s\n", (unsigned long long)result.rows,
+                (unsigned long long)result.batches, (unsigned long long)result.bytes, (unsigned long long)result.journal_records, elapsed_ms,
+                elapsed_ms > 0.0 ? (double)result.rows * 1000.0 / elapsed_ms : 0.0, result.damaged ? ", journal ends in a torn record" : "");
+    if (synthetic)
+    {
+        std::remove(synthetic_path);
+    }
+    return 0;
+}
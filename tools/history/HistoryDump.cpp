@@ -0,0 +1,171 @@
+/**
+ * @file HistoryDump.cpp
+ * @brief Command-line inspector for the capture history segments.
+ * @details Lists the segments in a directory (sequence, state, blocks, records, size) or, with
+ * `--csv`, prints every record of every segment in order. `--maintain` first runs the same
+ * maintenance the plugin runs in the background (sealing and merging); only do that while the game
+ * is not running, since the tool cannot know which segment is active.
+ *
+ * `--tracks <out>` runs the plugin's track export instead: the path before every red light fine,
+ * as GPX if `out` ends in `.gpx` and as GeoJSON otherwise, decimated to `--tolerance` metres
+ * (default 2) over a window of `--window` seconds (default 30).
+ *
+ * Usage:
+ *   rlc_history <directory> [--maintain] [--csv]
+ *   rlc_history <directory> --tracks <out.geojson|out.gpx> [--tolerance <m>] [--window <s>]
+ */
+
+#include "HistoryStore.hpp"
+#include "TrackExport.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    const char *KIND_NAMES[] = {"sample", "red_light_fine", "other_fine"};
+    static_assert(sizeof(KIND_NAMES) / sizeof(KIND_NAMES[0]) == static_cast<size_t>(HistoryKind::Count), "Kind name table out of date.");
+
+    const char *KindName(HistoryKind kind) { return kind < HistoryKind::Count ? KIND_NAMES[static_cast<size_t>(kind)] : "unknown"; }
+
+    long FileSize(const char *path)
+    {
+        FILE *file = std::fopen(path, "rb");
+        if (!file)
+        {
+            return -1;
+        }
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fclose(file);
+        return size;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *directory = nullptr;
+    const char *tracks_path = nullptr;
+    TrackExportOptions options;
+    bool maintain = false;
+    bool csv = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--maintain") == 0)
+        {
+            maintain = true;
+        }
+        else if (std::strcmp(argv[i], "--csv") == 0)
+        {
+            csv = true;
+        }
+        else if (std::strcmp(argv[i], "--tracks") == 0 && i + 1 < argc)
+        {
+            tracks_path = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--tolerance") == 0 && i + 1 < argc)
+        {
+            options.tolerance_m = std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--window") == 0 && i + 1 < argc)
+        {
+            options.window_s = std::atof(argv[++i]);
+        }
+        else if (argv[i][0] != '-' && !directory)
+        {
+            directory = argv[i];
+        }
+        else
+        {
+            directory = nullptr;
+            break;
+        }
+    }
+    if (!directory)
+    {
+        std::fprintf(stderr, "Usage: rlc_history <directory> [--maintain] [--csv]\n"
+                             "       rlc_history <directory> --tracks <out.geojson|out.gpx> [--tolerance <m>] [--window <s>]\n");
+        return 2;
+    }
+
+    if (tracks_path)
+    {
+        const size_t length = std::strlen(tracks_path);
+        options.format = length >= 4 && std::strcmp(tracks_path + length - 4, ".gpx") == 0 ? TrackFormat::Gpx : TrackFormat::GeoJson;
+        const auto started = std::chrono::steady_clock::now();
+        const TrackExportResult result = ExportTracks(directory, tracks_path, options);
+        const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        if (!result.ok)
+        {
+            std::fprintf(stderr, "Export of '%s' to '%s' failed.\n", directory, tracks_path);
+            return 1;
+        }
+        std::printf("%llu tracks, %llu -> %llu points, %llu bytes, from %llu records in %u segments in %.0f ms%s\n", (unsigned long long)result.tracks,
+                    (unsigned long long)result.points_in, (unsigned long long)result.points_out, (unsigned long long)result.bytes,
+                    (unsigned long long)result.records, result.segments, elapsed_ms, result.damaged ? ", a segment ends in a torn block" : "");
+        return 0;
+    }
+
+    if (maintain)
+    {
+        const HistoryMaintenanceResult result = MaintainHistory(directory, 0);
+        std::fprintf(csv ? stderr : stdout, "maintenance: %u sealed, %u merged, %u leftovers removed, %u failed, %llu -> %llu bytes\n", result.sealed,
+                     result.merged, result.leftovers, result.failures, (unsigned long long)result.bytes_before, (unsigned long long)result.bytes_after);
+    }
+
+    static uint32_t sequences[HISTORY_MAX_SEGMENTS];
+    const size_t count = ListHistorySegments(directory, sequences, HISTORY_MAX_SEGMENTS);
+    if (csv)
+    {
+        std::printf("segment,time_us,x,y,z,heading,speed,kind\n");
+    }
+
+    static HistoryReader reader;
+    uint64_t total_records = 0, total_bytes = 0;
+    bool damaged = false;
+    for (size_t i = 0; i < count; ++i)
+    {
+        char path[HISTORY_PATH_SIZE];
+        FormatHistorySegmentPath(path, sizeof(path), directory, sequences[i]);
+        const long size = FileSize(path);
+        total_bytes += size > 0 ? (uint64_t)size : 0;
+        if (!reader.Open(path))
+        {
+            std::fprintf(stderr, "%s: not a history segment.\n", path);
+            damaged = true;
+            continue;
+        }
+
+        uint64_t records = 0;
+        HistoryRecord record;
+        while (reader.Next(record))
+        {
+            if (csv)
+            {
+                std::printf("%u,%llu,%.2f,%.2f,%.2f,%.5f,%.2f,%s\n", sequences[i], (unsigned long long)record.time_us, record.position.x, record.position.y,
+                            record.position.z, record.heading, record.speed, KindName(record.kind));
+            }
+            ++records;
+        }
+        total_records += records;
+        damaged = damaged || reader.IsDamaged();
+        if (!csv)
+        {
+            std::printf("%08u%s  %-6s %6llu blocks %8llu records %10ld bytes%s\n", sequences[i],
+                        reader.GetLastSequence() != sequences[i] ? "+" : " ", reader.IsSealed() ? "sealed" : "raw",
+                        (unsigned long long)reader.GetBlockCount(), (unsigned long long)records, size, reader.IsDamaged() ? "  (damaged tail)" : "");
+        }
+        reader.Close();
+    }
+
+    if (!csv)
+    {
+        std::printf("%zu segments, %llu records, %llu bytes (%.1f B/record)\n", count, (unsigned long long)total_records, (unsigned long long)total_bytes,
+                    total_records ? (double)total_bytes / (double)total_records : 0.0);
+    }
+    return damaged ? 1 : 0;
+}
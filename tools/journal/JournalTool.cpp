@@ -0,0 +1,416 @@
+/**
+ * @file JournalTool.cpp
+ * @brief Prints a capture journal, or checks its crash recovery by fault injection.
+ * @details `--fault-injection` writes a reference journal (records and checkpoints, with a small
+ * checkpoint interval) while capturing every write the journal makes. It then replays that write
+ * stream cut at every byte offset, once leaving the file short and once zero-filling the rest of
+ * the interrupted write (as a file system may after a power loss), opens each image and checks
+ * that recovery keeps exactly the records whose write completed, truncates the file after the last
+ * of them, scans no more than the unsynced tail, and leaves a journal that can be appended to and
+ * reopened cleanly.
+ *
+ * Usage:
+ *   rlc_journal <capture_journal.rlcj>
+ *   rlc_journal --fault-injection [--records <n>] [--checkpoint-bytes <n>] [--dir <directory>]
+ *
+ * Exits with status 1 if the journal is damaged or any injected fault is not recovered correctly.
+ */
+
+#include "CaptureJournal.hpp"
+#include "Crc32c.hpp"
+#include "ScreenshotQuality.hpp"
+#include "ViolationExport.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    const char *OUTCOME_NAMES[] = {"saved", "failed", "timed out"};
+
+    int PrintJournal(const char *path)
+    {
+        JournalReader reader;
+        if (!reader.Open(path))
+        {
+            std::fprintf(stderr, "Cannot open journal '%s'.\n", path);
+            return 1;
+        }
+
+        uint8_t payload[JOURNAL_MAX_PAYLOAD];
+        JournalRecordType type;
+        size_t size = 0;
+        uint64_t count = 0;
+        while (reader.Next(type, payload, size))
+        {
+            ++count;
+            if (type == JournalRecordType::Screenshot && size == sizeof(JournalScreenshot))
+            {
+                JournalScreenshot shot;
+                std::memcpy(&shot, payload, sizeof(shot));
+                std::printf("screenshot  %-24.*s %.*s  t=%llu pos=(%.1f, %.1f, %.1f) shot=%d attempt=%u\n", (int)sizeof(shot.label), shot.label,
+                            (int)sizeof(shot.name), shot.name, (unsigned long long)shot.simulation_time, shot.x, shot.y, shot.z, shot.shot, shot.attempt);
+            }
+            else if (type == JournalRecordType::ScreenshotResult && size == sizeof(JournalScreenshotResult))
+            {
+                JournalScreenshotResult result;
+                std::memcpy(&result, payload, sizeof(result));
+                std::printf("result      %-24s %.*s  latency=%llu us attempt=%u%s\n", result.outcome < 3 ? OUTCOME_NAMES[result.outcome] : "unknown",
+                            (int)sizeof(result.name), result.name, (unsigned long long)result.latency_us, result.attempt, result.retry_queued ? " (retry queued)" : "");
+            }
+            else if (type == JournalRecordType::Fine && size == sizeof(JournalFine))
+            {
+                JournalFine fine;
+                std::memcpy(&fine, payload, sizeof(fine));
+                std::printf("fine        %-24.*s %lld  t=%llu pos=(%.1f, %.1f, %.1f) %.1f m/s %s #%u %.*s %.*s\n", (int)sizeof(fine.offence), fine.offence,
+                            (long long)fine.fine_amount, (unsigned long long)fine.simulation_time, fine.x, fine.y, fine.z, fine.speed,
+                            FineCaptureName((JournalFineCapture)fine.capture), fine.capture_id, (int)sizeof(fine.truck_id), fine.truck_id, (int)sizeof(fine.plate), fine.plate);
+            }
+            else if (type == JournalRecordType::CaptureNamed && size == sizeof(JournalCaptureNamed))
+            {
+                JournalCaptureNamed named;
+                std::memcpy(&named, payload, sizeof(named));
+                std::printf("named       #%-23u %.*s\n", named.capture_id, (int)sizeof(named.name), named.name);
+            }
+            else if (type == JournalRecordType::ScreenshotQuality && size == sizeof(JournalScreenshotQuality))
+            {
+                JournalScreenshotQuality quality;
+                std::memcpy(&quality, payload, sizeof(quality));
+                char flags[48];
+                FormatQualityFlags(flags, sizeof(flags), quality.flags);
+                std::printf("quality     %-24s %.*s  %ux%u luma=%.1f laplacian=%.1f difference=%.2f attempt=%u%s\n", flags, (int)sizeof(quality.name),
+                            quality.name, quality.width, quality.height, quality.mean_luma, quality.laplacian_variance, quality.difference, quality.attempt,
+                            quality.retake ? " (retake queued)" : "");
+            }
+            else
+            {
+                std::printf("record type %u, %zu bytes\n", (unsigned)type, size);
+            }
+        }
+        std::printf("%llu records%s\n", (unsigned long long)count, reader.IsDamaged() ? ", damaged tail" : "");
+        return reader.IsDamaged() ? 1 : 0;
+    }
+
+    // =================================================================================================
+    // Fault injection
+    // =================================================================================================
+
+    struct Write
+    {
+        uint64_t offset;
+        std::vector<uint8_t> bytes;
+    };
+
+    struct Reference
+    {
+        std::vector<Write> writes;
+        std::vector<std::vector<uint8_t>> payloads;
+        std::vector<uint64_t> completed_at; ///< Stream position after each record's write.
+        std::vector<uint64_t> ends;         ///< File offset after each record.
+        std::vector<size_t> record_writes;  ///< Index of each record's write.
+    };
+
+    void CaptureWrite(void *user_data, uint64_t offset, const void *data, size_t size)
+    {
+        Reference &reference = *static_cast<Reference *>(user_data);
+        const uint8_t *bytes = static_cast<const uint8_t *>(data);
+        reference.writes.push_back({offset, std::vector<uint8_t>(bytes, bytes + size)});
+    }
+
+    uint64_t StreamSize(const Reference &reference)
+    {
+        uint64_t total = 0;
+        for (const Write &write : reference.writes)
+        {
+            total += write.bytes.size();
+        }
+        return total;
+    }
+
+    bool BuildReference(const char *path, size_t record_count, uint64_t checkpoint_bytes, Reference &reference)
+    {
+        std::remove(path);
+        CaptureJournal journal;
+        journal.SetWriteObserver(CaptureWrite, &reference);
+        JournalRecovery recovery;
+        if (!journal.Open(path, recovery))
+        {
+            std::fprintf(stderr, "Cannot create '%s'.\n", path);
+            return false;
+        }
+        for (size_t i = 0; i < record_count; ++i)
+        {
+            std::vector<uint8_t> payload;
+            JournalRecordType type;
+            if (i % 2 == 0)
+            {
+                JournalScreenshot shot{};
+                shot.simulation_time = 1000000ull * i;
+                shot.x = 10.0 * i;
+                shot.z = -3.0 * i;
+                shot.shot = (int32_t)(i % 5) - 1;
+                std::snprintf(shot.label, sizeof(shot.label), "red_light");
+                std::snprintf(shot.name, sizeof(shot.name), "red_light_X%zu_Y0_Z%zu_T%zu", i * 10, i * 3, i);
+                payload.assign(reinterpret_cast<uint8_t *>(&shot), reinterpret_cast<uint8_t *>(&shot) + sizeof(shot));
+                type = JournalRecordType::Screenshot;
+            }
+            else
+            {
+                JournalScreenshotResult result{};
+                result.latency_us = 1000 + i;
+                result.outcome = (uint8_t)(i % 3);
+                std::snprintf(result.name, sizeof(result.name), "red_light_X%zu", i);
+                // Results are short on purpose: records of several sizes.
+                payload.assign(reinterpret_cast<uint8_t *>(&result), reinterpret_cast<uint8_t *>(&result) + 14 + (i % 7) * 9);
+                type = JournalRecordType::ScreenshotResult;
+            }
+            if (!journal.Append(type, payload.data(), payload.size()))
+            {
+                std::fprintf(stderr, "Append failed.\n");
+                return false;
+            }
+            reference.payloads.push_back(payload);
+            reference.completed_at.push_back(StreamSize(reference));
+            reference.record_writes.push_back(reference.writes.size() - 1);
+            reference.ends.push_back(journal.GetLength());
+            if (journal.GetUnsyncedBytes() >= checkpoint_bytes)
+            {
+                journal.Checkpoint();
+            }
+        }
+        journal.Close();
+        std::remove(path);
+        return true;
+    }
+
+    // The file as it would be if the process died `cut` bytes into the write stream.
+    std::vector<uint8_t> BuildImage(const Reference &reference, uint64_t cut, bool zero_fill)
+    {
+        std::vector<uint8_t> image;
+        uint64_t streamed = 0;
+        for (const Write &write : reference.writes)
+        {
+            if (streamed >= cut)
+            {
+                break;
+            }
+            const size_t kept = (size_t)(cut - streamed < write.bytes.size() ? cut - streamed : write.bytes.size());
+            const size_t extent = zero_fill ? write.bytes.size() : kept;
+            if (image.size() < write.offset + extent)
+            {
+                image.resize((size_t)(write.offset + extent), 0);
+            }
+            std::memcpy(image.data() + write.offset, write.bytes.data(), kept);
+            if (zero_fill)
+            {
+                std::memset(image.data() + write.offset + kept, 0, write.bytes.size() - kept);
+            }
+            streamed += write.bytes.size();
+        }
+        return image;
+    }
+
+    bool WriteImage(const char *path, const std::vector<uint8_t> &image)
+    {
+        FILE *file = std::fopen(path, "wb");
+        if (!file)
+        {
+            return false;
+        }
+        const bool ok = image.empty() || std::fwrite(image.data(), 1, image.size(), file) == image.size();
+        return std::fclose(file) == 0 && ok;
+    }
+
+    long FileLength(const char *path)
+    {
+        FILE *file = std::fopen(path, "rb");
+        if (!file)
+        {
+            return -1;
+        }
+        std::fseek(file, 0, SEEK_END);
+        const long size = std::ftell(file);
+        std::fclose(file);
+        return size;
+    }
+
+    // Checks one injected fault. Returns an empty string on success.
+    std::string CheckCut(const char *path, const Reference &reference, uint64_t cut, bool zero_fill, uint64_t scan_bound, uint64_t &max_scanned)
+    {
+        if (!WriteImage(path, BuildImage(reference, cut, zero_fill)))
+        {
+            return "cannot write image";
+        }
+        size_t expected = 0;
+        while (expected < reference.completed_at.size() && reference.completed_at[expected] <= cut)
+        {
+            ++expected;
+        }
+        if (zero_fill && expected < reference.completed_at.size())
+        {
+            // A record cut where only its zero padding was left to write is intact.
+            const std::vector<uint8_t> &bytes = reference.writes[reference.record_writes[expected]].bytes;
+            const uint64_t start = reference.completed_at[expected] - bytes.size();
+            bool intact = cut >= start;
+            for (uint64_t i = cut > start ? cut - start : 0; intact && i < bytes.size(); ++i)
+            {
+                intact = bytes[(size_t)i] == 0;
+            }
+            expected += intact ? 1 : 0;
+        }
+
+        CaptureJournal journal;
+        JournalRecovery recovery;
+        if (!journal.Open(path, recovery))
+        {
+            return "open failed";
+        }
+        max_scanned = recovery.scanned_bytes > max_scanned ? recovery.scanned_bytes : max_scanned;
+        if (recovery.records != expected)
+        {
+            return "recovered " + std::to_string(recovery.records) + " records, expected " + std::to_string(expected);
+        }
+        if (recovery.scanned_bytes > scan_bound)
+        {
+            return "scanned " + std::to_string(recovery.scanned_bytes) + " bytes";
+        }
+        const uint64_t expected_length = expected ? reference.ends[expected - 1] : sizeof(JournalFileHeader);
+        if (journal.GetLength() != expected_length || (uint64_t)FileLength(path) != expected_length)
+        {
+            return "length " + std::to_string(FileLength(path)) + ", expected " + std::to_string(expected_length);
+        }
+
+        // Still usable: one more record survives a clean reopen without a scan.
+        const uint8_t extra[3] = {1, 2, 3};
+        if (!journal.Append(JournalRecordType::ScreenshotResult, extra, sizeof(extra)))
+        {
+            return "append after recovery failed";
+        }
+        journal.Close();
+        if (!journal.Open(path, recovery) || recovery.records != expected + 1 || recovery.scanned_bytes != 0)
+        {
+            return "reopen after append found " + std::to_string(recovery.records) + " records, scanned " + std::to_string(recovery.scanned_bytes);
+        }
+        journal.Close();
+
+        JournalReader reader;
+        uint8_t payload[JOURNAL_MAX_PAYLOAD];
+        JournalRecordType type;
+        size_t size = 0;
+        if (!reader.Open(path))
+        {
+            return "reader cannot open";
+        }
+        for (size_t i = 0; i <= expected; ++i)
+        {
+            const uint8_t *want = i < expected ? reference.payloads[i].data() : extra;
+            const size_t want_size = i < expected ? reference.payloads[i].size() : sizeof(extra);
+            if (!reader.Next(type, payload, size) || size != want_size || std::memcmp(payload, want, size) != 0)
+            {
+                return "record " + std::to_string(i) + " differs";
+            }
+        }
+        if (reader.Next(type, payload, size) || reader.IsDamaged())
+        {
+            return "records after the recovered ones";
+        }
+        return std::string();
+    }
+
+    int RunFaultInjection(const char *directory, size_t record_count, uint64_t checkpoint_bytes)
+    {
+        const std::string reference_path = std::string(directory) + "/rlc_journal_reference.rlcj";
+        const std::string path = std::string(directory) + "/rlc_journal_fault.rlcj";
+
+        const uint8_t check[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+        if (Crc32c(check, sizeof(check)) != 0xE3069283u)
+        {
+            std::fprintf(stderr, "CRC-32C check value mismatch.\n");
+            return 1;
+        }
+
+        Reference reference;
+        if (!BuildReference(reference_path.c_str(), record_count, checkpoint_bytes, reference))
+        {
+            return 1;
+        }
+        const uint64_t stream_size = StreamSize(reference);
+
+        // A torn checkpoint falls back to the one before it: two intervals plus the records that crossed them.
+        const uint64_t scan_bound = 2 * (checkpoint_bytes + sizeof(JournalRecordHeader) + JOURNAL_MAX_PAYLOAD);
+        uint64_t failures = 0, max_scanned = 0;
+        for (uint64_t cut = 0; cut <= stream_size; ++cut)
+        {
+            for (int zero_fill = 0; zero_fill < 2; ++zero_fill)
+            {
+                const std::string error = CheckCut(path.c_str(), reference, cut, zero_fill != 0, scan_bound, max_scanned);
+                if (!error.empty() && failures++ < 10)
+                {
+                    std::fprintf(stderr, "Cut at byte %llu%s: %s\n", (unsigned long long)cut, zero_fill ? " (zero-filled)" : "", error.c_str());
+                }
+            }
+        }
+        std::remove(path.c_str());
+
+        std::printf("fault injection: %zu records, %zu writes, %llu bytes, cut at every byte twice (%s CRC-32C): %llu failures, max tail scanned %llu bytes "
+                    "(checkpoint every %llu)\n",
+                    record_count, reference.writes.size(), (unsigned long long)stream_size, Crc32cUsesHardware() ? "SSE4.2" : "table",
+                    (unsigned long long)failures, (unsigned long long)max_scanned, (unsigned long long)checkpoint_bytes);
+        return failures == 0 ? 0 : 1;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *path = nullptr;
+    const char *directory = ".";
+    bool fault_injection = false;
+    size_t records = 24;
+    uint64_t checkpoint_bytes = 1024;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--fault-injection") == 0)
+        {
+            fault_injection = true;
+        }
+        else if (std::strcmp(argv[i], "--records") == 0 && i + 1 < argc)
+        {
+            records = (size_t)std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--checkpoint-bytes") == 0 && i + 1 < argc)
+        {
+            checkpoint_bytes = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--dir") == 0 && i + 1 < argc)
+        {
+            directory = argv[++i];
+        }
+        else if (argv[i][0] != '-' && !path)
+        {
+            path = argv[i];
+        }
+        else
+        {
+            path = nullptr;
+            fault_injection = false;
+            break;
+        }
+    }
+
+    if (fault_injection)
+    {
+        return RunFaultInjection(directory, records, checkpoint_bytes);
+    }
+    if (!path)
+    {
+        std::fprintf(stderr, "Usage: rlc_journal <capture_journal.rlcj>\n"
+                             "       rlc_journal --fault-injection [--records <n>] [--checkpoint-bytes <n>] [--dir <directory>]\n");
+        return 2;
+    }
+    return PrintJournal(path);
+}
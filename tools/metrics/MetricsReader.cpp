@@ -0,0 +1,146 @@
+/**
+ * @file MetricsReader.cpp
+ * @brief Command-line reader for the plugin's shared-memory metrics segment.
+ * @details Maps the segment read-only and prints a consistent snapshot, either once or repeatedly.
+ * It never writes to the segment, so any number of readers can run alongside the game.
+ *
+ * Usage:
+ *   rlc_metrics [--watch <interval ms>]
+ */
+
+#include "SharedMetrics.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    const char *PHASE_NAMES[] = {"posed", "screenshot", "restored", "finished"};
+    static_assert(sizeof(PHASE_NAMES) / sizeof(PHASE_NAMES[0]) == static_cast<size_t>(CapturePhase::Count), "Phase name table out of date.");
+
+    // Upper bound (us) of the bucket that contains the given percentile.
+    uint64_t Percentile(const MetricsHistogram &histogram, double fraction)
+    {
+        if (histogram.count == 0)
+        {
+            return 0;
+        }
+        const uint64_t target = (uint64_t)(fraction * (double)histogram.count + 0.5);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < METRICS_HISTOGRAM_BUCKETS; ++i)
+        {
+            seen += histogram.buckets[i];
+            if (seen >= target)
+            {
+                return i == 0 ? 1 : (1ull << i);
+            }
+        }
+        return histogram.max_us;
+    }
+
+    void PrintHistogram(const char *name, const MetricsHistogram &histogram)
+    {
+        std::printf("  %-12s n=%-8llu avg=%-8llu p50<=%-8llu p95<=%-8llu max=%-8u last=%u\n",
+                    name,
+                    (unsigned long long)histogram.count,
+                    (unsigned long long)(histogram.count ? histogram.sum_us / histogram.count : 0),
+                    (unsigned long long)Percentile(histogram, 0.50),
+                    (unsigned long long)Percentile(histogram, 0.95),
+                    histogram.max_us,
+                    histogram.last_us);
+    }
+
+    void PrintSnapshot(const MetricsBlock &block)
+    {
+        std::printf("publish #%llu\n", (unsigned long long)block.publish_count);
+
+        std::printf("fines:\n");
+        const uint32_t offences = block.offence_count < METRICS_MAX_OFFENCES ? block.offence_count : (uint32_t)METRICS_MAX_OFFENCES;
+        for (uint32_t i = 0; i < offences; ++i)
+        {
+            if (block.fines_by_offence[i] != 0)
+            {
+                std::printf("  %-26.*s %llu\n", (int)METRICS_OFFENCE_NAME_SIZE, block.offence_names[i], (unsigned long long)block.fines_by_offence[i]);
+            }
+        }
+
+        std::printf("captures: completed=%llu dropped=%llu deduplicated=%llu queue=%u\n",
+                    (unsigned long long)block.captures_completed,
+                    (unsigned long long)block.captures_dropped,
+                    (unsigned long long)block.captures_deduplicated,
+                    block.queue_depth);
+        std::printf("capture latency (us since fine):\n");
+        for (size_t i = 0; i < static_cast<size_t>(CapturePhase::Count); ++i)
+        {
+            PrintHistogram(PHASE_NAMES[i], block.phase_latency[i]);
+        }
+        std::printf("screenshots: saved=%llu failed=%llu unconfirmed=%llu retries=%llu\n",
+                    (unsigned long long)block.screenshots_saved,
+                    (unsigned long long)block.screenshots_failed,
+                    (unsigned long long)block.screenshots_unconfirmed,
+                    (unsigned long long)block.screenshot_retries);
+        PrintHistogram("write (us)", block.screenshot_write_latency);
+        std::printf("screenshot quality: checked=%llu black=%llu blurred=%llu stale=%llu unreadable=%llu retakes=%llu\n",
+                    (unsigned long long)block.screenshots_checked,
+                    (unsigned long long)block.screenshots_black,
+                    (unsigned long long)block.screenshots_blurred,
+                    (unsigned long long)block.screenshots_stale,
+                    (unsigned long long)block.screenshots_unreadable,
+                    (unsigned long long)block.quality_retakes);
+        std::printf("manual captures: taken=%llu ignored=%llu\n",
+                    (unsigned long long)block.manual_captures,
+                    (unsigned long long)block.manual_captures_ignored);
+        PrintHistogram("key (us)", block.manual_capture_latency);
+
+        std::printf("frame cost (us): budget=%u overruns=%llu\n", block.frame_budget_us, (unsigned long long)block.frame_overruns);
+        PrintHistogram("frame", block.frame_cost);
+        std::fflush(stdout);
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    int watch_ms = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--watch") == 0 && i + 1 < argc)
+        {
+            watch_ms = std::atoi(argv[++i]);
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: rlc_metrics [--watch <interval ms>]\n");
+            return 2;
+        }
+    }
+
+    SharedMetricsReader reader;
+    if (!reader.Open())
+    {
+        std::fprintf(stderr, "rlc_metrics: metrics segment not found or has an incompatible layout (version %u expected)\n", METRICS_VERSION);
+        return 1;
+    }
+
+    MetricsBlock block;
+    do
+    {
+        if (!reader.Read(block))
+        {
+            std::fprintf(stderr, "rlc_metrics: could not take a consistent snapshot\n");
+            return 1;
+        }
+        PrintSnapshot(block);
+        if (watch_ms > 0)
+        {
+            std::printf("\n");
+            std::this_thread::sleep_for(std::chrono::milliseconds(watch_ms));
+        }
+    } while (watch_ms > 0);
+
+    return 0;
+}
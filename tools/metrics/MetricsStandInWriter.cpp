@@ -0,0 +1,146 @@
+/**
+ * @file MetricsStandInWriter.cpp
+ * @brief Stand-in for the plugin's metrics writer, for exercising readers without the game.
+ * @details Default mode publishes plausible synthetic metrics at 60 Hz so `rlc_metrics` or a
+ * dashboard can be developed against a live segment.
+ *
+ * `--stress` runs a writer thread publishing as fast as it can and a reader thread in the same
+ * process. Every publish keeps several counters equal to each other, so any torn snapshot the
+ * seqlock fails to reject shows up as a mismatch. Exits non-zero on the first inconsistency.
+ *
+ * Usage:
+ *   rlc_metrics_writer [--frames <n>] [--stress <publishes>]
+ */
+
+#include "SharedMetrics.hpp"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+using namespace SPF_RedLightCamera;
+
+namespace
+{
+    int RunSynthetic(uint64_t frames)
+    {
+        SharedMetricsWriter writer;
+        if (!writer.Open())
+        {
+            std::fprintf(stderr, "rlc_metrics_writer: cannot create metrics segment\n");
+            return 1;
+        }
+
+        uint32_t rng = 12345;
+        auto next = [&rng]() { rng = rng * 1664525u + 1013904223u; return rng >> 8; };
+
+        for (uint64_t frame = 0; frames == 0 || frame < frames; ++frame)
+        {
+            const uint32_t cost = 40 + next() % 200;
+            writer.RecordFrameCost(cost, cost > 200, 200);
+
+            // Roughly one red light fine every ten seconds, other offences in between.
+            if (frame % 600 == 0)
+            {
+                writer.RecordFine("red_signal");
+                writer.RecordPhaseLatency(CapturePhase::Posed, 15000 + next() % 2000);
+                writer.RecordPhaseLatency(CapturePhase::Screenshot, 32000 + next() % 4000);
+                writer.RecordPhaseLatency(CapturePhase::Restored, 49000 + next() % 6000);
+                writer.RecordPhaseLatency(CapturePhase::Finished, 99000 + next() % 8000);
+                writer.RecordCaptureCompleted();
+            }
+            else if (frame % 450 == 0)
+            {
+                writer.RecordFine(frame % 900 == 0 ? "speeding" : "no_lights");
+            }
+
+            writer.Publish();
+            std::this_thread::sleep_for(std::chrono::microseconds(16667));
+        }
+        return 0;
+    }
+
+    int RunStress(uint64_t publishes)
+    {
+        SharedMetricsWriter writer;
+        if (!writer.Open())
+        {
+            std::fprintf(stderr, "rlc_metrics_writer: cannot create metrics segment\n");
+            return 1;
+        }
+        SharedMetricsReader reader;
+        if (!reader.Open())
+        {
+            std::fprintf(stderr, "rlc_metrics_writer: cannot open metrics segment for reading\n");
+            return 1;
+        }
+
+        std::atomic<bool> done{false};
+        std::atomic<uint64_t> snapshots{0};
+        std::atomic<uint64_t> torn{0};
+
+        std::thread reader_thread([&]() {
+            MetricsBlock block;
+            while (!done.load(std::memory_order_relaxed))
+            {
+                if (!reader.Read(block))
+                {
+                    continue;
+                }
+                snapshots.fetch_add(1, std::memory_order_relaxed);
+                // Counters written in the same publish must agree.
+                const uint64_t completed = block.captures_completed;
+                if (block.captures_dropped != completed || block.fines_by_offence[0] != completed ||
+                    block.frame_cost.count != completed || block.frame_cost.sum_us != completed * 7)
+                {
+                    torn.fetch_add(1, std::memory_order_relaxed);
+                }
+            }
+        });
+
+        for (uint64_t i = 0; i < publishes; ++i)
+        {
+            writer.RecordCaptureCompleted();
+            writer.RecordCaptureDropped();
+            writer.RecordFine("red_signal");
+            writer.RecordFrameCost(7, false, 0);
+            writer.Publish();
+        }
+
+        done.store(true, std::memory_order_relaxed);
+        reader_thread.join();
+
+        std::printf("publishes=%llu snapshots=%llu inconsistent=%llu\n",
+                    (unsigned long long)publishes,
+                    (unsigned long long)snapshots.load(),
+                    (unsigned long long)torn.load());
+        return torn.load() == 0 ? 0 : 1;
+    }
+} // namespace
+
+int main(int argc, char **argv)
+{
+    uint64_t frames = 0;
+    uint64_t stress = 0;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc)
+        {
+            frames = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--stress") == 0 && i + 1 < argc)
+        {
+            stress = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else
+        {
+            std::fprintf(stderr, "Usage: rlc_metrics_writer [--frames <n>] [--stress <publishes>]\n");
+            return 2;
+        }
+    }
+
+    return stress > 0 ? RunStress(stress) : RunSynthetic(frames);
+}
@@ -0,0 +1,106 @@
+/**
+ * @file QualityTool.cpp
+ * @brief Runs the plugin's screenshot quality check over PNG files.
+ * @details Checks the files in the order given, each against the one before (as the plugin does
+ * with consecutive captures), and prints the metrics, the flags and the time the check took. Use it
+ * to tune the thresholds on real screenshots:
+ *
+ *     rlc_quality screenshot/red_light_*.png --blur 25
+ *
+ * Usage:
+ *   rlc_quality <image.png>... [--black <luma>] [--blur <variance>] [--stale <difference>] [--repeat <n>]
+ *
+ * `--repeat` checks every file n times (against itself after the first) and reports the fastest.
+ */
+
+#include "ScreenshotQuality.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+using namespace SPF_RedLightCamera;
+
+int main(int argc, char **argv)
+{
+    QualityThresholds thresholds;
+    std::vector<const char *> paths;
+    int repeat = 1;
+    bool usage = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--black") == 0 && i + 1 < argc)
+        {
+            thresholds.black_luma = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--blur") == 0 && i + 1 < argc)
+        {
+            thresholds.blur_variance = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--stale") == 0 && i + 1 < argc)
+        {
+            thresholds.stale_difference = (float)std::atof(argv[++i]);
+        }
+        else if (std::strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeat = std::atoi(argv[++i]);
+            usage = usage || repeat < 1;
+        }
+        else if (argv[i][0] != '-')
+        {
+            paths.push_back(argv[i]);
+        }
+        else
+        {
+            usage = true;
+        }
+    }
+    if (usage || paths.empty())
+    {
+        std::fprintf(stderr, "Usage: rlc_quality <image.png>... [--black <luma>] [--blur <variance>] [--stale <difference>] [--repeat <n>]\n");
+        return 2;
+    }
+
+    // About 1 MB: too large for the stack.
+    const std::unique_ptr<ScreenshotQualityChecker> checker(new ScreenshotQualityChecker());
+    int unreadable = 0;
+    for (const char *path : paths)
+    {
+        QualityMetrics metrics;
+        double best_ms = 0.0;
+        for (int n = 0; n < repeat; ++n)
+        {
+            // Repeats compare the file with itself; report the comparison with the file before.
+            QualityMetrics run;
+            const auto started = std::chrono::steady_clock::now();
+            checker->Check(path, thresholds, run);
+            const double elapsed_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+            best_ms = n == 0 || elapsed_ms < best_ms ? elapsed_ms : best_ms;
+            metrics = n == 0 ? run : metrics;
+        }
+
+        char flags[48];
+        FormatQualityFlags(flags, sizeof(flags), metrics.flags);
+        std::printf("%s: ", path);
+        if (metrics.flags & QUALITY_UNREADABLE)
+        {
+            std::printf("%s\n", flags);
+            ++unreadable;
+            continue;
+        }
+        std::printf("%ux%u luma %.1f laplacian %.1f difference ", metrics.width, metrics.height, metrics.mean_luma, metrics.laplacian_variance);
+        if (metrics.difference >= 0.0f)
+        {
+            std::printf("%.2f", metrics.difference);
+        }
+        else
+        {
+            std::printf("-");
+        }
+        std::printf(" -> %s (%.2f ms)\n", flags, best_ms);
+    }
+    return unreadable ? 1 : 0;
+}
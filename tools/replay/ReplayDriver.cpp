@@ -0,0 +1,1214 @@
+/**
+ * @file ReplayDriver.cpp
+ * @brief Offline driver that replays a telemetry recording into the plugin.
+ * @details The plugin is linked in directly and loaded through its exported entry points
+ * (`SPF_GetManifestAPI`, `SPF_GetPlugin`) exactly as the framework would do it. Every framework
+ * service the plugin touches is replaced by a stand-in that records the call to a deterministic
+ * log, so two runs over the same recording with the same settings produce identical output.
+ *
+ * Usage:
+ *   rlc_replay <recording.rlcrec> [--out <log file>] [--data-dir <dir>] [--set key=value]...
+ *              [--synthetic-traffic <vehicles>] [--screenshot-failures <n>] [--press-key <frame>]...
+ *              [--show-window <id>]... [--combination <trailers>]
+ *
+ * `--set` overrides a plugin setting (e.g. `--set settings.distance_forward=30`). Settings that
+ * are not overridden resolve to the default passed by the plugin, except the frame budget, which
+ * defaults to 0 (unlimited) so deferred work does not depend on host timing. Structured settings
+ * take JSON text (e.g. `--set 'settings.offence_presets=[{"offence":"red_signal","preset":0}]'`)
+ * and have no value unless overridden.
+ *
+ * Traffic is not part of a recording. `--synthetic-traffic` populates the stand-in Vehicle API with
+ * a deterministic set of AI vehicles (every 7th one speeding, every 11th one braking hard) so the
+ * traffic watch can be exercised offline. Set its scan budget to 0 for deterministic logs.
+ * The same vehicles are given positions on a spiral around the truck and installed as the traffic
+ * index's position source, which the game's Vehicle API cannot provide.
+ *
+ * The stand-in game log reports every screenshot one frame after its command, as saved, or as
+ * failed for every n-th screenshot with `--screenshot-failures <n>`. It writes no files: the
+ * screenshots directory is `<data-dir>/screenshot`, where PNGs can be placed under the logged names
+ * to exercise the screenshot quality check (which reports missing ones as unreadable).
+ *
+ * `--press-key <frame>` fires the plugin's keybind callbacks before that frame's `OnUpdate`, after
+ * the frame's truck data and timestamps have been delivered to the telemetry subscriptions.
+ *
+ * `--show-window <id>` opens a plugin window from the start, as the user would from the framework's
+ * window list. Windows that show timings (e.g. "StatsWindow") make the log host-dependent.
+ *
+ * Two runs over the same recording log the same calls on the same frames: the frame budget is
+ * disabled, the worker pool runs its jobs on the game thread (see `WorkerPoolConfig::run_inline`)
+ * and durations in log messages are masked.
+ *
+ * Truck and trailer constants are not part of a recording either. `--combination <trailers>` gives
+ * the truck the constants of a 6x4 tractor and couples that many tri-axle semi-trailers, laid out
+ * straight behind it, so auto-framing can be exercised offline. The constants are delivered to
+ * their subscriptions on the first frame and the trailers on every frame.
+ */
+
+#define _USE_MATH_DEFINES
+#include <cstddef> // Before SPF_Plugin.h: SPF_Hooks_API.h uses size_t without including it.
+#include <SPF_Plugin.h>
+#include <SPF_Manifest_API.h>
+#include <SPF_Logger_API.h>
+#include <SPF_Formatting_API.h>
+#include <SPF_Config_API.h>
+#include <SPF_Localization_API.h>
+#include <SPF_Environment_API.h>
+#include <SPF_Telemetry_API.h>
+#include <SPF_Camera_API.h>
+#include <SPF_GameConsole_API.h>
+#include <SPF_GameLog_API.h>
+#include <SPF_KeyBinds_API.h>
+#include <SPF_UI_API.h>
+#include <SPF_Vehicle_API.h>
+
+#include "SPF_RedLightCamera.hpp"
+#include "TelemetryRecorder.hpp"
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <map>
+#include <regex>
+#include <string>
+#include <vector>
+
+extern "C" bool SPF_GetManifestAPI(SPF_Manifest_API *out_api);
+
+namespace
+{
+    // =================================================================================================
+    // 1. Replay State
+    // =================================================================================================
+
+    struct ReplayState
+    {
+        FILE *out = stdout;
+        std::string dataDir = ".";
+        std::map<std::string, std::string> overrides;
+
+        uint64_t frame = 0;
+        SPF_TruckData truck{};
+        SPF_Timestamps timestamps{};
+
+        SPF_Telemetry_GameplayEvents_Callback gameplayCallback = nullptr;
+        void *gameplayUserData = nullptr;
+        SPF_Telemetry_TruckData_Callback truckDataCallback = nullptr;
+        void *truckDataUserData = nullptr;
+        SPF_Telemetry_Timestamps_Callback timestampsCallback = nullptr;
+        void *timestampsUserData = nullptr;
+        SPF_Telemetry_TruckConstants_Callback truckConstantsCallback = nullptr;
+        void *truckConstantsUserData = nullptr;
+        SPF_Telemetry_TrailerConstants_Callback trailerConstantsCallback = nullptr;
+        void *trailerConstantsUserData = nullptr;
+        SPF_Telemetry_Trailers_Callback trailersCallback = nullptr;
+        void *trailersUserData = nullptr;
+
+        // Synthetic combination (--combination): zeroed constants and no trailers unless given.
+        SPF_TruckConstants truckConstants{};
+        std::vector<SPF_Trailer> trailers;
+        bool constantsDelivered = false;
+
+        // Keybinds: every registered action fires on the frames given with --press-key.
+        std::map<std::string, void (*)(void)> keybinds;
+        std::vector<uint64_t> keyPressFrames;
+
+        struct Window
+        {
+            std::string id;
+            SPF_DrawCallback callback = nullptr;
+            void *userData = nullptr;
+            bool visible = false;
+        };
+        std::map<std::string, Window> windows;
+
+        SPF_CameraType camera = SPF_CAMERA_BEHIND;
+        float freePos[3] = {0.0f, 0.0f, 0.0f};
+        float interiorYaw = 0.0f;
+        float interiorPitch = 0.0f;
+        float behindLive[3] = {0.1f, 0.2f, 8.0f};
+        float behindFov = 60.0f;
+        float interiorFov = 65.0f;
+        float freeFov = 70.0f;
+
+        // Camera states and animation playback. The stand-in advances playback by a fixed number
+        // of keyframes per replayed frame.
+        static constexpr int MAX_STATES = 64;
+        static constexpr float ANIM_KEYFRAMES_PER_FRAME = 0.5f;
+        SPF_CameraState_t states[MAX_STATES] = {};
+        int stateCount = 0;
+        SPF_AnimPlaybackState anim = SPF_ANIM_STOPPED;
+        float animPosition = 0.0f;
+
+        uint64_t screenshotCount = 0;
+        uint64_t eventCount = 0;
+
+        // Game log: lines emitted by stand-ins are delivered to the plugin after the next OnUpdate.
+        SPF_GameLog_Callback_t gameLogCallback = nullptr;
+        void *gameLogUserData = nullptr;
+        std::vector<std::string> pendingLogLines;
+        uint64_t screenshotFailureInterval = 0;
+
+        // Synthetic traffic: vehicle i has id 1000 + i and its handle points at vehicles[i].
+        static constexpr uint32_t MAX_TRAFFIC = 256;
+        uint32_t trafficCount = 0;
+        int32_t vehicles[MAX_TRAFFIC] = {};
+    };
+
+    ReplayState g_replay;
+
+    // Opaque handles only need to be unique, non-null addresses.
+    char g_handleToken;
+    template <typename T>
+    T *Handle() { return reinterpret_cast<T *>(&g_handleToken); }
+
+    void Trace(const char *format, ...)
+    {
+        std::fprintf(g_replay.out, "[%08llu] ", (unsigned long long)g_replay.frame);
+        va_list args;
+        va_start(args, format);
+        std::vfprintf(g_replay.out, format, args);
+        va_end(args);
+        std::fputc('\n', g_replay.out);
+    }
+
+    const std::string *FindOverride(const char *key)
+    {
+        const auto it = g_replay.overrides.find(key ? key : "");
+        return it == g_replay.overrides.end() ? nullptr : &it->second;
+    }
+
+    // =================================================================================================
+    // 2. Stand-in Load API (Logger, Formatting, Config, Localization, Environment)
+    // =================================================================================================
+
+    SPF_Logger_Handle *Log_GetContext(const char *) { return Handle<SPF_Logger_Handle>(); }
+    // Durations in messages (" in 1.25 ms") are host timing; they are logged as " in - ms".
+    void Log(SPF_Logger_Handle *, SPF_LogLevel level, const char *message)
+    {
+        static const std::regex duration(R"( in [0-9]+(\.[0-9]+)? ms)");
+        Trace("Log(%d, \"%s\")", (int)level, std::regex_replace(message ? message : "", duration, " in - ms").c_str());
+    }
+    void LogThrottled(SPF_Logger_Handle *h, SPF_LogLevel level, const char *, uint32_t, const char *message) { Log(h, level, message); }
+    void Log_SetLevel(SPF_Logger_Handle *, SPF_LogLevel) {}
+    SPF_LogLevel Log_GetLevel(SPF_Logger_Handle *) { return SPF_LOG_TRACE; }
+
+    int Fmt_Format(char *buffer, size_t buffer_size, const char *format, ...)
+    {
+        va_list args;
+        va_start(args, format);
+        const int written = std::vsnprintf(buffer, buffer_size, format, args);
+        va_end(args);
+        return written;
+    }
+
+    SPF_Config_Handle *Cfg_GetContext(const char *) { return Handle<SPF_Config_Handle>(); }
+    double Cfg_GetFloat(SPF_Config_Handle *, const char *key, double defaultValue)
+    {
+        const std::string *value = FindOverride(key);
+        return value ? std::strtod(value->c_str(), nullptr) : defaultValue;
+    }
+    int64_t Cfg_GetInt(SPF_Config_Handle *, const char *key, int64_t defaultValue)
+    {
+        const std::string *value = FindOverride(key);
+        return value ? std::strtoll(value->c_str(), nullptr, 10) : defaultValue;
+    }
+    int32_t Cfg_GetInt32(SPF_Config_Handle *h, const char *key, int32_t defaultValue) { return (int32_t)Cfg_GetInt(h, key, defaultValue); }
+    bool Cfg_GetBool(SPF_Config_Handle *, const char *key, bool defaultValue)
+    {
+        const std::string *value = FindOverride(key);
+        return value ? (*value == "true" || *value == "1") : defaultValue;
+    }
+    int Cfg_GetString(SPF_Config_Handle *, const char *key, const char *defaultValue, char *out_buffer, int buffer_size)
+    {
+        const std::string *value = FindOverride(key);
+        return std::snprintf(out_buffer, (size_t)buffer_size, "%s", value ? value->c_str() : (defaultValue ? defaultValue : ""));
+    }
+
+    // Structured settings: an override holding JSON text is parsed once into a small node tree; a
+    // handle points at a node. Settings without an override have no JSON value.
+    struct JsonNode
+    {
+        SPF_JsonType type = SPF_JSON_TYPE_NULL;
+        double number = 0.0;
+        std::string text;
+        std::vector<std::pair<std::string, JsonNode>> members;
+        std::vector<JsonNode> items;
+    };
+
+    std::map<std::string, JsonNode> g_jsonValues;
+
+    void SkipSpace(const char *&p)
+    {
+        while (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r')
+        {
+            ++p;
+        }
+    }
+
+    bool ParseJsonString(const char *&p, std::string &out)
+    {
+        if (*p != '"')
+        {
+            return false;
+        }
+        for (++p; *p && *p != '"'; ++p)
+        {
+            if (*p == '\\' && p[1])
+            {
+                ++p;
+            }
+            out += *p;
+        }
+        return *p == '"' ? (++p, true) : false;
+    }
+
+    bool ParseJson(const char *&p, JsonNode &node)
+    {
+        SkipSpace(p);
+        if (*p == '{' || *p == '[')
+        {
+            const bool object = *p == '{';
+            const char close = object ? '}' : ']';
+            node.type = object ? SPF_JSON_TYPE_OBJECT : SPF_JSON_TYPE_ARRAY;
+            ++p;
+            SkipSpace(p);
+            while (*p && *p != close)
+            {
+                JsonNode child;
+                std::string name;
+                if (object)
+                {
+                    if (!ParseJsonString(p, name))
+                    {
+                        return false;
+                    }
+                    SkipSpace(p);
+                    if (*p++ != ':')
+                    {
+                        return false;
+                    }
+                }
+                if (!ParseJson(p, child))
+                {
+                    return false;
+                }
+                if (object)
+                {
+                    node.members.emplace_back(name, child);
+                }
+                else
+                {
+                    node.items.push_back(child);
+                }
+                SkipSpace(p);
+                if (*p == ',')
+                {
+                    ++p;
+                    SkipSpace(p);
+                }
+            }
+            return *p == close ? (++p, true) : false;
+        }
+        if (*p == '"')
+        {
+            node.type = SPF_JSON_TYPE_STRING;
+            return ParseJsonString(p, node.text);
+        }
+        if (std::strncmp(p, "true", 4) == 0 || std::strncmp(p, "false", 5) == 0)
+        {
+            node.type = SPF_JSON_TYPE_BOOLEAN;
+            node.number = *p == 't' ? 1.0 : 0.0;
+            p += *p == 't' ? 4 : 5;
+            return true;
+        }
+        if (std::strncmp(p, "null", 4) == 0)
+        {
+            p += 4;
+            return true;
+        }
+        char *end = nullptr;
+        node.number = std::strtod(p, &end);
+        if (end == p)
+        {
+            return false;
+        }
+        node.type = std::string(p, (size_t)(end - p)).find_first_of(".eE") != std::string::npos ? SPF_JSON_TYPE_NUMBER_FLOAT : SPF_JSON_TYPE_NUMBER_INTEGER;
+        p = end;
+        return true;
+    }
+
+    const JsonNode *Node(const SPF_JsonValue_Handle *h) { return reinterpret_cast<const JsonNode *>(h); }
+    SPF_JsonValue_Handle *ToHandle(const JsonNode *node) { return reinterpret_cast<SPF_JsonValue_Handle *>(const_cast<JsonNode *>(node)); }
+
+    SPF_JsonValue_Handle *Cfg_GetJsonValueHandle(SPF_Config_Handle *, const char *key)
+    {
+        const auto cached = g_jsonValues.find(key ? key : "");
+        if (cached != g_jsonValues.end())
+        {
+            return ToHandle(&cached->second);
+        }
+        const std::string *value = FindOverride(key);
+        JsonNode node;
+        const char *p = value ? value->c_str() : "";
+        if (!value || !ParseJson(p, node))
+        {
+            return nullptr;
+        }
+        return ToHandle(&(g_jsonValues[key] = node));
+    }
+
+    SPF_JsonType Json_GetType(const SPF_JsonValue_Handle *h) { return h ? Node(h)->type : SPF_JSON_TYPE_UNKNOWN; }
+    bool Json_GetBool(const SPF_JsonValue_Handle *h, bool defaultValue) { return h ? Node(h)->number != 0.0 : defaultValue; }
+    int64_t Json_GetInt(const SPF_JsonValue_Handle *h, int64_t defaultValue) { return h ? (int64_t)Node(h)->number : defaultValue; }
+    int32_t Json_GetInt32(const SPF_JsonValue_Handle *h, int32_t defaultValue) { return h ? (int32_t)Node(h)->number : defaultValue; }
+    uint64_t Json_GetUint(const SPF_JsonValue_Handle *h, uint64_t defaultValue) { return h ? (uint64_t)Node(h)->number : defaultValue; }
+    double Json_GetFloat(const SPF_JsonValue_Handle *h, double defaultValue) { return h ? Node(h)->number : defaultValue; }
+    int Json_GetString(const SPF_JsonValue_Handle *h, char *out_buffer, int buffer_size)
+    {
+        return h ? std::snprintf(out_buffer, (size_t)buffer_size, "%s", Node(h)->text.c_str()) : 0;
+    }
+    SPF_JsonValue_Handle *Json_GetMember(const SPF_JsonValue_Handle *h, const char *memberName)
+    {
+        if (!h || !memberName)
+        {
+            return nullptr;
+        }
+        for (const auto &member : Node(h)->members)
+        {
+            if (member.first == memberName)
+            {
+                return ToHandle(&member.second);
+            }
+        }
+        return nullptr;
+    }
+    bool Json_HasMember(const SPF_JsonValue_Handle *h, const char *memberName) { return Json_GetMember(h, memberName) != nullptr; }
+    int Json_GetArraySize(const SPF_JsonValue_Handle *h) { return h ? (int)Node(h)->items.size() : 0; }
+    SPF_JsonValue_Handle *Json_GetArrayItem(const SPF_JsonValue_Handle *h, int index)
+    {
+        return (h && index >= 0 && (size_t)index < Node(h)->items.size()) ? ToHandle(&Node(h)->items[(size_t)index]) : nullptr;
+    }
+
+    SPF_Localization_Handle *Loc_GetContext(const char *) { return Handle<SPF_Localization_Handle>(); }
+
+    SPF_Environment_Handle *Env_GetContext(const char *) { return Handle<SPF_Environment_Handle>(); }
+    int Env_GetPluginDataDir(SPF_Environment_Handle *, char *out_buffer, int buffer_size)
+    {
+        return std::snprintf(out_buffer, (size_t)buffer_size, "%s", g_replay.dataDir.c_str());
+    }
+    int Env_GetSCSScreenshotsDir(SPF_Environment_Handle *, char *out_buffer, int buffer_size)
+    {
+        return std::snprintf(out_buffer, (size_t)buffer_size, "%s/screenshot", g_replay.dataDir.c_str());
+    }
+    bool Env_CreatePath(SPF_Environment_Handle *, const char *path)
+    {
+        std::error_code error;
+        std::filesystem::create_directories(path, error);
+        return !error;
+    }
+
+    // =================================================================================================
+    // 3. Stand-in Core API (Telemetry, Camera, Console, UI)
+    // =================================================================================================
+
+    SPF_Telemetry_Handle *Tel_GetContext(const char *) { return Handle<SPF_Telemetry_Handle>(); }
+    SPF_Telemetry_Callback_Handle *Tel_RegisterForGameplayEvents(SPF_Telemetry_Handle *, SPF_Telemetry_GameplayEvents_Callback callback, void *user_data)
+    {
+        g_replay.gameplayCallback = callback;
+        g_replay.gameplayUserData = user_data;
+        return Handle<SPF_Telemetry_Callback_Handle>();
+    }
+    SPF_Telemetry_Callback_Handle *Tel_RegisterForTruckData(SPF_Telemetry_Handle *, SPF_Telemetry_TruckData_Callback callback, void *user_data)
+    {
+        g_replay.truckDataCallback = callback;
+        g_replay.truckDataUserData = user_data;
+        return Handle<SPF_Telemetry_Callback_Handle>();
+    }
+    SPF_Telemetry_Callback_Handle *Tel_RegisterForTimestamps(SPF_Telemetry_Handle *, SPF_Telemetry_Timestamps_Callback callback, void *user_data)
+    {
+        g_replay.timestampsCallback = callback;
+        g_replay.timestampsUserData = user_data;
+        return Handle<SPF_Telemetry_Callback_Handle>();
+    }
+    SPF_Telemetry_Callback_Handle *Tel_RegisterForTruckConstants(SPF_Telemetry_Handle *, SPF_Telemetry_TruckConstants_Callback callback, void *user_data)
+    {
+        g_replay.truckConstantsCallback = callback;
+        g_replay.truckConstantsUserData = user_data;
+        return Handle<SPF_Telemetry_Callback_Handle>();
+    }
+    SPF_Telemetry_Callback_Handle *Tel_RegisterForTrailerConstants(SPF_Telemetry_Handle *, SPF_Telemetry_TrailerConstants_Callback callback, void *user_data)
+    {
+        g_replay.trailerConstantsCallback = callback;
+        g_replay.trailerConstantsUserData = user_data;
+        return Handle<SPF_Telemetry_Callback_Handle>();
+    }
+    SPF_Telemetry_Callback_Handle *Tel_RegisterForTrailers(SPF_Telemetry_Handle *, SPF_Telemetry_Trailers_Callback callback, void *user_data)
+    {
+        g_replay.trailersCallback = callback;
+        g_replay.trailersUserData = user_data;
+        return Handle<SPF_Telemetry_Callback_Handle>();
+    }
+    void Tel_GetTruckConstants(SPF_Telemetry_Handle *, SPF_TruckConstants *out_data, size_t struct_size)
+    {
+        Trace("Tel_GetTruckConstants()");
+        std::memcpy(out_data, &g_replay.truckConstants, struct_size < sizeof(SPF_TruckConstants) ? struct_size : sizeof(SPF_TruckConstants));
+    }
+    void Tel_GetTrailers(SPF_Telemetry_Handle *, SPF_Trailer *out_trailers, size_t struct_size, uint32_t *in_out_count)
+    {
+        Trace("Tel_GetTrailers(%u)", *in_out_count);
+        uint32_t count = 0;
+        for (; count < *in_out_count && count < g_replay.trailers.size(); ++count)
+        {
+            std::memcpy(reinterpret_cast<char *>(out_trailers) + count * struct_size, &g_replay.trailers[count],
+                        struct_size < sizeof(SPF_Trailer) ? struct_size : sizeof(SPF_Trailer));
+        }
+        *in_out_count = count;
+    }
+
+    void AddWheel(SPF_WheelConstants *wheels, uint32_t &count, float x, float z, float radius)
+    {
+        wheels[count].simulated = true;
+        wheels[count].radius = radius;
+        wheels[count].position = {x, radius, z};
+        count++;
+    }
+
+    /** @brief A 6x4 tractor and `trailers` tri-axle semi-trailers (SCS frame: -Z is forward). */
+    void BuildCombination(uint32_t trailers)
+    {
+        SPF_TruckConstants &truck = g_replay.truckConstants;
+        std::snprintf(truck.id, sizeof(truck.id), "replay.tractor");
+        truck.cabin_position = {0.0f, 1.4f, -3.9f};
+        truck.head_position = {-0.6f, 1.1f, 0.2f};
+        truck.hook_position = {0.0f, 1.15f, 0.65f};
+        for (float z : {-3.7f, 0.0f, 1.35f})
+        {
+            AddWheel(truck.wheels, truck.wheel_count, -1.0f, z, 0.52f);
+            AddWheel(truck.wheels, truck.wheel_count, 1.0f, z, 0.52f);
+        }
+
+        g_replay.trailers.assign(trailers < SPF_TELEMETRY_TRAILER_MAX_COUNT ? trailers : SPF_TELEMETRY_TRAILER_MAX_COUNT, SPF_Trailer{});
+        for (size_t i = 0; i < g_replay.trailers.size(); ++i)
+        {
+            SPF_TrailerConstants &trailer = g_replay.trailers[i].constants;
+            std::snprintf(trailer.id, sizeof(trailer.id), "replay.trailer.%zu", i);
+            trailer.hook_position = {0.0f, 1.15f, -6.9f};
+            for (float z : {0.0f, 1.31f, 2.62f})
+            {
+                AddWheel(trailer.wheels, trailer.wheel_count, -1.0f, z, 0.45f);
+                AddWheel(trailer.wheels, trailer.wheel_count, 1.0f, z, 0.45f);
+            }
+            g_replay.trailers[i].data.connected = true;
+        }
+    }
+
+    /** @brief Places the trailers straight behind the truck: first on the hook, then 13.6 m apart. */
+    void PlaceTrailers()
+    {
+        const double phi = 1.5 * M_PI - 2.0 * M_PI * g_replay.truck.world_placement.orientation.heading;
+        double back = (double)g_replay.truckConstants.hook_position.z;
+        for (size_t i = 0; i < g_replay.trailers.size(); ++i)
+        {
+            SPF_Trailer &trailer = g_replay.trailers[i];
+            back += i == 0 ? -(double)trailer.constants.hook_position.z : 13.6;
+            trailer.data.world_placement = g_replay.truck.world_placement;
+            trailer.data.world_placement.position.x -= std::cos(phi) * back;
+            trailer.data.world_placement.position.z -= std::sin(phi) * back;
+        }
+    }
+
+    void Tel_GetTruckData(SPF_Telemetry_Handle *, SPF_TruckData *out_data, size_t struct_size)
+    {
+        std::memcpy(out_data, &g_replay.truck, struct_size < sizeof(SPF_TruckData) ? struct_size : sizeof(SPF_TruckData));
+    }
+    void Tel_GetTimestamps(SPF_Telemetry_Handle *, SPF_Timestamps *out_data, size_t struct_size)
+    {
+        std::memcpy(out_data, &g_replay.timestamps, struct_size < sizeof(SPF_Timestamps) ? struct_size : sizeof(SPF_Timestamps));
+    }
+
+    void Cam_SwitchTo(SPF_CameraType type)
+    {
+        Trace("Cam_SwitchTo(%d)", (int)type);
+        g_replay.camera = type;
+    }
+    bool Cam_GetCurrentCamera(SPF_CameraType *out_type)
+    {
+        *out_type = g_replay.camera;
+        return true;
+    }
+    bool Cam_GetInteriorHeadRot(float *yaw, float *pitch)
+    {
+        *yaw = g_replay.interiorYaw;
+        *pitch = g_replay.interiorPitch;
+        return true;
+    }
+    void Cam_SetInteriorHeadRot(float yaw, float pitch)
+    {
+        Trace("Cam_SetInteriorHeadRot(%.4f, %.4f)", yaw, pitch);
+        g_replay.interiorYaw = yaw;
+        g_replay.interiorPitch = pitch;
+    }
+    // The stand-in uses a local grid whose origin coincides with the world origin.
+    bool Cam_GetCameraWorldCoordinates(float *x, float *y, float *z)
+    {
+        *x = g_replay.freePos[0];
+        *y = g_replay.freePos[1];
+        *z = g_replay.freePos[2];
+        return true;
+    }
+    bool Cam_GetFreePosition(float *x, float *y, float *z) { return Cam_GetCameraWorldCoordinates(x, y, z); }
+    void Cam_SetFreePosition(float x, float y, float z)
+    {
+        Trace("Cam_SetFreePosition(%.3f, %.3f, %.3f)", x, y, z);
+        g_replay.freePos[0] = x;
+        g_replay.freePos[1] = y;
+        g_replay.freePos[2] = z;
+    }
+    void Cam_SetFreeOrientation(float yaw, float pitch, float roll) { Trace("Cam_SetFreeOrientation(%.4f, %.4f, %.4f)", yaw, pitch, roll); }
+    void Cam_SetFreeFov(float fov)
+    {
+        Trace("Cam_SetFreeFov(%.2f)", fov);
+        g_replay.freeFov = fov;
+    }
+    bool Cam_GetFreeFov(float *fov)
+    {
+        *fov = g_replay.freeFov;
+        return true;
+    }
+    bool Cam_GetBehindLiveState(float *pitch, float *yaw, float *zoom)
+    {
+        *pitch = g_replay.behindLive[0];
+        *yaw = g_replay.behindLive[1];
+        *zoom = g_replay.behindLive[2];
+        return true;
+    }
+    void Cam_SetBehindLiveState(float pitch, float yaw, float zoom)
+    {
+        Trace("Cam_SetBehindLiveState(%.4f, %.4f, %.2f)", pitch, yaw, zoom);
+        g_replay.behindLive[0] = pitch;
+        g_replay.behindLive[1] = yaw;
+        g_replay.behindLive[2] = zoom;
+    }
+    bool Cam_GetBehindFov(float *fov)
+    {
+        *fov = g_replay.behindFov;
+        return true;
+    }
+    void Cam_SetBehindFov(float fov)
+    {
+        Trace("Cam_SetBehindFov(%.2f)", fov);
+        g_replay.behindFov = fov;
+    }
+    bool Cam_GetInteriorFov(float *fov)
+    {
+        *fov = g_replay.interiorFov;
+        return true;
+    }
+    void Cam_SetInteriorFov(float fov)
+    {
+        Trace("Cam_SetInteriorFov(%.2f)", fov);
+        g_replay.interiorFov = fov;
+    }
+
+    int Cam_GetStateCount() { return g_replay.stateCount; }
+    bool Cam_GetState(int index, SPF_CameraState_t *out_state)
+    {
+        if (index < 0 || index >= g_replay.stateCount)
+        {
+            return false;
+        }
+        *out_state = g_replay.states[index];
+        return true;
+    }
+    void Cam_ReloadStatesFromFile()
+    {
+        Trace("Cam_ReloadStatesFromFile()");
+        g_replay.stateCount = 0;
+    }
+    void Cam_ClearAllStatesInMemory()
+    {
+        Trace("Cam_ClearAllStatesInMemory()");
+        g_replay.stateCount = 0;
+    }
+    void Cam_AddStateInMemory(const SPF_CameraState_t *state)
+    {
+        Trace("Cam_AddStateInMemory(pos %.3f, %.3f, %.3f, q %.4f, %.4f, %.4f, %.4f, fov %.2f)",
+              state->pos_x, state->pos_y, state->pos_z, state->q_x, state->q_y, state->q_z, state->q_w, state->fov);
+        if (g_replay.stateCount < ReplayState::MAX_STATES)
+        {
+            g_replay.states[g_replay.stateCount++] = *state;
+        }
+    }
+    void Cam_Anim_Play(int start_index)
+    {
+        Trace("Cam_Anim_Play(%d)", start_index);
+        g_replay.anim = g_replay.stateCount > 1 ? SPF_ANIM_PLAYING : SPF_ANIM_STOPPED;
+        g_replay.animPosition = (float)start_index;
+    }
+    void Cam_Anim_Stop()
+    {
+        Trace("Cam_Anim_Stop()");
+        g_replay.anim = SPF_ANIM_STOPPED;
+    }
+    SPF_AnimPlaybackState Cam_Anim_GetPlaybackState() { return g_replay.anim; }
+    int Cam_Anim_GetCurrentFrame() { return (int)g_replay.animPosition; }
+    float Cam_Anim_GetCurrentFrameProgress() { return g_replay.animPosition - (float)(int)g_replay.animPosition; }
+
+    void AdvanceAnimation()
+    {
+        if (g_replay.anim != SPF_ANIM_PLAYING)
+        {
+            return;
+        }
+        g_replay.animPosition += ReplayState::ANIM_KEYFRAMES_PER_FRAME;
+        if (g_replay.animPosition >= (float)(g_replay.stateCount - 1))
+        {
+            g_replay.animPosition = (float)(g_replay.stateCount - 1);
+            g_replay.anim = SPF_ANIM_STOPPED;
+        }
+    }
+
+    void GCon_ExecuteCommand(const char *command)
+    {
+        Trace("GCon_ExecuteCommand(\"%s\")", command ? command : "");
+        if (command && std::strncmp(command, "screenshot", 10) == 0)
+        {
+            g_replay.screenshotCount++;
+            const char *name = command[10] == ' ' ? command + 11 : "";
+            const bool fail = g_replay.screenshotFailureInterval != 0 && g_replay.screenshotCount % g_replay.screenshotFailureInterval == 0;
+            g_replay.pendingLogLines.push_back(std::string(fail ? "[sys] Failed to save screenshot '/screenshot/" : "[sys] Screenshot saved: '/screenshot/") + name + ".png'");
+        }
+    }
+
+    SPF_KeyBinds_Handle *Kbind_GetContext(const char *) { return Handle<SPF_KeyBinds_Handle>(); }
+    void Kbind_Register(SPF_KeyBinds_Handle *, const char *actionName, void (*callback)(void))
+    {
+        Trace("Kbind_Register(\"%s\")", actionName);
+        g_replay.keybinds[actionName] = callback;
+    }
+    void Kbind_UnregisterAll(SPF_KeyBinds_Handle *) { g_replay.keybinds.clear(); }
+
+    // Telemetry subscriptions see each frame before OnUpdate, then any key pressed on it.
+    void DeliverFrameCallbacks()
+    {
+        if (!g_replay.constantsDelivered && g_replay.truckConstants.wheel_count != 0)
+        {
+            g_replay.constantsDelivered = true;
+            if (g_replay.truckConstantsCallback)
+            {
+                g_replay.truckConstantsCallback(&g_replay.truckConstants, g_replay.truckConstantsUserData);
+            }
+            for (const SPF_Trailer &trailer : g_replay.trailers)
+            {
+                if (g_replay.trailerConstantsCallback)
+                {
+                    g_replay.trailerConstantsCallback(&trailer.constants, g_replay.trailerConstantsUserData);
+                }
+            }
+        }
+        PlaceTrailers();
+        if (g_replay.trailersCallback)
+        {
+            g_replay.trailersCallback(g_replay.trailers.data(), (uint32_t)g_replay.trailers.size(), g_replay.trailersUserData);
+        }
+        if (g_replay.truckDataCallback)
+        {
+            g_replay.truckDataCallback(&g_replay.truck, g_replay.truckDataUserData);
+        }
+        if (g_replay.timestampsCallback)
+        {
+            g_replay.timestampsCallback(&g_replay.timestamps, g_replay.timestampsUserData);
+        }
+        for (uint64_t frame : g_replay.keyPressFrames)
+        {
+            if (frame != g_replay.frame)
+            {
+                continue;
+            }
+            for (const auto &keybind : g_replay.keybinds)
+            {
+                Trace("KeyPress(\"%s\")", keybind.first.c_str());
+                keybind.second();
+            }
+        }
+    }
+
+    SPF_GameLog_Handle *GLog_GetContext(const char *) { return Handle<SPF_GameLog_Handle>(); }
+    SPF_GameLog_Callback_Handle *GLog_RegisterCallback(SPF_GameLog_Handle *, SPF_GameLog_Callback_t callback, void *user_data)
+    {
+        g_replay.gameLogCallback = callback;
+        g_replay.gameLogUserData = user_data;
+        return Handle<SPF_GameLog_Callback_Handle>();
+    }
+
+    void DeliverGameLog()
+    {
+        std::vector<std::string> lines;
+        lines.swap(g_replay.pendingLogLines);
+        for (const std::string &line : lines)
+        {
+            Trace("GameLog(\"%s\")", line.c_str());
+            if (g_replay.gameLogCallback)
+            {
+                g_replay.gameLogCallback(line.c_str(), g_replay.gameLogUserData);
+            }
+        }
+    }
+
+    void UI_RegisterDrawCallback(const char *, const char *windowId, SPF_DrawCallback callback, void *user_data)
+    {
+        auto &window = g_replay.windows[windowId];
+        window.id = windowId;
+        window.callback = callback;
+        window.userData = user_data;
+    }
+    // Window handles point at the stand-in window entries so visibility can be tracked.
+    SPF_Window_Handle *UI_GetWindowHandle(const char *, const char *windowId)
+    {
+        auto &window = g_replay.windows[windowId];
+        window.id = windowId;
+        return reinterpret_cast<SPF_Window_Handle *>(&window);
+    }
+    void UI_SetVisibility(SPF_Window_Handle *handle, bool isVisible)
+    {
+        auto *window = reinterpret_cast<ReplayState::Window *>(handle);
+        Trace("UI_SetVisibility(%s, %d)", window->id.c_str(), (int)isVisible);
+        window->visible = isVisible;
+    }
+    bool UI_IsVisible(SPF_Window_Handle *handle) { return reinterpret_cast<ReplayState::Window *>(handle)->visible; }
+    void UI_GetViewportSize(float *out_width, float *out_height)
+    {
+        *out_width = 1920.0f;
+        *out_height = 1080.0f;
+    }
+    void UI_AddRectFilled(float x1, float y1, float x2, float y2, float r, float g, float b, float a)
+    {
+        Trace("UI_AddRectFilled(%.0f, %.0f, %.0f, %.0f, %.2f, %.2f, %.2f, %.2f)", x1, y1, x2, y2, r, g, b, a);
+    }
+    uint32_t UI_ColorConvertFloat4ToU32(float r, float g, float b, float a)
+    {
+        const auto channel = [](float v) { return (uint32_t)(v <= 0.0f ? 0.0f : (v >= 1.0f ? 255.0f : v * 255.0f + 0.5f)); };
+        return channel(r) | (channel(g) << 8) | (channel(b) << 16) | (channel(a) << 24);
+    }
+    SPF_DrawList_Handle UI_GetWindowDrawList() { return Handle<SPF_DrawList_Handle_t>(); }
+    void UI_Text(const char *text)
+    {
+        std::string escaped;
+        for (const char *c = text ? text : ""; *c; ++c)
+        {
+            escaped += *c == '\n' ? std::string("\\n") : std::string(1, *c);
+        }
+        Trace("UI_Text(\"%s\")", escaped.c_str());
+    }
+    void UI_GetCursorScreenPos(float *out_x, float *out_y)
+    {
+        *out_x = 48.0f;
+        *out_y = 200.0f;
+    }
+    void UI_GetContentRegionAvail(float *out_x, float *out_y)
+    {
+        *out_x = 300.0f;
+        *out_y = 120.0f;
+    }
+    void UI_Dummy(float width, float height) { Trace("UI_Dummy(%.0f, %.0f)", width, height); }
+    void UI_DrawList_AddPolyline(SPF_DrawList_Handle, const float *points_x, const float *points_y, int num_points, uint32_t col, bool closed, float thickness)
+    {
+        Trace("UI_DrawList_AddPolyline(%d points, (%.1f, %.1f) .. (%.1f, %.1f), %08x, %d, %.1f)", num_points, points_x[0], points_y[0], points_x[num_points - 1],
+              points_y[num_points - 1], col, (int)closed, thickness);
+    }
+    void UI_ShowNotification(SPF_NotificationType type, const char *message, SPF_Notification_DisplayMode mode)
+    {
+        Trace("UI_ShowNotification(%d, \"%s\", %d)", (int)type, message ? message : "", (int)mode);
+    }
+    void UI_DrawList_AddRectFilled(SPF_DrawList_Handle, float x1, float y1, float x2, float y2, uint32_t col, float rounding)
+    {
+        Trace("UI_DrawList_AddRectFilled(%.1f, %.1f, %.1f, %.1f, %08x, %.1f)", x1, y1, x2, y2, col, rounding);
+    }
+    void UI_DrawList_AddCircleFilled(SPF_DrawList_Handle, float x, float y, float radius, uint32_t col, int segments)
+    {
+        Trace("UI_DrawList_AddCircleFilled(%.1f, %.1f, %.1f, %08x, %d)", x, y, radius, col, segments);
+    }
+    void UI_DrawList_AddRectFilledMultiColor(SPF_DrawList_Handle, float x1, float y1, float x2, float y2, uint32_t upper_left, uint32_t upper_right, uint32_t bottom_right, uint32_t bottom_left)
+    {
+        Trace("UI_DrawList_AddRectFilledMultiColor(%.0f, %.0f, %.0f, %.0f, %08x, %08x, %08x, %08x)", x1, y1, x2, y2, upper_left, upper_right, bottom_right, bottom_left);
+    }
+
+    int32_t TrafficIndex(SPF_VehicleHandle h) { return (int32_t)(static_cast<int32_t *>(h) - g_replay.vehicles); }
+
+    bool Veh_IsReady() { return true; }
+    uint32_t Veh_GetAllHandles(SPF_VehicleHandle *out_handles, uint32_t max_count)
+    {
+        uint32_t count = g_replay.trafficCount < max_count ? g_replay.trafficCount : max_count;
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            out_handles[i] = &g_replay.vehicles[i];
+        }
+        return count;
+    }
+    SPF_VehicleHandle Veh_GetVehicleById(int32_t id)
+    {
+        const int32_t index = id - 1000;
+        return (index >= 0 && (uint32_t)index < g_replay.trafficCount) ? &g_replay.vehicles[index] : nullptr;
+    }
+    int32_t Veh_GetId(SPF_VehicleHandle h) { return *static_cast<int32_t *>(h); }
+    float Veh_GetSpeedLimit(SPF_VehicleHandle) { return 25.0f; }
+    float Veh_GetCurrentSpeed(SPF_VehicleHandle h) { return TrafficIndex(h) % 7 == 3 ? 36.0f : 24.0f; }
+    float Veh_GetAcceleration(SPF_VehicleHandle h) { return TrafficIndex(h) % 11 == 5 ? -6.0f : 0.5f; }
+
+    // Vehicle i sits on a spiral around the truck's current position.
+    bool SyntheticTrafficPosition(SPF_VehicleHandle h, SPF_DVector *out_position)
+    {
+        const int32_t index = TrafficIndex(h);
+        const double angle = 2.39996 * index; // Golden angle spreads vehicles evenly.
+        const double distance = 8.0 + 6.0 * (index % 16);
+        out_position->x = g_replay.truck.world_placement.position.x + distance * std::cos(angle);
+        out_position->y = g_replay.truck.world_placement.position.y;
+        out_position->z = g_replay.truck.world_placement.position.z + distance * std::sin(angle);
+        return true;
+    }
+
+    // =================================================================================================
+    // 4. API Tables
+    // =================================================================================================
+
+    SPF_Logger_API g_logger{};
+    SPF_Formatting_API g_formatting{};
+    SPF_Config_API g_config{};
+    SPF_Localization_API g_localization{};
+    SPF_Environment_API g_environment{};
+    SPF_Telemetry_API g_telemetry{};
+    SPF_Camera_API g_camera{};
+    SPF_GameConsole_API g_console{};
+    SPF_UI_API g_ui{};
+    SPF_Vehicle_API g_vehicle{};
+    SPF_GameLog_API g_gameLog{};
+    SPF_KeyBinds_API g_keybinds{};
+    SPF_JsonReader_API g_jsonReader{};
+    SPF_Load_API g_loadApi{};
+    SPF_Core_API g_coreApi{};
+
+    void BuildApiTables()
+    {
+        g_logger.Log_GetContext = Log_GetContext;
+        g_logger.Log = Log;
+        g_logger.Log_SetLevel = Log_SetLevel;
+        g_logger.Log_GetLevel = Log_GetLevel;
+        g_logger.LogThrottled = LogThrottled;
+
+        g_formatting.Fmt_Format = Fmt_Format;
+
+        g_config.Cfg_GetContext = Cfg_GetContext;
+        g_config.Cfg_GetString = Cfg_GetString;
+        g_config.Cfg_GetInt = Cfg_GetInt;
+        g_config.Cfg_GetInt32 = Cfg_GetInt32;
+        g_config.Cfg_GetFloat = Cfg_GetFloat;
+        g_config.Cfg_GetBool = Cfg_GetBool;
+        g_config.Cfg_GetJsonValueHandle = Cfg_GetJsonValueHandle;
+
+        g_jsonReader.Json_GetType = Json_GetType;
+        g_jsonReader.Json_GetBool = Json_GetBool;
+        g_jsonReader.Json_GetInt = Json_GetInt;
+        g_jsonReader.Json_GetInt32 = Json_GetInt32;
+        g_jsonReader.Json_GetUint = Json_GetUint;
+        g_jsonReader.Json_GetFloat = Json_GetFloat;
+        g_jsonReader.Json_GetString = Json_GetString;
+        g_jsonReader.Json_HasMember = Json_HasMember;
+        g_jsonReader.Json_GetMember = Json_GetMember;
+        g_jsonReader.Json_GetArraySize = Json_GetArraySize;
+        g_jsonReader.Json_GetArrayItem = Json_GetArrayItem;
+
+        g_localization.Loc_GetContext = Loc_GetContext;
+
+        g_environment.Env_GetContext = Env_GetContext;
+        g_environment.Env_GetPluginDataDir = Env_GetPluginDataDir;
+        g_environment.Env_GetSCSScreenshotsDir = Env_GetSCSScreenshotsDir;
+        g_environment.Env_CreatePath = Env_CreatePath;
+
+        g_telemetry.Tel_GetContext = Tel_GetContext;
+        g_telemetry.Tel_RegisterForGameplayEvents = Tel_RegisterForGameplayEvents;
+        g_telemetry.Tel_RegisterForTruckData = Tel_RegisterForTruckData;
+        g_telemetry.Tel_RegisterForTimestamps = Tel_RegisterForTimestamps;
+        g_telemetry.Tel_GetTruckData = Tel_GetTruckData;
+        g_telemetry.Tel_GetTimestamps = Tel_GetTimestamps;
+        g_telemetry.Tel_RegisterForTruckConstants = Tel_RegisterForTruckConstants;
+        g_telemetry.Tel_RegisterForTrailerConstants = Tel_RegisterForTrailerConstants;
+        g_telemetry.Tel_RegisterForTrailers = Tel_RegisterForTrailers;
+        g_telemetry.Tel_GetTruckConstants = Tel_GetTruckConstants;
+        g_telemetry.Tel_GetTrailers = Tel_GetTrailers;
+
+        g_camera.Cam_SwitchTo = Cam_SwitchTo;
+        g_camera.Cam_GetCurrentCamera = Cam_GetCurrentCamera;
+        g_camera.Cam_GetInteriorHeadRot = Cam_GetInteriorHeadRot;
+        g_camera.Cam_SetInteriorHeadRot = Cam_SetInteriorHeadRot;
+        g_camera.Cam_GetCameraWorldCoordinates = Cam_GetCameraWorldCoordinates;
+        g_camera.Cam_GetFreePosition = Cam_GetFreePosition;
+        g_camera.Cam_SetFreePosition = Cam_SetFreePosition;
+        g_camera.Cam_SetFreeOrientation = Cam_SetFreeOrientation;
+        g_camera.Cam_SetFreeFov = Cam_SetFreeFov;
+        g_camera.Cam_GetFreeFov = Cam_GetFreeFov;
+        g_camera.Cam_GetBehindLiveState = Cam_GetBehindLiveState;
+        g_camera.Cam_SetBehindLiveState = Cam_SetBehindLiveState;
+        g_camera.Cam_GetBehindFov = Cam_GetBehindFov;
+        g_camera.Cam_SetBehindFov = Cam_SetBehindFov;
+        g_camera.Cam_GetInteriorFov = Cam_GetInteriorFov;
+        g_camera.Cam_SetInteriorFov = Cam_SetInteriorFov;
+        g_camera.Cam_GetStateCount = Cam_GetStateCount;
+        g_camera.Cam_GetState = Cam_GetState;
+        g_camera.Cam_ReloadStatesFromFile = Cam_ReloadStatesFromFile;
+        g_camera.Cam_ClearAllStatesInMemory = Cam_ClearAllStatesInMemory;
+        g_camera.Cam_AddStateInMemory = Cam_AddStateInMemory;
+        g_camera.Cam_Anim_Play = Cam_Anim_Play;
+        g_camera.Cam_Anim_Stop = Cam_Anim_Stop;
+        g_camera.Cam_Anim_GetPlaybackState = Cam_Anim_GetPlaybackState;
+        g_camera.Cam_Anim_GetCurrentFrame = Cam_Anim_GetCurrentFrame;
+        g_camera.Cam_Anim_GetCurrentFrameProgress = Cam_Anim_GetCurrentFrameProgress;
+
+        g_console.GCon_ExecuteCommand = GCon_ExecuteCommand;
+
+        g_ui.UI_RegisterDrawCallback = UI_RegisterDrawCallback;
+        g_ui.UI_GetWindowHandle = UI_GetWindowHandle;
+        g_ui.UI_SetVisibility = UI_SetVisibility;
+        g_ui.UI_IsVisible = UI_IsVisible;
+        g_ui.UI_GetViewportSize = UI_GetViewportSize;
+        g_ui.UI_AddRectFilled = UI_AddRectFilled;
+        g_ui.UI_ColorConvertFloat4ToU32 = UI_ColorConvertFloat4ToU32;
+        g_ui.UI_GetWindowDrawList = UI_GetWindowDrawList;
+        g_ui.UI_Text = UI_Text;
+        g_ui.UI_GetCursorScreenPos = UI_GetCursorScreenPos;
+        g_ui.UI_GetContentRegionAvail = UI_GetContentRegionAvail;
+        g_ui.UI_Dummy = UI_Dummy;
+        g_ui.UI_DrawList_AddPolyline = UI_DrawList_AddPolyline;
+        g_ui.UI_DrawList_AddRectFilledMultiColor = UI_DrawList_AddRectFilledMultiColor;
+        g_ui.UI_DrawList_AddRectFilled = UI_DrawList_AddRectFilled;
+        g_ui.UI_ShowNotification = UI_ShowNotification;
+        g_ui.UI_DrawList_AddCircleFilled = UI_DrawList_AddCircleFilled;
+
+        g_vehicle.Veh_IsReady = Veh_IsReady;
+        g_vehicle.Veh_GetAllHandles = Veh_GetAllHandles;
+        g_vehicle.Veh_GetVehicleById = Veh_GetVehicleById;
+        g_vehicle.Veh_GetId = Veh_GetId;
+        g_vehicle.Veh_GetSpeedLimit = Veh_GetSpeedLimit;
+        g_vehicle.Veh_GetCurrentSpeed = Veh_GetCurrentSpeed;
+        g_vehicle.Veh_GetAcceleration = Veh_GetAcceleration;
+
+        g_keybinds.Kbind_GetContext = Kbind_GetContext;
+        g_keybinds.Kbind_Register = Kbind_Register;
+        g_keybinds.Kbind_UnregisterAll = Kbind_UnregisterAll;
+
+        g_gameLog.GLog_GetContext = GLog_GetContext;
+        g_gameLog.GLog_RegisterCallback = GLog_RegisterCallback;
+
+        g_loadApi.logger = &g_logger;
+        g_loadApi.localization = &g_localization;
+        g_loadApi.config = &g_config;
+        g_loadApi.formatting = &g_formatting;
+        g_loadApi.environment = &g_environment;
+
+        g_coreApi.logger = &g_logger;
+        g_coreApi.localization = &g_localization;
+        g_coreApi.config = &g_config;
+        g_coreApi.ui = &g_ui;
+        g_coreApi.telemetry = &g_telemetry;
+        g_coreApi.camera = &g_camera;
+        g_coreApi.console = &g_console;
+        g_coreApi.formatting = &g_formatting;
+        g_coreApi.environment = &g_environment;
+        g_coreApi.json_reader = &g_jsonReader;
+        g_coreApi.vehicle = g_replay.trafficCount > 0 ? &g_vehicle : nullptr;
+        g_coreApi.gamelog = &g_gameLog;
+        g_coreApi.keybinds = &g_keybinds;
+    }
+
+    // =================================================================================================
+    // 5. Replay Loop
+    // =================================================================================================
+
+    void ApplyFrame(const SPF_RedLightCamera::FrameRecord &frame)
+    {
+        g_replay.timestamps = frame.timestamps;
+        g_replay.truck.world_placement = frame.world_placement;
+        g_replay.truck.local_linear_velocity = frame.local_linear_velocity;
+        g_replay.truck.local_linear_acceleration = frame.local_linear_acceleration;
+        g_replay.truck.speed = frame.speed;
+    }
+
+    void DispatchEvent(const SPF_RedLightCamera::EventRecord &event)
+    {
+        g_replay.eventCount++;
+        Trace("Event(\"%s\", \"%s\", %lld)", event.event_id, event.fine_offence, (long long)event.fine_amount);
+        if (!g_replay.gameplayCallback)
+        {
+            return;
+        }
+
+        SPF_GameplayEvents data{};
+        std::memcpy(data.player_fined.fine_offence, event.fine_offence, sizeof(data.player_fined.fine_offence));
+        data.player_fined.fine_amount = event.fine_amount;
+        g_replay.gameplayCallback(event.event_id, &data, g_replay.gameplayUserData);
+    }
+
+    void DrawVisibleWindows()
+    {
+        for (auto &entry : g_replay.windows)
+        {
+            auto &window = entry.second;
+            if (window.visible && window.callback)
+            {
+                window.callback(&g_ui, window.userData);
+            }
+        }
+    }
+
+    int PrintUsage()
+    {
+        std::fprintf(stderr, "Usage: rlc_replay <recording.rlcrec> [--out <log file>] [--data-dir <dir>] [--set key=value]... [--synthetic-traffic <vehicles>] [--screenshot-failures <n>] [--press-key <frame>]... [--show-window <id>]... [--combination <trailers>]\n");
+        return 2;
+    }
+
+} // namespace
+
+int main(int argc, char **argv)
+{
+    const char *recordingPath = nullptr;
+    const char *outPath = nullptr;
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--out") == 0 && i + 1 < argc)
+        {
+            outPath = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--data-dir") == 0 && i + 1 < argc)
+        {
+            g_replay.dataDir = argv[++i];
+        }
+        else if (std::strcmp(argv[i], "--set") == 0 && i + 1 < argc)
+        {
+            const std::string assignment = argv[++i];
+            const size_t eq = assignment.find('=');
+            if (eq == std::string::npos)
+            {
+                return PrintUsage();
+            }
+            g_replay.overrides[assignment.substr(0, eq)] = assignment.substr(eq + 1);
+        }
+        else if (std::strcmp(argv[i], "--synthetic-traffic") == 0 && i + 1 < argc)
+        {
+            const long count = std::strtol(argv[++i], nullptr, 10);
+            g_replay.trafficCount = count < 0 ? 0 : (count > (long)ReplayState::MAX_TRAFFIC ? ReplayState::MAX_TRAFFIC : (uint32_t)count);
+            for (uint32_t v = 0; v < g_replay.trafficCount; ++v)
+            {
+                g_replay.vehicles[v] = 1000 + (int32_t)v;
+            }
+        }
+        else if (std::strcmp(argv[i], "--screenshot-failures") == 0 && i + 1 < argc)
+        {
+            g_replay.screenshotFailureInterval = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if (std::strcmp(argv[i], "--press-key") == 0 && i + 1 < argc)
+        {
+            g_replay.keyPressFrames.push_back(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (std::strcmp(argv[i], "--show-window") == 0 && i + 1 < argc)
+        {
+            auto &window = g_replay.windows[argv[++i]];
+            window.id = argv[i];
+            window.visible = true;
+        }
+        else if (std::strcmp(argv[i], "--combination") == 0 && i + 1 < argc)
+        {
+            BuildCombination((uint32_t)std::strtoul(argv[++i], nullptr, 10));
+        }
+        else if (!recordingPath && argv[i][0] != '-')
+        {
+            recordingPath = argv[i];
+        }
+        else
+        {
+            return PrintUsage();
+        }
+    }
+    if (!recordingPath)
+    {
+        return PrintUsage();
+    }
+
+    SPF_RedLightCamera::TelemetryReader reader;
+    if (!reader.Open(recordingPath))
+    {
+        std::fprintf(stderr, "rlc_replay: cannot open recording '%s'\n", recordingPath);
+        return 1;
+    }
+
+    if (outPath)
+    {
+        g_replay.out = std::fopen(outPath, "w");
+        if (!g_replay.out)
+        {
+            std::fprintf(stderr, "rlc_replay: cannot open output '%s'\n", outPath);
+            return 1;
+        }
+    }
+
+    // Wall-clock budgets would make the call log depend on the host machine.
+    g_replay.overrides.emplace("settings.frame_budget_us", "0");
+
+    BuildApiTables();
+
+    SPF_Manifest_API manifestApi{};
+    SPF_Plugin_Exports exports{};
+    if (!SPF_GetManifestAPI(&manifestApi) || !SPF_GetPlugin(&exports))
+    {
+        std::fprintf(stderr, "rlc_replay: plugin exports are not available\n");
+        return 1;
+    }
+
+    // Same lifecycle order as the framework: OnLoad -> OnActivated -> OnRegisterUI -> frames -> OnUnload.
+    exports.OnLoad(&g_loadApi);
+    // Jobs run on the pool's threads would complete on a frame that depends on the host's timing.
+    SPF_RedLightCamera::g_ctx.workers_inline = true;
+    exports.OnActivated(&g_coreApi);
+    if (g_replay.trafficCount > 0)
+    {
+        SPF_RedLightCamera::g_ctx.traffic_index.SetPositionSource(SyntheticTrafficPosition);
+    }
+    if (exports.OnRegisterUI)
+    {
+        exports.OnRegisterUI(&g_ui);
+    }
+
+    SPF_RedLightCamera::ReplayRecord record;
+    while (reader.Next(record))
+    {
+        if (record.type == SPF_RedLightCamera::RecordType::GameplayEvent)
+        {
+            DispatchEvent(record.event);
+            continue;
+        }
+
+        g_replay.frame++;
+        ApplyFrame(record.frame);
+        DeliverFrameCallbacks();
+        if (exports.OnUpdate)
+        {
+            exports.OnUpdate();
+        }
+        AdvanceAnimation();
+        DeliverGameLog();
+        DrawVisibleWindows();
+    }
+
+    exports.OnUnload();
+
+    std::fprintf(g_replay.out, "# frames=%llu events=%llu screenshots=%llu\n",
+                 (unsigned long long)g_replay.frame,
+                 (unsigned long long)g_replay.eventCount,
+                 (unsigned long long)g_replay.screenshotCount);
+    if (g_replay.out != stdout)
+    {
+        std::fclose(g_replay.out);
+    }
+    return 0;
+}